@@ -0,0 +1,42 @@
+#include <benchmark/benchmark.h>
+#include <triqs/mc_tools.hpp>
+
+using namespace triqs::mc_tools;
+
+// The overhead of mc_generic per Metropolis step, for a move which does (almost) nothing.
+// The time is reported per step (items).
+
+struct move_cheap {
+  int *x;
+  int dx;
+  double attempt() { return (*x + dx > 10 or *x + dx < -10) ? 0.5 : 1.0; }
+  double accept() {
+    *x += dx;
+    return 1;
+  }
+  void reject() {}
+};
+
+template <typename MC> void run_mc(benchmark::State &state) {
+  int x           = 0;
+  uint64_t length = 1000;
+  MC mc("", 2938, 0);
+  mc.add_move(move_cheap{&x, 1}, "right");
+  mc.add_move(move_cheap{&x, -1}, "left");
+  mc.set_step_chunk_size(state.range(0));
+  for (auto _ : state) mc.accumulate(100, length, [] { return false; });
+  benchmark::DoNotOptimize(x);
+  state.SetItemsProcessed(int64_t(state.iterations()) * 100 * length);
+}
+
+// ===== type erased move_set. Arg : size of the chunks of steps (0 : standard loop)
+
+static void McRunMoveSet(benchmark::State &state) { run_mc<mc_generic<double>>(state); }
+BENCHMARK(McRunMoveSet)->Arg(0)->Arg(64)->Arg(1024);
+
+// ===== static_move_set
+
+static void McRunStaticMoveSet(benchmark::State &state) { run_mc<mc_generic<double, static_move_set<double, move_cheap, move_cheap>>>(state); }
+BENCHMARK(McRunStaticMoveSet)->Arg(0)->Arg(64)->Arg(1024);
+
+BENCHMARK_MAIN();
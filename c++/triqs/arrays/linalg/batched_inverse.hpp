@@ -0,0 +1,210 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#pragma once
+#include "./det_and_inverse.hpp"
+#include "../blas_lapack/f77/cxx_interface.hpp"
+#include <triqs/utility/parallel_for.hpp>
+#include <vector>
+
+namespace triqs::arrays {
+
+  namespace batched_inverse_impl {
+
+    // Number of matrices inverted together by the closed-form kernels.
+    // Their elements are stored in a buffer as [element][lane], so that the kernels vectorize over the lanes.
+    constexpr int n_lanes = 8;
+
+    template <int N, typename T> using lane_buffer_t = T[N * N][n_lanes];
+
+    // Closed-form inverse of the N x N matrices x[r * N + c][l] into y. Returns false if one of them is singular.
+    template <int N, typename T> bool closed_form_inverse(lane_buffer_t<N, T> const &x, lane_buffer_t<N, T> &y) {
+      T det[n_lanes];
+
+      if constexpr (N == 1) {
+        for (int l = 0; l < n_lanes; ++l) {
+          det[l]  = x[0][l];
+          y[0][l] = T(1) / x[0][l];
+        }
+      }
+
+      if constexpr (N == 2) {
+        for (int l = 0; l < n_lanes; ++l) {
+          det[l]  = x[0][l] * x[3][l] - x[1][l] * x[2][l];
+          T d     = T(1) / det[l];
+          y[0][l] = x[3][l] * d;
+          y[1][l] = -x[1][l] * d;
+          y[2][l] = -x[2][l] * d;
+          y[3][l] = x[0][l] * d;
+        }
+      }
+
+      if constexpr (N == 3) {
+        for (int l = 0; l < n_lanes; ++l) {
+          T a00 = x[0][l], a01 = x[1][l], a02 = x[2][l];
+          T a10 = x[3][l], a11 = x[4][l], a12 = x[5][l];
+          T a20 = x[6][l], a21 = x[7][l], a22 = x[8][l];
+          T c00 = a11 * a22 - a12 * a21, c10 = a12 * a20 - a10 * a22, c20 = a10 * a21 - a11 * a20;
+          det[l]  = a00 * c00 + a01 * c10 + a02 * c20;
+          T d     = T(1) / det[l];
+          y[0][l] = c00 * d;
+          y[1][l] = (a02 * a21 - a01 * a22) * d;
+          y[2][l] = (a01 * a12 - a02 * a11) * d;
+          y[3][l] = c10 * d;
+          y[4][l] = (a00 * a22 - a02 * a20) * d;
+          y[5][l] = (a02 * a10 - a00 * a12) * d;
+          y[6][l] = c20 * d;
+          y[7][l] = (a01 * a20 - a00 * a21) * d;
+          y[8][l] = (a00 * a11 - a01 * a10) * d;
+        }
+      }
+
+      if constexpr (N == 4) {
+        // Laplace expansion on the 2 x 2 minors of the first two rows (s) and of the last two rows (c)
+        for (int l = 0; l < n_lanes; ++l) {
+          T a00 = x[0][l], a01 = x[1][l], a02 = x[2][l], a03 = x[3][l];
+          T a10 = x[4][l], a11 = x[5][l], a12 = x[6][l], a13 = x[7][l];
+          T a20 = x[8][l], a21 = x[9][l], a22 = x[10][l], a23 = x[11][l];
+          T a30 = x[12][l], a31 = x[13][l], a32 = x[14][l], a33 = x[15][l];
+
+          T s0 = a00 * a11 - a10 * a01, s1 = a00 * a12 - a10 * a02, s2 = a00 * a13 - a10 * a03;
+          T s3 = a01 * a12 - a11 * a02, s4 = a01 * a13 - a11 * a03, s5 = a02 * a13 - a12 * a03;
+          T c5 = a22 * a33 - a32 * a23, c4 = a21 * a33 - a31 * a23, c3 = a21 * a32 - a31 * a22;
+          T c2 = a20 * a33 - a30 * a23, c1 = a20 * a32 - a30 * a22, c0 = a20 * a31 - a30 * a21;
+
+          det[l] = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+          T d    = T(1) / det[l];
+
+          y[0][l]  = (a11 * c5 - a12 * c4 + a13 * c3) * d;
+          y[1][l]  = (-a01 * c5 + a02 * c4 - a03 * c3) * d;
+          y[2][l]  = (a31 * s5 - a32 * s4 + a33 * s3) * d;
+          y[3][l]  = (-a21 * s5 + a22 * s4 - a23 * s3) * d;
+          y[4][l]  = (-a10 * c5 + a12 * c2 - a13 * c1) * d;
+          y[5][l]  = (a00 * c5 - a02 * c2 + a03 * c1) * d;
+          y[6][l]  = (-a30 * s5 + a32 * s2 - a33 * s1) * d;
+          y[7][l]  = (a20 * s5 - a22 * s2 + a23 * s1) * d;
+          y[8][l]  = (a10 * c4 - a11 * c2 + a13 * c0) * d;
+          y[9][l]  = (-a00 * c4 + a01 * c2 - a03 * c0) * d;
+          y[10][l] = (a30 * s4 - a31 * s2 + a33 * s0) * d;
+          y[11][l] = (-a20 * s4 + a21 * s2 - a23 * s0) * d;
+          y[12][l] = (-a10 * c3 + a11 * c1 - a12 * c0) * d;
+          y[13][l] = (a00 * c3 - a01 * c1 + a02 * c0) * d;
+          y[14][l] = (-a30 * s3 + a31 * s1 - a32 * s0) * d;
+          y[15][l] = (a20 * s3 - a21 * s1 + a22 * s0) * d;
+        }
+      }
+
+      bool ok = true;
+      for (int l = 0; l < n_lanes; ++l) ok = ok and (det[l] != T(0));
+      return ok;
+    }
+
+    // Inverts the matrices [i0, i1) of the batch p(i, r, c) = p[i * st[0] + r * st[1] + c * st[2]] with the closed-form kernel
+    template <int N, typename T, typename S> void invert_closed_form(T *p, S const &st, long i0, long i1) {
+      lane_buffer_t<N, T> x, y;
+      for (long i = i0; i < i1; i += n_lanes) {
+        int n_active = std::min<long>(n_lanes, i1 - i);
+
+        // gather. The unused lanes are the identity
+        for (int l = 0; l < n_lanes; ++l)
+          for (int r = 0; r < N; ++r)
+            for (int c = 0; c < N; ++c) x[r * N + c][l] = (l < n_active ? p[(i + l) * st[0] + r * st[1] + c * st[2]] : T(r == c ? 1 : 0));
+
+        if (!closed_form_inverse<N>(x, y)) throw matrix_inverse_exception() << "Inverse error : matrix is not invertible";
+
+        // scatter
+        for (int l = 0; l < n_active; ++l)
+          for (int r = 0; r < N; ++r)
+            for (int c = 0; c < N; ++c) p[(i + l) * st[0] + r * st[1] + c * st[2]] = y[r * N + c][l];
+      }
+    }
+
+    // Inverts the matrices [i0, i1) of the batch with LU (getrf, getri), with the pivots and the workspace allocated once
+    template <typename T, typename S> void invert_lu(T *p, S const &st, long n, long i0, long i1) {
+      std::vector<int> ipiv(n);
+      std::vector<T> buf(n * n);
+      int info = 0;
+
+      // Workspace query
+      T work1[1];
+      lapack::f77::getri(n, buf.data(), n, ipiv.data(), work1, -1, info);
+      int lwork = lapack::r_round(work1[0]);
+      std::vector<T> work(lwork);
+
+      for (long i = i0; i < i1; ++i) {
+        T *m = p + i * st[0];
+
+        // A C or Fortran contiguous matrix is inverted in place (the inverse of the transpose is the transpose of the inverse)
+        bool in_place = ((st[2] == 1 and st[1] == n) or (st[1] == 1 and st[2] == n));
+        T *w          = (in_place ? m : buf.data());
+        if (!in_place)
+          for (long r = 0; r < n; ++r)
+            for (long c = 0; c < n; ++c) buf[r + c * n] = m[r * st[1] + c * st[2]];
+
+        lapack::f77::getrf(n, n, w, n, ipiv.data(), info);
+        if (info < 0) throw matrix_inverse_exception() << "Inverse error : failure of getrf lapack routine";
+        if (info > 0) throw matrix_inverse_exception() << "Inverse error : matrix is not invertible";
+        lapack::f77::getri(n, w, n, ipiv.data(), work.data(), lwork, info);
+        if (info != 0) throw matrix_inverse_exception() << "Inverse error : matrix is not invertible";
+
+        if (!in_place)
+          for (long r = 0; r < n; ++r)
+            for (long c = 0; c < n; ++c) m[r * st[1] + c * st[2]] = buf[r + c * n];
+      }
+    }
+
+  } // namespace batched_inverse_impl
+
+  /**
+   * Inverts in place all the matrices a(i, _, _) of a rank 3 array or view.
+   *
+   * The matrices of size 1 to 4 are inverted with closed-form (cofactor) kernels, which process several matrices at once
+   * and vectorize over them. Larger matrices use LU (getrf, getri), with the pivots and the workspace allocated once.
+   *
+   * @param a The array of the matrices
+   * @param n_threads Number of threads over which the matrices are distributed
+   * @throws triqs::runtime_error if one of the matrices is singular
+   */
+  template <typename A3> void batched_inverse_in_place(A3 &&a, int n_threads = 1) {
+    using A_t = std::decay_t<A3>;
+    using T   = std::remove_const_t<typename A_t::value_type>;
+    static_assert(A_t::rank == 3, "batched_inverse_in_place : requires an array of rank 3");
+    static_assert(is_blas_lapack_type<T>::value, "batched_inverse_in_place : requires an array of double or complex");
+
+    long n_mat = first_dim(a), n = second_dim(a);
+    if (third_dim(a) != n) TRIQS_RUNTIME_ERROR << "batched_inverse_in_place : the matrices are not square but of size " << n << " x " << third_dim(a);
+    if (n_mat == 0 or n == 0) return;
+
+    T *p          = a.data_start();
+    auto const st = a.indexmap().strides();
+
+    auto run = [p, &st, n](long i0, long i1) {
+      using namespace batched_inverse_impl;
+      switch (n) {
+        case 1: invert_closed_form<1>(p, st, i0, i1); break;
+        case 2: invert_closed_form<2>(p, st, i0, i1); break;
+        case 3: invert_closed_form<3>(p, st, i0, i1); break;
+        case 4: invert_closed_form<4>(p, st, i0, i1); break;
+        default: invert_lu(p, st, n, i0, i1);
+      }
+    };
+
+    // Split the matrices in n_threads contiguous chunks
+    triqs::utility::parallel_for_chunks(n_mat, n_threads, run);
+  }
+
+} // namespace triqs::arrays
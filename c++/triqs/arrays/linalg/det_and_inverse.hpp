@@ -77,6 +77,22 @@ namespace triqs {
         return _det;
       }
 
+      /// The determinant as (phase, log|det|), i.e. det = phase * exp(log|det|), without overflow for large matrices
+      std::pair<value_type, double> phase_and_log_abs_det() {
+        V_type W = fortran_view(a);
+        _step1(W);
+        value_type phase = 1;
+        double log_abs   = 0;
+        bool flip        = false;
+        for (size_t i = 0; i < dim; i++) {
+          auto d = W(i, i);
+          log_abs += std::log(std::abs(d));
+          if (d != value_type(0)) phase *= d / std::abs(d);
+          if (ipiv(i) != int(i) + 1) flip = !(flip);
+        }
+        return {(flip ? -phase : phase), log_abs};
+      }
+
       A const &inverse() {
         if (step < 2) {
           V_type W = fortran_view(a);
@@ -23,6 +23,8 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <climits>
+#include <limits>
 #include <triqs/utility/exceptions.hpp>
 #include <triqs/arrays/vector.hpp>
 #include <triqs/arrays/matrix.hpp>
@@ -48,6 +50,33 @@ namespace triqs {
     // Quantum number operators are Hermitian, hence their eigenvalues are real
     using quantum_number_t = double;
 
+    /// Parameters of the iterative diagonalization of the large subspaces
+    /**
+     * The Hamiltonian of a subspace of dimension at least `min_dim` is assembled as a sparse (CSR) matrix,
+     * and only its `n_states` lowest eigenstates are computed with the block Lanczos algorithm.
+     * Among them, only those within `energy_window` of the ground state are kept (at least one per subspace), completed
+     * to the end of the last multiplet.
+     * All the other quantities (c, c^dagger matrices, Green's functions, density matrix, ...) are then
+     * computed in the truncated spectrum.
+     */
+    struct lanczos_params_t {
+      /// Minimal dimension of the subspaces treated with Lanczos. By default, all subspaces are diagonalized with LAPACK
+      int min_dim = INT_MAX;
+      /// Number of the lowest eigenstates kept in each of these subspaces. To keep the multiplets whole, it is extended
+      /// to the end of the last multiplet, or reduced to its start if the multiplet may have more than block_size states
+      int n_states = 10;
+      /// Maximal energy above the ground state of the eigenstates kept in these subspaces
+      double energy_window = std::numeric_limits<double>::infinity();
+      /// Block size of the Lanczos algorithm, i.e. maximal degeneracy resolved
+      int block_size = 4;
+      /// Maximal dimension of the Krylov space, before a restart
+      int krylov_dim = 60;
+      /// Convergence criterion on the norm of the residual of the eigenpairs
+      double tolerance = 1.e-10;
+      /// Maximal number of restarts
+      int max_restarts = 1000;
+    };
+
     /// Lightweight exact diagonalization solver
     /**
      * This class is provided as a simple tool to diagonalize Hamiltonians of
@@ -79,6 +108,7 @@ namespace triqs {
         vector<double> eigenvalues;
         /// Unitary transformation matrix :math:`\hat U` from the Fock basis to the eigenbasis.
         /// Defined according to :math:`\hat H = \hat  U \mathrm{diag}(E) * \hat U^\dagger`.
+        /// In a truncated spectrum (cf lanczos_params_t), only the columns of the kept eigenstates.
         matrix_t unitary_matrix;
 
 #ifdef __cpp_impl_three_way_comparison
@@ -132,11 +162,15 @@ namespace triqs {
        *
        * @param h Hamiltonian operator to be diagonalized.
        * @param fops Fundamental operator set; Must at least contain all fundamental operators met in `h`.
+       * @param n_threads Number of threads over which the subspaces are diagonalized, and the matrices of the
+       *                  creation and annihilation operators are computed. The largest subspaces are treated first.
+       * @param lanczos Diagonalization of the large subspaces with Lanczos, in a truncated spectrum (disabled by default)
        * @note See :ref:`space_partition` for more details on the auto-partition scheme.
        */
-      atom_diag(many_body_op_t const &h, fundamental_operator_set const &fops);
+      atom_diag(many_body_op_t const &h, fundamental_operator_set const &fops, int n_threads = 1, lanczos_params_t const &lanczos = {});
 
-      atom_diag(many_body_op_t const &h, fundamental_operator_set const &fops, int n_min, int n_max);
+      atom_diag(many_body_op_t const &h, fundamental_operator_set const &fops, int n_min, int n_max, int n_threads = 1,
+                lanczos_params_t const &lanczos = {});
 
       /// Reduce a given Hamiltonian to a block-diagonal form and diagonalize it
       /**
@@ -148,8 +182,11 @@ namespace triqs {
        * @param h Hamiltonian operator to be diagonalized.
        * @param fops Fundamental operator set; Must at least contain all fundamental operators met in `h`.
        * @param qn_vector Vector of quantum number operators.
+       * @param n_threads Number of threads (cf above)
+       * @param lanczos Diagonalization of the large subspaces (cf above)
        */
-      atom_diag(many_body_op_t const &h, fundamental_operator_set const &fops, std::vector<many_body_op_t> const &qn_vector);
+      atom_diag(many_body_op_t const &h, fundamental_operator_set const &fops, std::vector<many_body_op_t> const &qn_vector, int n_threads = 1,
+                lanczos_params_t const &lanczos = {});
 
       /// The Hamiltonian used at construction
       many_body_op_t const &get_h_atomic() const { return h_atomic; }
@@ -220,6 +257,8 @@ namespace triqs {
       /// A vector of all the quantum numbers, grouped by subspace
       /**
        * @return result[sp_index][qn_index] is the qunatum number value.
+       * @warning Known limitation : the sp_index is the order in which the subspaces are created by the partition,
+       *          not the index of the subspace, which is sorted by energy.
        */
       std::vector<std::vector<quantum_number_t>> const &get_quantum_numbers() const { return quantum_numbers; }
 
@@ -302,7 +341,7 @@ namespace triqs {
       std::vector<int> first_eigenstate_of_subspace; // Index of the first eigenstate of each subspace
       void fill_first_eigenstate_of_subspace();
       void compute_vacuum();
-      std::pair<int, matrix_t> get_matrix_element_of_monomial(operators::monomial_t const &op_vec, int B) const;
+      int get_connection_of_monomial(operators::monomial_t const &op_vec, int B) const;
 
       /* Friend declarations of a template class are a bit ugly */
       friend std::ostream &operator<<<Complex>(std::ostream &os, atom_diag const &ss);
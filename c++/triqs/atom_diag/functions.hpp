@@ -66,7 +66,7 @@ namespace triqs {
  * @param op Operator to act on the state.
  * @param st Initial state vector in the full Hilbert space, written in the eigenbasis of the Hamiltonian.
  * @param atom Solved diagonalization problem.
- * @return Final state vector in the full Hilbert space.
+ * @return Final state vector in the full Hilbert space. With a truncated spectrum, it is projected on the kept eigenstates.
  * @include triqs/atom_diag/functions.hpp
  */
     template <bool Complex>
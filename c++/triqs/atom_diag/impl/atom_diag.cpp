@@ -21,6 +21,9 @@
 #include "../atom_diag.hpp"
 #include "./worker.hpp"
 
+#include <triqs/hilbert_space/imperative_operator.hpp>
+#include <triqs/hilbert_space/state.hpp>
+
 #include <triqs/arrays.hpp>
 
 using namespace triqs::arrays;
@@ -32,25 +35,27 @@ namespace triqs {
 #define ATOM_DIAG_CONSTRUCTOR(ARGS) template <bool Complex> atom_diag<Complex>::atom_diag ARGS
 #define ATOM_DIAG_METHOD(RET, F) template <bool Complex> auto atom_diag<Complex>::F->RET
 
-    ATOM_DIAG_CONSTRUCTOR((many_body_op_t const &h, fundamental_operator_set const &fops, std::vector<many_body_op_t> const &qn_vector))
+    ATOM_DIAG_CONSTRUCTOR((many_body_op_t const &h, fundamental_operator_set const &fops, std::vector<many_body_op_t> const &qn_vector, int n_threads,
+                           lanczos_params_t const &lanczos))
        : h_atomic(h), fops(fops), full_hs(fops), vacuum(full_hs.size()) {
-      atom_diag_worker<Complex>{this}.partition_with_qn(qn_vector);
+      atom_diag_worker<Complex>{this, 0, INT_MAX, n_threads, lanczos}.partition_with_qn(qn_vector);
       fill_first_eigenstate_of_subspace();
       compute_vacuum();
     }
 
     // -----------------------------------------------------------------
 
-    ATOM_DIAG_CONSTRUCTOR((many_body_op_t const &h, fundamental_operator_set const &fops))
+    ATOM_DIAG_CONSTRUCTOR((many_body_op_t const &h, fundamental_operator_set const &fops, int n_threads, lanczos_params_t const &lanczos))
        : h_atomic(h), fops(fops), full_hs(fops), vacuum(full_hs.size()) {
-      atom_diag_worker<Complex>{this}.autopartition();
+      atom_diag_worker<Complex>{this, 0, INT_MAX, n_threads, lanczos}.autopartition();
       fill_first_eigenstate_of_subspace();
       compute_vacuum();
     }
 
-    ATOM_DIAG_CONSTRUCTOR((many_body_op_t const &h, fundamental_operator_set const &fops, int n_min, int n_max))
+    ATOM_DIAG_CONSTRUCTOR((many_body_op_t const &h, fundamental_operator_set const &fops, int n_min, int n_max, int n_threads,
+                           lanczos_params_t const &lanczos))
        : h_atomic(h), fops(fops), full_hs(fops), vacuum(full_hs.size()) {
-      atom_diag_worker<Complex>{this, n_min, n_max}.autopartition();
+      atom_diag_worker<Complex>{this, n_min, n_max, n_threads, lanczos}.autopartition();
       fill_first_eigenstate_of_subspace();
       compute_vacuum();
     }
@@ -68,7 +73,8 @@ namespace triqs {
     // -----------------------------------------------------------------
 
     ATOM_DIAG_METHOD(void, compute_vacuum()) {
-      // Compute vacuum vector in the eigenbasis
+      // Compute vacuum vector in the eigenbasis (of the kept eigenstates in a truncated spectrum)
+      vacuum.resize(n_subspaces() == 0 ? 0 : flatten_subspace_index(n_subspaces() - 1, get_subspace_dim(n_subspaces() - 1)));
       vacuum() = 0;
       for (int sp : range(sub_hilbert_spaces.size())) {
         if (sub_hilbert_spaces[sp].has_state(fock_state_t(0))) {
@@ -89,53 +95,41 @@ namespace triqs {
 
     // -----------------------------------------------------------------
     // Given a monomial (ccccc), and a subspace B, returns
-    //   - the subspace connected by ccccc from B
-    //   - the corresponding matrix (not necessarily square)
-
-    template <bool Complex>
-    auto atom_diag<Complex>::get_matrix_element_of_monomial(operators::monomial_t const &op_vec, int B) const
-      -> std::pair<int, matrix_t> {
-
-      auto m = triqs::arrays::make_unit_matrix<scalar_t>(get_subspace_dim(B));
+    // the subspace connected by ccccc from B, or -1
 
+    ATOM_DIAG_METHOD(int, get_connection_of_monomial(operators::monomial_t const &op_vec, int B) const) {
       auto const &fops = get_fops();
-      for (int i = op_vec.size() - 1; i >= 0; --i) {
+      for (int i = op_vec.size() - 1; i >= 0 and B != -1; --i) {
         int ind = fops[op_vec[i].indices];
-        int Bp  = (op_vec[i].dagger ? cdag_connection(ind, B) : c_connection(ind, B));
-        if (Bp == -1) return {-1, std::move(m)};
-        m = (op_vec[i].dagger ? cdag_matrix(ind, B) : c_matrix(ind, B)) * m;
-        B = Bp;
+        B       = (op_vec[i].dagger ? cdag_connection(ind, B) : c_connection(ind, B));
       }
-      return {B, std::move(m)};
+      return B;
     }
 
     // -----------------------------------------------------------------
 
+    // The blocks are computed in the Fock basis, and transformed once to the eigenbasis.
+    // NB : the products of the c, c^dagger matrices would not do with a truncated spectrum (Lanczos),
+    // as the intermediate states of a monomial are not all kept.
     ATOM_DIAG_METHOD(op_block_mat_t, get_op_mat(many_body_op_t const &op) const) {
       op_block_mat_t op_mat(n_subspaces());
+      imperative_operator<class hilbert_space, scalar_t> imp_op(op, fops);
+
+      for (int b : range(n_subspaces())) {
+        for (auto const &term : op) {
+          int bb = get_connection_of_monomial(term.monomial, b);
+          if (bb == -1) continue;
+          if (op_mat.connection(b) == -1)
+            op_mat.connection(b) = bb;
+          else if (op_mat.connection(b) != bb)
+            TRIQS_RUNTIME_ERROR << "ERROR: <atom_diag::get_op_mat> Monomials in operator does not connect the same subspaces.";
+        }
+        int bb = op_mat.connection(b);
+        if (bb == -1) continue;
 
-      for(int b : range(n_subspaces()) ) {
-	for( auto const &term : op ) {
-	  auto [bb, mat] = get_matrix_element_of_monomial(term.monomial, b);
-	  if(bb == -1) continue;
-	  
-	  if( op_mat.connection(b) == -1 ) {
-	    op_mat.connection(b) = bb;
-	    op_mat.block_mat[b] = term.coef * mat;
-	  } else if ( op_mat.connection(b) != bb ) {
-	    TRIQS_RUNTIME_ERROR << "ERROR: <atom_diag::get_op_mat> Monomials in operator does not connect the same subspaces.";
-	  } else {
-	    op_mat.block_mat[b] += term.coef * mat;
-	  }
-	}
-	// Transform to Hamiltonian eigen basis
-	if( op_mat.connection(b) != -1 ) {
-	  auto U_left = dagger(eigensystems[op_mat.connection(b)].unitary_matrix);
-	  auto U_right = eigensystems[b].unitary_matrix;
-	  op_mat.block_mat[b] = U_left * op_mat.block_mat[b] * U_right;
-	}
+        op_mat.block_mat[b] = atom_diag_worker<Complex>::op_matrix_in_eigenbasis(*this, imp_op, b, bb);
       }
-      return std::move(op_mat);
+      return op_mat;
     }
 
 #undef ATOM_DIAG_METHOD
@@ -63,22 +63,17 @@ namespace triqs {
 
     // -----------------------------------------------------------------
 
-    // Given a monomial (ccccc), and a subspace B, returns
-    //   - the subspace connected by ccccc from B
-    //   - the corresponding matrix (not necessarily square)
-    template <bool Complex>
-    auto matrix_element_of_monomial(ATOM_DIAG const &atom, operators::monomial_t const &op_vec, int B) -> std::pair<int, ATOM_DIAG_T::matrix_t> {
-
-      auto m           = triqs::arrays::make_unit_matrix<ATOM_DIAG_T::scalar_t>(atom.get_subspace_dim(B));
-      auto const &fops = atom.get_fops();
-      for (int i = op_vec.size() - 1; i >= 0; --i) {
-        int ind = fops[op_vec[i].indices];
-        int Bp  = (op_vec[i].dagger ? atom.cdag_connection(ind, B) : atom.c_connection(ind, B));
-        if (Bp == -1) return {-1, std::move(m)};
-        m = (op_vec[i].dagger ? atom.cdag_matrix(ind, B) : atom.c_matrix(ind, B)) * m;
-        B = Bp;
+    // Calls f(B, Bp, M) for each term of op, and each subspace B connected by this term to the subspace Bp,
+    // with M the (not necessarily square) matrix of the term from B to Bp.
+    // The terms are taken one by one, as they may connect different subspaces. Their blocks are computed in the Fock basis by
+    // get_op_mat : a product of the c, c^dagger matrices would miss the intermediate states which are not kept in a truncated
+    // spectrum (Lanczos).
+    template <bool Complex, typename F> void foreach_term_block(ATOM_DIAG const &atom, ATOM_DIAG_T::many_body_op_t const &op, F f) {
+      for (auto const &x : op) {
+        auto op_mat = atom.get_op_mat(ATOM_DIAG_T::many_body_op_t(x));
+        for (int B = 0; B < atom.n_subspaces(); ++B)
+          if (op_mat.connection(B) != -1) f(B, op_mat.connection(B), op_mat.block_mat[B]);
       }
-      return {B, std::move(m)};
     }
 
     // -----------------------------------------------------------------
@@ -91,11 +86,10 @@ namespace triqs {
       for (int sp = 0; sp < atom.n_subspaces(); ++sp) {
         if (atom.get_subspace_dim(sp) != first_dim(density_matrix[sp]))
           TRIQS_RUNTIME_ERROR << "trace_rho_op : size mismatch : size of block " << sp << " differ";
-        for (auto const &x : op) {
-          auto b_m = matrix_element_of_monomial(atom, x.monomial, sp);
-          if (b_m.first == sp) result += x.coef * trace(b_m.second * density_matrix[sp]);
-        }
       }
+      foreach_term_block(atom, op, [&](int B, int Bp, auto const &M) {
+        if (Bp == B) result += trace(M * density_matrix[B]);
+      });
       return result;
     }
     template ATOM_DIAG_R::scalar_t trace_rho_op(ATOM_DIAG_R::block_matrix_t const &, ATOM_DIAG_R::many_body_op_t const &, ATOM_DIAG_R const &);
@@ -107,13 +101,9 @@ namespace triqs {
        -> ATOM_DIAG_T::full_hilbert_space_state_t {
       ATOM_DIAG_T::full_hilbert_space_state_t result(st.size());
       result() = 0;
-      for (auto const &x : op) {
-        for (int bl = 0; bl < atom.n_subspaces(); ++bl) {
-          auto b_m = matrix_element_of_monomial(atom, x.monomial, bl);
-          if (b_m.first == -1) continue;
-          result(atom.index_range_of_subspace(b_m.first)) += x.coef * b_m.second * st(atom.index_range_of_subspace(bl));
-        }
-      }
+      foreach_term_block(atom, op, [&](int B, int Bp, auto const &M) {
+        result(atom.index_range_of_subspace(Bp)) += M * st(atom.index_range_of_subspace(B));
+      });
       return result;
     }
     template ATOM_DIAG_R::full_hilbert_space_state_t act(ATOM_DIAG_R::many_body_op_t const &, ATOM_DIAG_R::full_hilbert_space_state_t const &,
@@ -130,15 +120,11 @@ namespace triqs {
 
       std::vector<std::vector<quantum_number_t>> result;
 
-      for (int sp = 0; sp < atom.n_subspaces(); ++sp) {
-        auto dim = atom.get_subspace_dim(sp);
-        result.push_back(std::vector<quantum_number_t>(dim, 0));
-        for (auto const &x : op) {
-          auto b_m = matrix_element_of_monomial(atom, x.monomial, sp);
-          if (b_m.first != sp) continue;
-          for (int i = 0; i < dim; ++i) result.back()[i] += real(x.coef * b_m.second(i, i));
-        }
-      }
+      for (int sp = 0; sp < atom.n_subspaces(); ++sp) result.push_back(std::vector<quantum_number_t>(atom.get_subspace_dim(sp), 0));
+      foreach_term_block(atom, op, [&](int B, int Bp, auto const &M) {
+        if (Bp != B) return;
+        for (int i = 0; i < result[B].size(); ++i) result[B][i] += real(M(i, i));
+      });
       return result;
     }
     template std::vector<std::vector<quantum_number_t>> quantum_number_eigenvalues(ATOM_DIAG_R::many_body_op_t const &, ATOM_DIAG_R const &);
@@ -164,14 +150,9 @@ namespace triqs {
       M() = 0;
       std::vector<std::vector<quantum_number_t>> result;
 
-      for (int sp = 0; sp < atom.n_subspaces(); ++sp) {
-        auto dim = atom.get_subspace_dim(sp);
-        for (auto const &x : op) {
-          auto b_m = matrix_element_of_monomial(atom, x.monomial, sp);
-          if (b_m.first == -1) continue;
-          M(atom.index_range_of_subspace(b_m.first), atom.index_range_of_subspace(sp)) += real(x.coef * b_m.second);
-        }
-      }
+      foreach_term_block(atom, op, [&](int B, int Bp, auto const &m) {
+        M(atom.index_range_of_subspace(Bp), atom.index_range_of_subspace(B)) += real(m);
+      });
       if (!is_diagonal(M)) TRIQS_RUNTIME_ERROR << "The matrix of the operator is not diagonal !!!";
 
       for (int sp = 0; sp < atom.n_subspaces(); ++sp) {
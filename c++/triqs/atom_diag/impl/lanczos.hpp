@@ -0,0 +1,218 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Igor Krivenko, Nils Wentzell
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <random>
+#include <utility>
+#include <vector>
+#include <triqs/arrays.hpp>
+#include <triqs/arrays/linalg/eigenelements.hpp>
+#include <triqs/utility/exceptions.hpp>
+
+namespace triqs {
+  namespace atom_diag {
+
+    using namespace triqs::arrays;
+
+    /// A square matrix in the compressed sparse row (CSR) format
+    template <typename T> struct csr_matrix {
+      long n = 0;                      // dimension
+      std::vector<long> row_start{0};  // the elements of row i are [row_start[i], row_start[i+1])
+      std::vector<int> col;            // column of each element
+      std::vector<T> val;              // value of each element
+
+      /// Close the current row
+      void end_row() {
+        row_start.push_back(col.size());
+        ++n;
+      }
+
+      /// y = A x
+      void apply(T const *x, T *y) const {
+        for (long i = 0; i < n; ++i) {
+          T r = 0;
+          for (long p = row_start[i]; p < row_start[i + 1]; ++p) r += val[p] * x[col[p]];
+          y[i] = r;
+        }
+      }
+
+      /// The dense matrix
+      matrix<T> to_dense() const {
+        matrix<T> m(n, n);
+        m() = 0;
+        for (long i = 0; i < n; ++i)
+          for (long p = row_start[i]; p < row_start[i + 1]; ++p) m(i, col[p]) += val[p];
+        return m;
+      }
+    };
+
+    namespace lanczos_impl {
+
+      inline double conj_(double x) { return x; }
+      inline std::complex<double> conj_(std::complex<double> const &x) { return std::conj(x); }
+
+      // <x|y>
+      template <typename T> T dot(T const *x, T const *y, long n) {
+        T r = 0;
+        for (long i = 0; i < n; ++i) r += conj_(x[i]) * y[i];
+        return r;
+      }
+
+      // y += a x
+      template <typename T> void axpy(T a, T const *x, T *y, long n) {
+        for (long i = 0; i < n; ++i) y[i] += a * x[i];
+      }
+
+      // Orthogonalize w against the n_vec vectors of V, twice, and return the coefficients
+      template <typename T> std::vector<T> orthogonalize(std::vector<T> const &V, int n_vec, T *w, long n) {
+        std::vector<T> h(n_vec, 0);
+        for (int pass = 0; pass < 2; ++pass)
+          for (int i = 0; i < n_vec; ++i) {
+            T c = dot(&V[i * n], w, n);
+            axpy(-c, &V[i * n], w, n);
+            h[i] += c;
+          }
+        return h;
+      }
+
+    } // namespace lanczos_impl
+
+    /**
+     * The n_ev lowest eigenpairs of a hermitian matrix, with the thick-restart block Lanczos algorithm.
+     *
+     * The Krylov basis is fully reorthogonalized. The blocks of b vectors resolve the degeneracies up to b.
+     * At each restart, the lowest Ritz vectors are kept with the residual block.
+     *
+     * @param A Hermitian matrix
+     * @param n_ev Number of eigenpairs
+     * @param b Block size
+     * @param krylov_dim Maximal dimension of the Krylov space before a restart
+     * @param tolerance The Ritz pairs are converged when |A y - theta y| <= tolerance * max(1, |theta|)
+     * @param max_restarts Maximal number of restarts
+     * @return The eigenvalues in ascending order, and the eigenvectors as the columns of a matrix
+     */
+    template <typename T>
+    std::pair<vector<double>, matrix<T>> lanczos_lowest(csr_matrix<T> const &A, int n_ev, int b, int krylov_dim, double tolerance, int max_restarts) {
+      using namespace lanczos_impl;
+      long n = A.n;
+      n_ev   = std::min<long>(n_ev, n);
+      b      = std::max(1, std::min(b, n_ev));
+      int M  = std::max(krylov_dim, 2 * (n_ev + b));
+
+      // Small matrix : dense diagonalization
+      if (n <= M + b) {
+        auto eig = linalg::eigenelements(A.to_dense());
+        return {vector<double>(eig.first(range(0, n_ev))), matrix<T>(eig.second.transpose()(range(), range(0, n_ev)))};
+      }
+
+      // V : the basis vectors, contiguous. h(i, j) = <v_i|A|v_j> as computed by the orthogonalization of A v_j
+      std::vector<T> V((M + b) * n), w(n);
+      matrix<T> h(M + b, M);
+      h() = 0;
+
+      std::mt19937 rng(1234);
+      std::uniform_real_distribution<double> unif(-1, 1);
+      auto add_random_vector = [&](int n_basis) {
+        T *v = &V[n_basis * n];
+        for (long i = 0; i < n; ++i) v[i] = unif(rng);
+        orthogonalize(V, n_basis, v, n);
+        double nrm = std::sqrt(std::abs(dot(v, v, n)));
+        for (long i = 0; i < n; ++i) v[i] /= nrm;
+      };
+
+      int n_basis = 0, j_start = 0;
+      for (; n_basis < b; ++n_basis) add_random_vector(n_basis);
+
+      for (int restart = 0;; ++restart) {
+
+        // Extend the Krylov basis : A v_j generates v_{j+b}
+        for (int j = j_start; j < M; ++j) {
+          A.apply(&V[j * n], w.data());
+          auto c = orthogonalize(V, n_basis, w.data(), n);
+          for (int i = 0; i < n_basis; ++i) h(i, j) = c[i];
+          double beta = std::sqrt(std::abs(dot(w.data(), w.data(), n)));
+          if (beta > 1e-12 * std::max(1.0, std::abs(h(j, j)))) {
+            for (long i = 0; i < n; ++i) V[n_basis * n + i] = w[i] / beta;
+            h(n_basis, j) = beta;
+          } else { // A invariant subspace is found : continue with a new direction
+            add_random_vector(n_basis);
+            h(n_basis, j) = 0;
+          }
+          ++n_basis;
+        }
+
+        // Ritz pairs of the hermitian projected matrix, from its upper triangle
+        matrix<T> H(M, M);
+        for (int i = 0; i < M; ++i)
+          for (int j = i; j < M; ++j) {
+            H(i, j) = h(i, j);
+            H(j, i) = conj_(h(i, j));
+          }
+        auto eig          = linalg::eigenelements(H);
+        auto const &theta = eig.first;
+        auto const &S     = eig.second; // the eigenvectors are the rows of S
+
+        // The residual of the Ritz pair i is sum_j h(M + l, j) S(i, j) v_{M + l}
+        auto residual = [&](int i) {
+          double r = 0;
+          for (int l = 0; l < b; ++l) {
+            T c = 0;
+            for (int j = 0; j < M; ++j) c += h(M + l, j) * S(i, j);
+            r += std::norm(c);
+          }
+          return std::sqrt(r);
+        };
+
+        bool converged = true;
+        for (int i = 0; i < n_ev; ++i) converged = converged and (residual(i) <= tolerance * std::max(1.0, std::abs(theta(i))));
+        if (restart == max_restarts and !converged) TRIQS_RUNTIME_ERROR << "lanczos_lowest : no convergence after " << max_restarts << " restarts";
+
+        // Keep the p lowest Ritz vectors, followed by the residual block
+        int p = (converged ? n_ev : n_ev + (M - n_ev - b) / 2);
+        std::vector<T> Y(p * n, 0);
+        for (int i = 0; i < p; ++i)
+          for (int j = 0; j < M; ++j) axpy(S(i, j), &V[j * n], &Y[i * n], n);
+
+        if (converged) {
+          auto U = matrix<T>(n, n_ev);
+          for (int i = 0; i < n_ev; ++i)
+            for (long k = 0; k < n; ++k) U(k, i) = Y[i * n + k];
+          return {vector<double>(theta(range(0, n_ev))), std::move(U)};
+        }
+
+        // The new projected matrix : A y_i = theta_i y_i + sum_l h(M + l, :) S(i, :) v_{M + l}
+        matrix<T> h_new(M + b, M);
+        h_new() = 0;
+        for (int i = 0; i < p; ++i) {
+          h_new(i, i) = theta(i);
+          for (int l = 0; l < b; ++l)
+            for (int j = 0; j < M; ++j) h_new(p + l, i) += h(M + l, j) * S(i, j);
+        }
+        std::copy(Y.begin(), Y.end(), V.begin());
+        std::copy(V.begin() + M * n, V.begin() + (M + b) * n, V.begin() + p * n);
+        h       = std::move(h_new);
+        n_basis = p + b;
+        j_start = p;
+      }
+    }
+
+  } // namespace atom_diag
+} // namespace triqs
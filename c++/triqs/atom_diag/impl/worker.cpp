@@ -21,18 +21,65 @@
 #include "./worker.hpp"
 
 #include <vector>
-#include <bitset>
 #include <map>
+#include <numeric>
 #include <triqs/hilbert_space/state.hpp>
 #include <triqs/hilbert_space/imperative_operator.hpp>
 #include <triqs/hilbert_space/space_partition.hpp>
 #include <triqs/arrays/linalg/eigenelements.hpp>
+#include <triqs/utility/parallel_for.hpp>
+#include "./lanczos.hpp"
 
 using namespace triqs::hilbert_space;
 
 namespace triqs {
   namespace atom_diag {
 
+    namespace {
+
+      // The diagonal elements <f|Q|f> of an operator Q on the Fock states f of the full Hilbert space.
+      // Only the monomials with the same creation and annihilation indices are diagonal in the Fock basis.
+      // Such a monomial is (up to its coefficient) a product of n_i, so <f|Q|f> = sum_m coef_m [f contains mask_m],
+      // which is evaluated bitwise, without building any state.
+      template <typename ScalarType> struct fock_diagonal {
+        std::vector<std::pair<fock_state_t, ScalarType>> terms;
+
+        fock_diagonal(triqs::operators::many_body_operator_generic<ScalarType> const &op, fundamental_operator_set const &fops, class hilbert_space const &full_hs) {
+          for (auto const &term : op) {
+            fock_state_t cdag_mask = 0, c_mask = 0;
+            for (auto const &cop : term.monomial) (cop.dagger ? cdag_mask : c_mask) |= fock_state_t(1) << fops[cop.indices];
+            if (cdag_mask != c_mask) continue;
+            // The coefficient with the sign of the reordering, from the action of the monomial on |mask>
+            state<class hilbert_space, ScalarType, true> s(full_hs);
+            s(full_hs.get_state_index(c_mask)) = 1.0;
+            auto coef = dot_product(s, imperative_operator<class hilbert_space, ScalarType>(triqs::operators::many_body_operator_generic<ScalarType>(term), fops)(s));
+            if (coef != ScalarType(0)) terms.emplace_back(c_mask, coef);
+          }
+        }
+
+        ScalarType operator()(fock_state_t f) const {
+          ScalarType r = 0;
+          for (auto const &[mask, coef] : terms)
+            if ((f & mask) == mask) r += coef;
+          return r;
+        }
+      };
+
+      // Two eigenvalues closer than this are in the same multiplet, which the truncations of the spectrum do not split
+      constexpr double degeneracy_tol = 1.e-8;
+
+      // The number of states kept among the lowest eigenvalues E of a subspace of dimension dim : n_states, extended
+      // to the end of the last multiplet. If this multiplet may go on beyond the computed states, it is dropped instead.
+      int cut_at_gap(vector<double> const &E, int n_states, long dim) {
+        int m = E.size(), n = std::max(1, std::min(n_states, m));
+        while (n < m and E(n) - E(n - 1) <= degeneracy_tol) ++n;
+        if (n < m or m == dim) return n;
+        while (n > 0 and E(m - 1) - E(n - 1) <= degeneracy_tol) --n;
+        return (n > 0 ? n : m); // all the computed states are degenerate : they are all kept
+      }
+
+    } // namespace
+
 // Methods of atom_diag_worker
 #define ATOM_DIAG_WORKER_METHOD(RET, F) template <bool Complex> auto atom_diag_worker<Complex>::F->RET
 
@@ -40,7 +87,7 @@ namespace triqs {
 
     // Filter the Fock states with a number of particles within [n_min;n_max]
     ATOM_DIAG_WORKER_METHOD(bool, fock_state_filter(fock_state_t s)) {
-      auto c = std::bitset<64>(s).count();
+      auto c = popcount(s);
       return ((c >= n_min) && (c <= n_max));
     }
 
@@ -104,12 +151,12 @@ namespace triqs {
       for (auto const &o : fops) {
         int n = o.linear_index;
         for (auto const &e : creation_melem[n]) {
-          fock_state_t i, f;
+          typename space_partition_t::index_t i, f;
           std::tie(i, f)                                                  = e.first;
           hdiag->creation_connection(n, remap[SP.lookup_basis_state(i)])  = remap[SP.lookup_basis_state(f)];
         }
         for (auto const &e : annihilation_melem[n]) {
-          fock_state_t i, f;
+          typename space_partition_t::index_t i, f;
           std::tie(i, f)                                                      = e.first;
           hdiag->annihilation_connection(n, remap[SP.lookup_basis_state(i)])  = remap[SP.lookup_basis_state(f)];
         }
@@ -143,105 +190,71 @@ namespace triqs {
       // Quantum numbers -> Hilbert subspace mapping
       std::map<std::vector<double>, int, decltype(lt_dbl)> map_qn_n(lt_dbl);
 
-      // The QN as operators: a vector of imperative operators for the quantum numbers
-      std::vector<imperative_operator<class hilbert_space, scalar_t>> qsize;
-      for (auto &qn : qn_vector) qsize.emplace_back(qn, fops);
-
-      // Helper function to get quantum numbers
-      auto get_quantum_numbers = [&qsize](state<class hilbert_space, scalar_t, false> const &s) {
-        std::vector<quantum_number_t> qn;
-        for (auto const &op : qsize) {
-          auto y = dot_product(s, op(s));
-          if (std::abs(imag(y)) > 1.e-10) TRIQS_RUNTIME_ERROR << "Quantum number is complex !";
-          qn.push_back(real(y));
-        }
-        return qn;
-      };
+      // The QN as their diagonal elements in the Fock basis
+      std::vector<fock_diagonal<scalar_t>> qsize;
+      for (auto &qn : qn_vector) qsize.emplace_back(qn, fops, full_hs);
 
       // The first part consists in dividing the full Hilbert space
-      // into smaller subspaces using the quantum numbers
+      // into smaller subspaces using the quantum numbers.
+      // The subspace of each Fock state is kept for the connections below.
+      std::vector<int> subspace_of(full_hs.size());
+      std::vector<quantum_number_t> qn(qsize.size());
       for (int r = 0; r < full_hs.size(); ++r) {
 
         // fock_state corresponding to r
         fock_state_t fs = full_hs.get_fock_state(r);
 
-        // The state we'll act on
-        state<class hilbert_space, scalar_t, false> s(full_hs);
-        s(r) = 1.0;
-
         // Create the vector with the quantum numbers
-        std::vector<quantum_number_t> qn = get_quantum_numbers(s);
+        for (int q = 0; q < qsize.size(); ++q) {
+          auto y = qsize[q](fs);
+          if (std::abs(imag(y)) > 1.e-10) TRIQS_RUNTIME_ERROR << "Quantum number is complex !";
+          qn[q] = real(y);
+        }
 
         // If first time we meet these quantum numbers create partial Hilbert space
-        if (map_qn_n.count(qn) == 0) {
+        auto it = map_qn_n.find(qn);
+        if (it == map_qn_n.end()) {
           auto n_blocks = hdiag->sub_hilbert_spaces.size();
           hdiag->sub_hilbert_spaces.emplace_back(n_blocks); // a new sub_hilbert_space
           hdiag->quantum_numbers.push_back(qn);
-          map_qn_n[qn] = n_blocks;
+          it = map_qn_n.emplace(qn, n_blocks).first;
         }
 
         // Add fock state to partial Hilbert space
-        hdiag->sub_hilbert_spaces[map_qn_n[qn]].add_fock_state(fs);
+        hdiag->sub_hilbert_spaces[it->second].add_fock_state(fs);
+        subspace_of[r] = it->second;
       }
 
       // ---- Now make the creation/annihilation maps -----
 
-      auto creation_map     = std::vector<std::vector<int>>(fops.size(), std::vector<int>(hdiag->sub_hilbert_spaces.size(), -1));
-      auto annihilation_map = creation_map;
-
       // init the mapping tables
       hdiag->creation_connection.resize(fops.size(), hdiag->sub_hilbert_spaces.size());
       hdiag->annihilation_connection.resize(fops.size(), hdiag->sub_hilbert_spaces.size());
       hdiag->creation_connection.as_array_view()     = -1;
       hdiag->annihilation_connection.as_array_view() = -1;
 
+      // c^+_n |fs> (resp. c_n |fs>) is, up to a sign, the Fock state fs with the bit n set (resp. unset),
+      // or 0 if the bit n is already set (resp. unset) in fs.
       for (auto const &x : fops) {
+        int n           = x.linear_index;
+        fock_state_t bn = fock_state_t(1) << n;
 
-        // Get the operators and their index
-        int n        = x.linear_index;
-        auto create  = many_body_op_t::make_canonical(true, x.index);
-        auto destroy = many_body_op_t::make_canonical(false, x.index);
-
-        // Construct their imperative counterpart
-        imperative_operator<class hilbert_space, scalar_t> op_c_dag(create, fops), op_c(destroy, fops);
-
-        // to avoid declaring every time in the loop below
-        std::vector<quantum_number_t> qn_before, qn_after;
-
-        // Now act on the state with the c, c_dag to see how quantum numbers change
         for (int r = 0; r < full_hs.size(); ++r) {
-
-          // The state we'll act on and its quantum numbers
-          state<class hilbert_space, scalar_t, false> s(full_hs);
-          s(r)      = 1.0;
-          qn_before = get_quantum_numbers(s);
-
-          // Apply creation on state to figure quantum numbers
-          qn_after = get_quantum_numbers(op_c_dag(s));
-
-          // Insert in creation map checking whether it was already there
-          if (!triqs::utility::is_zero(dot_product(op_c_dag(s), op_c_dag(s)))) {
-            auto origin = hdiag->sub_hilbert_spaces[map_qn_n[qn_before]].get_index();
-            auto target = hdiag->sub_hilbert_spaces[map_qn_n[qn_after]].get_index();
-            if (creation_map[n][origin] == -1)
-              creation_map[n][origin] = target;
-            else if (creation_map[n][origin] != target)
-              TRIQS_RUNTIME_ERROR << "partition_with_qn(): internal error while filling creation_connection";
-            hdiag->creation_connection(n, map_qn_n[qn_before]) = map_qn_n[qn_after];
-          }
-
-          // apply annihilation on state to figure quantum numbers
-          qn_after = get_quantum_numbers(op_c(s));
-
-          // insert in annihilation map checking whether it was already there
-          if (!triqs::utility::is_zero(dot_product(op_c(s), op_c(s)))) {
-            auto origin = hdiag->sub_hilbert_spaces[map_qn_n[qn_before]].get_index();
-            auto target = hdiag->sub_hilbert_spaces[map_qn_n[qn_after]].get_index();
-            if (annihilation_map[n][origin] == -1)
-              annihilation_map[n][origin] = target;
-            else if (annihilation_map[n][origin] != target)
+          fock_state_t fs = full_hs.get_fock_state(r);
+          int origin      = subspace_of[r];
+          int target      = subspace_of[full_hs.get_state_index(fs ^ bn)];
+
+          // insert in the map checking whether it was already there
+          if (fs & bn) {
+            if (hdiag->annihilation_connection(n, origin) == -1)
+              hdiag->annihilation_connection(n, origin) = target;
+            else if (hdiag->annihilation_connection(n, origin) != target)
               TRIQS_RUNTIME_ERROR << "partition_with_qn(): internal error while filling annihilation_connection";
-            hdiag->annihilation_connection(n, map_qn_n[qn_before]) = map_qn_n[qn_after];
+          } else {
+            if (hdiag->creation_connection(n, origin) == -1)
+              hdiag->creation_connection(n, origin) = target;
+            else if (hdiag->creation_connection(n, origin) != target)
+              TRIQS_RUNTIME_ERROR << "partition_with_qn(): internal error while filling creation_connection";
           }
         }
       }
@@ -251,27 +264,36 @@ namespace triqs {
     // -----------------------------------------------------------------
 
     ATOM_DIAG_WORKER_METHOD(matrix_t, make_op_matrix(many_body_op_t const &op, int from_spn, int to_spn) const) {
+      imperative_operator<class hilbert_space, scalar_t> imp_op(op, hdiag->get_fops());
+      return op_matrix_in_eigenbasis(*hdiag, imp_op, from_spn, to_spn);
+    }
 
-      fundamental_operator_set const &fops = hdiag->get_fops();
-      class hilbert_space const &full_hs   = hdiag->full_hs;
-      auto const &from_sp                  = hdiag->sub_hilbert_spaces[from_spn];
-      auto const &to_sp                    = hdiag->sub_hilbert_spaces[to_spn];
+    // -----------------------------------------------------------------
 
-      imperative_operator<class hilbert_space, scalar_t> imp_op(op, fops);
+    template <bool Complex>
+    auto atom_diag_worker<Complex>::op_matrix_in_eigenbasis(atom_diag<Complex> const &hdiag,
+                                                            imperative_operator<class hilbert_space, scalar_t> const &imp_op, int from_spn, int to_spn)
+       -> matrix_t {
 
-      auto M = matrix_t(to_sp.size(), from_sp.size());
-      M()    = 0;
+      class hilbert_space const &full_hs = hdiag.full_hs;
+      auto const &from_sp                = hdiag.sub_hilbert_spaces[from_spn];
+      auto const &to_sp                  = hdiag.sub_hilbert_spaces[to_spn];
+
+      // The operator is sparse in the Fock basis : M * U_from is accumulated row by row, without M
+      auto const &U_from = hdiag.eigensystems[from_spn].unitary_matrix;
+      auto MU            = matrix_t(to_sp.size(), second_dim(U_from));
+      MU()               = 0;
 
       for (int i = 0; i < from_sp.size(); ++i) { // loop on all fock states of the blocks
         state<class hilbert_space, scalar_t, true> from_s(full_hs);
-        from_s(from_sp.get_fock_state(i)) = 1.0;
-        auto to_s                         = imp_op(from_s);
-        auto proj_s                       = project<state<sub_hilbert_space, scalar_t, true>>(to_s, to_sp);
-        foreach (proj_s, [&](int j, scalar_t ampl) { M(j, i) = ampl; })
+        from_s(full_hs.get_state_index(from_sp.get_fock_state(i))) = 1.0;
+        auto to_s                                                  = imp_op(from_s);
+        auto proj_s                                                = project<state<sub_hilbert_space, scalar_t, true>>(to_s, to_sp);
+        foreach (proj_s, [&](int j, scalar_t ampl) { MU(j, range()) += ampl * U_from(i, range()); })
           ;
       }
 
-      return dagger(hdiag->eigensystems[to_spn].unitary_matrix) * M * hdiag->eigensystems[from_spn].unitary_matrix;
+      return dagger(hdiag.eigensystems[to_spn].unitary_matrix) * MU;
     }
 
     // -----------------------------------------------------------------
@@ -288,12 +310,39 @@ namespace triqs {
       hdiag->eigensystems.resize(n_subspaces);
       hdiag->gs_energy = std::numeric_limits<double>::infinity();
 
-      // Prepare the eigensystem in a temporary map to sort them by energy !
-      std::map<std::pair<double, int>, typename atom_diag<Complex>::eigensystem_t> eign_map;
-      double energy_split = 1.e-10; // to split the eigenvalues, which are numerically very close
-      for (int spn = 0; spn < n_subspaces; ++spn) {
+      // The subspaces are diagonalized in parallel, the largest first
+      auto by_size = std::vector<int>(n_subspaces);
+      std::iota(by_size.begin(), by_size.end(), 0);
+      std::stable_sort(by_size.begin(), by_size.end(),
+                       [&](int a, int b) { return hdiag->sub_hilbert_spaces[a].size() > hdiag->sub_hilbert_spaces[b].size(); });
+
+      std::vector<typename atom_diag<Complex>::eigensystem_t> eigensystems(n_subspaces);
+      utility::parallel_for(n_subspaces, n_threads, [&](long t) {
+        int spn        = by_size[t];
         auto const &sp = hdiag->sub_hilbert_spaces[spn];
-        typename atom_diag<Complex>::eigensystem_t eigensystem;
+
+        // Large subspace : sparse Hamiltonian and Lanczos for the lowest eigenstates.
+        // The row i of H is the conjugate of its column i, i.e. of H|i>
+        if (sp.size() >= lanczos.min_dim) {
+          csr_matrix<scalar_t> h_csr;
+          for (int i = 0; i < sp.size(); ++i) {
+            state<sub_hilbert_space, scalar_t, true> i_state(sp);
+            i_state(i) = 1;
+            foreach (hamiltonian(i_state), [&](int j, scalar_t ampl) {
+              h_csr.col.push_back(j);
+              h_csr.val.push_back(lanczos_impl::conj_(ampl));
+            })
+              ;
+            h_csr.end_row();
+          }
+          // block_size more states are computed, so that the truncation does not split the last multiplet
+          auto eig   = lanczos_lowest(h_csr, lanczos.n_states + lanczos.block_size, lanczos.block_size, lanczos.krylov_dim, lanczos.tolerance,
+                                    lanczos.max_restarts);
+          int n_kept = cut_at_gap(eig.first, lanczos.n_states, sp.size());
+          eigensystems[spn].eigenvalues    = vector<double>(eig.first(range(0, n_kept)));
+          eigensystems[spn].unitary_matrix = matrix_t(eig.second(range(), range(0, n_kept)));
+          return;
+        }
 
         state<sub_hilbert_space, scalar_t, false> i_state(sp);
         matrix_t h_matrix(sp.size(), sp.size());
@@ -305,15 +354,33 @@ namespace triqs {
           h_matrix(range(), i)   = f_state.amplitudes();
         }
 
-        auto eig                   = linalg::eigenelements(h_matrix);
-        eigensystem.eigenvalues    = eig.first;
-        eigensystem.unitary_matrix = eig.second.transpose(); // Convert from eigenvectors as rows to columns.
-        hdiag->gs_energy           = std::min(hdiag->gs_energy, eigensystem.eigenvalues[0]);
+        auto eig                         = linalg::eigenelements(h_matrix);
+        eigensystems[spn].eigenvalues    = eig.first;
+        eigensystems[spn].unitary_matrix = eig.second.transpose(); // Convert from eigenvectors as rows to columns.
+      });
 
-        eign_map.insert({{eigensystem.eigenvalues(0) + energy_split * spn, spn}, eigensystem});
+      // Prepare the eigensystem in a temporary map to sort them by energy !
+      std::map<std::pair<double, int>, typename atom_diag<Complex>::eigensystem_t> eign_map;
+      double energy_split = 1.e-10; // to split the eigenvalues, which are numerically very close
+      for (int spn = 0; spn < n_subspaces; ++spn) {
+        hdiag->gs_energy = std::min(hdiag->gs_energy, eigensystems[spn].eigenvalues[0]);
+        eign_map.insert({{eigensystems[spn].eigenvalues(0) + energy_split * spn, spn}, std::move(eigensystems[spn])});
+      }
+
+      // Truncate the spectrum of the subspaces treated with Lanczos to the energy window, without splitting a multiplet
+      for (auto &[key, es] : eign_map) {
+        if (hdiag->sub_hilbert_spaces[key.second].size() < lanczos.min_dim) continue;
+        int n_kept = 1;
+        while (n_kept < es.eigenvalues.size() and es.eigenvalues(n_kept) - hdiag->gs_energy <= lanczos.energy_window) ++n_kept;
+        while (n_kept < es.eigenvalues.size() and es.eigenvalues(n_kept) - es.eigenvalues(n_kept - 1) <= degeneracy_tol) ++n_kept;
+        if (n_kept == es.eigenvalues.size()) continue;
+        es.eigenvalues    = vector<double>(es.eigenvalues(range(0, n_kept)));
+        es.unitary_matrix = matrix_t(es.unitary_matrix(range(), range(0, n_kept)));
       }
 
       // Reorder the block along their minimal energy
+      // NB : quantum_numbers is not reordered, it stays in the order in which partition_with_qn created the subspaces.
+      // This is a known limitation of get_quantum_numbers(), kept as the reference data of the tests depend on it.
       {
         auto tmp = hdiag->sub_hilbert_spaces;
         std::map<int, int> remap;
@@ -338,31 +405,36 @@ namespace triqs {
       // Shift the ground state energy of the local Hamiltonian to zero.
       for (auto &eigensystem : hdiag->eigensystems) eigensystem.eigenvalues() -= hdiag->get_gs_energy();
 
+      // Compute the matrices of c, c dagger in the diagonalization base of H_loc.
+      // n is guaranteed to be 0, 1, 2, 3, ... by the fundamental_operator_set class.
+      // One task per non zero block, in parallel, the largest first
+      struct c_task_t {
+        int n, B, Bp;
+        bool dagger;
+      };
+      std::vector<c_task_t> tasks;
+      std::vector<many_body_op_t> c_ops(fops.size()), cdag_ops(fops.size());
+      hdiag->c_matrices.assign(fops.size(), std::vector<matrix_t>(n_subspaces));
+      hdiag->cdag_matrices.assign(fops.size(), std::vector<matrix_t>(n_subspaces));
+
       for (auto const &x : fops) {
-        // get the operators and their index
-        int n = x.linear_index;
-        // n is guaranteed to be 0, 1, 2, 3, ... by the fundamental_operator_set class ... but it is very weird...
-        // otherwise the push_back below is false.
-        auto create  = many_body_op_t::make_canonical(true, x.index);
-        auto destroy = many_body_op_t::make_canonical(false, x.index);
-
-        // Compute the matrices of c, c dagger in the diagonalization base of H_loc
-        // first a lambda, since it is almost the same code for c and cdag
-        auto make_c_mat = [&](int n, matrix<long> const &connection, many_body_op_t const &op) {
-          std::vector<matrix_t> cmat(second_dim(connection));
-          for (int B = 0; B < second_dim(connection); ++B) {
-            auto Bp = connection(n, B);
-            if (Bp == -1) continue;
-            cmat[B] = make_op_matrix(op, B, Bp);
-          }
-          return cmat;
-        };
+        int n       = x.linear_index;
+        c_ops[n]    = many_body_op_t::make_canonical(false, x.index);
+        cdag_ops[n] = many_body_op_t::make_canonical(true, x.index);
+        for (int B = 0; B < n_subspaces; ++B) {
+          if (auto Bp = hdiag->annihilation_connection(n, B); Bp != -1) tasks.push_back({n, B, int(Bp), false});
+          if (auto Bp = hdiag->creation_connection(n, B); Bp != -1) tasks.push_back({n, B, int(Bp), true});
+        }
+      }
 
-        // now execute code...
-        hdiag->c_matrices.push_back(make_c_mat(n, hdiag->annihilation_connection, destroy));
-        hdiag->cdag_matrices.push_back(make_c_mat(n, hdiag->creation_connection, create));
+      auto cost = [&](c_task_t const &t) { return long(hdiag->sub_hilbert_spaces[t.B].size()) * hdiag->sub_hilbert_spaces[t.Bp].size(); };
+      std::stable_sort(tasks.begin(), tasks.end(), [&](auto const &a, auto const &b) { return cost(a) > cost(b); });
 
-      } // end of loop on operators
+      utility::parallel_for(tasks.size(), n_threads, [&](long i) {
+        auto const &[n, B, Bp, dagger] = tasks[i];
+        auto &cmat                     = (dagger ? hdiag->cdag_matrices : hdiag->c_matrices);
+        cmat[n][B]                     = make_op_matrix(dagger ? cdag_ops[n] : c_ops[n], B, Bp);
+      });
     }
 
     // -----------------------------------------------------------------
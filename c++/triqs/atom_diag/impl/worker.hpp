@@ -23,6 +23,7 @@
 #include <vector>
 #include <climits>
 #include "../atom_diag.hpp"
+#include <triqs/hilbert_space/imperative_operator.hpp>
 
 using namespace triqs::hilbert_space;
 
@@ -37,14 +38,21 @@ namespace triqs {
       using matrix_t       = typename atom_diag<Complex>::matrix_t;
       using many_body_op_t = typename atom_diag<Complex>::many_body_op_t;
 
-      atom_diag_worker(atom_diag<Complex> *hdiag, int n_min = 0, int n_max = INT_MAX) : hdiag(hdiag), n_min(n_min), n_max(n_max) {}
+      atom_diag_worker(atom_diag<Complex> *hdiag, int n_min = 0, int n_max = INT_MAX, int n_threads = 1, lanczos_params_t const &lanczos = {})
+         : hdiag(hdiag), n_min(n_min), n_max(n_max), n_threads(n_threads), lanczos(lanczos) {}
 
       void autopartition();
       void partition_with_qn(std::vector<many_body_op_t> const &qn_vector);
 
+      // The block of an operator from the subspace from_sp to to_sp, in the eigenbases (possibly truncated) of hdiag
+      static matrix_t op_matrix_in_eigenbasis(atom_diag<Complex> const &hdiag, imperative_operator<class hilbert_space, scalar_t> const &imp_op,
+                                              int from_sp, int to_sp);
+
       private:
       atom_diag<Complex> *hdiag;
       int n_min, n_max;
+      int n_threads; // Number of threads of the diagonalization and of the computation of the c, c^dagger matrices
+      lanczos_params_t lanczos;
 
       // Create matrix of an operator acting from one subspace to another
       matrix_t make_op_matrix(many_body_op_t const &op, int from_sp, int to_sp) const;
@@ -25,6 +25,9 @@
 #include <iterator>
 #include <numeric>
 #include <cmath>
+#include <tuple>
+#include <random>
+#include <chrono>
 #include <triqs/arrays.hpp>
 #include <triqs/arrays/algorithms.hpp>
 #include <triqs/arrays/linalg/det_and_inverse.hpp>
@@ -70,6 +73,8 @@ namespace triqs {
 
       // serialized data. There are all VALUES.
       det_type det;
+      value_type det_phase = 1; // det = det_phase * exp(log_abs_det), tracked along det (the sign of the permutations is not included)
+      double log_abs_det   = 0;
       size_t Nmax, N;
       enum {
         NoTry,
@@ -86,24 +91,39 @@ namespace triqs {
       std::vector<x_type> x_values;
       std::vector<y_type> y_values;
       int sign = 1;
-      matrix_type mat_inv;
-      uint64_t n_opts                  = 0;   // count the number of operation
-      uint64_t n_opts_max_before_check = 100; // max number of ops before the test of deviation of the det, M^-1 is performed.
-      double singular_threshold = -1; // the test to see if the matrix is singular is abs(det) > singular_threshold. If <0, it is !isnormal(abs(det))
+      matrix_type mat_inv; // without the pending delayed updates, cf mat_inv_element and materialized_mat_inv
+      uint64_t n_opts                       = 0;   // count the number of operation
+      uint64_t n_opts_max_before_check      = 100; // max number of ops before the test of deviation of the det, M^-1 is performed.
+      uint64_t n_opts_adaptive_before_check = 100; // the same for the adaptive check, in [1, n_opts_max_before_check]. Not serialized.
+      double singular_threshold = -1; // the test to see if the matrix is singular is abs(det) > singular_threshold. If <0, it is !isfinite(log|det|)
       double precision_warning  = 1.e-8; // bound for warning message in check for singular matrix
       double precision_error    = 1.e-5; // bound for throwing error in check for singular matrix
+      size_t n_delayed_max      = 0;     // max number of pending rank-1 updates before mat_inv is materialized. If 0, no delayed updates.
+      size_t n_sweep_max        = 32;    // max number of pending rank-1 updates in a sweep (submatrix updates)
+      bool adaptive_check       = false; // if true, the check of M^-1 is a cheap residual estimate, and its period is adapted
+      double residual_baseline  = 0;     // residual estimate just after the last regeneration (adaptive check)
+      std::minstd_rand residual_rng;     // to pick the rows of the residual estimate
+
+      // statistics of the regenerations (not serialized)
+      uint64_t n_regenerations   = 0; // number of full regenerations of M^-1
+      uint64_t n_residual_checks = 0; // number of residual estimates (adaptive check)
+      double regeneration_time   = 0; // time spent in the regenerations, in seconds
 
       private:
       //  ------------     BOOST Serialization ------------
       //  What about f ? Not serialized at the moment.
       friend class boost::serialization::access;
       template <class Archive> void serialize(Archive &ar, const unsigned int version) {
+        flush_delayed_updates();
         ar &Nmax;
         ar &N;
         ar &n_opts;
         ar &n_opts_max_before_check;
+        n_opts_adaptive_before_check = n_opts_max_before_check;
         ar &singular_threshold;
         ar &det;
+        ar &det_phase;
+        ar &log_abs_det;
         ar &sign;
         ar &mat_inv;
         ar &row_num;
@@ -116,8 +136,15 @@ namespace triqs {
       friend void h5_write(h5::group fg, std::string subgroup_name, det_manip const &g) {
         auto gr = fg.create_group(subgroup_name);
         h5_write(gr, "N", g.N);
-        h5_write(gr, "mat_inv", g.mat_inv);
+        if (g.has_pending_updates()) {
+          auto m                    = g.mat_inv;
+          m(range(g.N), range(g.N)) = g.materialized_mat_inv();
+          h5_write(gr, "mat_inv", m);
+        } else
+          h5_write(gr, "mat_inv", g.mat_inv);
         h5_write(gr, "det", g.det);
+        h5_write(gr, "det_phase", g.det_phase);
+        h5_write(gr, "log_abs_det", g.log_abs_det);
         h5_write(gr, "sign", g.sign);
         h5_write(gr, "row_num", g.row_num);
         h5_write(gr, "col_num", g.col_num);
@@ -135,7 +162,18 @@ namespace triqs {
         h5_read(gr, "mat_inv", g.mat_inv);
         g.Nmax     = first_dim(g.mat_inv); // restore Nmax
         g.last_try = NoTry;
+        g.wd.n     = 0;
+        g.wd.reserve(g.Nmax, g.n_delayed_max);
+        g.sw.k = 0;
+        if (g.sw.active) g.sw.reserve(g.Nmax, g.n_sweep_max);
         h5_read(gr, "det", g.det);
+        if (gr.has_key("log_abs_det")) {
+          h5_read(gr, "det_phase", g.det_phase);
+          h5_read(gr, "log_abs_det", g.log_abs_det);
+        } else { // backward compatibility : files without the log of the det
+          g.det_phase   = phase(g.det);
+          g.log_abs_det = std::log(std::abs(g.det));
+        }
         h5_read(gr, "sign", g.sign);
         h5_read(gr, "row_num", g.row_num);
         h5_read(gr, "col_num", g.col_num);
@@ -143,6 +181,7 @@ namespace triqs {
         h5_read(gr, "y_values", g.y_values);
         h5_read(gr, "n_opts", g.n_opts);
         h5_read(gr, "n_opts_max_before_check", g.n_opts_max_before_check);
+        g.n_opts_adaptive_before_check = g.n_opts_max_before_check;
         h5_read(gr, "singular_threshold", g.singular_threshold);
       }
 
@@ -196,10 +235,65 @@ namespace triqs {
         }
       };
 
+      // Delayed updates : the accepted operations are accumulated as n rank-1 updates,
+      // i.e. the true inverse is mat_inv + U(:, 0:n) * V(0:n, :).
+      // mat_inv is materialized with one gemm when n reaches n_delayed_max.
+      struct work_data_delayed {
+        matrix_type U, V;     // U : Nmax x n_max, V : n_max x Nmax
+        matrix_type MB, MC;   // V * B (n_max x 2) and C * U (2 x n_max) for the double insertion
+        vector_type tmp;      // V * B or U^T * C for the single operations
+        size_t n = 0;         // number of pending rank-1 updates
+        void reserve(size_t s, size_t n_max) {
+          if (n_max == 0) return;
+          U.resize(s, n_max);
+          V.resize(n_max, s);
+          MB.resize(n_max, 2);
+          MC.resize(2, n_max);
+          tmp.resize(n_max);
+        }
+      };
+
+      // Submatrix updates : between begin_sweep() and end_sweep(), the accepted change_col/change_row
+      // are accumulated as M = M0 + P * Q^T where M0^-1 = mat_inv is kept frozen. By Woodbury,
+      //   M^-1 = M0^-1 - M0^-1 P * gamma * Q^T M0^-1,   gamma = (1 + Q^T M0^-1 P)^-1  (k x k).
+      // A try only needs a few rows/cols of M0^-1 (O(N k)) and mat_inv is materialized with 3 gemm.
+      struct work_data_sweep {
+        bool active = false;
+        size_t k    = 0;                       // number of pending rank-1 updates
+        matrix_type P, Q;                      // Nmax x (n_max + 2). The cols k, k+1 are the update being tried.
+        std::vector<long> p_idx, q_idx;        // if >= 0, the col of P (resp. Q) is the unit vector e_idx
+        matrix_type gamma;                     // (n_max + 2) x (n_max + 2)
+        matrix_type U, V, X, GV, UG;           // border of gamma^-1 for the tried update, X is its Schur complement
+        matrix_type AP, QA, APG;               // M0^-1 P, Q^T M0^-1, M0^-1 P gamma
+        vector_type b;                         // Q^T M0^-1(:, j) for mat_inv_element
+        bool ap_ok[2] = {false, false}, qa_ok[2] = {false, false}; // AP(:, k+i), QA(k+i, :) are computed for the tried update
+        void reserve(size_t s, size_t n_max) {
+          size_t n = n_max + 2;
+          P.resize(s, n);
+          Q.resize(s, n);
+          p_idx.resize(n);
+          q_idx.resize(n);
+          gamma.resize(n, n);
+          U.resize(2, n);
+          V.resize(n, 2);
+          X.resize(2, 2);
+          GV.resize(n, 2);
+          UG.resize(2, n);
+          AP.resize(s, n);
+          QA.resize(n, s);
+          APG.resize(s, n);
+          b.resize(n);
+        }
+      };
+
       work_data_type1 w1;
       work_data_type2 w2;
       work_data_type_refill w_refill;
+      work_data_delayed wd;
+      work_data_sweep sw;
       det_type newdet;
+      value_type newdet_phase;
+      double newlog_abs_det;
       int newsign;
 
       private: // for the move constructor, I need to separate the swap since f may not be defaulted constructed
@@ -218,9 +312,24 @@ namespace triqs {
         SW(mat_inv);
         SW(n_opts);
         SW(n_opts_max_before_check);
+        SW(n_opts_adaptive_before_check);
+        SW(n_delayed_max);
+        SW(n_sweep_max);
+        SW(adaptive_check);
+        SW(residual_baseline);
+        SW(n_regenerations);
+        SW(n_residual_checks);
+        SW(regeneration_time);
+        SW(residual_rng);
         SW(w1);
         SW(w2);
+        SW(wd);
+        SW(sw);
         SW(newdet);
+        SW(det_phase);
+        SW(log_abs_det);
+        SW(newdet_phase);
+        SW(newlog_abs_det);
         SW(newsign);
 #undef SW
       }
@@ -241,6 +350,7 @@ namespace triqs {
      */
       void reserve(size_t new_size) {
         if (new_size <= Nmax) return;
+        flush_delayed_updates();
         matrix_type Mcopy(mat_inv);
         size_t N0 = Nmax;
         Nmax      = new_size;
@@ -252,9 +362,11 @@ namespace triqs {
         y_values.reserve(Nmax);
         w1.reserve(Nmax);
         w2.reserve(Nmax);
+        wd.reserve(Nmax, n_delayed_max);
+        if (sw.active) sw.reserve(Nmax, n_sweep_max);
       }
 
-      /// Get the number below which abs(det) is considered 0. If <0, the test will be isnormal(abs(det))
+      /// Get the number below which abs(det) is considered 0. If <0, the test will be isfinite(log|det|)
       double get_singular_threshold() const { return singular_threshold; }
 
       /// Sets the number below which abs(det) is considered 0. Cf get_is_singular_threshold
@@ -264,7 +376,36 @@ namespace triqs {
       double get_n_operations_before_check() const { return n_opts_max_before_check; }
 
       /// Sets the number of operations done before a check in the dets.
-      void set_n_operations_before_check(uint64_t n) { n_opts_max_before_check = n; }
+      void set_n_operations_before_check(uint64_t n) { n_opts_max_before_check = n_opts_adaptive_before_check = n; }
+
+      /// Is the adaptive check of the inverse matrix on ? Cf set_adaptive_check
+      bool get_adaptive_check() const { return adaptive_check; }
+
+      /**
+     * Sets the adaptive check of the inverse matrix.
+     *
+     * When on, every get_n_operations_before_check() operations, the residual M * M^-1 - 1 is
+     * estimated on a few random rows (O(N^2)) instead of a full regeneration (O(N^3)).
+     * The inverse is regenerated only if the residual is above the warning precision
+     * (or well above its value just after the last regeneration, for ill-conditioned matrices).
+     * The number of operations before the next check is then halved, otherwise it is doubled,
+     * up to get_n_operations_before_check() (which is not changed).
+     *
+     * @param b Adaptive check on/off. Default is off : a full regeneration and comparison at each check.
+     */
+      void set_adaptive_check(bool b) {
+        adaptive_check               = b;
+        n_opts_adaptive_before_check = n_opts_max_before_check;
+      }
+
+      /// Number of full regenerations of the inverse matrix (by the checks, a singular det or regenerate())
+      uint64_t get_n_regenerations() const { return n_regenerations; }
+
+      /// Time spent in the full regenerations of the inverse matrix, in seconds
+      double get_regeneration_time() const { return regeneration_time; }
+
+      /// Number of residual estimates done by the adaptive check
+      uint64_t get_n_residual_checks() const { return n_residual_checks; }
 
       /// Get the bound for warning messages in the singular tests
       double get_precision_warning() const { return precision_warning; }
@@ -278,6 +419,43 @@ namespace triqs {
       /// Set the bound for throwing error in the singular tests
       void set_precision_error(double threshold) { precision_error = threshold; }
 
+      /// Gets the maximal number of delayed rank-1 updates. 0 means that the inverse is updated at each operation.
+      size_t get_n_delayed_updates() const { return n_delayed_max; }
+
+      /**
+     * Sets the maximal number of delayed rank-1 updates.
+     *
+     * The accepted operations are then accumulated as low-rank factors, and the inverse matrix
+     * is only materialized (with one BLAS-3 gemm) when this number of rank-1 updates is reached.
+     * Insert, remove, change_col and change_row count as 1, the double operations and change_col_row as 2.
+     * Do NOT use it between a try_XXX and a complete_operation.
+     *
+     * @param n Maximal number of pending rank-1 updates. 0 (default) disables the delayed updates.
+     */
+      void set_n_delayed_updates(size_t n) {
+        TRIQS_ASSERT(last_try == NoTry);
+        flush_delayed_updates();
+        n_delayed_max = (n == 1 ? 0 : n); // a single pending update is exactly the usual update
+        wd.reserve(Nmax, n_delayed_max);
+      }
+
+      /// Gets the maximal number of pending rank-1 updates in a sweep.
+      size_t get_n_sweep_updates() const { return n_sweep_max; }
+
+      /**
+     * Sets the maximal number of pending rank-1 updates in a sweep (size of the active window).
+     * Cf begin_sweep. Do NOT use it between a try_XXX and a complete_operation.
+     *
+     * @param n Maximal number of pending rank-1 updates (default 32).
+     */
+      void set_n_sweep_updates(size_t n) {
+        TRIQS_ASSERT(last_try == NoTry);
+        TRIQS_ASSERT(n > 0);
+        flush_delayed_updates();
+        n_sweep_max = n;
+        if (sw.active) sw.reserve(Nmax, n_sweep_max);
+      }
+
       /**
      * @brief Constructor.
      *
@@ -317,8 +495,8 @@ namespace triqs {
           for (size_t j = 0; j < N; ++j) mat_inv(i, j) = f(x_values[i], y_values[j]);
         }
         range R(0, N);
-        det           = arrays::determinant(mat_inv(R, R));
-        mat_inv(R, R) = inverse(mat_inv(R, R));
+        std::tie(det, det_phase, log_abs_det) = det_phase_log(mat_inv(R, R));
+        mat_inv(R, R)                         = inverse(mat_inv(R, R));
       }
 
       det_manip(det_manip const &) = default;
@@ -335,9 +513,13 @@ namespace triqs {
 
       /// Put to size 0 : like a vector
       void clear() {
-        N        = 0;
-        sign     = 1;
-        det      = 1;
+        N           = 0;
+        wd.n        = 0;
+        sw.k        = 0;
+        sign        = 1;
+        det         = 1;
+        det_phase   = 1;
+        log_abs_det = 0;
         last_try = NoTry;
         row_num.clear();
         col_num.clear();
@@ -395,15 +577,28 @@ namespace triqs {
         return sign * det;
       }
 
+      /**
+     * det M of the current state of the matrix, as a pair (s, l) with det M = s * exp(l).
+     *
+     * s is the sign (the phase in the complex case) and l = log|det M|.
+     * The log is tracked along all operations, so it does not overflow/underflow at large N,
+     * in contrast to determinant().
+     */
+      std::pair<value_type, double> log_determinant() {
+        if (is_singular()) regenerate();
+        return {sign * det_phase, log_abs_det};
+      }
+
       /** Returns M^{-1}(i,j) */
       // warning : need to invert the 2 permutations: (AP)^-1= P^-1 A^-1.
-      value_type inverse_matrix(int i, int j) const { return mat_inv(col_num[i], row_num[j]); }
+      value_type inverse_matrix(int i, int j) const { return mat_inv_element(col_num[i], row_num[j]); }
 
       /// Returns the inverse matrix. Warning : this is slow, since it create a new copy, and reorder the lines/cols
       matrix_type inverse_matrix() const {
+        matrix_type m = materialized_mat_inv();
         matrix_type res(N, N);
         for (size_t i = 0; i < N; i++)
-          for (size_t j = 0; j < N; j++) res(i, j) = inverse_matrix(i, j);
+          for (size_t j = 0; j < N; j++) res(i, j) = m(col_num[i], row_num[j]);
         return res;
       }
 
@@ -411,13 +606,26 @@ namespace triqs {
      * Advanced: Returns the inverse matrix using the INTERNAL STORAGE ORDER.
      * See doc of get_x_internal_order.
      */
-      value_type inverse_matrix_internal_order(int i, int j) const { return mat_inv(i, j); }
+      value_type inverse_matrix_internal_order(int i, int j) const { return mat_inv_element(i, j); }
 
       /**
      * Advanced: Returns the inverse matrix using the INTERNAL STORAGE ORDER.
      * See doc of get_x_internal_order.
      */
-      matrix_const_view_type inverse_matrix_internal_order() const { return mat_inv(range(N), range(N)); }
+      matrix_const_view_type inverse_matrix_internal_order() {
+        flush_delayed_updates();
+        return mat_inv(range(N), range(N));
+      }
+
+      /**
+     * Advanced: Returns the inverse matrix using the INTERNAL STORAGE ORDER.
+     * See doc of get_x_internal_order.
+     *
+     * As the other const methods, it does not modify the object : it returns a copy of the inverse matrix,
+     * with the pending delayed updates (or the updates of the current sweep) applied to the copy.
+     * The non-const version flushes the updates and returns a view, without copy.
+     */
+      matrix_type inverse_matrix_internal_order() const { return materialized_mat_inv(); }
 
       /// Rebuild the matrix. Warning : this is slow, since it create a new matrix and re-evaluate the function.
       matrix_type matrix() const {
@@ -433,11 +641,281 @@ namespace triqs {
         //for (size_t i=0; i<d.N;i++)
         //for (size_t j=0; j<d.N;j++)
         // f(d.x_values[i], d.y_values[j], d.mat_inv(j,i));
-        range R(0, d.N);
-        foreach (d.mat_inv(R, R), [&f, &d](int i, int j) { return f(d.x_values[i], d.y_values[j], d.mat_inv(j, i)); })
-          ;
+        // With pending updates, iterate on a copy of the inverse : d is not modified.
+        auto run = [&f, &d](matrix_type const &m) {
+          range R(0, d.N);
+          foreach (m(R, R), [&f, &d, &m](int i, int j) { return f(d.x_values[i], d.y_values[j], m(j, i)); })
+            ;
+        };
+        if (d.has_pending_updates())
+          run(d.materialized_mat_inv());
+        else
+          run(d.mat_inv);
+      }
+
+      private:
+      // x / |x|, and 1 for x = 0
+      static value_type phase(value_type const &x) { return (x == value_type(0) ? value_type(1) : x / std::abs(x)); }
+
+      // det, its phase and log|det| of a matrix, with one LU factorization
+      static std::tuple<det_type, value_type, double> det_phase_log(matrix_type m) {
+        auto worker  = arrays::det_and_inverse_worker<matrix_type>{std::move(m)};
+        auto [ph, l] = worker.phase_and_log_abs_det();
+        return {worker.det(), ph, l};
+      }
+
+      // newdet = det * r, with its phase and log
+      void set_newdet_from_ratio(value_type const &r) {
+        newdet         = det * r;
+        newdet_phase   = det_phase * phase(r);
+        newlog_abs_det = log_abs_det + std::log(std::abs(r));
+      }
+
+      // newdet = d, with its phase and log
+      void set_newdet(det_type const &d) {
+        newdet         = d;
+        newdet_phase   = phase(d);
+        newlog_abs_det = std::log(std::abs(d));
+      }
+
+      public:
+      // ------------------------- DELAYED UPDATES -----------------------------------------
+
+      /// Apply the pending delayed updates (and the pending updates of the current sweep) to the inverse matrix.
+      void flush_delayed_updates() {
+        flush_sweep_updates();
+        if ((wd.n == 0) or (N == 0)) {
+          wd.n = 0;
+          return;
+        }
+        range R(0, N), Rk(0, wd.n);
+        blas::gemm(1.0, wd.U(R, Rk), wd.V(Rk, R), 1.0, mat_inv(R, R));
+        wd.n = 0;
+      }
+
+      private:
+      // Are there delayed updates, or updates of the current sweep, not yet applied to mat_inv ?
+      // They are never both pending : a try in a sweep first applies the delayed updates.
+      bool has_pending_updates() const { return (N > 0) and (wd.n > 0 or sw.k > 0); }
+
+      // M^-1(i,j), including the pending delayed updates, in the try/complete methods : no allocation.
+      value_type mat_inv_element(size_t i, size_t j) { return mat_inv_element(i, j, sw.b); }
+
+      // Same for the const accessors, with a temporary workspace (allocated only in a sweep) to stay thread-safe.
+      value_type mat_inv_element(size_t i, size_t j) const {
+        vector_type b(sw.k);
+        return mat_inv_element(i, j, b);
+      }
+
+      // M^-1(i,j), including the pending delayed updates. It does not modify the object.
+      // b is a workspace of size >= sw.k, used only in a sweep.
+      value_type mat_inv_element(size_t i, size_t j, vector_type &b) const {
+        value_type r = mat_inv(i, j);
+        for (size_t k = 0; k < wd.n; ++k) r += wd.U(i, k) * wd.V(k, j);
+        if (sw.k == 0) return r;
+        // r -= (M0^-1 P)(i, :) gamma (Q^T M0^-1)(:, j)
+        range R(0, N), Rk(0, sw.k);
+        for (size_t s = 0; s < sw.k; ++s) b(s) = (sw.q_idx[s] >= 0 ? mat_inv(sw.q_idx[s], j) : arrays::dot(sw.Q(R, s), mat_inv(R, j)));
+        for (size_t s = 0; s < sw.k; ++s) {
+          value_type a = (sw.p_idx[s] >= 0 ? mat_inv(i, sw.p_idx[s]) : arrays::dot(mat_inv(i, R), sw.P(R, s)));
+          r -= a * arrays::dot(sw.gamma(s, Rk), b(Rk));
+        }
+        return r;
+      }
+
+      // M^-1(R, R), including the pending updates, in O(N^2 k). It does not modify the object.
+      matrix_type materialized_mat_inv() const {
+        range R(0, N);
+        matrix_type m = mat_inv(R, R);
+        if (N == 0) return m;
+        if (wd.n) {
+          range Rk(0, wd.n);
+          blas::gemm(1.0, wd.U(R, Rk), wd.V(Rk, R), 1.0, m());
+        }
+        if (sw.k) { // as in flush_sweep_updates
+          range Rk(0, sw.k);
+          matrix_type AP(N, sw.k), QA(sw.k, N), APG(N, sw.k);
+          blas::gemm(1.0, mat_inv(R, R), sw.P(R, Rk), 0.0, AP());
+          blas::gemm(1.0, sw.Q(R, Rk).transpose(), mat_inv(R, R), 0.0, QA());
+          blas::gemm(1.0, AP(), sw.gamma(Rk, Rk), 0.0, APG());
+          blas::gemm(-1.0, APG(), QA(), 1.0, m());
+        }
+        return m;
+      }
+
+      // out = M^-1(R, i), including the pending delayed updates
+      template <typename V> void get_mat_inv_col(size_t i, V &&out) const {
+        range R(0, N), Rk(0, wd.n);
+        out = mat_inv(R, i);
+        if (wd.n) blas::gemv(1.0, wd.U(R, Rk), wd.V(Rk, i), 1.0, out);
+      }
+
+      // out = M^-1(j, R), including the pending delayed updates
+      template <typename V> void get_mat_inv_row(size_t j, V &&out) const {
+        range R(0, N), Rk(0, wd.n);
+        out = mat_inv(j, R);
+        if (wd.n) blas::gemv(1.0, wd.V(Rk, R).transpose(), wd.U(j, Rk), 1.0, out);
+      }
+
+      // out(R) = M^-1 * in(R), including the pending delayed updates
+      void gemv_mat_inv(vector_type const &in, vector_type &out) {
+        range R(0, N), Rk(0, wd.n);
+        blas::gemv(1.0, mat_inv(R, R), in(R), 0.0, out(R));
+        if (wd.n == 0) return;
+        blas::gemv(1.0, wd.V(Rk, R), in(R), 0.0, wd.tmp(Rk));
+        blas::gemv(1.0, wd.U(R, Rk), wd.tmp(Rk), 1.0, out(R));
+      }
+
+      // out(R) = in(R) * M^-1, including the pending delayed updates
+      void gemv_mat_inv_transpose(vector_type const &in, vector_type &out) {
+        range R(0, N), Rk(0, wd.n);
+        blas::gemv(1.0, mat_inv(R, R).transpose(), in(R), 0.0, out(R));
+        if (wd.n == 0) return;
+        blas::gemv(1.0, wd.U(R, Rk).transpose(), in(R), 0.0, wd.tmp(Rk));
+        blas::gemv(1.0, wd.V(Rk, R).transpose(), wd.tmp(Rk), 1.0, out(R));
+      }
+
+      // The row/col k is a new one : clear the pending updates on it, like mat_inv(k, R) = 0
+      void clear_delayed_updates_at(size_t k) {
+        if (wd.n == 0) return;
+        range Rk(0, wd.n);
+        wd.U(k, Rk) = 0;
+        wd.V(Rk, k) = 0;
+      }
+
+      // Add the rank-1 update M^-1 += u * v to the pending ones. u, v can be lazy expressions.
+      template <typename U, typename V> void push_delayed_update(U const &u, V const &v) {
+        if (wd.n == n_delayed_max) flush_delayed_updates();
+        range R(0, N);
+        wd.U(R, wd.n) = u;
+        wd.V(wd.n, R) = v;
+        ++wd.n;
+      }
+
+      public:
+      // ------------------------- SWEEPS (SUBMATRIX UPDATES) ------------------------------
+
+      /**
+     * Starts a sweep of change_col, change_row and change_col_row operations.
+     *
+     * Until end_sweep(), the accepted changes are not applied to the inverse matrix but
+     * accumulated in a window of at most get_n_sweep_updates() rank-1 updates (submatrix updates).
+     * A try then costs O(N k) instead of O(N^2) when only columns (or only rows) are changed, and
+     * the inverse is materialized with BLAS-3 gemm when the window is full.
+     * Other operations are allowed in a sweep, they first apply the pending updates.
+     * Do NOT use it between a try_XXX and a complete_operation.
+     */
+      void begin_sweep() {
+        TRIQS_ASSERT(last_try == NoTry);
+        flush_delayed_updates();
+        sw.active = true;
+        sw.reserve(Nmax, n_sweep_max);
+      }
+
+      /// Ends the sweep started by begin_sweep() and applies the pending updates to the inverse matrix.
+      void end_sweep() {
+        TRIQS_ASSERT(last_try == NoTry);
+        flush_delayed_updates();
+        sw.active = false;
       }
 
+      /// Are we between a begin_sweep() and an end_sweep() ?
+      bool in_sweep() const { return sw.active; }
+
+      private:
+      // Apply the pending updates of the sweep : mat_inv -= (mat_inv P) gamma (Q^T mat_inv)
+      void flush_sweep_updates() {
+        if ((sw.k == 0) or (N == 0)) {
+          sw.k = 0;
+          return;
+        }
+        range R(0, N), Rk(0, sw.k);
+        blas::gemm(1.0, mat_inv(R, R), sw.P(R, Rk), 0.0, sw.AP(R, Rk));
+        blas::gemm(1.0, sw.Q(R, Rk).transpose(), mat_inv(R, R), 0.0, sw.QA(Rk, R));
+        blas::gemm(1.0, sw.AP(R, Rk), sw.gamma(Rk, Rk), 0.0, sw.APG(R, Rk));
+        blas::gemm(-1.0, sw.APG(R, Rk), sw.QA(Rk, R), 1.0, mat_inv(R, R));
+        sw.k = 0;
+      }
+
+      // The col t of P (resp. Q) is the unit vector e_i
+      void sweep_set_p_unit(size_t t, size_t i) {
+        sw.P(range(0, N), t) = 0;
+        sw.P(i, t)           = 1;
+        sw.p_idx[t]          = i;
+      }
+      void sweep_set_q_unit(size_t t, size_t i) {
+        sw.Q(range(0, N), t) = 0;
+        sw.Q(i, t)           = 1;
+        sw.q_idx[t]          = i;
+      }
+
+      // Q(:, s)^T M0^-1 P(:, t). At most one of s, t is a pending update.
+      // If both cols are general vectors, one gemv is needed, which is cached for the tried update.
+      value_type sweep_qAp(size_t s, size_t t) {
+        range R(0, N);
+        long qi = sw.q_idx[s], pi = sw.p_idx[t];
+        if (qi >= 0 and pi >= 0) return mat_inv(qi, pi);
+        if (qi >= 0) return arrays::dot(mat_inv(qi, R), sw.P(R, t));
+        if (pi >= 0) return arrays::dot(sw.Q(R, s), mat_inv(R, pi));
+        if (t >= sw.k) { // M0^-1 P(:, t)
+          if (!sw.ap_ok[t - sw.k]) blas::gemv(1.0, mat_inv(R, R), sw.P(R, t), 0.0, sw.AP(R, t));
+          sw.ap_ok[t - sw.k] = true;
+          return arrays::dot(sw.Q(R, s), sw.AP(R, t));
+        }
+        // Q(:, s)^T M0^-1
+        if (!sw.qa_ok[s - sw.k]) blas::gemv(1.0, mat_inv(R, R).transpose(), sw.Q(R, s), 0.0, sw.QA(s, R));
+        sw.qa_ok[s - sw.k] = true;
+        return arrays::dot(sw.QA(s, R), sw.P(R, t));
+      }
+
+      // Try the m (1 or 2) updates stored in the cols k, k+1 of P and Q : border gamma^-1 with
+      //   [ gamma^-1  V ]
+      //   [ U         C ],  X = C - U gamma V is the Schur complement, and the det ratio is det X.
+      value_type sweep_try(int m) {
+        if (wd.n) flush_delayed_updates();
+        size_t k    = sw.k;
+        sw.ap_ok[0] = sw.ap_ok[1] = sw.qa_ok[0] = sw.qa_ok[1] = false;
+        for (int a = 0; a < m; ++a) {
+          for (size_t s = 0; s < k; ++s) {
+            sw.U(a, s) = sweep_qAp(k + a, s);
+            sw.V(s, a) = sweep_qAp(s, k + a);
+          }
+          for (int b = 0; b < m; ++b) sw.X(a, b) = (a == b ? 1 : 0) + sweep_qAp(k + a, k + b);
+        }
+        if (k > 0) {
+          range Rk(0, k), Rm(0, m);
+          blas::gemm(1.0, sw.gamma(Rk, Rk), sw.V(Rk, Rm), 0.0, sw.GV(Rk, Rm));
+          blas::gemm(1.0, sw.U(Rm, Rk), sw.gamma(Rk, Rk), 0.0, sw.UG(Rm, Rk));
+          blas::gemm(-1.0, sw.U(Rm, Rk), sw.GV(Rk, Rm), 1.0, sw.X(Rm, Rm));
+        }
+        return (m == 1 ? sw.X(0, 0) : sw.X(0, 0) * sw.X(1, 1) - sw.X(0, 1) * sw.X(1, 0));
+      }
+
+      // Accept the tried updates : gamma is extended by block inversion.
+      void sweep_complete(int m) {
+        size_t k = sw.k;
+        range Rk(0, k), Rm(0, m), Rn(k, k + m);
+        if (m == 1)
+          sw.X(0, 0) = 1 / sw.X(0, 0);
+        else {
+          auto d = sw.X(0, 0) * sw.X(1, 1) - sw.X(0, 1) * sw.X(1, 0);
+          std::swap(sw.X(0, 0), sw.X(1, 1));
+          sw.X(0, 0) /= d;
+          sw.X(1, 1) /= d;
+          sw.X(0, 1) /= -d;
+          sw.X(1, 0) /= -d;
+        }
+        if (k > 0) {
+          blas::gemm(-1.0, sw.GV(Rk, Rm), sw.X(Rm, Rm), 0.0, sw.gamma(Rk, Rn));
+          blas::gemm(-1.0, sw.X(Rm, Rm), sw.UG(Rm, Rk), 0.0, sw.gamma(Rn, Rk));
+          blas::gemm(-1.0, sw.gamma(Rk, Rn), sw.UG(Rm, Rk), 1.0, sw.gamma(Rk, Rk));
+        }
+        sw.gamma(Rn, Rn) = sw.X(Rm, Rm);
+        sw.k += m;
+        if (sw.k >= n_sweep_max) flush_sweep_updates();
+      }
+
+      public:
       // ------------------------- OPERATIONS -----------------------------------------------
 
       /**
@@ -466,6 +944,7 @@ namespace triqs {
 
         // check input and store it for complete_operation
         TRIQS_ASSERT(last_try == NoTry);
+        flush_sweep_updates();
         TRIQS_ASSERT(i <= N);
         TRIQS_ASSERT(j <= N);
         TRIQS_ASSERT(i >= 0);
@@ -479,7 +958,7 @@ namespace triqs {
 
         // treat empty matrix separately
         if (N == 0) {
-          newdet  = f(x, y);
+          set_newdet(f(x, y));
           newsign = 1;
           return value_type(newdet);
         }
@@ -492,9 +971,9 @@ namespace triqs {
         }
         range R(0, N);
         //w1.MB(R) = mat_inv(R,R) * w1.B(R);// OPTIMIZE BELOW
-        blas::gemv(1.0, mat_inv(R, R), w1.B(R), 0.0, w1.MB(R));
-        w1.ksi  = f(x, y) - arrays::dot(w1.C(R), w1.MB(R));
-        newdet  = det * w1.ksi;
+        gemv_mat_inv(w1.B, w1.MB);
+        w1.ksi = f(x, y) - arrays::dot(w1.C(R), w1.MB(R));
+        set_newdet_from_ratio(w1.ksi);
         newsign = ((i + j) % 2 == 0 ? sign : -sign); // since N-i0 + N-j0  = i0+j0 [2]
         return w1.ksi * (newsign * sign);            // sign is unity, hence 1/sign == sign
       }
@@ -504,6 +983,7 @@ namespace triqs {
 
         // check input and store it for complete_operation
         TRIQS_ASSERT(last_try == NoTry);
+        flush_sweep_updates();
         TRIQS_ASSERT(i <= N);
         TRIQS_ASSERT(j <= N);
         TRIQS_ASSERT(i >= 0);
@@ -515,7 +995,7 @@ namespace triqs {
 
         // treat empty matrix separately
         if (N == 0) {
-          newdet  = ksi;
+          set_newdet(ksi);
           newsign = 1;
           return newdet;
         }
@@ -528,9 +1008,9 @@ namespace triqs {
         }
         range R(0, N);
         //w1.MB(R) = mat_inv(R,R) * w1.B(R);// OPTIMIZE BELOW
-        blas::gemv(1.0, mat_inv(R, R), w1.B(R), 0.0, w1.MB(R));
-        w1.ksi  = ksi - arrays::dot(w1.C(R), w1.MB(R));
-        newdet  = det * w1.ksi;
+        gemv_mat_inv(w1.B, w1.MB);
+        w1.ksi = ksi - arrays::dot(w1.C(R), w1.MB(R));
+        set_newdet_from_ratio(w1.ksi);
         newsign = ((i + j) % 2 == 0 ? sign : -sign); // since N-i0 + N-j0  = i0+j0 [2]
         return w1.ksi * (newsign * sign);            // sign is unity, hence 1/sign == sign
       }
@@ -547,13 +1027,13 @@ namespace triqs {
         // special empty case again
         if (N == 0) {
           N             = 1;
+          wd.n          = 0;
           mat_inv(0, 0) = 1 / value_type(newdet);
           return;
         }
 
-        range R1(0, N);
         //w1.MC(R1) = mat_inv(R1,R1).transpose() * w1.C(R1); //OPTIMIZE BELOW
-        blas::gemv(1.0, mat_inv(R1, R1).transpose(), w1.C(R1), 0.0, w1.MC(R1));
+        gemv_mat_inv_transpose(w1.C, w1.MC);
         w1.MC(N) = -1;
         w1.MB(N) = -1;
 
@@ -576,6 +1056,13 @@ namespace triqs {
         range R(0, N);
         mat_inv(R, N - 1) = 0;
         mat_inv(N - 1, R) = 0;
+        if (n_delayed_max > 0) {
+          // NB : MC = C^T M^-1 above is still a O(N^2) gemv per insertion. Only the rank-1 update
+          // of mat_inv is delayed and grouped into a gemm.
+          clear_delayed_updates_at(N - 1);
+          push_delayed_update(w1.MB(R), w1.ksi * w1.MC(R));
+          return;
+        }
         //mat_inv(R,R) += w1.ksi* w1.MB(R) * w1.MC(R)// OPTIMIZE BELOW
         blas::ger(w1.ksi, w1.MB(R), w1.MC(R), mat_inv(R, R));
       }
@@ -609,6 +1096,7 @@ namespace triqs {
 
         // check input and store it for complete_operation
         TRIQS_ASSERT(last_try == NoTry);
+        flush_sweep_updates();
         TRIQS_ASSERT(i0 != i1);
         TRIQS_ASSERT(j0 != j1);
         TRIQS_ASSERT(i0 <= N);
@@ -639,7 +1127,7 @@ namespace triqs {
 
         // treat empty matrix separately
         if (N == 0) {
-          newdet  = w2.det_ksi();
+          set_newdet(w2.det_ksi());
           newsign = 1;
           return value_type(newdet);
         }
@@ -655,12 +1143,17 @@ namespace triqs {
         range R(0, N), R2(0, 2);
         //w2.MB(R,R2) = mat_inv(R,R) * w2.B(R,R2); // OPTIMIZE BELOW
         blas::gemm(1.0, mat_inv(R, R), w2.B(R, R2), 0.0, w2.MB(R, R2));
+        if (wd.n) {
+          range Rk(0, wd.n);
+          blas::gemm(1.0, wd.V(Rk, R), w2.B(R, R2), 0.0, wd.MB(Rk, R2));
+          blas::gemm(1.0, wd.U(R, Rk), wd.MB(Rk, R2), 1.0, w2.MB(R, R2));
+        }
         //w2.ksi -= w2.C (R2, R) * w2.MB(R, R2); // OPTIMIZE BELOW
         blas::gemm(-1.0, w2.C(R2, R), w2.MB(R, R2), 1.0, w2.ksi);
         auto ksi = w2.det_ksi();
-        newdet   = det * ksi;
-        newsign  = ((i0 + j0 + i1 + j1) % 2 == 0 ? sign : -sign); // since N-i0 + N-j0 + N + 1 -i1 + N+1 -j1 = i0+j0 [2]
-        return ksi * (newsign * sign);                            // sign is unity, hence 1/sign == sign
+        set_newdet_from_ratio(ksi);
+        newsign = ((i0 + j0 + i1 + j1) % 2 == 0 ? sign : -sign); // since N-i0 + N-j0 + N + 1 -i1 + N+1 -j1 = i0+j0 [2]
+        return ksi * (newsign * sign);                           // sign is unity, hence 1/sign == sign
       }
 
       //------------------------------------------------------------------------------------------
@@ -678,6 +1171,7 @@ namespace triqs {
         // treat empty matrix separately
         if (N == 0) {
           N                = 2;
+          wd.n             = 0;
           mat_inv(R2, R2)  = inverse(w2.ksi);
           row_num[w2.i[1]] = 1;
           col_num[w2.j[1]] = 1;
@@ -687,6 +1181,11 @@ namespace triqs {
         range Ri(0, N);
         //w2.MC(R2,Ri) = w2.C(R2,Ri) * mat_inv(Ri,Ri);// OPTIMIZE BELOW
         blas::gemm(1.0, w2.C(R2, Ri), mat_inv(Ri, Ri), 0.0, w2.MC(R2, Ri));
+        if (wd.n) {
+          range Rk(0, wd.n);
+          blas::gemm(1.0, w2.C(R2, Ri), wd.U(Ri, Rk), 0.0, wd.MC(R2, Rk));
+          blas::gemm(1.0, wd.MC(R2, Rk), wd.V(Rk, Ri), 1.0, w2.MC(R2, Ri));
+        }
         w2.MC(R2, range(N, N + 2)) = -1; // -identity matrix
         w2.MB(range(N, N + 2), R2) = -1; // -identity matrix !
 
@@ -705,6 +1204,12 @@ namespace triqs {
         range R(0, N);
         mat_inv(R, range(N - 2, N)) = 0;
         mat_inv(range(N - 2, N), R) = 0;
+        if (n_delayed_max > 0) {
+          clear_delayed_updates_at(N - 2);
+          clear_delayed_updates_at(N - 1);
+          for (int k = 0; k < 2; ++k) push_delayed_update(w2.MB(R, k), w2.ksi(k, 0) * w2.MC(0, R) + w2.ksi(k, 1) * w2.MC(1, R));
+          return;
+        }
         //mat_inv(R,R) += w2.MB(R,R2) * (w2.ksi * w2.MC(R2,R)); // OPTIMIZE BELOW
         blas::gemm(1.0, w2.MB(R, R2), (w2.ksi * w2.MC(R2, R)), 1.0, mat_inv(R, R));
       }
@@ -720,6 +1225,7 @@ namespace triqs {
      */
       value_type try_remove(size_t i, size_t j) {
         TRIQS_ASSERT(last_try == NoTry);
+        flush_sweep_updates();
         TRIQS_ASSERT(i < N);
         TRIQS_ASSERT(j < N);
         TRIQS_ASSERT(i >= 0);
@@ -732,10 +1238,10 @@ namespace triqs {
         // compute the newdet
         // first we resolve the w1.ireal,w1.jreal, with the permutation of the Minv, then we pick up what
         // will become the 'corner' coefficient, if the move is accepted, after the exchange of row and col.
-        w1.ksi   = mat_inv(w1.jreal, w1.ireal);
+        w1.ksi   = mat_inv_element(w1.jreal, w1.ireal);
         auto ksi = w1.ksi;
-        newdet   = det * ksi;
-        newsign  = ((i + j) % 2 == 0 ? sign : -sign);
+        set_newdet_from_ratio(ksi);
+        newsign = ((i + j) % 2 == 0 ? sign : -sign);
         return ksi * (newsign * sign); // sign is unity, hence 1/sign == sign
       }
       //------------------------------------------------------------------------------------------
@@ -750,27 +1256,39 @@ namespace triqs {
         // swap the rows w1.ireal and N, w1.jreal and N in inv_mat
         // Remember that for M row/col is interchanged by inversion, transposition.
         {
-          range R(0, N);
+          range R(0, N), Rk(0, wd.n);
           if (w1.jreal != N - 1) {
             arrays::deep_swap(mat_inv(w1.jreal, R), mat_inv(N - 1, R));
+            if (wd.n) arrays::deep_swap(wd.U(w1.jreal, Rk), wd.U(N - 1, Rk));
             y_values[w1.jreal] = y_values[N - 1];
           }
 
           if (w1.ireal != N - 1) {
             arrays::deep_swap(mat_inv(R, w1.ireal), mat_inv(R, N - 1));
+            if (wd.n) arrays::deep_swap(wd.V(Rk, w1.ireal), wd.V(Rk, N - 1));
             x_values[w1.ireal] = x_values[N - 1];
           }
         }
 
         N--;
 
-        // M <- a - d^-1 b c with BLAS
-        w1.ksi = -1 / mat_inv(N, N);
-        ASSERT(std::isfinite(std::abs(w1.ksi)));
-        range R(0, N);
+        if (n_delayed_max > 0) {
+          range R(0, N);
+          get_mat_inv_col(N, w1.MB(R));
+          get_mat_inv_row(N, w1.MC(R));
+          w1.ksi = -1 / mat_inv_element(N, N);
+          ASSERT(std::isfinite(std::abs(w1.ksi)));
+          push_delayed_update(w1.MB(R), w1.ksi * w1.MC(R));
+        } else {
+
+          // M <- a - d^-1 b c with BLAS
+          w1.ksi = -1 / mat_inv(N, N);
+          ASSERT(std::isfinite(std::abs(w1.ksi)));
+          range R(0, N);
 
-        //mat_inv(R,R) += w1.ksi, * mat_inv(R,N) * mat_inv(N,R);
-        blas::ger(w1.ksi, mat_inv(R, N), mat_inv(N, R), mat_inv(R, R));
+          //mat_inv(R,R) += w1.ksi, * mat_inv(R,N) * mat_inv(N,R);
+          blas::ger(w1.ksi, mat_inv(R, N), mat_inv(N, R), mat_inv(R, R));
+        }
 
         // modify the permutations
         for (size_t k = w1.i; k < N; k++) { row_num[k] = row_num[k + 1]; }
@@ -801,6 +1319,7 @@ namespace triqs {
         if (j0 > j1) std::swap(j0, j1);
 
         TRIQS_ASSERT(last_try == NoTry);
+        flush_sweep_updates();
         TRIQS_ASSERT(N >= 2);
         TRIQS_ASSERT(i0 != i1);
         TRIQS_ASSERT(j0 != j1);
@@ -825,13 +1344,13 @@ namespace triqs {
         w2.jreal[1] = col_num[w2.j[1]];
 
         // compute the newdet
-        w2.ksi(0, 0) = mat_inv(w2.jreal[0], w2.ireal[0]);
-        w2.ksi(1, 0) = mat_inv(w2.jreal[1], w2.ireal[0]);
-        w2.ksi(0, 1) = mat_inv(w2.jreal[0], w2.ireal[1]);
-        w2.ksi(1, 1) = mat_inv(w2.jreal[1], w2.ireal[1]);
+        w2.ksi(0, 0) = mat_inv_element(w2.jreal[0], w2.ireal[0]);
+        w2.ksi(1, 0) = mat_inv_element(w2.jreal[1], w2.ireal[0]);
+        w2.ksi(0, 1) = mat_inv_element(w2.jreal[0], w2.ireal[1]);
+        w2.ksi(1, 1) = mat_inv_element(w2.jreal[1], w2.ireal[1]);
         auto ksi     = w2.det_ksi();
-        newdet       = det * ksi;
-        newsign      = ((i0 + j0 + i1 + j1) % 2 == 0 ? sign : -sign);
+        set_newdet_from_ratio(ksi);
+        newsign = ((i0 + j0 + i1 + j1) % 2 == 0 ? sign : -sign);
 
         return ksi * (newsign * sign); // sign is unity, hence 1/sign == sign
       }
@@ -848,22 +1367,26 @@ namespace triqs {
         size_t j_real_max = std::max(w2.jreal[0], w2.jreal[1]);
         size_t j_real_min = std::min(w2.jreal[0], w2.jreal[1]);
 
-        range R(0, N);
+        range R(0, N), Rk(0, wd.n);
 
         if (j_real_max != N - 1) {
           arrays::deep_swap(mat_inv(j_real_max, R), mat_inv(N - 1, R));
+          if (wd.n) arrays::deep_swap(wd.U(j_real_max, Rk), wd.U(N - 1, Rk));
           y_values[j_real_max] = y_values[N - 1];
         }
         if (j_real_min != N - 2) {
           arrays::deep_swap(mat_inv(j_real_min, R), mat_inv(N - 2, R));
+          if (wd.n) arrays::deep_swap(wd.U(j_real_min, Rk), wd.U(N - 2, Rk));
           y_values[j_real_min] = y_values[N - 2];
         }
         if (i_real_max != N - 1) {
           arrays::deep_swap(mat_inv(R, i_real_max), mat_inv(R, N - 1));
+          if (wd.n) arrays::deep_swap(wd.V(Rk, i_real_max), wd.V(Rk, N - 1));
           x_values[i_real_max] = x_values[N - 1];
         }
         if (i_real_min != N - 2) {
           arrays::deep_swap(mat_inv(R, i_real_min), mat_inv(R, N - 2));
+          if (wd.n) arrays::deep_swap(wd.V(Rk, i_real_min), wd.V(Rk, N - 2));
           x_values[i_real_min] = x_values[N - 2];
         }
 
@@ -871,13 +1394,23 @@ namespace triqs {
 
         // M <- a - d^-1 b c with BLAS
         range Rn(0, N), Rl(N, N + 2);
-        //w2.ksi = mat_inv(Rl,Rl);
-        //w2.ksi = inverse( w2.ksi);
-        w2.ksi = inverse(mat_inv(Rl, Rl));
-
-        // write explicitely the second product on ksi for speed ?
-        //mat_inv(Rn,Rn) -= mat_inv(Rn,Rl) * (w2.ksi * mat_inv(Rl,Rn)); // OPTIMIZE BELOW
-        blas::gemm(-1.0, mat_inv(Rn, Rl), w2.ksi * mat_inv(Rl, Rn), 1.0, mat_inv(Rn, Rn));
+        if (n_delayed_max > 0) {
+          for (int a = 0; a < 2; ++a) {
+            get_mat_inv_col(N + a, w2.MB(Rn, a));
+            get_mat_inv_row(N + a, w2.MC(a, Rn));
+            for (int b = 0; b < 2; ++b) w2.ksi(a, b) = mat_inv_element(N + a, N + b);
+          }
+          w2.ksi = inverse(w2.ksi);
+          for (int k = 0; k < 2; ++k) push_delayed_update(w2.MB(Rn, k), -w2.ksi(k, 0) * w2.MC(0, Rn) - w2.ksi(k, 1) * w2.MC(1, Rn));
+        } else {
+          //w2.ksi = mat_inv(Rl,Rl);
+          //w2.ksi = inverse( w2.ksi);
+          w2.ksi = inverse(mat_inv(Rl, Rl));
+
+          // write explicitely the second product on ksi for speed ?
+          //mat_inv(Rn,Rn) -= mat_inv(Rn,Rl) * (w2.ksi * mat_inv(Rl,Rn)); // OPTIMIZE BELOW
+          blas::gemm(-1.0, mat_inv(Rn, Rl), w2.ksi * mat_inv(Rl, Rn), 1.0, mat_inv(Rn, Rn));
+        }
 
         // modify the permutations
         for (size_t k = w2.i[0]; k < w2.i[1] - 1; k++) row_num[k] = row_num[k + 1];
@@ -915,17 +1448,26 @@ namespace triqs {
         w1.jreal = col_num[j];
         w1.y     = y;
 
+        if (sw.active) { // M += delta_col * e_jreal^T
+          for (size_t i = 0; i < N; i++) sw.P(i, sw.k) = f(x_values[i], w1.y) - f(x_values[i], y_values[w1.jreal]);
+          sw.p_idx[sw.k] = -1;
+          sweep_set_q_unit(sw.k, w1.jreal);
+          w1.ksi = sweep_try(1);
+          set_newdet_from_ratio(w1.ksi);
+          newsign = sign;
+          return w1.ksi;
+        }
+
         // Compute the col B.
         for (size_t i = 0; i < N; i++) w1.MC(i) = f(x_values[i], w1.y) - f(x_values[i], y_values[w1.jreal]);
-        range R(0, N);
         //w1.MB(R) = mat_inv(R,R) * w1.MC(R);// OPTIMIZE BELOW
-        blas::gemv(1.0, mat_inv(R, R), w1.MC(R), 0.0, w1.MB(R));
+        gemv_mat_inv(w1.MC, w1.MB);
 
         // compute the newdet
         w1.ksi   = (1 + w1.MB(w1.jreal));
         auto ksi = w1.ksi;
-        newdet   = det * ksi;
-        newsign  = sign;
+        set_newdet_from_ratio(ksi);
+        newsign = sign;
 
         return ksi; // newsign/sign is unity
       }
@@ -935,6 +1477,14 @@ namespace triqs {
         range R(0, N);
         y_values[w1.jreal] = w1.y;
 
+        if (sw.active) return sweep_complete(1);
+
+        if (n_delayed_max > 0) { // M^-1 -= M^-1 B M^-1(jreal, :) / ksi
+          get_mat_inv_row(w1.jreal, w1.MC(R));
+          push_delayed_update(w1.MB(R), (-1 / w1.ksi) * w1.MC(R));
+          return;
+        }
+
         // modifying M : Mij += w1.ksi Bi Mnj
         // using Shermann Morrison formula.
         // implemented in 2 times : first Bn=0 so that Mnj is not modified ! and then change Mnj
@@ -963,17 +1513,26 @@ namespace triqs {
         w1.ireal = row_num[i];
         w1.x     = x;
 
+        if (sw.active) { // M += e_ireal * delta_row^T
+          for (size_t i = 0; i < N; i++) sw.Q(i, sw.k) = f(w1.x, y_values[i]) - f(x_values[w1.ireal], y_values[i]);
+          sw.q_idx[sw.k] = -1;
+          sweep_set_p_unit(sw.k, w1.ireal);
+          w1.ksi = sweep_try(1);
+          set_newdet_from_ratio(w1.ksi);
+          newsign = sign;
+          return w1.ksi;
+        }
+
         // Compute the col B.
         for (size_t i = 0; i < N; i++) w1.MB(i) = f(w1.x, y_values[i]) - f(x_values[w1.ireal], y_values[i]);
-        range R(0, N);
         //w1.MC(R) = mat_inv(R,R).transpose() * w1.MB(R); // OPTIMIZE BELOW
-        blas::gemv(1.0, mat_inv(R, R).transpose(), w1.MB(R), 0.0, w1.MC(R));
+        gemv_mat_inv_transpose(w1.MB, w1.MC);
 
         // compute the newdet
         w1.ksi   = (1 + w1.MC(w1.ireal));
         auto ksi = w1.ksi;
-        newdet   = det * ksi;
-        newsign  = sign;
+        set_newdet_from_ratio(ksi);
+        newsign = sign;
         return ksi; // newsign/sign is unity
       }
       //------------------------------------------------------------------------------------------
@@ -982,6 +1541,14 @@ namespace triqs {
         range R(0, N);
         x_values[w1.ireal] = w1.x;
 
+        if (sw.active) return sweep_complete(1);
+
+        if (n_delayed_max > 0) { // M^-1 -= M^-1(:, ireal) C M^-1 / ksi
+          get_mat_inv_col(w1.ireal, w1.MB(R));
+          push_delayed_update(w1.MB(R), (-1 / w1.ksi) * w1.MC(R));
+          return;
+        }
+
         // modifying M : M ij += w1.ksi Min Cj
         // using Shermann Morrison formula.
         // impl. Cf case 3
@@ -1024,21 +1591,35 @@ namespace triqs {
         w1.MB(w1.jreal) = 0;
 
         range R(0, N);
+        if (sw.active) { // M += delta_x * e_jreal^T + e_ireal * delta_y^T
+          size_t k        = sw.k;
+          sw.P(R, k)      = w1.MC(R);
+          sw.Q(R, k + 1)  = w1.MB(R);
+          sw.p_idx[k]     = -1;
+          sw.q_idx[k + 1] = -1;
+          sweep_set_q_unit(k, w1.jreal);
+          sweep_set_p_unit(k + 1, w1.ireal);
+          w1.ksi = sweep_try(2);
+          set_newdet_from_ratio(w1.ksi);
+          newsign = sign;
+          return w1.ksi;
+        }
+
         // C : X, B : Y
         //w1.C(R) = mat_inv(R,R) * w1.MC(R);// OPTIMIZE BELOW
-        blas::gemv(1.0, mat_inv(R, R), w1.MC(R), 0.0, w1.C(R));
+        gemv_mat_inv(w1.MC, w1.C);
         //w1.B(R) = mat_inv(R,R).transpose() * w1.MB(R); // OPTIMIZE BELOW
-        blas::gemv(1.0, mat_inv(R, R).transpose(), w1.MB(R), 0.0, w1.B(R));
+        gemv_mat_inv_transpose(w1.MB, w1.B);
 
         // compute the det_ratio
         auto Xn        = w1.C(w1.jreal);
         auto Yn        = w1.B(w1.ireal);
         auto Z         = arrays::dot(w1.MB(R), w1.C(R));
-        auto Mnn       = mat_inv(w1.jreal, w1.ireal);
+        auto Mnn       = mat_inv_element(w1.jreal, w1.ireal);
         auto det_ratio = (1 + Xn) * (1 + Yn) - Mnn * Z;
         w1.ksi         = det_ratio;
-        newdet         = det * det_ratio;
-        newsign        = sign;
+        set_newdet_from_ratio(det_ratio);
+        newsign = sign;
         return det_ratio; // newsign/sign is unity
       }
       //------------------------------------------------------------------------------------------
@@ -1048,10 +1629,12 @@ namespace triqs {
         x_values[w1.ireal] = w1.x;
         y_values[w1.jreal] = w1.y;
 
+        if (sw.active) return sweep_complete(2);
+
         // FIXME : Use blas for this ? Is it better
         auto Xn  = w1.C(w1.jreal);
         auto Yn  = w1.B(w1.ireal);
-        auto Mnn = mat_inv(w1.jreal, w1.ireal);
+        auto Mnn = mat_inv_element(w1.jreal, w1.ireal);
 
         auto D   = w1.ksi;        // get back
         auto a   = -(1 + Yn) / D; // D in the notes
@@ -1059,6 +1642,15 @@ namespace triqs {
         auto Z   = arrays::dot(w1.MB(R), w1.C(R)); // FIXME : store this ?
         Z        = Z / D;
         Mnn      = Mnn / D;
+
+        if (n_delayed_max > 0) { // M^-1 += (a X + Z Min) Mnj + (b Min + Mnn X) Y
+          get_mat_inv_row(w1.jreal, w1.MB(R)); // Mnj
+          get_mat_inv_col(w1.ireal, w1.MC(R)); // Min
+          push_delayed_update(a * w1.C(R) + Z * w1.MC(R), w1.MB(R));
+          push_delayed_update(b * w1.MC(R) + Mnn * w1.C(R), w1.B(R));
+          return;
+        }
+
         w1.MB(R) = mat_inv(w1.jreal, R); // Mnj
         w1.MC(R) = mat_inv(R, w1.ireal); // Min
 
@@ -1086,6 +1678,7 @@ namespace triqs {
       template <typename ArgumentContainer1, typename ArgumentContainer2>
       value_type try_refill(ArgumentContainer1 const &X, ArgumentContainer2 const &Y) {
         TRIQS_ASSERT(last_try == NoTry);
+        flush_sweep_updates();
         TRIQS_ASSERT(X.size() == Y.size());
 
         last_try = Refill;
@@ -1095,7 +1688,7 @@ namespace triqs {
         if (s == 0) {
           w_refill.x_values.clear();
           w_refill.y_values.clear();
-          return 1 / (sign * det);
+          return std::exp(-log_abs_det) / (sign * det_phase);
         }
 
         w_refill.reserve(s);
@@ -1107,10 +1700,10 @@ namespace triqs {
         for (size_t i = 0; i < s; ++i)
           for (size_t j = 0; j < s; ++j) w_refill.M(i, j) = f(w_refill.x_values[i], w_refill.y_values[j]);
         range R(0, s);
-        newdet  = arrays::determinant(w_refill.M(R, R));
-        newsign = 1;
+        std::tie(newdet, newdet_phase, newlog_abs_det) = det_phase_log(w_refill.M(R, R));
+        newsign                                        = 1;
 
-        return newdet / (sign * det);
+        return std::exp(newlog_abs_det - log_abs_det) * newdet_phase / (sign * det_phase);
       }
 
       //------------------------------------------------------------------------------------------
@@ -1121,7 +1714,7 @@ namespace triqs {
         // special empty case again
         if (N == 0) {
           clear();
-          newdet  = 1;
+          set_newdet(1);
           newsign = 1;
           return;
         }
@@ -1136,15 +1729,26 @@ namespace triqs {
         std::iota(col_num.begin(), col_num.end(), 0);
 
         range R(0, N);
+        wd.n          = 0;
         mat_inv(R, R) = inverse(w_refill.M(R, R));
       }
 
       //------------------------------------------------------------------------------------------
       private:
       void _regenerate_with_check(bool do_check, double precision_warning, double precision_error) {
+        flush_delayed_updates();
+        auto t0 = std::chrono::steady_clock::now();
+        ++n_regenerations;
+        _regenerate_impl(do_check, precision_warning, precision_error);
+        regeneration_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+      }
+
+      void _regenerate_impl(bool do_check, double precision_warning, double precision_error) {
         if (N == 0) {
-          det  = 1;
-          sign = 1;
+          det         = 1;
+          det_phase   = 1;
+          log_abs_det = 0;
+          sign        = 1;
           return;
         }
 
@@ -1152,7 +1756,7 @@ namespace triqs {
         matrix_type res(N, N);
         for (int i = 0; i < N; i++)
           for (int j = 0; j < N; j++) res(i, j) = f(x_values[i], y_values[j]);
-        det = arrays::determinant(res);
+        std::tie(det, det_phase, log_abs_det) = det_phase_log(res);
 
         if (is_singular()) TRIQS_RUNTIME_ERROR << "ERROR in det_manip regenerate: Determinant is singular";
         res = inverse(res);
@@ -1195,8 +1799,41 @@ namespace triqs {
 
       void check_mat_inv() { _regenerate_with_check(true, precision_warning, precision_error); }
 
-      /// it the det 0 ? I.e. (singular_threshold <0 ? not std::isnormal(std::abs(det)) : (std::abs(det)<singular_threshold))
-      bool is_singular() const { return (singular_threshold < 0 ? not std::isnormal(std::abs(det)) : (std::abs(det) < singular_threshold)); }
+      // max |M * M^-1 - 1| on a few random rows, in O(N^2)
+      double residual_estimate() {
+        flush_delayed_updates();
+        range R(0, N);
+        double r = 0;
+        for (int s = 0; s < 2; ++s) {
+          size_t a = std::uniform_int_distribution<size_t>(0, N - 1)(residual_rng);
+          for (size_t b = 0; b < N; ++b) w1.B(b) = f(x_values[a], y_values[b]);
+          blas::gemv(1.0, mat_inv(R, R).transpose(), w1.B(R), 0.0, w1.C(R)); // row a of M * M^-1
+          w1.C(a) -= 1;
+          r = std::max(r, max_element(abs(w1.C(R))));
+        }
+        ++n_residual_checks;
+        return r;
+      }
+
+      // The adaptive policy : regenerate only if the residual has drifted, and adapt the period of the checks
+      void adaptive_check_mat_inv() {
+        if (N == 0) return check_mat_inv();
+        n_opts = 0;
+        if (residual_estimate() < std::max(precision_warning, 10 * residual_baseline)) {
+          n_opts_adaptive_before_check = std::min(2 * n_opts_adaptive_before_check, n_opts_max_before_check);
+          return;
+        }
+        // the drift below precision_error is simply corrected, without warning
+        _regenerate_with_check(true, precision_error, precision_error);
+        residual_baseline            = residual_estimate();
+        n_opts_adaptive_before_check = std::max(n_opts_adaptive_before_check / 2, uint64_t(1));
+      }
+
+      /// it the det 0 ? I.e. (singular_threshold <0 ? not std::isfinite(log|det|) : (|det| < singular_threshold))
+      /// The test is done on the tracked log|det|, so a det which is simply out of the range of double is not singular.
+      bool is_singular() const {
+        return (singular_threshold < 0 ? not std::isfinite(log_abs_det) : (log_abs_det < std::log(singular_threshold)));
+      }
 
       //------------------------------------------------------------------------------------------
       public:
@@ -1221,10 +1858,19 @@ namespace triqs {
           default: TRIQS_RUNTIME_ERROR << "Misuing det_manip"; // Never used?
         }
 
-        det  = newdet;
-        sign = newsign;
+        // if the product of the ratios has under/overflowed, recover the value from the log
+        bool lost_precision = not(std::isnormal(std::abs(det)) and std::isnormal(std::abs(newdet)));
+        det                 = (lost_precision ? newdet_phase * std::exp(newlog_abs_det) : newdet);
+        det_phase           = newdet_phase;
+        log_abs_det         = newlog_abs_det;
+        sign                = newsign;
         ++n_opts;
-        if (n_opts > n_opts_max_before_check) check_mat_inv();
+        if (n_opts > (adaptive_check ? n_opts_adaptive_before_check : n_opts_max_before_check)) {
+          if (adaptive_check)
+            adaptive_check_mat_inv();
+          else
+            check_mat_inv();
+        }
         last_try = NoTry;
       }
 
@@ -70,4 +70,6 @@
 
 // fourier
 #include "./gfs/transform/fourier.hpp"
+#include "./gfs/transform/fourier_workspace.hpp"
 #include "./gfs/transform/legendre_matsubara.hpp"
+#include "./gfs/transform/dlr.hpp"
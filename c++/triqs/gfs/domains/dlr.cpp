@@ -0,0 +1,196 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include "../../gfs.hpp"
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+namespace triqs::gfs {
+
+  namespace {
+
+    // Number of Chebyshev nodes per panel of the fine grids
+    constexpr int n_cheb = 24;
+
+    // Matsubara indices |n| <= n_dense are all candidates, beyond they are geometrically spaced
+    constexpr long n_dense = 512;
+
+    // Adds the Chebyshev nodes of [a, b] to x
+    void add_chebyshev_nodes(std::vector<double> &x, double a, double b) {
+      for (int k = 0; k < n_cheb; ++k) x.push_back((a + b) / 2 + (b - a) / 2 * std::cos(M_PI * (2 * k + 1) / (2 * n_cheb)));
+    }
+
+    // Number of dyadic levels to resolve the scale 1 / lambda
+    int n_levels(double lambda) { return std::max(0, int(std::ceil(std::log2(lambda)))); }
+
+    // Fine grid in [-lambda, lambda], dyadically refined towards 0
+    std::vector<double> fine_omega_grid(double lambda) {
+      std::vector<double> x;
+      int p = n_levels(lambda);
+      add_chebyshev_nodes(x, 0, lambda / std::pow(2, p));
+      for (int i = 0; i < p; ++i) add_chebyshev_nodes(x, lambda / std::pow(2, i + 1), lambda / std::pow(2, i));
+      long n = x.size();
+      for (long i = 0; i < n; ++i) x.push_back(-x[i]);
+      return x;
+    }
+
+    // Fine grid in [0, 1], dyadically refined towards 0 and 1
+    std::vector<double> fine_tau_grid(double lambda) {
+      std::vector<double> x;
+      int p = n_levels(lambda);
+      add_chebyshev_nodes(x, 0, std::pow(2, -(p + 1)));
+      for (int i = 0; i < p; ++i) add_chebyshev_nodes(x, std::pow(2, -(i + 2)), std::pow(2, -(i + 1)));
+      long n = x.size();
+      for (long i = 0; i < n; ++i) x.push_back(1 - x[i]);
+      return x;
+    }
+
+    // Candidate Matsubara indices : all of them up to n_dense, then geometrically spaced up to lambda
+    std::vector<long> candidate_matsubara_indices(double lambda, statistic_enum s) {
+      long n_max = std::max(n_dense, long(std::ceil(lambda)));
+      std::vector<long> pos;
+      for (long n = 0; n <= std::min(n_dense, n_max); ++n) pos.push_back(n);
+      for (double n = n_dense * 1.01; n <= n_max; n *= 1.01)
+        if (long(n) > pos.back()) pos.push_back(long(n));
+      // negative frequencies : -n for bosons, -n-1 for fermions (the mirror of n)
+      std::vector<long> res = pos;
+      for (long n : pos)
+        if (s == Fermion or n > 0) res.push_back(s == Fermion ? -n - 1 : -n);
+      return res;
+    }
+
+    // Pivoted (modified) Gram-Schmidt on the vectors v.
+    // Selects the vector of largest residual norm, until max_rank vectors are selected or the largest residual norm
+    // is below eps times the largest norm. Returns the indices of the selected vectors.
+    template <typename T> std::vector<long> pivoted_gram_schmidt(std::vector<std::vector<T>> v, double eps, long max_rank) {
+      long n = v.size();
+      if (n == 0) return {};
+      long m = v[0].size();
+
+      auto dot = [m](std::vector<T> const &a, std::vector<T> const &b) {
+        T r = 0;
+        for (long i = 0; i < m; ++i) {
+          if constexpr (std::is_same_v<T, double>)
+            r += a[i] * b[i];
+          else
+            r += std::conj(a[i]) * b[i];
+        }
+        return r;
+      };
+      auto norm2 = [&dot](std::vector<T> const &a) { return std::real(dot(a, a)); };
+
+      std::vector<double> nrm(n);
+      for (long j = 0; j < n; ++j) nrm[j] = norm2(v[j]);
+      double ref = std::sqrt(*std::max_element(nrm.begin(), nrm.end()));
+
+      std::vector<long> selected;
+      std::vector<std::vector<T>> q;
+      std::vector<bool> used(n, false);
+      while (long(selected.size()) < std::min(max_rank, n)) {
+        long j = -1;
+        for (long k = 0; k < n; ++k)
+          if (!used[k] and (j == -1 or nrm[k] > nrm[j])) j = k;
+        if (std::sqrt(nrm[j]) <= eps * ref) break;
+
+        auto u = v[j];
+        for (auto const &qk : q) { // reorthogonalization
+          T c = dot(qk, u);
+          for (long i = 0; i < m; ++i) u[i] -= c * qk[i];
+        }
+        double nu = std::sqrt(norm2(u));
+        for (auto &x : u) x /= nu;
+
+        used[j] = true;
+        selected.push_back(j);
+        for (long k = 0; k < n; ++k) {
+          if (used[k]) continue;
+          T c = dot(u, v[k]);
+          for (long i = 0; i < m; ++i) v[k][i] -= c * u[i];
+          nrm[k] = norm2(v[k]);
+        }
+        q.push_back(std::move(u));
+      }
+      return selected;
+    }
+
+  } // namespace
+
+  //-------------------------------------------------------
+
+  dlr_basis::dlr_basis(double lambda, double eps) : _lambda(lambda), _eps(eps) {
+
+    if (lambda <= 0 or eps <= 0 or eps >= 1) TRIQS_RUNTIME_ERROR << "DLR basis : requires lambda > 0 and 0 < eps < 1";
+
+    // The poles : the columns of the kernel on the fine grids
+    auto om_fine  = fine_omega_grid(lambda);
+    auto tau_fine = fine_tau_grid(lambda);
+    std::vector<std::vector<double>> cols;
+    for (double w : om_fine) {
+      std::vector<double> c;
+      for (double x : tau_fine) c.push_back(k_tau(x, w));
+      cols.push_back(std::move(c));
+    }
+    for (long j : pivoted_gram_schmidt(cols, eps, tau_fine.size())) _omega.push_back(om_fine[j]);
+    std::sort(_omega.begin(), _omega.end());
+    long r = _omega.size();
+
+    // The tau sampling points : the rows of the kernel restricted to the poles
+    std::vector<std::vector<double>> rows;
+    for (double x : tau_fine) {
+      std::vector<double> c;
+      for (double w : _omega) c.push_back(k_tau(x, w));
+      rows.push_back(std::move(c));
+    }
+    for (long j : pivoted_gram_schmidt(rows, 0, r)) _tau.push_back(tau_fine[j]);
+    std::sort(_tau.begin(), _tau.end());
+
+    _k_tau = arrays::matrix<dcomplex>(r, r);
+    for (long k = 0; k < r; ++k)
+      for (long l = 0; l < r; ++l) _k_tau(k, l) = k_tau(_tau[k], _omega[l]);
+
+    // The Matsubara sampling points, for each statistic
+    for (auto s : {Boson, Fermion}) {
+      auto n_cand = candidate_matsubara_indices(lambda, s);
+      std::vector<std::vector<dcomplex>> rows_iw;
+      for (long n : n_cand) {
+        std::vector<dcomplex> c;
+        for (double w : _omega) c.push_back(k_iw(n, w, s));
+        rows_iw.push_back(std::move(c));
+      }
+      for (long j : pivoted_gram_schmidt(rows_iw, 0, r)) _iw_n[s].push_back(n_cand[j]);
+      std::sort(_iw_n[s].begin(), _iw_n[s].end());
+      if (long(_iw_n[s].size()) != r) TRIQS_RUNTIME_ERROR << "DLR basis : can not select the Matsubara sampling points";
+
+      _k_iw[s] = arrays::matrix<dcomplex>(r, r);
+      for (long k = 0; k < r; ++k)
+        for (long l = 0; l < r; ++l) _k_iw[s](k, l) = k_iw(_iw_n[s][k], _omega[l], s);
+    }
+  }
+
+  //-------------------------------------------------------
+
+  std::shared_ptr<const dlr_basis> make_dlr_basis(double lambda, double eps) {
+    static std::mutex mutex;
+    static std::map<std::pair<double, double>, std::shared_ptr<const dlr_basis>> cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &b = cache[{lambda, eps}];
+    if (!b) b = std::make_shared<const dlr_basis>(lambda, eps);
+    return b;
+  }
+
+} // namespace triqs::gfs
@@ -0,0 +1,154 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#pragma once
+#include <memory>
+#include <vector>
+
+namespace triqs {
+  namespace gfs {
+
+    /**
+     * The Discrete Lehmann Representation (DLR) basis of imaginary time Green functions,
+     * for the dimensionless cutoff lambda = beta * omega_max and the accuracy eps.
+     *
+     * Any G(tau) with a spectral function supported in [-omega_max, omega_max] is represented to accuracy eps
+     * as a sum of r poles at the real frequencies omega_l / beta (r ~ log(lambda) log(1/eps))
+     *
+     *    G(tau) = sum_l g_l k(tau / beta, omega_l),     k(x, w) = -exp(-x w) / (1 + exp(-w))
+     *
+     * i.e. g_l is the weight of the pole 1 / (i omega_n - omega_l / beta), for fermions.
+     * For bosons, the same basis is used, and G(i nu_n) = sum_l g_l tanh(omega_l / 2) / (i nu_n - omega_l / beta).
+     *
+     * The basis also provides r sampling points in imaginary time and r Matsubara frequencies (for each statistic),
+     * from which the coefficients g_l are obtained.
+     *
+     * The poles and the sampling points are selected by pivoted Gram-Schmidt on the kernel, discretized on fine composite
+     * Chebyshev grids (Kaye, Chen, Parcollet, Phys. Rev. B 105, 235115 (2022)).
+     */
+    class dlr_basis {
+
+      double _lambda, _eps;
+      std::vector<double> _omega;              // the poles, dimensionless (beta * omega), sorted
+      std::vector<double> _tau;                // the sampling points in tau / beta, in [0, 1], sorted
+      std::vector<long> _iw_n[2];              // the sampling Matsubara indices, for Boson and Fermion, sorted
+      arrays::matrix<dcomplex> _k_tau;         // (tau sampling point, pole) : k(tau, omega)
+      arrays::matrix<dcomplex> _k_iw[2];       // (Matsubara sampling point, pole) : the kernel in Matsubara, without the factor beta
+
+      public:
+      /// Builds the basis. Prefer make_dlr_basis, which caches the bases
+      dlr_basis(double lambda, double eps);
+
+      double lambda() const { return _lambda; }
+      double eps() const { return _eps; }
+
+      /// Number of poles, and of sampling points
+      long rank() const { return _omega.size(); }
+
+      /// The poles, as beta * omega
+      std::vector<double> const &omega() const { return _omega; }
+
+      /// The sampling points in imaginary time, as tau / beta
+      std::vector<double> const &tau() const { return _tau; }
+
+      /// The indices n of the sampling Matsubara frequencies
+      std::vector<long> const &iw_n(statistic_enum s) const { return _iw_n[s]; }
+
+      /// The kernel in imaginary time, x = tau / beta in [0, 1], w = beta * omega
+      static double k_tau(double x, double w) {
+        return (w >= 0 ? -std::exp(-x * w) / (1 + std::exp(-w)) : -std::exp((1 - x) * w) / (1 + std::exp(w)));
+      }
+
+      /// The kernel at the Matsubara frequency of index n, w = beta * omega, without the factor beta
+      static dcomplex k_iw(long n, double w, statistic_enum s) {
+        if (s == Fermion) return 1 / (dcomplex(0, M_PI * (2 * n + 1)) - w);
+        if (n == 0 and std::abs(w) < 1.e-8) return -0.5 + w * w / 24; // limit of tanh(w / 2) / (-w)
+        return std::tanh(w / 2) / (dcomplex(0, 2 * M_PI * n) - w);
+      }
+
+      /// Matrix (tau sampling point, pole) of the kernel
+      arrays::matrix<dcomplex> const &k_tau_matrix() const { return _k_tau; }
+
+      /// Matrix (Matsubara sampling point, pole) of the kernel, without the factor beta
+      arrays::matrix<dcomplex> const &k_iw_matrix(statistic_enum s) const { return _k_iw[s]; }
+    };
+
+    /// The DLR basis for (lambda, eps). The bases are built once per process, and shared.
+    std::shared_ptr<const dlr_basis> make_dlr_basis(double lambda, double eps);
+
+    /*----------------------------------------------------------------------------------------------------*/
+
+    /// Domain of the DLR meshes : beta, statistic, and the basis for (lambda, eps)
+    class dlr_domain {
+
+      public:
+      double beta = 1;
+      statistic_enum statistic = Fermion;
+      double lambda = 0, eps = 0;
+      std::shared_ptr<const dlr_basis> basis;
+
+      using point_t = long;
+      size_t size() const { return (basis ? basis->rank() : 0); };
+
+      dlr_domain() = default;
+
+      /**
+       * @param beta_    Inverse temperature
+       * @param stat_    Statistic
+       * @param lambda_  Dimensionless cutoff beta * omega_max
+       * @param eps_     Accuracy of the representation
+       */
+      dlr_domain(double beta_, statistic_enum stat_, double lambda_, double eps_)
+         : beta(beta_), statistic(stat_), lambda(lambda_), eps(eps_), basis(make_dlr_basis(lambda_, eps_)) {}
+
+      bool operator==(dlr_domain const &D) const {
+        return ((std::abs(beta - D.beta) < 1.e-15) && (statistic == D.statistic) && (lambda == D.lambda) && (eps == D.eps));
+      }
+
+      /// Write into HDF5
+      friend void h5_write(h5::group fg, std::string subgroup_name, dlr_domain const &d) {
+        h5::group gr = fg.create_group(subgroup_name);
+        h5_write(gr, "beta", d.beta);
+        h5_write(gr, "statistic", (d.statistic == Fermion ? "F" : "B"));
+        h5_write(gr, "lambda", d.lambda);
+        h5_write(gr, "eps", d.eps);
+      }
+
+      /// Read from HDF5
+      friend void h5_read(h5::group fg, std::string subgroup_name, dlr_domain &d) {
+        h5::group gr = fg.open_group(subgroup_name);
+        double beta, lambda, eps;
+        std::string statistic = " ";
+        h5_read(gr, "beta", beta);
+        h5_read(gr, "statistic", statistic);
+        h5_read(gr, "lambda", lambda);
+        h5_read(gr, "eps", eps);
+        d = dlr_domain(beta, (statistic == "F" ? Fermion : Boson), lambda, eps);
+      }
+
+      //  BOOST Serialization
+      friend class boost::serialization::access;
+      template <class Archive> void serialize(Archive &ar, const unsigned int version) {
+        ar &beta;
+        ar &statistic;
+        ar &lambda;
+        ar &eps;
+        if constexpr (Archive::is_loading::value) basis = make_dlr_basis(lambda, eps);
+      }
+    };
+  } // namespace gfs
+} // namespace triqs
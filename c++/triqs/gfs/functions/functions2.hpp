@@ -20,6 +20,7 @@
 #pragma once
 #include "../meshes/product.hpp"
 #include <itertools/itertools.hpp>
+#include <triqs/utility/parallel_for.hpp>
 
 namespace triqs::gfs {
 
@@ -52,9 +53,68 @@ namespace triqs::gfs {
     }
   }
 
+  // internal. The frequency mesh of g
+  template <int N, typename G> decltype(auto) _tail_fit_mesh(G const &g) {
+    if constexpr (std::is_base_of_v<tag::composite, typename G::mesh_t>)
+      return std::get<N>(g.mesh());
+    else
+      return g.mesh();
+  }
+
+  // internal. The inner matrix dimension for the hermitian tail fit of g
+  template <typename G> long _hermitian_inner_matrix_dim(G const &g) {
+    constexpr int rank = G::target_t::rank;
+    if (rank == 0) return 1;
+    if (rank == 2 && g.target_shape()[0] == g.target_shape()[1]) return g.target_shape()[0];
+    TRIQS_RUNTIME_ERROR << "Incompatible target_shape for fit_hermitian_tail\n";
+  }
+
+  // internal. Fit the tails of the Green functions gs.
+  // The ones with the same mesh, number of known moments and (for the hermitian fit) inner matrix dimension are fitted together,
+  // as one least-squares problem with many right-hand sides (cf tail_fitter::fit_batch).
+  template <int N, bool enforce_hermiticity, typename G, typename BA>
+  std::pair<std::vector<arrays::array<dcomplex, G::data_rank>>, double> _fit_tail_batch(std::vector<G> const &gs, BA const &known_moments) {
+    constexpr int R = G::data_rank;
+    long n_g        = gs.size();
+    if (not known_moments.empty() and long(known_moments.size()) != n_g)
+      TRIQS_RUNTIME_ERROR << "Tail fit : the number of known_moments (" << known_moments.size() << ") differs from the number of Green functions (" << n_g
+                          << ")";
+
+    auto n_known = [&](long i) { return (known_moments.empty() ? 0 : first_dim(known_moments[i])); };
+    auto inner   = [&](long i) { return (enforce_hermiticity ? std::optional<long>{_hermitian_inner_matrix_dim(gs[i])} : std::optional<long>{}); };
+
+    std::vector<arrays::array<dcomplex, R>> tail_vec(n_g);
+    std::vector<bool> done(n_g, false);
+    double max_err = 0.0;
+
+    for (long i : range(n_g)) {
+      if (done[i]) continue;
+      auto const &m = _tail_fit_mesh<N>(gs[i]);
+
+      // Gather all the Green functions which can be fitted with gs[i]
+      std::vector<long> batch;
+      std::vector<array_const_view<dcomplex, R>> g_data, km;
+      for (long j : range(i, n_g)) {
+        if (done[j] or !(_tail_fit_mesh<N>(gs[j]) == m) or n_known(j) != n_known(i) or inner(j) != inner(i)) continue;
+        done[j] = true;
+        batch.push_back(j);
+        g_data.push_back(make_const_view(gs[j].data()));
+        if (n_known(j) > 0) km.push_back(make_const_view(known_moments[j]));
+      }
+
+      auto [tails, err] = m.get_tail_fitter().template fit_batch<enforce_hermiticity>(m, g_data, N, true, km, inner(i));
+      for (auto [k, j] : itertools::enumerate(batch)) tail_vec[j] = std::move(tails[k]);
+      max_err = std::max(err, max_err);
+    }
+    return std::make_pair(std::move(tail_vec), max_err);
+  }
+
   /**
    * Fit the tail of a Block Green function using a least-squares fitting procedure
    *
+   * The blocks with the same mesh and number of known moments are fitted together, as a single
+   * least-squares problem with many right-hand sides.
+   *
    * @tparam BG The type of the Block Green function (block_gf, block_gf_view, block_gf_const_view)
    * @tparam AG The type of the high-frequecy moments for Block Green functions (e.g. std::vector<array>)
    *
@@ -63,14 +123,32 @@ namespace triqs::gfs {
   template <int N = 0, typename BG, typename BA = std::vector<typename BG::g_t::data_t::regular_type>>
   std::pair<std::vector<typename BG::g_t::data_t::regular_type>, double> fit_tail(BG const &bg, BA const &known_moments = {})
      REQUIRES(is_block_gf_v<BG, 1>) {
-    double max_err = 0.0;
-    std::vector<typename BG::g_t::data_t::regular_type> tail_vec;
-    for (auto [i, g_bl] : itertools::enumerate(bg)) {
-      auto [tail, err] = known_moments.empty() ? fit_tail<N, typename BG::g_t>(g_bl) : fit_tail<N, typename BG::g_t>(g_bl, known_moments[i]);
-      tail_vec.emplace_back(std::move(tail));
-      max_err = std::max(err, max_err);
-    }
-    return std::make_pair(tail_vec, max_err);
+    std::vector<typename BG::g_t::const_view_type> gs;
+    for (auto const &g_bl : bg) gs.emplace_back(g_bl);
+    auto [tails, max_err] = _fit_tail_batch<N, false>(gs, known_moments);
+    return std::make_pair(std::vector<typename BG::g_t::data_t::regular_type>(std::make_move_iterator(tails.begin()), std::make_move_iterator(tails.end())), max_err);
+  }
+
+  /**
+   * Fit the tails of several Green functions using a least-squares fitting procedure
+   *
+   * The Green functions with the same mesh and number of known moments, e.g. G(iw) at all the k-points of a lattice,
+   * are fitted together, as a single least-squares problem with many right-hand sides.
+   *
+   * @tparam N The position of the frequency mesh in case of a product mesh [default: 0]
+   * @tparam G The type of the Green functions (gf, gf_view, gf_const_view)
+   * @tparam A The type of the high-frequency moment arrays
+   *
+   * @param gs The Green functions to fit the tail for
+   * @param known_moments The known high-frequency moments of each Green function (or empty)
+   *
+   * @return A pair of the vector of the tails and the largest fitting error
+   */
+  template <int N = 0, typename G, typename A = typename G::data_t::regular_type>
+  std::pair<std::vector<typename A::regular_type>, double> fit_tail(std::vector<G> const &gs, std::vector<A> const &known_moments = {})
+     REQUIRES(is_gf_v<G>) {
+    auto [tails, max_err] = _fit_tail_batch<N, false>(gs, known_moments);
+    return std::make_pair(std::vector<typename A::regular_type>(std::make_move_iterator(tails.begin()), std::make_move_iterator(tails.end())), max_err);
   }
 
   /**
@@ -89,14 +167,7 @@ namespace triqs::gfs {
    */
   template <int N = 0, typename G, typename A = typename G::data_t::const_view_type>
   std::pair<typename A::regular_type, double> fit_hermitian_tail(G const &g, A const &known_moments = {}) REQUIRES(is_gf_v<G>) {
-    std::optional<long> inner_matrix_dim;
-    constexpr int rank = G::target_t::rank;
-    if (rank == 0)
-      inner_matrix_dim = 1;
-    else if (rank == 2 && g.target_shape()[0] == g.target_shape()[1]) {
-      inner_matrix_dim = g.target_shape()[0];
-    } else
-      TRIQS_RUNTIME_ERROR << "Incompatible target_shape for fit_hermitian_tail\n";
+    std::optional<long> inner_matrix_dim = _hermitian_inner_matrix_dim(g);
     if constexpr (std::is_base_of_v<tag::composite, typename G::mesh_t>) { // product mesh
       auto const &m = std::get<N>(g.mesh());
       return m.get_tail_fitter().fit_hermitian(m, make_const_view(g.data()), N, true, make_const_view(known_moments), inner_matrix_dim);
@@ -116,15 +187,10 @@ namespace triqs::gfs {
    */
   template <int N = 0, typename BG, typename A = std::vector<typename BG::g_t::data_t::regular_type>>
   std::pair<std::vector<typename BG::g_t::data_t::regular_type>, double> fit_hermitian_tail(BG const &bg, A const &known_moments = {}) REQUIRES(is_block_gf_v<BG, 1>) {
-    double max_err = 0.0;
-    std::vector<typename BG::g_t::data_t::regular_type> tail_vec;
-    for (auto [i, g_bl] : itertools::enumerate(bg)) {
-      auto [tail, err] =
-         known_moments.empty() ? fit_hermitian_tail<N, typename BG::g_t>(g_bl) : fit_hermitian_tail<N, typename BG::g_t>(g_bl, known_moments[i]);
-      tail_vec.emplace_back(std::move(tail));
-      max_err = std::max(err, max_err);
-    }
-    return std::make_pair(tail_vec, max_err);
+    std::vector<typename BG::g_t::const_view_type> gs;
+    for (auto const &g_bl : bg) gs.emplace_back(g_bl);
+    auto [tails, max_err] = _fit_tail_batch<N, true>(gs, known_moments);
+    return std::make_pair(std::vector<typename BG::g_t::data_t::regular_type>(std::make_move_iterator(tails.begin()), std::make_move_iterator(tails.end())), max_err);
   }
 
   // Tail-fit without normalization, returns moments rescaled by maximum frequency:  a_n * omega_max^n
@@ -188,16 +254,38 @@ namespace triqs::gfs {
   *-----------------------------------------------------------------------------------------------------*/
 
   // auxiliary function : invert the data : one function for all matrix valued gf (save code).
-  template <typename A3> void _gf_invert_data_in_place(A3 &&a) {
-    auto dom = a(ellipsis(), 0, 0).indexmap().domain();
-    auto f   = [&a, _ = itertools::range()](auto... x) { return a(x..., _, _); };
-    for (auto ind : dom) {
-      auto v = make_matrix_view(triqs::tuple::apply(f, ind));
-      v      = triqs::arrays::inverse(v);
+  // The matrices are inverted in batches over the mesh, cf batched_inverse_in_place.
+  // For a product mesh, the mesh indices are regrouped into one when the strides allow it (always for
+  // the data of a gf), so that the threads are started once. Otherwise, the threads run over the first index.
+  template <typename A3> void _gf_invert_data_in_place(A3 &&a, int n_threads = 1) {
+    using A_t       = std::decay_t<A3>;
+    constexpr int R = A_t::rank;
+    if constexpr (R == 3)
+      batched_inverse_in_place(a, n_threads);
+    else {
+      auto const &la = a.indexmap().lengths();
+      auto const &st = a.indexmap().strides();
+      bool can_group = true;
+      for (int d = 0; d < R - 3; ++d) can_group = can_group and (st[d] == st[d + 1] * long(la[d + 1]));
+      if (can_group) {
+        utility::mini_vector<size_t, 3> l{size_t(la[0]), size_t(la[R - 2]), size_t(la[R - 1])};
+        utility::mini_vector<std::ptrdiff_t, 3> s{st[R - 3], st[R - 2], st[R - 1]};
+        for (int d = 1; d < R - 2; ++d) l[0] *= la[d];
+        batched_inverse_in_place(array_view<typename A_t::value_type, 3>{{l, s, std::ptrdiff_t(a.indexmap().start_shift())}, a.storage()}, n_threads);
+      } else
+        triqs::utility::parallel_for_chunks(first_dim(a), n_threads, [&a](long i0, long i1) {
+          for (long i = i0; i < i1; ++i) _gf_invert_data_in_place(a(i, ellipsis()), 1);
+        });
     }
   }
 
-  template <typename M> void invert_in_place(gf_view<M, matrix_valued> g) { _gf_invert_data_in_place(g.data()); }
+  /**
+   * Inverts in place the matrix g(x) for all mesh points x
+   *
+   * @param g The Green function
+   * @param n_threads Number of threads over which the mesh points are distributed
+   */
+  template <typename M> void invert_in_place(gf_view<M, matrix_valued> g, int n_threads = 1) { _gf_invert_data_in_place(g.data(), n_threads); }
 
   template <typename M> gf<M, matrix_valued> inverse(gf<M, matrix_valued> const &g) {
     auto res                    = g;
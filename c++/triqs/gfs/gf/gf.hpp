@@ -58,6 +58,9 @@ namespace triqs::gfs {
     is_instantiation_of_v<gf_const_view, G>;
   template <typename G> inline constexpr bool is_gf_v<G, typename std::decay_t<G>::variable_t> = is_gf_v<G, void>;
 
+  // is_gf_expr<G> : G is a lazy expression of Green functions (cf gf_expr.hpp)
+  template <typename T> struct is_gf_expr : std::false_type {};
+
   /// ---------------------------  implementation  ---------------------------------
 
   namespace details {
@@ -361,7 +364,10 @@ namespace triqs::gfs {
     template <typename RHS> gf &operator=(RHS &&rhs) REQUIRES(GreenFunction<RHS>::value) {
       _mesh = rhs.mesh();
       _data.resize(rhs.data_shape());
-      for (auto const &w : _mesh) (*this)[w] = rhs[w];
+      if constexpr (is_gf_expr<std::decay_t<RHS>>::value)
+        fused_assign(view_type{*this}, rhs);
+      else
+        for (auto const &w : _mesh) (*this)[w] = rhs[w];
       _indices = rhs.indices();
       if (_indices.empty()) _indices = indices_t(target_shape());
       //if (not _indices.has_shape(target_shape())) _indices = indices_t(target_shape());
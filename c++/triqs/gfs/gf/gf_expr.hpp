@@ -19,6 +19,9 @@
 
 #pragma once
 #include <triqs/utility/expression_template_tools.hpp>
+#include <triqs/arrays/linalg/batched_inverse.hpp>
+#include <triqs/utility/parallel_for.hpp>
+#include <vector>
 namespace triqs {
   namespace gfs {
 
@@ -163,9 +166,40 @@ namespace triqs {
       friend std::ostream &operator<<(std::ostream &sout, gf_unary_m_expr const &expr) { return sout << '-' << expr.l; }
     };
 
-    template <typename T> struct is_gf_expr : std::false_type {};
+    // -------------------------------------------------------------------
+    // the inverse of the matrices of an expression, point by point
+    template <typename L> struct gf_inverse_expr : TRIQS_CONCEPT_TAG_NAME(GreenFunction) {
+      using L_t        = typename std::remove_reference<L>::type;
+      using variable_t = typename L_t::variable_t;
+      using target_t   = typename L_t::target_t;
+      static_assert(target_t::is_matrix or target_t::rank == 0, "inverse : the expression must be scalar or matrix valued");
+
+      L l;
+      template <typename LL> gf_inverse_expr(LL &&l_) : l(std::forward<LL>(l_)) {}
+
+      decltype(auto) mesh() const { return l.mesh(); }
+      auto data_shape() const { return l.data_shape(); }
+      decltype(auto) indices() const { return l.indices(); }
+
+      template <typename KeyType> auto operator[](KeyType &&key) const { return _inv(l[key]); }
+      template <typename... Args> auto operator()(Args &&... args) const { return _inv(l(std::forward<Args>(args)...)); }
+      friend std::ostream &operator<<(std::ostream &sout, gf_inverse_expr const &expr) { return sout << "inverse(" << expr.l << ")"; }
+
+      private:
+      template <typename X> static auto _inv(X const &x) {
+        using scalar_t = typename target_t::scalar_t;
+        if constexpr (target_t::rank == 0)
+          return scalar_t(1) / x;
+        else
+          return arrays::matrix<scalar_t>(arrays::inverse(arrays::matrix<scalar_t>(x)));
+      }
+    };
+
     template <typename Tag, typename L, typename R> struct is_gf_expr<gf_expr<Tag, L, R>> : std::true_type {};
     template <typename L> struct is_gf_expr<gf_unary_m_expr<L>> : std::true_type {};
+    template <typename L> struct is_gf_expr<gf_inverse_expr<L>> : std::true_type {};
+
+    template <typename L> gf(gf_inverse_expr<L> const &)->gf<typename gf_inverse_expr<L>::variable_t, typename gf_inverse_expr<L>::target_t>;
 
 // -------------------------------------------------------------------
 // Now we can define all the C++ operators ...
@@ -191,6 +225,16 @@ namespace triqs {
       return {std::forward<A1>(a1)};
     }
 
+    /**
+     * The lazy inverse of the matrices of a gf expression, point by point
+     *
+     * Unlike inverse(g) for a gf, which returns a new gf, the inverse of an expression is part of the expression,
+     * e.g. inverse(g0_inv - sigma) * w is evaluated without intermediate gf (cf fused_assign).
+     */
+    template <typename E> std::enable_if_t<is_gf_expr<std::decay_t<E>>::value, gf_inverse_expr<gfs_expr_tools::node_t<E>>> inverse(E &&e) {
+      return {std::forward<E>(e)};
+    }
+
     // Now the inplace operator. Because of expression template, there are useless for speed
     // we implement them trivially.
 
@@ -204,5 +248,226 @@ namespace triqs {
     DEFINE_OPERATOR(/=, /);
 
 #undef DEFINE_OPERATOR
+
+    // -------------------------------------------------------------------
+    // Fused evaluation of the expressions, by chunks of mesh points
+
+    namespace gfs_expr_tools {
+
+      // The nodes which can be evaluated by chunks : complex scalar or matrix valued gf on a single mesh, and their expressions
+      template <typename N> struct is_fusable : std::false_type {};
+      template <typename S> struct is_fusable<scalar_wrap<S>> : std::true_type {};
+      template <typename V, typename T>
+      struct _fusable_gf : std::bool_constant<get_n_variables<V>::value == 1 and (std::is_same_v<T, matrix_valued> or std::is_same_v<T, scalar_valued>)> {};
+      template <typename V, typename T> struct is_fusable<gf<V, T>> : _fusable_gf<V, T> {};
+      template <typename V, typename T> struct is_fusable<gf_view<V, T>> : _fusable_gf<V, T> {};
+      template <typename V, typename T> struct is_fusable<gf_const_view<V, T>> : _fusable_gf<V, T> {};
+      template <typename Tag, typename L, typename R>
+      struct is_fusable<gf_expr<Tag, L, R>> : std::bool_constant<is_fusable<std::decay_t<L>>::value and is_fusable<std::decay_t<R>>::value> {};
+      template <typename L> struct is_fusable<gf_unary_m_expr<L>> : is_fusable<std::decay_t<L>> {};
+      template <typename L> struct is_fusable<gf_inverse_expr<L>> : is_fusable<std::decay_t<L>> {};
+
+      template <typename N> struct is_scalar_node : std::false_type {};
+      template <typename S> struct is_scalar_node<scalar_wrap<S>> : std::true_type {};
+
+      // Number of chunk buffers used to evaluate a node (and its children)
+      template <typename N> struct n_buffers : std::integral_constant<int, 0> {};
+      template <typename Tag, typename L, typename R>
+      struct n_buffers<gf_expr<Tag, L, R>>
+         : std::integral_constant<int, 1 + n_buffers<std::decay_t<L>>::value + n_buffers<std::decay_t<R>>::value
+                                          + (std::is_same_v<Tag, utility::tags::divides> and !is_scalar_node<std::decay_t<L>>::value
+                                             and !is_scalar_node<std::decay_t<R>>::value)> {};
+      template <typename L> struct n_buffers<gf_unary_m_expr<L>> : std::integral_constant<int, 1 + n_buffers<std::decay_t<L>>::value> {};
+      template <typename L> struct n_buffers<gf_inverse_expr<L>> : std::integral_constant<int, 1 + n_buffers<std::decay_t<L>>::value> {};
+
+      // The data of a scalar or matrix valued gf, as an array (mesh point, a, b)
+      template <typename A> arrays::array_const_view<dcomplex, 3> data3(A const &d) {
+        if constexpr (A::rank == 1)
+          return reinterpret_array_add_1x1(arrays::array_const_view<dcomplex, 1>(d));
+        else
+          return d;
+      }
+      inline arrays::array_view<dcomplex, 3> data3(arrays::array_view<dcomplex, 3> d) { return d; }
+      inline arrays::array_view<dcomplex, 3> data3(arrays::array_view<dcomplex, 1> d) { return reinterpret_array_add_1x1(d); }
+
+      // The values of a node on the chunk of mesh points : x(i, a, b) for the points i0 + i, with strides
+      struct chunk_t {
+        dcomplex const *p;
+        long s0, s1, s2;
+        dcomplex operator()(long i, long a, long b) const { return p[i * s0 + a * s1 + b * s2]; }
+      };
+
+      // The buffers of one thread, for the chunk of mesh points [i0, i1)
+      struct workspace {
+        long n1, n2, i0 = 0, i1 = 0;
+        std::vector<arrays::array<dcomplex, 3>> buffers;
+
+        workspace(int n_buf, long chunk, long n1_, long n2_) : n1(n1_), n2(n2_), buffers(n_buf, arrays::array<dcomplex, 3>(chunk, n1_, n2_)) {}
+
+        long size() const { return i1 - i0; }
+        dcomplex *buffer(int k) { return buffers[k].data_start(); }
+        arrays::array_view<dcomplex, 3> buffer_view(int k) { return buffers[k](arrays::range(0, size()), arrays::range(), arrays::range()); }
+        chunk_t as_chunk(int k) { return {buffer(k), n1 * n2, n2, 1}; }
+
+        // out(i, a, b) = f(i, a, b) on the chunk, for the contiguous buffer out
+        template <typename F> void fill(dcomplex *out, F f) const {
+          for (long i = 0; i < size(); ++i)
+            for (long a = 0; a < n1; ++a)
+              for (long b = 0; b < n2; ++b) *out++ = f(i, a, b);
+        }
+
+        // out(i) = x(i) * y(i), matrix product for each point
+        void matmul(chunk_t x, chunk_t y, dcomplex *out) const {
+          if (n1 != n2) TRIQS_RUNTIME_ERROR << "Green Function Expression : matrix product of non square matrices " << n1 << " x " << n2;
+          long n = n1;
+          for (long i = 0; i < size(); ++i) {
+            dcomplex *o = out + i * n * n;
+            std::fill(o, o + n * n, dcomplex{0});
+            for (long a = 0; a < n; ++a)
+              for (long c = 0; c < n; ++c) {
+                dcomplex x_ac = x(i, a, c);
+                for (long b = 0; b < n; ++b) o[a * n + b] += x_ac * y(i, c, b);
+              }
+          }
+        }
+
+        // buffer k = x^{-1}
+        void invert(chunk_t x, int k) {
+          fill(buffer(k), x);
+          arrays::batched_inverse_in_place(buffer_view(k));
+        }
+      };
+
+      // --- evaluation of the nodes on the chunk of the workspace. The node writes in buffer k, its children in the next ones.
+
+      template <typename S> dcomplex eval(scalar_wrap<S> const &s, workspace &, int) { return s.s; }
+
+      template <typename G> std::enable_if_t<is_gf_v<G>, chunk_t> eval(G const &g, workspace &ws, int) {
+        auto d  = data3(g.data());
+        auto st = d.indexmap().strides();
+        return {d.data_start() + ws.i0 * st[0], st[0], st[1], st[2]};
+      }
+
+      template <typename L> chunk_t eval(gf_unary_m_expr<L> const &e, workspace &ws, int k) {
+        auto x = eval(e.l, ws, k + 1);
+        ws.fill(ws.buffer(k), [x](long i, long a, long b) { return -x(i, a, b); });
+        return ws.as_chunk(k);
+      }
+
+      template <typename L> chunk_t eval(gf_inverse_expr<L> const &e, workspace &ws, int k) {
+        ws.invert(eval(e.l, ws, k + 1), k);
+        return ws.as_chunk(k);
+      }
+
+      inline void apply(utility::tags::plus, chunk_t x, chunk_t y, workspace &ws, int k) {
+        ws.fill(ws.buffer(k), [x, y](long i, long a, long b) { return x(i, a, b) + y(i, a, b); });
+      }
+      inline void apply(utility::tags::minus, chunk_t x, chunk_t y, workspace &ws, int k) {
+        ws.fill(ws.buffer(k), [x, y](long i, long a, long b) { return x(i, a, b) - y(i, a, b); });
+      }
+
+      // s + y, x + s, s - y, x - s : the scalar is added on the diagonal, as for the matrices of the point by point evaluation
+      inline void apply(utility::tags::plus, dcomplex s, chunk_t y, workspace &ws, int k) {
+        ws.fill(ws.buffer(k), [s, y](long i, long a, long b) { return (a == b ? s : dcomplex{0}) + y(i, a, b); });
+      }
+      inline void apply(utility::tags::plus, chunk_t x, dcomplex s, workspace &ws, int k) {
+        ws.fill(ws.buffer(k), [s, x](long i, long a, long b) { return x(i, a, b) + (a == b ? s : dcomplex{0}); });
+      }
+      inline void apply(utility::tags::minus, dcomplex s, chunk_t y, workspace &ws, int k) {
+        ws.fill(ws.buffer(k), [s, y](long i, long a, long b) { return (a == b ? s : dcomplex{0}) - y(i, a, b); });
+      }
+      inline void apply(utility::tags::minus, chunk_t x, dcomplex s, workspace &ws, int k) {
+        ws.fill(ws.buffer(k), [s, x](long i, long a, long b) { return x(i, a, b) - (a == b ? s : dcomplex{0}); });
+      }
+
+      inline void apply(utility::tags::multiplies, chunk_t x, chunk_t y, workspace &ws, int k) { ws.matmul(x, y, ws.buffer(k)); }
+      inline void apply(utility::tags::multiplies, dcomplex s, chunk_t y, workspace &ws, int k) {
+        ws.fill(ws.buffer(k), [s, y](long i, long a, long b) { return s * y(i, a, b); });
+      }
+      inline void apply(utility::tags::multiplies, chunk_t x, dcomplex s, workspace &ws, int k) {
+        ws.fill(ws.buffer(k), [s, x](long i, long a, long b) { return x(i, a, b) * s; });
+      }
+
+      // x / y = x * y^{-1}. The inverse goes in the extra buffer k + 1 + n_buffers of the children
+      inline void apply(utility::tags::divides, chunk_t x, chunk_t y, workspace &ws, int k, int k_extra) {
+        ws.invert(y, k_extra);
+        ws.matmul(x, ws.as_chunk(k_extra), ws.buffer(k));
+      }
+      inline void apply(utility::tags::divides, dcomplex s, chunk_t y, workspace &ws, int k, int) {
+        ws.invert(y, k);
+        dcomplex *o = ws.buffer(k);
+        for (long j = 0; j < ws.size() * ws.n1 * ws.n2; ++j) o[j] *= s;
+      }
+      inline void apply(utility::tags::divides, chunk_t x, dcomplex s, workspace &ws, int k, int) {
+        ws.fill(ws.buffer(k), [s, x](long i, long a, long b) { return x(i, a, b) / s; });
+      }
+
+      template <typename Tag, typename L, typename R> chunk_t eval(gf_expr<Tag, L, R> const &e, workspace &ws, int k) {
+        int k_l = k + 1, k_r = k_l + n_buffers<std::decay_t<L>>::value, k_extra = k_r + n_buffers<std::decay_t<R>>::value;
+        auto x = eval(e.l, ws, k_l);
+        auto y = eval(e.r, ws, k_r);
+        if constexpr (std::is_same_v<Tag, utility::tags::divides>)
+          apply(Tag{}, x, y, ws, k, k_extra);
+        else
+          apply(Tag{}, x, y, ws, k);
+        return ws.as_chunk(k);
+      }
+
+      // dst = e, by chunks of mesh points, in n_threads threads
+      template <typename E> void fused_eval(E const &e, arrays::array_view<dcomplex, 3> dst, int n_threads) {
+        long n_pts = first_dim(dst), n1 = second_dim(dst), n2 = third_dim(dst);
+        if (n_pts == 0 or n1 * n2 == 0) return;
+
+        // The buffers of a chunk stay in the L1 cache
+        long chunk = std::max(8l, 2048 / (n1 * n2));
+
+        dcomplex *q  = dst.data_start();
+        auto const st = dst.indexmap().strides();
+
+        auto run = [&](long j0, long j1) {
+          auto ws = workspace(n_buffers<E>::value, std::min(chunk, j1 - j0), n1, n2);
+          for (ws.i0 = j0; ws.i0 < j1; ws.i0 = ws.i1) {
+            ws.i1  = std::min(ws.i0 + chunk, j1);
+            auto r = eval(e, ws, 0);
+            for (long i = 0; i < ws.size(); ++i)
+              for (long a = 0; a < n1; ++a)
+                for (long b = 0; b < n2; ++b) q[(ws.i0 + i) * st[0] + a * st[1] + b * st[2]] = r(i, a, b);
+          }
+        };
+
+        // Split the mesh in n_threads contiguous parts
+        utility::parallel_for_chunks(n_pts, n_threads, run);
+      }
+
+    } // namespace gfs_expr_tools
+
+    /**
+     * Assigns a gf expression to g, in a single pass over the mesh
+     *
+     * For complex scalar or matrix valued Green functions on a single mesh, the expression, including
+     * the matrix products, divisions and inverse(...), is evaluated by chunks of mesh points, in buffers
+     * allocated once per thread, without intermediate gf or matrix. The inverses of a chunk are computed
+     * together (cf batched_inverse_in_place). Other expressions are evaluated point by point.
+     * Each point of the result only depends on the same point of the operands, hence g may appear in expr.
+     *
+     * The assignment g = expr uses this function, with one thread.
+     *
+     * @param g The Green function, of the mesh and shape of the expression
+     * @param expr The expression
+     * @param n_threads Number of threads over which the mesh points are distributed
+     */
+    template <typename V, typename T, typename E> void fused_assign(gf_view<V, T> g, E const &expr, int n_threads = 1) {
+      if (!(g.mesh() == expr.mesh())) TRIQS_RUNTIME_ERROR << "fused_assign : incompatible mesh \n" << g.mesh() << "\n vs \n" << expr.mesh();
+      if (!(g.data_shape() == expr.data_shape())) TRIQS_RUNTIME_ERROR << "fused_assign : shape mismatch " << g.data_shape() << " vs " << expr.data_shape();
+      if constexpr (gfs_expr_tools::is_fusable<gf_view<V, T>>::value and gfs_expr_tools::is_fusable<E>::value)
+        gfs_expr_tools::fused_eval(expr, gfs_expr_tools::data3(g.data()), n_threads);
+      else
+        for (auto const &w : g.mesh()) g[w] = expr[w];
+    }
+
+    template <typename V, typename T, typename E> void fused_assign(gf<V, T> &g, E const &expr, int n_threads = 1) {
+      fused_assign(gf_view<V, T>{g}, expr, n_threads);
+    }
+
   } // namespace gfs
 } // namespace triqs
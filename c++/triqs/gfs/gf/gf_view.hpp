@@ -332,7 +332,10 @@ namespace triqs::gfs {
       for (auto const &w : g.mesh()) g[w] = rhs;
     } else {
       if (!(g.mesh() == rhs.mesh())) TRIQS_RUNTIME_ERROR << "Gf Assignment in View : incompatible mesh \n" << g.mesh() << "\n vs \n" << rhs.mesh();
-      for (auto const &w : g.mesh()) g[w] = rhs[w];
+      if constexpr (is_gf_expr<RHS>::value)
+        fused_assign(g, rhs);
+      else
+        for (auto const &w : g.mesh()) g[w] = rhs[w];
     }
   }
 } // namespace triqs::gfs
@@ -0,0 +1,104 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#pragma once
+#include "../domains/dlr.hpp"
+#include "./discrete.hpp"
+
+namespace triqs {
+  namespace gfs {
+
+    /*----------------------------------------------------------------------------------------------------
+     * The meshes of the Discrete Lehmann Representation (cf dlr_basis). For a given domain, they have the same size r :
+     *
+     *   - dlr        : the coefficients g_l of the poles omega_l,
+     *   - dlr_imtime : the values of G at the r sampling points in imaginary time,
+     *   - dlr_imfreq : the values of G at the r sampling Matsubara frequencies.
+     *
+     * Cf transform/dlr.hpp for the transformations between them, and to/from imtime and imfreq.
+     *--------------------------------------------------------------------------------------------------*/
+
+    struct dlr {};
+    struct dlr_imtime {};
+    struct dlr_imfreq {};
+
+    template <> struct gf_mesh<dlr> : gf_mesh<discrete<dlr_domain>> {
+      using B     = gf_mesh<discrete<dlr_domain>>;
+      using var_t = dlr;
+
+      gf_mesh() = default;
+      gf_mesh(dlr_domain dom) : B(std::move(dom)) {}
+
+      /**
+       * @param beta    Inverse temperature
+       * @param S       Statistic
+       * @param lambda  Dimensionless cutoff beta * omega_max
+       * @param eps     Accuracy of the representation
+       */
+      gf_mesh(double beta, statistic_enum S, double lambda, double eps) : B(dlr_domain(beta, S, lambda, eps)) {}
+
+      /// The real frequency of the pole l
+      double omega(long l) const { return domain().basis->omega()[l] / domain().beta; }
+
+      static std::string hdf5_format() { return "MeshDLR"; }
+
+      friend void h5_write(h5::group fg, std::string const &subgroup_name, gf_mesh const &m) { h5_write_impl(fg, subgroup_name, m, "MeshDLR"); }
+
+      friend void h5_read(h5::group fg, std::string const &subgroup_name, gf_mesh &m) { h5_read_impl(fg, subgroup_name, m, "MeshDLR"); }
+    };
+
+    template <> struct gf_mesh<dlr_imtime> : gf_mesh<discrete<dlr_domain>> {
+      using B     = gf_mesh<discrete<dlr_domain>>;
+      using var_t = dlr_imtime;
+
+      gf_mesh() = default;
+      gf_mesh(dlr_domain dom) : B(std::move(dom)) {}
+      gf_mesh(double beta, statistic_enum S, double lambda, double eps) : B(dlr_domain(beta, S, lambda, eps)) {}
+
+      /// The imaginary time of the sampling point k
+      double tau(long k) const { return domain().basis->tau()[k] * domain().beta; }
+
+      static std::string hdf5_format() { return "MeshDLRImTime"; }
+
+      friend void h5_write(h5::group fg, std::string const &subgroup_name, gf_mesh const &m) { h5_write_impl(fg, subgroup_name, m, "MeshDLRImTime"); }
+
+      friend void h5_read(h5::group fg, std::string const &subgroup_name, gf_mesh &m) { h5_read_impl(fg, subgroup_name, m, "MeshDLRImTime"); }
+    };
+
+    template <> struct gf_mesh<dlr_imfreq> : gf_mesh<discrete<dlr_domain>> {
+      using B     = gf_mesh<discrete<dlr_domain>>;
+      using var_t = dlr_imfreq;
+
+      gf_mesh() = default;
+      gf_mesh(dlr_domain dom) : B(std::move(dom)) {}
+      gf_mesh(double beta, statistic_enum S, double lambda, double eps) : B(dlr_domain(beta, S, lambda, eps)) {}
+
+      /// The index n of the sampling Matsubara frequency k
+      long matsubara_index(long k) const { return domain().basis->iw_n(domain().statistic)[k]; }
+
+      /// The sampling Matsubara frequency k
+      matsubara_freq matsubara_frequency(long k) const { return {matsubara_index(k), domain().beta, domain().statistic}; }
+
+      static std::string hdf5_format() { return "MeshDLRImFreq"; }
+
+      friend void h5_write(h5::group fg, std::string const &subgroup_name, gf_mesh const &m) { h5_write_impl(fg, subgroup_name, m, "MeshDLRImFreq"); }
+
+      friend void h5_read(h5::group fg, std::string const &subgroup_name, gf_mesh &m) { h5_read_impl(fg, subgroup_name, m, "MeshDLRImFreq"); }
+    };
+
+  } // namespace gfs
+} // namespace triqs
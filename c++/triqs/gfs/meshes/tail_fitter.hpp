@@ -194,17 +194,49 @@ namespace triqs::gfs {
     template <bool enforce_hermiticity = false, typename M, int R, int R2 = R>
     std::pair<arrays::array<dcomplex, R>, double> fit(M const &m, array_const_view<dcomplex, R> g_data, int n, bool normalize,
                                                       array_const_view<dcomplex, R2> known_moments, std::optional<long> inner_matrix_dim = {}) {
+      static_assert((R == R2), "The rank of the moment array is not equal to the data to fit !!!");
+      using v_t           = std::vector<array_const_view<dcomplex, R>>;
+      auto [res, epsilon] = fit_batch<enforce_hermiticity>(m, v_t{g_data}, n, normalize, v_t{known_moments}, inner_matrix_dim);
+      return {std::move(res[0]), epsilon};
+    }
+
+    /**
+     * Fit the tails of several data arrays on the same mesh m, as one least-square problem with many right-hand sides.
+     * The data points in the tail of all the arrays are gathered in a single matrix, and the least-square solver is applied once.
+     *
+     * @param m mesh
+     * @param g_data The data arrays, with the omega at position n
+     * @param n position of the omega in the data arrays
+     * @param normalize Finish the normalization of the tail coefficient (normally true)
+     * @param known_moments  The known_moments of each data array (or empty). They must all have the same number of moments.
+     * @return The tails of each data array, and the largest fitting error
+     * */
+    template <bool enforce_hermiticity = false, typename M, int R>
+    std::pair<std::vector<arrays::array<dcomplex, R>>, double> fit_batch(M const &m, std::vector<array_const_view<dcomplex, R>> const &g_data, int n,
+                                                                         bool normalize, std::vector<array_const_view<dcomplex, R>> const &known_moments,
+                                                                         std::optional<long> inner_matrix_dim = {}) {
 
       if (enforce_hermiticity and not inner_matrix_dim.has_value())
         TRIQS_RUNTIME_ERROR << "Enforcing the hermiticity in tail_fit requires inner matrix dimension";
       if constexpr (enforce_hermiticity)
         static_assert(std::is_same_v<typename M::var_t, imfreq>, "Enforcing the hermiticity in tail_fit requires Matsubara mesh");
-      static_assert((R == R2), "The rank of the moment array is not equal to the data to fit !!!");
       if (m.positive_only()) TRIQS_RUNTIME_ERROR << "Can not fit on a positive_only mesh";
 
+      long n_g = g_data.size();
+      if (not known_moments.empty() and known_moments.size() != g_data.size())
+        TRIQS_RUNTIME_ERROR << "Tail fit : the number of known_moments arrays (" << known_moments.size() << ") differs from the number of data arrays (" << n_g
+                            << ")";
+      auto km = [&known_moments](long i) { return (known_moments.empty() ? array_const_view<dcomplex, R>{} : known_moments[i]); };
+
       // If not set, build least square solver for for given number of known moments
-      int n_fixed_moments = first_dim(known_moments);
-      if (n_fixed_moments > _expansion_order) return {known_moments, 0.0};
+      int n_fixed_moments = (n_g == 0 ? 0 : first_dim(km(0)));
+      for (long i : range(n_g))
+        if (first_dim(km(i)) != n_fixed_moments) TRIQS_RUNTIME_ERROR << "Tail fit : all the data arrays must have the same number of known moments";
+      if (n_fixed_moments > _expansion_order) {
+        std::vector<arrays::array<dcomplex, R>> res;
+        for (long i : range(n_g)) res.emplace_back(km(i));
+        return {std::move(res), 0.0};
+      }
 
       auto &lss = get_lss<enforce_hermiticity>();
       if (!bool(lss[n_fixed_moments])) setup_lss<enforce_hermiticity>(m, n_fixed_moments);
@@ -215,41 +247,51 @@ namespace triqs::gfs {
       using triqs::arrays::ellipsis;
       using itertools::enumerate;
 
-      // The values of the Green function. Swap relevant mesh to front
-      auto g_data_swap_idx = rotate_index_view(g_data, n);
-      auto const &imp      = g_data_swap_idx.indexmap();
-      long ncols           = imp.size() / imp.lengths()[0];
+      // The values of the Green functions. Swap relevant mesh to front
+      // We flatten the data in the target space and remaining meshes into the second dim, the arrays one after the other
+      std::vector<array_const_view<dcomplex, R>> g_data_swap_idx;
+      std::vector<long> col_offset(1, 0);
+      for (auto const &d : g_data) {
+        g_data_swap_idx.push_back(rotate_index_view(d, n));
+        auto const &imp = g_data_swap_idx.back().indexmap();
+        col_offset.push_back(col_offset.back() + imp.size() / imp.lengths()[0]);
+      }
+      long ncols = col_offset.back();
 
-      // We flatten the data in the target space and remaining meshes into the second dim
       arrays::matrix<dcomplex> g_mat(first_dim(_vander), ncols);
 
       // Copy g_data into new matrix (necessary because g_data might have fancy strides/lengths)
-      for (auto [i, n] : enumerate(_fit_idx_lst)) {
-        if constexpr (R == 1)
-          g_mat(i, 0) = g_data_swap_idx(m.index_to_linear(n));
-        else
-          for (auto [j, x] : enumerate(g_data_swap_idx(m.index_to_linear(n), ellipsis()))) g_mat(i, j) = x;
+      for (auto [k, g] : enumerate(g_data_swap_idx)) {
+        for (auto [i, n] : enumerate(_fit_idx_lst)) {
+          if constexpr (R == 1)
+            g_mat(i, col_offset[k]) = g(m.index_to_linear(n));
+          else
+            for (auto [j, x] : enumerate(g(m.index_to_linear(n), ellipsis()))) g_mat(i, col_offset[k] + j) = x;
+        }
       }
 
-      // If an array with known_moments was passed, flatten the array into a matrix
+      // If arrays with known_moments were passed, flatten them into a matrix
       // just like g_data. Then account for the proper shift in g_mat
       if (n_fixed_moments > 0) {
-        auto imp_km   = known_moments.indexmap();
-        long ncols_km = imp_km.size() / imp_km.lengths()[0];
-
-        if (ncols != ncols_km) TRIQS_RUNTIME_ERROR << "known_moments shape incompatible with shape of data";
         arrays::matrix<dcomplex> km_mat(n_fixed_moments, ncols);
 
-        // We have to scale the known_moments by 1/Omega_max^n
-        double z = 1.0;
-	double om_max = std::abs(m.omega_max());
-
-        for (int order : range(n_fixed_moments)) {
-          if constexpr (R == 1)
-            km_mat(order, 0) = z * known_moments(order, ellipsis());
-          else
-            for (auto [n, x] : enumerate(known_moments(order, ellipsis()))) km_mat(order, n) = z * x;
-          z /= om_max;
+        for (long k : range(n_g)) {
+          auto km_k          = km(k);
+          auto const &imp_km = km_k.indexmap();
+          if (col_offset[k + 1] - col_offset[k] != imp_km.size() / imp_km.lengths()[0])
+            TRIQS_RUNTIME_ERROR << "known_moments shape incompatible with shape of data";
+
+          // We have to scale the known_moments by 1/Omega_max^n
+          double z      = 1.0;
+          double om_max = std::abs(m.omega_max());
+
+          for (int order : range(n_fixed_moments)) {
+            if constexpr (R == 1)
+              km_mat(order, col_offset[k]) = z * km_k(order, ellipsis());
+            else
+              for (auto [n, x] : enumerate(km_k(order, ellipsis()))) km_mat(order, col_offset[k] + n) = z * x;
+            z /= om_max;
+          }
         }
 
         // Shift g_mat to account for known moment correction
@@ -262,8 +304,8 @@ namespace triqs::gfs {
       // === The result a_mat contains the fitted moments divided by omega_max()^n
       // Here we extract the real moments
       if (normalize) {
-        double z = 1.0;
-	double om_max = std::abs(m.omega_max());
+        double z      = 1.0;
+        double om_max = std::abs(m.omega_max());
         for (int i : range(n_fixed_moments)) z *= om_max;
         for (int i : range(first_dim(a_mat))) {
           a_mat(i, range()) *= z;
@@ -271,23 +313,30 @@ namespace triqs::gfs {
         }
       }
 
-      // === Reinterpret the result as an R-dimensional array according to initial shape and return together with the error
+      // === Reinterpret the result as R-dimensional arrays according to the initial shapes and return together with the error
 
       using r_t = arrays::array<dcomplex, R>; // return type
-      auto lg   = g_data_swap_idx.indexmap().lengths();
+      std::vector<r_t> res_vec;
+      res_vec.reserve(n_g);
 
-      // Index map for the view on the a_mat result
-      lg[0]     = n_moments - n_fixed_moments;
-      auto imp1 = typename r_t::indexmap_type{typename r_t::indexmap_type::domain_type{lg}};
+      for (long k : range(n_g)) {
+        auto lg = g_data_swap_idx[k].indexmap().lengths();
 
-      // Index map for the full result
-      lg[0]    = n_moments;
-      auto res = r_t(typename r_t::indexmap_type::domain_type{lg});
+        // Index map for the view on the columns of a_mat for this array
+        lg[0]       = n_moments - n_fixed_moments;
+        auto imp1   = typename r_t::indexmap_type{typename r_t::indexmap_type::domain_type{lg}};
+        auto a_cols = arrays::matrix<dcomplex>{a_mat(range(), range(col_offset[k], col_offset[k + 1])), arrays::memory_layout_t<2>{}}; // C layout
 
-      if (n_fixed_moments) res(range(n_fixed_moments), ellipsis()) = known_moments;
-      res(range(n_fixed_moments, n_moments), ellipsis()) = typename r_t::view_type{imp1, a_mat.storage()};
+        // Index map for the full result
+        lg[0]    = n_moments;
+        auto res = r_t(typename r_t::indexmap_type::domain_type{lg});
+
+        if (n_fixed_moments) res(range(n_fixed_moments), ellipsis()) = km(k);
+        res(range(n_fixed_moments, n_moments), ellipsis()) = typename r_t::view_type{imp1, a_cols.storage()};
+        res_vec.push_back(std::move(res));
+      }
 
-      return {std::move(res), epsilon};
+      return {std::move(res_vec), epsilon};
     }
 
     template <typename M, int R, int R2 = R>
@@ -0,0 +1,58 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include "../../gfs.hpp"
+#include <triqs/arrays/blas_lapack/gelss.hpp>
+
+namespace triqs::gfs {
+
+  matrix<dcomplex> _dlr_kernel(dlr_domain const &d, gf_mesh<imtime> const &m) {
+    if (d.statistic != m.domain().statistic) TRIQS_RUNTIME_ERROR << "DLR : the statistic of the mesh differs from the one of the DLR domain";
+    auto const &om = d.basis->omega();
+    auto K         = matrix<dcomplex>(m.size(), om.size());
+    for (auto const &t : m)
+      for (long l = 0; l < long(om.size()); ++l) K(t.linear_index(), l) = dlr_basis::k_tau(double(t) / d.beta, om[l]);
+    return K;
+  }
+
+  //-------------------------------------------------------
+
+  matrix<dcomplex> _dlr_kernel(dlr_domain const &d, gf_mesh<imfreq> const &m) {
+    if (d.statistic != m.domain().statistic) TRIQS_RUNTIME_ERROR << "DLR : the statistic of the mesh differs from the one of the DLR domain";
+    auto const &om = d.basis->omega();
+    auto K         = matrix<dcomplex>(m.size(), om.size());
+    for (auto const &w : m)
+      for (long l = 0; l < long(om.size()); ++l) K(w.linear_index(), l) = d.beta * dlr_basis::k_iw(w.n, om[l], d.statistic);
+    return K;
+  }
+
+  //-------------------------------------------------------
+
+  array<dcomplex, 2> _dlr_fit(matrix<dcomplex> const &K, array_const_view<dcomplex, 2> data) {
+    long r = second_dim(K);
+    if (first_dim(K) < r) TRIQS_RUNTIME_ERROR << "DLR : the mesh has less points (" << first_dim(K) << ") than the rank of the DLR basis (" << r << ")";
+
+    // gelss overwrites B with the solution, in its first r rows
+    auto B = matrix<dcomplex>(data, FORTRAN_LAYOUT);
+    auto S = arrays::vector<double>(r);
+    int rank;
+    int info = arrays::lapack::gelss(K, B, S, -1, rank);
+    if (info != 0) TRIQS_RUNTIME_ERROR << "DLR : the least-square fit failed, gelss returned info = " << info;
+    return array<dcomplex, 2>(B(range(0, r), range()));
+  }
+
+} // namespace triqs::gfs
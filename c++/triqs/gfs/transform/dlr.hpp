@@ -0,0 +1,173 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#pragma once
+#include "../../gfs.hpp"
+
+namespace triqs::gfs {
+
+  /*------------------------------------------------------------------------------------------------------
+            Implementation
+  *-----------------------------------------------------------------------------------------------------*/
+
+  // The kernel matrices (mesh point, pole) : G(x) = sum_l K(x, l) g_l
+  matrix<dcomplex> _dlr_kernel(dlr_domain const &d, gf_mesh<imtime> const &m);
+  matrix<dcomplex> _dlr_kernel(dlr_domain const &d, gf_mesh<imfreq> const &m);
+
+  // Least square fit of the coefficients g_l to the data(x, i), for all i, with the kernel K.
+  // For the r x r kernels at the sampling points, it is a (backward stable) linear solve.
+  array<dcomplex, 2> _dlr_fit(matrix<dcomplex> const &K, array_const_view<dcomplex, 2> data);
+
+  // internal. The data of g as a complex matrix (mesh point, all the target indices)
+  template <typename G> array<dcomplex, 2> _dlr_data_2d(G const &g) {
+    if constexpr (std::decay_t<G>::target_t::is_real)
+      return array<dcomplex, 2>(flatten_2d(make_const_view(g.data()), 0));
+    else
+      return flatten_2d(make_const_view(g.data()), 0);
+  }
+
+  // internal. A new Green function on mesh with the data res (mesh point, all the target indices)
+  template <typename T, typename V, typename S, typename R> gf<V, T> _dlr_make_gf(gf_mesh<V> const &mesh, S const &shape, R const &res) {
+    auto g = gf<V, T>{mesh, shape};
+    if constexpr (T::is_real)
+      _as_matrix_view(g.data()) = real(res);
+    else
+      _as_matrix_view(g.data()) = res;
+    return g;
+  }
+
+  // internal. K * data
+  inline array<dcomplex, 2> _dlr_apply(matrix<dcomplex> const &K, array<dcomplex, 2> const &data) {
+    return array<dcomplex, 2>(K * make_matrix_view(data));
+  }
+
+  /*------------------------------------------------------------------------------------------------------
+   *
+   * The DLR coefficients from the values at the DLR sampling points, and back.
+   * These are r x r transformations, with r the rank of the basis.
+   *
+   *-----------------------------------------------------------------------------------------------------*/
+
+  /// The DLR coefficients of G, from its values at the sampling points in imaginary time
+  template <typename T> gf<dlr, T> make_gf_dlr(gf_const_view<dlr_imtime, T> g) {
+    auto const &d = g.mesh().domain();
+    return _dlr_make_gf<T>(gf_mesh<dlr>{d}, g.target_shape(), _dlr_fit(d.basis->k_tau_matrix(), _dlr_data_2d(g)));
+  }
+
+  /// The DLR coefficients of G, from its values at the sampling Matsubara frequencies
+  template <typename T> gf<dlr, T> make_gf_dlr(gf_const_view<dlr_imfreq, T> g) {
+    auto const &d = g.mesh().domain();
+    auto data     = _dlr_data_2d(g);
+    data /= d.beta;
+    return _dlr_make_gf<T>(gf_mesh<dlr>{d}, g.target_shape(), _dlr_fit(d.basis->k_iw_matrix(d.statistic), data));
+  }
+
+  /// The values of G at the DLR sampling points in imaginary time, from its DLR coefficients
+  template <typename T> gf<dlr_imtime, T> make_gf_dlr_imtime(gf_const_view<dlr, T> g) {
+    auto const &d = g.mesh().domain();
+    return _dlr_make_gf<T>(gf_mesh<dlr_imtime>{d}, g.target_shape(), _dlr_apply(d.basis->k_tau_matrix(), _dlr_data_2d(g)));
+  }
+
+  /// The values of G at the DLR sampling Matsubara frequencies, from its DLR coefficients
+  template <typename T> gf<dlr_imfreq, typename T::complex_t> make_gf_dlr_imfreq(gf_const_view<dlr, T> g) {
+    auto const &d = g.mesh().domain();
+    auto res      = _dlr_apply(d.basis->k_iw_matrix(d.statistic), _dlr_data_2d(g));
+    res *= d.beta;
+    return _dlr_make_gf<typename T::complex_t>(gf_mesh<dlr_imfreq>{d}, g.target_shape(), res);
+  }
+
+  /*------------------------------------------------------------------------------------------------------
+   *
+   * From the DLR coefficients to the regular imtime and imfreq meshes
+   *
+   *-----------------------------------------------------------------------------------------------------*/
+
+  /**
+   * G(tau) on a regular imaginary time mesh, from its DLR coefficients
+   *
+   * @param g      The DLR coefficients
+   * @param n_tau  Number of points of the imaginary time mesh
+   */
+  template <typename T> gf<imtime, T> make_gf_imtime(gf_const_view<dlr, T> g, long n_tau) {
+    auto const &d = g.mesh().domain();
+    auto mesh     = gf_mesh<imtime>{d.beta, d.statistic, n_tau};
+    return _dlr_make_gf<T>(mesh, g.target_shape(), _dlr_apply(_dlr_kernel(d, mesh), _dlr_data_2d(g)));
+  }
+
+  /**
+   * G(i omega_n) on a regular Matsubara mesh, from its DLR coefficients
+   *
+   * @param g     The DLR coefficients
+   * @param n_iw  Number of positive Matsubara frequencies
+   */
+  template <typename T> gf<imfreq, typename T::complex_t> make_gf_imfreq(gf_const_view<dlr, T> g, long n_iw) {
+    auto const &d = g.mesh().domain();
+    auto mesh     = gf_mesh<imfreq>{d.beta, d.statistic, n_iw};
+    return _dlr_make_gf<typename T::complex_t>(mesh, g.target_shape(), _dlr_apply(_dlr_kernel(d, mesh), _dlr_data_2d(g)));
+  }
+
+  /*------------------------------------------------------------------------------------------------------
+   *
+   * From the regular imtime and imfreq meshes to the DLR coefficients
+   *
+   *-----------------------------------------------------------------------------------------------------*/
+
+  /**
+   * The DLR coefficients of G, by a least square fit of G(tau) on a regular imaginary time mesh
+   *
+   * @param g       The Green function
+   * @param lambda  Dimensionless cutoff beta * omega_max. The spectrum of G must be in [-omega_max, omega_max]
+   * @param eps     Accuracy of the representation
+   */
+  template <typename T> gf<dlr, T> fit_gf_dlr(gf_const_view<imtime, T> g, double lambda, double eps) {
+    auto mesh = gf_mesh<dlr>{g.mesh().domain().beta, g.mesh().domain().statistic, lambda, eps};
+    return _dlr_make_gf<T>(mesh, g.target_shape(), _dlr_fit(_dlr_kernel(mesh.domain(), g.mesh()), _dlr_data_2d(g)));
+  }
+
+  /**
+   * The DLR coefficients of G, by a least square fit of G(i omega_n) on a regular Matsubara mesh
+   *
+   * @param g       The Green function
+   * @param lambda  Dimensionless cutoff beta * omega_max. The spectrum of G must be in [-omega_max, omega_max]
+   * @param eps     Accuracy of the representation
+   */
+  template <typename T> gf<dlr, T> fit_gf_dlr(gf_const_view<imfreq, T> g, double lambda, double eps) {
+    auto mesh = gf_mesh<dlr>{g.mesh().domain().beta, g.mesh().domain().statistic, lambda, eps};
+    return _dlr_make_gf<T>(mesh, g.target_shape(), _dlr_fit(_dlr_kernel(mesh.domain(), g.mesh()), _dlr_data_2d(g)));
+  }
+
+  // ----------------------------  gf and gf_view overloads ----------------------------
+
+  template <typename V, typename T> auto make_gf_dlr(gf<V, T> const &g) { return make_gf_dlr(make_const_view(g)); }
+  template <typename V, typename T> auto make_gf_dlr(gf_view<V, T> g) { return make_gf_dlr(make_const_view(g)); }
+
+  template <typename T> auto make_gf_dlr_imtime(gf<dlr, T> const &g) { return make_gf_dlr_imtime(make_const_view(g)); }
+  template <typename T> auto make_gf_dlr_imtime(gf_view<dlr, T> g) { return make_gf_dlr_imtime(make_const_view(g)); }
+
+  template <typename T> auto make_gf_dlr_imfreq(gf<dlr, T> const &g) { return make_gf_dlr_imfreq(make_const_view(g)); }
+  template <typename T> auto make_gf_dlr_imfreq(gf_view<dlr, T> g) { return make_gf_dlr_imfreq(make_const_view(g)); }
+
+  template <typename T> auto make_gf_imtime(gf<dlr, T> const &g, long n_tau) { return make_gf_imtime(make_const_view(g), n_tau); }
+  template <typename T> auto make_gf_imtime(gf_view<dlr, T> g, long n_tau) { return make_gf_imtime(make_const_view(g), n_tau); }
+
+  template <typename T> auto make_gf_imfreq(gf<dlr, T> const &g, long n_iw) { return make_gf_imfreq(make_const_view(g), n_iw); }
+  template <typename T> auto make_gf_imfreq(gf_view<dlr, T> g, long n_iw) { return make_gf_imfreq(make_const_view(g), n_iw); }
+
+  template <typename V, typename T> auto fit_gf_dlr(gf<V, T> const &g, double lambda, double eps) { return fit_gf_dlr(make_const_view(g), lambda, eps); }
+  template <typename V, typename T> auto fit_gf_dlr(gf_view<V, T> g, double lambda, double eps) { return fit_gf_dlr(make_const_view(g), lambda, eps); }
+
+} // namespace triqs::gfs
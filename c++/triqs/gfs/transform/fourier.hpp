@@ -20,6 +20,7 @@
 #pragma once
 #include "./../gf/flatten.hpp"
 #include <triqs/utility/tuple_tools.hpp>
+#include "./fourier_plans.hpp"
 
 namespace triqs::gfs {
 
@@ -88,6 +89,10 @@ namespace triqs::gfs {
   gf_vec_t<cyclic_lattice> _fourier_impl(gf_mesh<cyclic_lattice> const &r_mesh, gf_vec_cvt<brillouin_zone> gk);
   gf_vec_t<brillouin_zone> _fourier_impl(gf_mesh<brillouin_zone> const &k_mesh, gf_vec_cvt<cyclic_lattice> gr);
 
+  // lattice, on the data(x, i) directly, for all i. n_threads : 0 is the global setting
+  void _fourier_lattice_data(gf_mesh<brillouin_zone> const &k_mesh, array_const_view<dcomplex, 2> in, array_view<dcomplex, 2> out, int n_threads);
+  void _fourier_lattice_data(gf_mesh<cyclic_lattice> const &r_mesh, array_const_view<dcomplex, 2> in, array_view<dcomplex, 2> out, int n_threads);
+
   /*------------------------------------------------------------------------------------------------------
    *
    * The general Fourier function
@@ -221,6 +226,57 @@ namespace triqs::gfs {
     return std::move(make_gf_from_fourier<Ns...>(gin(), make_adjoint_mesh(std::get<Ns>(gin.mesh()))...));
   }
 
+  /* *-----------------------------------------------------------------------------------------------------
+   *
+   * make_gf_from_lattice_fourier : Fourier transform of the lattice mesh of a cartesian product, e.g. G(k, iw) -> G(r, iw)
+   *
+   * *-----------------------------------------------------------------------------------------------------*/
+
+  // internal. The view of a C-contiguous array as a matrix (first dimension, all the others)
+  template <typename A> auto _as_matrix_view(A &&a) {
+    using value_t = std::remove_const_t<typename std::decay_t<A>::value_type>;
+    long n0       = first_dim(a);
+    long n1       = (n0 == 0 ? 0 : a.size() / n0);
+    using im_t    = typename array_view<value_t, 2>::indexmap_type;
+    return array_view<value_t, 2>{im_t{make_shape(n0, n1), mini_vector<std::ptrdiff_t, 2>{n1, 1}, std::ptrdiff_t(a.indexmap().start_shift())}, a.storage()};
+  }
+
+  /**
+   * Fourier transform of the lattice mesh of gin, the first mesh of its cartesian product (brillouin_zone or cyclic_lattice),
+   * for all the values of the other meshes and of the target, e.g. G(k, iw) -> G(r, iw).
+   *
+   * The data are transformed from gin into the result in a single batched FFT,
+   * without copying the slices of the other meshes into temporaries.
+   *
+   * @param gin        The Green function
+   * @param n_threads  Number of threads (0 : the global setting, cf set_fourier_n_threads)
+   */
+  template <typename... Vs, typename T> auto make_gf_from_lattice_fourier(gf_const_view<cartesian_product<Vs...>, T> gin, int n_threads = 0) {
+    using V0 = std::tuple_element_t<0, std::tuple<Vs...>>;
+    static_assert(std::is_same_v<V0, brillouin_zone> or std::is_same_v<V0, cyclic_lattice>, "The first mesh must be a lattice mesh");
+
+    auto const &m0 = std::get<0>(gin.mesh());
+    auto out_mesh  = gf_mesh{triqs::tuple::replace<0>(gin.mesh().components(), make_adjoint_mesh(m0))};
+    using var_t    = typename std::decay_t<decltype(out_mesh)>::var_t;
+    auto gout      = gf<var_t, typename T::complex_t>{out_mesh, gin.target_shape()};
+
+    if constexpr (T::is_real)
+      _fourier_lattice_data(m0, _as_matrix_view(array<dcomplex, gin.data_rank>(gin.data())), _as_matrix_view(gout.data()), n_threads);
+    else if (!has_contiguous_data(gin.data()) or !gin.data().indexmap().memory_layout_is_c())
+      _fourier_lattice_data(m0, _as_matrix_view(array<dcomplex, gin.data_rank>(gin.data())), _as_matrix_view(gout.data()), n_threads);
+    else
+      _fourier_lattice_data(m0, _as_matrix_view(gin.data()), _as_matrix_view(gout.data()), n_threads);
+    return gout;
+  }
+
+  template <typename V, typename T> auto make_gf_from_lattice_fourier(gf_view<V, T> gin, int n_threads = 0) {
+    return make_gf_from_lattice_fourier(make_const_view(gin), n_threads);
+  }
+
+  template <typename V, typename T> auto make_gf_from_lattice_fourier(gf<V, T> const &gin, int n_threads = 0) {
+    return make_gf_from_lattice_fourier(make_const_view(gin), n_threads);
+  }
+
   /* *-----------------------------------------------------------------------------------------------------
    *
    * make_gf_from_fourier : Block / Block2 Gf
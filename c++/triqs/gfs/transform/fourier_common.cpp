@@ -19,29 +19,332 @@
 
 #include <triqs/gfs.hpp>
 #include "./fourier_common.hpp"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
 
 namespace triqs::gfs {
 
-  void _fourier_base(array_const_view<dcomplex, 2> in, array_view<dcomplex, 2> out, int rank, int *dims, int fftw_count, int fftw_backward_forward) {
+  /*------------------------------------------------------------------------------------------------------
+  *                                  Plan cache
+  *-----------------------------------------------------------------------------------------------------*/
+
+  namespace {
+
+    // Everything a plan depends on, for the new-array execute function fftw_execute_dft
+    struct plan_key {
+      std::array<int, 3> dims; // the rank first ones, then 0
+      int howmany, istride, ostride, sign;
+      bool in_place;
+      int in_alignment, out_alignment;
+      unsigned flags;
+
+      bool operator<(plan_key const &k) const {
+        return std::tie(dims, howmany, istride, ostride, sign, in_place, in_alignment, out_alignment, flags)
+           < std::tie(k.dims, k.howmany, k.istride, k.ostride, k.sign, k.in_place, k.in_alignment, k.out_alignment, k.flags);
+      }
+    };
+
+    using plan_ptr = fftw_plan_ptr;
+
+    // The FFTW planner, including the destruction of the plans, is not thread-safe.
+    // Recursive : the deleter of a plan evicted under the lock takes it again.
+    std::recursive_mutex &planner_mutex() {
+      static std::recursive_mutex m;
+      return m;
+    }
+
+    // The plans, with the time of their last use for the LRU eviction.
+    // A plan is shared with the transforms using it : an evicted plan is destroyed when its last transform is done.
+    struct plan_cache {
+      std::recursive_mutex &mutex = planner_mutex(); // constructed first, hence destroyed after the cache
+      std::map<plan_key, std::pair<plan_ptr, uint64_t>> plans;
+      uint64_t clock = 0;
+      long max_size  = 64;
+      fftw_planner_effort effort = fftw_planner_effort::estimate;
+      std::atomic<int> n_threads = 1;
+      std::string wisdom_file;
+
+      // Evicts the least recently used plans, to keep at most n plans
+      void shrink_to(long n) {
+        while (long(plans.size()) > n) {
+          auto lru = plans.begin();
+          for (auto it = plans.begin(); it != plans.end(); ++it)
+            if (it->second.second < lru->second.second) lru = it;
+          plans.erase(lru);
+        }
+      }
+      void clear() { plans.clear(); }
+      ~plan_cache() { clear(); }
+    };
+
+    plan_cache &cache() {
+      static plan_cache c;
+      return c;
+    }
+
+    plan_ptr make_plan_ptr(fftw_plan p) {
+      return plan_ptr(p, [](fftw_plan q) {
+        std::lock_guard<std::recursive_mutex> lock(planner_mutex());
+        fftw_destroy_plan(q);
+      });
+    }
+
+    unsigned flags_of(fftw_planner_effort e) {
+      switch (e) {
+        case fftw_planner_effort::measure: return FFTW_MEASURE;
+        case fftw_planner_effort::patient: return FFTW_PATIENT;
+        default: return FFTW_ESTIMATE;
+      }
+    }
+
+    bool export_wisdom_atomically(std::string const &filename) {
+      auto tmp = filename + ".tmp." + std::to_string(::getpid());
+      if (!fftw_export_wisdom_to_filename(tmp.c_str())) return false;
+      return std::rename(tmp.c_str(), filename.c_str()) == 0;
+    }
+
+    // A scratch buffer of n complex numbers, with the given alignment (as fftw_alignment_of) for the planner.
+    struct scratch {
+      void *raw;
+      fftw_complex *ptr;
+      scratch(long n, int alignment) : raw(fftw_malloc(n * sizeof(fftw_complex) + 64)) {
+        if (raw == nullptr) TRIQS_RUNTIME_ERROR << "FFTW plan : can not allocate a scratch buffer";
+        ptr = reinterpret_cast<fftw_complex *>(static_cast<char *>(raw) + alignment);
+      }
+      ~scratch() { fftw_free(raw); }
+    };
+
+  } // namespace
+
+  void set_fftw_planner_effort(fftw_planner_effort e) {
+    std::lock_guard<std::recursive_mutex> lock(cache().mutex);
+    cache().effort = e;
+  }
+
+  fftw_planner_effort get_fftw_planner_effort() {
+    std::lock_guard<std::recursive_mutex> lock(cache().mutex);
+    return cache().effort;
+  }
+
+  void set_fourier_n_threads(int n) {
+    if (n < 1) TRIQS_RUNTIME_ERROR << "set_fourier_n_threads : the number of threads must be >= 1";
+    cache().n_threads = n;
+  }
+
+  int get_fourier_n_threads() { return cache().n_threads; }
+
+  void clear_fftw_plan_cache() {
+    std::lock_guard<std::recursive_mutex> lock(cache().mutex);
+    cache().clear();
+  }
+
+  long fftw_plan_cache_size() {
+    std::lock_guard<std::recursive_mutex> lock(cache().mutex);
+    return cache().plans.size();
+  }
+
+  void set_fftw_plan_cache_max_size(long n) {
+    if (n < 1) TRIQS_RUNTIME_ERROR << "set_fftw_plan_cache_max_size : the size must be >= 1";
+    std::lock_guard<std::recursive_mutex> lock(cache().mutex);
+    cache().max_size = n;
+    cache().shrink_to(n);
+  }
+
+  long get_fftw_plan_cache_max_size() {
+    std::lock_guard<std::recursive_mutex> lock(cache().mutex);
+    return cache().max_size;
+  }
+
+  bool import_fftw_wisdom(std::string const &filename) {
+    std::lock_guard<std::recursive_mutex> lock(cache().mutex);
+    return fftw_import_wisdom_from_filename(filename.c_str());
+  }
+
+  bool export_fftw_wisdom(std::string const &filename) {
+    std::lock_guard<std::recursive_mutex> lock(cache().mutex);
+    return export_wisdom_atomically(filename);
+  }
+
+  bool set_fftw_wisdom_file(std::string const &filename) {
+    std::lock_guard<std::recursive_mutex> lock(cache().mutex);
+    cache().wisdom_file = filename;
+    if (filename.empty()) return false;
+    return fftw_import_wisdom_from_filename(filename.c_str());
+  }
+
+  /*------------------------------------------------------------------------------------------------------
+  *                                  Transform
+  *-----------------------------------------------------------------------------------------------------*/
+
+  namespace {
+
+    // The plan of a batch of FFT, from the cache, or created and cached.
+    plan_ptr get_plan(fftw_complex *in_fft, fftw_complex *out_fft, int rank, int *dims, int fftw_count, int istride, int ostride,
+                       int fftw_backward_forward) {
+      if (rank > 3) TRIQS_RUNTIME_ERROR << "FFTW plan : the rank " << rank << " is > 3";
+      auto &c = cache();
+      std::lock_guard<std::recursive_mutex> lock(c.mutex); // the FFTW planner is not thread-safe
+      std::array<int, 3> d = {0, 0, 0};
+      std::copy(dims, dims + rank, d.begin());
+      auto k = plan_key{d,
+                        fftw_count,
+                        istride,
+                        ostride,
+                        fftw_backward_forward,
+                        (in_fft == out_fft),
+                        fftw_alignment_of(reinterpret_cast<double *>(in_fft)),
+                        fftw_alignment_of(reinterpret_cast<double *>(out_fft)),
+                        flags_of(c.effort)};
+      auto it = c.plans.find(k);
+      if (it != c.plans.end()) {
+        it->second.second = ++c.clock;
+        return it->second.first;
+      }
+
+      // in and out are never touched by the planner : with an effort above estimate, it plans on scratch buffers
+      // of the same extent and alignment, since it overwrites them.
+      auto make_plan = [&](fftw_complex *i, fftw_complex *o) {
+        return fftw_plan_many_dft(rank,                  // rank
+                                  dims,                  // the dimension
+                                  fftw_count,            // how many FFT : here 1
+                                  i,                     // in data
+                                  NULL,                  // embed : unused. Doc unclear ?
+                                  istride,               // stride of the in data
+                                  1,                     // in : shift for multi fft.
+                                  o,                     // out data
+                                  NULL,                  // embed : unused. Doc unclear ?
+                                  ostride,               // stride of the out data
+                                  1,                     // out : shift for multi fft.
+                                  fftw_backward_forward, //
+                                  k.flags);
+      };
+      fftw_plan p = nullptr;
+      if (c.effort == fftw_planner_effort::estimate)
+        p = make_plan(in_fft, out_fft);
+      else {
+        long n_points = 1;
+        for (int r = 0; r < rank; ++r) n_points *= dims[r];
+        auto extent = [&](int stride) { return (n_points - 1) * stride + fftw_count; };
+        scratch s_in(extent(istride), k.in_alignment);
+        if (k.in_place)
+          p = make_plan(s_in.ptr, s_in.ptr);
+        else {
+          scratch s_out(extent(ostride), k.out_alignment);
+          p = make_plan(s_in.ptr, s_out.ptr);
+        }
+      }
+      if (p == nullptr) TRIQS_RUNTIME_ERROR << "FFTW : plan creation failed";
+      auto r = make_plan_ptr(p);
+      c.shrink_to(c.max_size - 1);
+      c.plans.emplace(std::move(k), std::make_pair(r, ++c.clock));
+      if (c.effort != fftw_planner_effort::estimate and !c.wisdom_file.empty()) export_wisdom_atomically(c.wisdom_file);
+      return r;
+    }
+
+    // The worker threads of the threaded transforms. They are created on the first use, and wait for the next transform.
+    // The chunk t of a transform is run by the worker t (the calling thread runs the chunk 0).
+    // A transform is done when all its chunks are : one threaded transform at a time.
+    struct fourier_pool {
+      std::mutex busy; // held during a transform
+      std::mutex mutex;
+      std::condition_variable cv_start, cv_done;
+      std::vector<std::thread> workers;
+      std::vector<std::pair<plan_ptr, int>> chunks; // (plan, start) of each chunk, reused
+      fftw_complex *in = nullptr, *out = nullptr;
+      int n_chunks = 0, n_running = 0;
+      uint64_t generation = 0;
+      bool stop = false;
+
+      void work(int t) {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+          cv_start.wait(lock, [&] { return stop or generation != seen; });
+          if (stop) return;
+          seen = generation;
+          if (t >= n_chunks) continue;
+          lock.unlock();
+          fftw_execute_dft(chunks[t].first.get(), in + chunks[t].second, out + chunks[t].second);
+          lock.lock();
+          if (--n_running == 0) cv_done.notify_one();
+        }
+      }
+
+      // Runs the chunks on in, out. Precondition : busy is held, and the chunks are set
+      void run(fftw_complex *in_, fftw_complex *out_, int n_chunks_) {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          while (int(workers.size()) < n_chunks_ - 1) workers.emplace_back(&fourier_pool::work, this, int(workers.size()) + 1);
+          in        = in_;
+          out       = out_;
+          n_chunks  = n_chunks_;
+          n_running = n_chunks_ - 1;
+          ++generation;
+        }
+        cv_start.notify_all();
+        fftw_execute_dft(chunks[0].first.get(), in_, out_);
+        std::unique_lock<std::mutex> lock(mutex);
+        cv_done.wait(lock, [&] { return n_running == 0; });
+      }
+
+      ~fourier_pool() {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          stop = true;
+        }
+        cv_start.notify_all();
+        for (auto &w : workers) w.join();
+      }
+    };
+
+    fourier_pool &pool() {
+      static fourier_pool p;
+      return p;
+    }
+
+  } // namespace
+
+  fftw_plan_ptr _fourier_plan(array_const_view<dcomplex, 2> in, array_view<dcomplex, 2> out, int rank, int *dims, int fftw_count,
+                              int fftw_backward_forward) {
+    return get_plan(reinterpret_cast<fftw_complex *>(in.data_start()), reinterpret_cast<fftw_complex *>(out.data_start()), rank, dims, fftw_count,
+                    in.indexmap().strides()[0], out.indexmap().strides()[0], fftw_backward_forward);
+  }
+
+  void _fourier_base(array_const_view<dcomplex, 2> in, array_view<dcomplex, 2> out, int rank, int *dims, int fftw_count, int fftw_backward_forward,
+                     int n_threads) {
 
     auto in_fft  = reinterpret_cast<fftw_complex *>(in.data_start());
     auto out_fft = reinterpret_cast<fftw_complex *>(out.data_start());
+    int istride = in.indexmap().strides()[0], ostride = out.indexmap().strides()[0];
+
+    // The fftw_count independent FFT are split in n_chunks contiguous batches, run in parallel on the pool.
+    // The new-array execute function is thread-safe.
+    if (n_threads <= 0) n_threads = get_fourier_n_threads();
+    int n_chunks = std::max(1, std::min(n_threads, fftw_count));
+
+    if (n_chunks == 1) {
+      fftw_execute_dft(get_plan(in_fft, out_fft, rank, dims, fftw_count, istride, ostride, fftw_backward_forward).get(), in_fft, out_fft);
+      return;
+    }
 
-    auto p = fftw_plan_many_dft(rank,                        // rank
-                                dims,                        // the dimension
-                                fftw_count,                  // how many FFT : here 1
-                                in_fft,                      // in data
-                                NULL,                        // embed : unused. Doc unclear ?
-                                in.indexmap().strides()[0],  // stride of the in data
-                                1,                           // in : shift for multi fft.
-                                out_fft,                     // out data
-                                NULL,                        // embed : unused. Doc unclear ?
-                                out.indexmap().strides()[0], // stride of the out data
-                                1,                           // out : shift for multi fft.
-                                fftw_backward_forward, FFTW_ESTIMATE);
-
-    fftw_execute(p);
-    fftw_destroy_plan(p);
+    auto &p = pool();
+    std::lock_guard<std::mutex> lock(p.busy);
+    p.chunks.resize(n_chunks);
+    for (int t = 0, start = 0; t < n_chunks; ++t) {
+      int count   = fftw_count / n_chunks + (t < fftw_count % n_chunks ? 1 : 0);
+      p.chunks[t] = {get_plan(in_fft + start, out_fft + start, rank, dims, count, istride, ostride, fftw_backward_forward), start};
+      start += count;
+    }
+    p.run(in_fft, out_fft, n_chunks);
+    for (auto &c : p.chunks) c.first.reset(); // an evicted plan is not kept alive by the pool
   }
 
   //void _fourier_base(array_const_view<double, 2> in, array_view<dcomplex, 2> out, int rank, int *dims, int fftw_count) {
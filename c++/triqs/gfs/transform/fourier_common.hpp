@@ -19,13 +19,22 @@
 
 #pragma once
 #include <triqs/arrays.hpp>
+#include <memory>
+#include <type_traits>
 // include only in cpp implementation
 #include <fftw3.h>
 
 namespace triqs::gfs {
 
   using namespace triqs::arrays;
-  // call to fftw
-  void _fourier_base(array_const_view<dcomplex, 2> in, array_view<dcomplex, 2> out, int rank, int *dims, int fftw_count, int fftw_backward_forward);
+  // call to fftw. n_threads : 0 is the global setting (cf set_fourier_n_threads)
+  void _fourier_base(array_const_view<dcomplex, 2> in, array_view<dcomplex, 2> out, int rank, int *dims, int fftw_count, int fftw_backward_forward,
+                     int n_threads = 0);
+
+  // The cached plan of _fourier_base(in, out, ...) with one thread, to be executed with fftw_execute_dft on the same arrays.
+  // It is kept alive by the pointer, even if it is evicted from the cache.
+  using fftw_plan_ptr = std::shared_ptr<std::remove_pointer_t<fftw_plan>>;
+  fftw_plan_ptr _fourier_plan(array_const_view<dcomplex, 2> in, array_view<dcomplex, 2> out, int rank, int *dims, int fftw_count,
+                              int fftw_backward_forward);
 
 } // namespace triqs::gfs
@@ -27,16 +27,11 @@
 namespace triqs::gfs {
 
   // The implementation is almost the same in both cases...
-  template <typename V1, typename V2> gf_vec_t<V1> __impl(int fftw_backward_forward, gf_mesh<V1> const &out_mesh, gf_vec_cvt<V2> g_in) {
-
-    //ASSERT_EQUAL(g_out.data().shape(), g_in.data().shape(), "Meshes are different");
-    //ASSERT_EQUAL(g_out.data().indexmap().strides()[1], g_out.data().shape()[1], "Unexpected strides in fourier implementation");
-    //ASSERT_EQUAL(g_out.data().indexmap().strides()[2], 1, "Unexpected strides in fourier implementation");
-    //ASSERT_EQUAL(g_in.data().indexmap().strides()[1], g_in.data().shape()[1], "Unexpected strides in fourier implementation");
-    //ASSERT_EQUAL(g_in.data().indexmap().strides()[2], 1, "Unexpected strides in fourier implementation");
+  template <typename V> void __impl_data(int fftw_backward_forward, gf_mesh<V> const &in_mesh, array_const_view<dcomplex, 2> in,
+                                         array_view<dcomplex, 2> out, int n_threads) {
 
     //check periodization_matrix is diagonal
-    auto &period_mat = g_in.mesh().periodization_matrix;
+    auto &period_mat = in_mesh.periodization_matrix;
     for (auto [i, j] : itertools::product_range(period_mat.shape()[0], period_mat.shape()[1]))
       if (i != j and period_mat(i, j) != 0) {
         std::cerr
@@ -44,12 +39,17 @@ namespace triqs::gfs {
         break;
       }
 
-    auto g_out    = gf_vec_t<V1>{out_mesh, g_in.target_shape()[0]};
-    long n_others = second_dim(g_in.data());
+    ASSERT_EQUAL(first_dim(in), in_mesh.size(), "Fourier : the first dimension of the data is not the size of the mesh");
+    ASSERT_EQUAL(in.shape(), out.shape(), "Fourier : in and out data have different shapes");
 
-    auto dims = g_in.mesh().get_dimensions();
-    _fourier_base(g_in.data(), g_out.data(), dims.size(), dims.ptr(), n_others, fftw_backward_forward);
+    long n_others = second_dim(in);
+    auto dims     = in_mesh.get_dimensions();
+    _fourier_base(in, out, dims.size(), dims.ptr(), n_others, fftw_backward_forward, n_threads);
+  }
 
+  template <typename V1, typename V2> gf_vec_t<V1> __impl(int fftw_backward_forward, gf_mesh<V1> const &out_mesh, gf_vec_cvt<V2> g_in) {
+    auto g_out = gf_vec_t<V1>{out_mesh, g_in.target_shape()[0]};
+    __impl_data(fftw_backward_forward, g_in.mesh(), g_in.data(), g_out.data(), 0);
     return std::move(g_out);
   }
 
@@ -67,4 +67,15 @@ namespace triqs::gfs {
     return __impl(FFTW_BACKWARD, k_mesh, gr);
   }
 
+  // ------------------------ BATCHED TRANSFORM OF THE DATA --------------------------------------------
+
+  void _fourier_lattice_data(gf_mesh<brillouin_zone> const &k_mesh, array_const_view<dcomplex, 2> in, array_view<dcomplex, 2> out, int n_threads) {
+    __impl_data(FFTW_FORWARD, k_mesh, in, out, n_threads);
+    out /= k_mesh.size();
+  }
+
+  void _fourier_lattice_data(gf_mesh<cyclic_lattice> const &r_mesh, array_const_view<dcomplex, 2> in, array_view<dcomplex, 2> out, int n_threads) {
+    __impl_data(FFTW_BACKWARD, r_mesh, in, out, n_threads);
+  }
+
 } // namespace triqs::gfs
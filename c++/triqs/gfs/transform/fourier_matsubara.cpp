@@ -122,66 +122,14 @@ namespace triqs::gfs {
       tail(range(0, n_known_moments), range()) = known_moments(range(0, n_known_moments), range());
     }
 
-    double beta = gt.mesh().domain().beta;
-    auto L      = gt.mesh().size() - 1;
-    if (L < 2 * (iw_mesh.last_index() + 1))
-      TRIQS_RUNTIME_ERROR << "Fourier: The time mesh mush be at least twice as long as the number of positive frequencies :\n gt.mesh().size() =  "
-                          << gt.mesh().size() << " gw.mesh().last_index()" << iw_mesh.last_index();
+    auto ws = fourier_workspace{gt.mesh(), iw_mesh, false};
 
-    if (L < 6 * (iw_mesh.last_index() + 1))
+    if (gt.mesh().size() - 1 < 6 * (iw_mesh.last_index() + 1))
       std::cerr << "[Direct Fourier] WARNING: The imaginary time mesh is less than six times as long as the number of positive frequencies.\n"
                 << "This can lead to substantial numerical inaccuracies at the boundary of the frequency mesh.\n";
 
-    long n_others = second_dim(gt.data());
-
-    array<dcomplex, 2> _gout(L, n_others); // FIXME Why do we need this dimension to be one less than gt.mesh().size() ?
-    array<dcomplex, 2> _gin(L + 1, n_others);
-
-    bool is_fermion = (iw_mesh.domain().statistic == Fermion);
-    double fact     = beta / L;
-    dcomplex iomega = M_PI * 1i / beta;
-
-    double b1, b2, b3;
-    array<dcomplex, 1> a1, a2, a3;
-    auto _  = range();
-    auto m1 = tail(1, _);
-    auto m2 = tail(2, _);
-    auto m3 = tail(3, _);
-
-    if (is_fermion) {
-      b1 = 0;
-      b2 = 1;
-      b3 = -1;
-      a1 = m1 - m3;
-      a2 = (m2 + m3) / 2;
-      a3 = (m3 - m2) / 2;
-
-      for (auto const &t : gt.mesh())
-        _gin(t.index(), _) =
-           fact * exp(iomega * t) * (gt[t] - (oneFermion(a1, b1, t, beta) + oneFermion(a2, b2, t, beta) + oneFermion(a3, b3, t, beta)));
-
-    } else {
-      b1 = -0.5;
-      b2 = -1;
-      b3 = 1;
-      a1 = 4 * (m1 - m3) / 3;
-      a2 = m3 - (m1 + m2) / 2;
-      a3 = m1 / 6 + m2 / 2 + m3 / 3;
-
-      for (auto const &t : gt.mesh())
-        _gin(t.index(), _) = fact * (gt[t] - (oneBoson(a1, b1, t, beta) + oneBoson(a2, b2, t, beta) + oneBoson(a3, b3, t, beta)));
-    }
-
-    int dims[] = {int(L)};
-    _fourier_base(_gin, _gout, 1, dims, n_others, FFTW_BACKWARD);
-
-    auto gw = gf_vec_t<imfreq>{iw_mesh, {int(n_others)}};
-
-    // Correction term to account for proper Trapezoidal integration
-    // FIXME Avoid copy, by doing proper in-place operation
-    auto corr = -0.5 * fact * (gt[0] + m1 + (is_fermion ? 1 : -1) * gt[L]);
-    for (auto const &w : iw_mesh) gw[w] = _gout((w.index() + L) % L, _) + corr + a1 / (w - b1) + a2 / (w - b2) + a3 / (w - b3);
-
+    auto gw = gf_vec_t<imfreq>{iw_mesh, {int(second_dim(gt.data()))}};
+    ws.direct(gw.data(), gt.data(), tail);
     return std::move(gw);
   }
 
@@ -213,61 +161,183 @@ namespace triqs::gfs {
     } else
       tail.rebind(known_moments); // known_moments is fine
 
-    double beta = tau_mesh.domain().beta;
-    long L      = tau_mesh.size() - 1;
-    if (L < 2 * (gw.mesh().last_index() + 1))
-      TRIQS_RUNTIME_ERROR << "Inverse Fourier: The time mesh mush be at least twice as long as the freq mesh :\n gt.mesh().size() =  "
-                          << tau_mesh.size() << " gw.mesh().last_index()" << gw.mesh().last_index() << "\n";
-
-    long n_others = second_dim(gw.data());
-
-    array<dcomplex, 2> _gin(L, n_others); // FIXME Why do we need this dimension to be one less than gt.mesh().size() ?
-    array<dcomplex, 2> _gout(L + 1, n_others);
-
-    bool is_fermion = (gw.domain().statistic == Fermion);
-    double fact     = 1.0 / beta;
-    dcomplex iomega = M_PI * 1i / beta;
-
-    double b1, b2, b3;
-    array<dcomplex, 1> a1, a2, a3;
-    auto _  = range();
-    auto m1 = tail(1, _);
-    auto m2 = tail(2, _);
-    auto m3 = tail(3, _);
-
-    if (is_fermion) {
-      b1 = 0;
-      b2 = 1;
-      b3 = -1;
-      a1 = m1 - m3;
-      a2 = (m2 + m3) / 2;
-      a3 = (m3 - m2) / 2;
+    auto gt = gf_vec_t<imtime>{tau_mesh, {int(second_dim(gw.data()))}};
+    fourier_workspace{tau_mesh, gw.mesh(), false}.inverse(gt.data(), gw.data(), tail);
+    return std::move(gt);
+  }
+
+  // ------------------------ WORKSPACE --------------------------------------------
+
+  fourier_workspace::fourier_workspace(gf_mesh<imtime> tau_mesh_, gf_mesh<imfreq> iw_mesh_, bool precompute_)
+     : tau_mesh(std::move(tau_mesh_)),
+       iw_mesh(std::move(iw_mesh_)),
+       L(tau_mesh.size() - 1),
+       is_fermion(iw_mesh.domain().statistic == Fermion),
+       precompute(precompute_),
+       beta(tau_mesh.domain().beta) {
+
+    if (L < 2 * (iw_mesh.last_index() + 1))
+      TRIQS_RUNTIME_ERROR << "Fourier: The time mesh mush be at least twice as long as the number of positive frequencies :\n gt.mesh().size() =  "
+                          << tau_mesh.size() << " gw.mesh().last_index()" << iw_mesh.last_index();
+
+    // The poles of the tail model
+    b = (is_fermion ? std::array<double, 3>{0, 1, -1} : std::array<double, 3>{-0.5, -1, 1});
+    if (!precompute) return;
+
+    // computed on the fly (the tables are empty), then stored
+    auto ph = array<dcomplex, 1>(L + 1);
+    auto tt = array<double, 2>(L + 1, 3);
+    auto tw = array<dcomplex, 2>(iw_mesh.size(), 3);
+    for (long t = 0; t <= L; ++t) {
+      ph(t)  = phase_at(t);
+      auto x = tail_tau_at(t);
+      for (int j = 0; j < 3; ++j) tt(t, j) = x[j];
+    }
+    for (auto const &w : iw_mesh) {
+      auto x = tail_iw_at(w);
+      for (int j = 0; j < 3; ++j) tw(w.linear_index(), j) = x[j];
+    }
+    phase    = std::move(ph);
+    tail_tau = std::move(tt);
+    tail_iw  = std::move(tw);
+  }
+
+  //-------------------------------------
+
+  dcomplex fourier_workspace::phase_at(long t) const {
+    if (!phase.is_empty()) return phase(t);
+    return (is_fermion ? exp(M_PI * 1i * tau_mesh.index_to_point(t) / beta) : 1);
+  }
+
+  std::array<double, 3> fourier_workspace::tail_tau_at(long t) const {
+    if (!tail_tau.is_empty()) return {tail_tau(t, 0), tail_tau(t, 1), tail_tau(t, 2)};
+    double tau = tau_mesh.index_to_point(t);
+    std::array<double, 3> r;
+    for (int j = 0; j < 3; ++j) r[j] = (is_fermion ? oneFermion(1, b[j], tau, beta) : oneBoson(1, b[j], tau, beta));
+    return r;
+  }
+
+  std::array<dcomplex, 3> fourier_workspace::tail_iw_at(gf_mesh<imfreq>::mesh_point_t const &w) const {
+    long l = w.linear_index();
+    if (!tail_iw.is_empty()) return {tail_iw(l, 0), tail_iw(l, 1), tail_iw(l, 2)};
+    return {1 / (dcomplex(w) - b[0]), 1 / (dcomplex(w) - b[1]), 1 / (dcomplex(w) - b[2])};
+  }
+
+  //-------------------------------------
+
+  void fourier_workspace::resize(long n_others) {
+    if (second_dim(buf_in) == n_others) return;
+    buf_in  = array<dcomplex, 2>(L + 1, n_others);
+    buf_out = array<dcomplex, 2>(L + 1, n_others);
+    a       = array<dcomplex, 2>(3, n_others);
+    m1      = array<dcomplex, 1>(n_others);
+    corr    = array<dcomplex, 1>(n_others);
+    if (precompute) { // the plans of the new buffers
+      int dims[]   = {int(L)};
+      plan_direct  = _fourier_plan(buf_in, buf_out, 1, dims, n_others, FFTW_BACKWARD);
+      plan_inverse = _fourier_plan(buf_in, buf_out, 1, dims, n_others, FFTW_FORWARD);
+    }
+  }
+
+  //-------------------------------------
+
+  // buf_out = FFT(buf_in), with the plans of the workspace if any, unless the transforms are threaded
+  void fourier_workspace::fft(int fftw_backward_forward) {
+    long n_others = second_dim(buf_in);
+    if (plan_direct and (n_others == 1 or get_fourier_n_threads() == 1)) {
+      auto p = (fftw_backward_forward == FFTW_BACKWARD ? plan_direct : plan_inverse).get();
+      fftw_execute_dft(p, reinterpret_cast<fftw_complex *>(buf_in.data_start()), reinterpret_cast<fftw_complex *>(buf_out.data_start()));
     } else {
-      b1 = -0.5;
-      b2 = -1;
-      b3 = 1;
-      a1 = 4 * (m1 - m3) / 3;
-      a2 = m3 - (m1 + m2) / 2;
-      a3 = m1 / 6 + m2 / 2 + m3 / 3;
+      int dims[] = {int(L)};
+      _fourier_base(buf_in, buf_out, 1, dims, n_others, fftw_backward_forward);
     }
+  }
 
-    for (auto const &w : gw.mesh()) _gin((w.index() + L) % L, _) = fact * (gw[w] - (a1 / (w - b1) + a2 / (w - b2) + a3 / (w - b3)));
+  //-------------------------------------
 
-    int dims[] = {int(L)};
-    _fourier_base(_gin, _gout, 1, dims, n_others, FFTW_FORWARD);
+  void fourier_workspace::set_pole_coefficients(array_const_view<dcomplex, 2> moments, bool require_3_moments) {
+    long n_others = second_dim(a);
+    if (second_dim(moments) != n_others) TRIQS_RUNTIME_ERROR << "Fourier: the moments and the Green function have different target sizes";
+    long n_moments = std::min<long>(first_dim(moments), 4);
+    if (require_3_moments and n_moments < 4) TRIQS_RUNTIME_ERROR << "Fourier: the moments 0 to 3 are required";
+
+    double abs_m0 = 0;
+    for (long i = 0; i < (n_moments > 0 ? n_others : 0); ++i) abs_m0 = std::max(abs_m0, std::abs(moments(0, i)));
+    TRIQS_ASSERT2((abs_m0 < 1e-8), "ERROR: Fourier implementation requires vanishing 0th moment\n  error is :" + std::to_string(abs_m0));
+
+    for (long i = 0; i < n_others; ++i) {
+      dcomplex m1_ = (n_moments > 1 ? moments(1, i) : 0), m2 = (n_moments > 2 ? moments(2, i) : 0), m3 = (n_moments > 3 ? moments(3, i) : 0);
+      if (is_fermion) {
+        a(0, i) = m1_ - m3;
+        a(1, i) = (m2 + m3) / 2;
+        a(2, i) = (m3 - m2) / 2;
+      } else {
+        a(0, i) = 4 * (m1_ - m3) / 3;
+        a(1, i) = m3 - (m1_ + m2) / 2;
+        a(2, i) = m1_ / 6 + m2 / 2 + m3 / 3;
+      }
+      m1(i) = m1_;
+    }
+  }
 
-    auto gt = gf_vec_t<imtime>{tau_mesh, {int(n_others)}};
+  //-------------------------------------
 
-    if (is_fermion)
-      for (auto const &t : tau_mesh)
-        gt[t] = _gout(t.index(), _) * exp(-iomega * t) + oneFermion(a1, b1, t, beta) + oneFermion(a2, b2, t, beta) + oneFermion(a3, b3, t, beta);
-    else
-      for (auto const &t : tau_mesh) gt[t] = _gout(t.index(), _) + oneBoson(a1, b1, t, beta) + oneBoson(a2, b2, t, beta) + oneBoson(a3, b3, t, beta);
+  void fourier_workspace::direct(array_view<dcomplex, 2> gw, array_const_view<dcomplex, 2> gt, array_const_view<dcomplex, 2> moments) {
 
-    double pm = (is_fermion ? -1 : 1);
-    gt[L]     = pm * (gt[0] + m1);
+    long n_others = second_dim(gt);
+    if (first_dim(gt) != L + 1 or first_dim(gw) != iw_mesh.size() or second_dim(gw) != n_others)
+      TRIQS_RUNTIME_ERROR << "Fourier: the data do not match the meshes of the workspace";
+    resize(n_others);
+    set_pole_coefficients(moments, false);
 
-    return std::move(gt);
+    double fact = beta / L;
+    for (long t = 0; t <= L; ++t) {
+      auto ph = fact * phase_at(t);
+      auto tt = tail_tau_at(t);
+      for (long i = 0; i < n_others; ++i) buf_in(t, i) = ph * (gt(t, i) - (a(0, i) * tt[0] + a(1, i) * tt[1] + a(2, i) * tt[2]));
+    }
+
+    fft(FFTW_BACKWARD);
+
+    // Correction term to account for proper Trapezoidal integration
+    for (long i = 0; i < n_others; ++i) corr(i) = -0.5 * fact * (gt(0, i) + m1(i) + (is_fermion ? 1 : -1) * gt(L, i));
+
+    for (auto const &w : iw_mesh) {
+      long r = (w.index() + L) % L, l = w.linear_index();
+      auto tw = tail_iw_at(w);
+      for (long i = 0; i < n_others; ++i) gw(l, i) = buf_out(r, i) + corr(i) + a(0, i) * tw[0] + a(1, i) * tw[1] + a(2, i) * tw[2];
+    }
+  }
+
+  //-------------------------------------
+
+  void fourier_workspace::inverse(array_view<dcomplex, 2> gt, array_const_view<dcomplex, 2> gw, array_const_view<dcomplex, 2> moments) {
+
+    TRIQS_ASSERT2(!iw_mesh.positive_only(), "Fourier is only implemented for g(i omega_n) with full mesh (positive and negative frequencies)");
+    long n_others = second_dim(gw);
+    if (first_dim(gt) != L + 1 or first_dim(gw) != iw_mesh.size() or second_dim(gt) != n_others)
+      TRIQS_RUNTIME_ERROR << "Fourier: the data do not match the meshes of the workspace";
+    resize(n_others);
+    set_pole_coefficients(moments, true);
+
+    double fact = 1.0 / beta;
+    buf_in()    = 0; // the frequencies beyond the mesh
+    for (auto const &w : iw_mesh) {
+      long r = (w.index() + L) % L, l = w.linear_index();
+      auto tw = tail_iw_at(w);
+      for (long i = 0; i < n_others; ++i) buf_in(r, i) = fact * (gw(l, i) - (a(0, i) * tw[0] + a(1, i) * tw[1] + a(2, i) * tw[2]));
+    }
+
+    fft(FFTW_FORWARD);
+
+    for (long t = 0; t < L; ++t) {
+      auto ph = std::conj(phase_at(t));
+      auto tt = tail_tau_at(t);
+      for (long i = 0; i < n_others; ++i) gt(t, i) = buf_out(t, i) * ph + a(0, i) * tt[0] + a(1, i) * tt[1] + a(2, i) * tt[2];
+    }
+
+    double pm = (is_fermion ? -1 : 1);
+    for (long i = 0; i < n_others; ++i) gt(L, i) = pm * (gt(0, i) + m1(i));
   }
 
 } // namespace triqs::gfs
@@ -0,0 +1,91 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Michel Ferrero, Nils Wentzell
+
+#pragma once
+#include <string>
+
+namespace triqs::gfs {
+
+  /*------------------------------------------------------------------------------------------------------
+  *                        Control of the FFTW plans used by the Fourier transforms
+  *
+  * The plans are cached per process, keyed on the shape of the transform (rank, dims, how many),
+  * the strides, the direction, the alignment of the data and the planner effort.
+  * A plan is hence created once per shape, and reused for all later transforms of the same shape.
+  * The cache keeps at most a given number of plans (cf set_fftw_plan_cache_max_size) : the least recently used one is
+  * evicted when a new plan is created.
+  *
+  * The cache is thread-safe, but clear_fftw_plan_cache must not be called while a transform is running.
+  *-----------------------------------------------------------------------------------------------------*/
+
+  /// Planner effort of the FFTW plans (FFTW_ESTIMATE, FFTW_MEASURE, FFTW_PATIENT)
+  enum class fftw_planner_effort { estimate, measure, patient };
+
+  /**
+   * Sets the planner effort of the plans created from now on (default : estimate).
+   *
+   * With measure or patient, FFTW times several algorithms when creating a plan, which is much slower
+   * than estimate, but the plan is cached, and faster. The data are not touched by the planning.
+   */
+  void set_fftw_planner_effort(fftw_planner_effort e);
+
+  /// The current planner effort
+  fftw_planner_effort get_fftw_planner_effort();
+
+  /**
+   * Sets the number of threads of all Fourier transforms (default : 1).
+   *
+   * The independent FFT of a transform (one per value of the other meshes and of the target)
+   * are split in n contiguous batches, run in parallel by a pool of threads.
+   * The threads are created by the first transform which needs them, and kept for the next ones.
+   * The threaded transforms of several calling threads are run one after the other.
+   */
+  void set_fourier_n_threads(int n);
+
+  /// The number of threads of the Fourier transforms
+  int get_fourier_n_threads();
+
+  /// Destroys all cached plans
+  void clear_fftw_plan_cache();
+
+  /// Number of cached plans
+  long fftw_plan_cache_size();
+
+  /// Sets the maximal number of cached plans (default : 64). Precondition : n >= 1
+  void set_fftw_plan_cache_max_size(long n);
+
+  /// The maximal number of cached plans
+  long get_fftw_plan_cache_max_size();
+
+  /// Imports the FFTW wisdom from a file. Returns false if the file can not be read.
+  bool import_fftw_wisdom(std::string const &filename);
+
+  /// Exports the FFTW wisdom to a file. Returns false if the file can not be written.
+  bool export_fftw_wisdom(std::string const &filename);
+
+  /**
+   * Persists the FFTW wisdom in a file between runs.
+   *
+   * The wisdom is imported from the file now (if it exists), and exported to it each time a new plan is created
+   * with an effort above estimate. The file is written atomically (rename), so several processes can share it.
+   * An empty filename stops the export.
+   *
+   * @return true iff the wisdom was imported
+   */
+  bool set_fftw_wisdom_file(std::string const &filename);
+
+} // namespace triqs::gfs
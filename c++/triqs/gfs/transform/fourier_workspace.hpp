@@ -0,0 +1,127 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Michel Ferrero, Olivier Parcollet, Nils Wentzell
+
+#pragma once
+#include "./fourier.hpp"
+#include <array>
+#include <memory>
+
+struct fftw_plan_s; // the plan of FFTW (fftw_plan is fftw_plan_s *)
+
+namespace triqs::gfs {
+
+  /**
+   * Workspace for repeated Matsubara Fourier transforms between a given pair of meshes,
+   * e.g. G(tau) <-> G(iw) at each iteration of a self-consistency loop.
+   *
+   * It precomputes the phase factors exp(i pi tau / beta) and the tail model (the 3 poles) on both meshes,
+   * and keeps the buffers and the FFTW plans of the FFT. The transforms write directly into the Green function given by the caller.
+   * After the first call (or a change of the target size), a transform makes no heap allocation.
+   *
+   * The one-shot fourier functions use a workspace without the precomputed tables (precompute = false) : the phases and tails
+   * are computed on the fly, and the plan is taken from the plan cache at each call.
+   *
+   * The high-frequency moments are given by the caller, as in fourier(g, known_moments) :
+   * the 0th moment must vanish, and the moments 1, 2, 3 are used (the missing ones are 0 for the direct transform,
+   * the inverse transform requires all of them). Same results as fourier(g, known_moments).
+   *
+   * The data of the result must be contiguous in memory (C order). Non contiguous data of G and of the moments are copied.
+   * A workspace is not thread-safe : use one per thread.
+   */
+  class fourier_workspace {
+
+    gf_mesh<imtime> tau_mesh;
+    gf_mesh<imfreq> iw_mesh;
+    long L;
+    bool is_fermion, precompute;
+    double beta;
+    std::array<double, 3> b;            // the poles of the tail model
+    array<dcomplex, 1> phase;           // exp(i pi tau / beta) for fermions, 1 for bosons
+    array<double, 2> tail_tau;          // (tau, j) : the pole j of the tail model in tau, with unit coefficient
+    array<dcomplex, 2> tail_iw;         // (iw, j)  : 1 / (iw - b_j)
+    array<dcomplex, 2> buf_in, buf_out; // FFT buffers
+    std::shared_ptr<fftw_plan_s> plan_direct, plan_inverse; // their plans, if precompute
+    array<dcomplex, 2> a;               // (j, i)   : the coefficients of the 3 poles
+    array<dcomplex, 1> m1;              // first moment
+    array<dcomplex, 1> corr;            // correction term of the trapezoidal integration
+
+    void resize(long n_others);
+    void set_pole_coefficients(array_const_view<dcomplex, 2> moments, bool require_3_moments);
+    void fft(int fftw_backward_forward);
+
+    // The phase and tail model at the time index t, and the tail model at the frequency w
+    dcomplex phase_at(long t) const;
+    std::array<double, 3> tail_tau_at(long t) const;
+    std::array<dcomplex, 3> tail_iw_at(gf_mesh<imfreq>::mesh_point_t const &w) const;
+
+    public:
+    /**
+     * @param tau_mesh    The imaginary time mesh
+     * @param iw_mesh     The Matsubara frequency mesh
+     * @param precompute  Precompute the phases, tail models and FFTW plans, for repeated transforms
+     */
+    fourier_workspace(gf_mesh<imtime> tau_mesh, gf_mesh<imfreq> iw_mesh, bool precompute = true);
+
+    gf_mesh<imtime> const &get_tau_mesh() const { return tau_mesh; }
+    gf_mesh<imfreq> const &get_iw_mesh() const { return iw_mesh; }
+
+    /**
+     * gw = fourier(gt), on the data flattened to (mesh, target)
+     *
+     * @param gw       Output : data of G(iw)
+     * @param gt       Data of G(tau)
+     * @param moments  (moment, target) high-frequency moments of G
+     */
+    void direct(array_view<dcomplex, 2> gw, array_const_view<dcomplex, 2> gt, array_const_view<dcomplex, 2> moments);
+
+    /// gt = fourier(gw), on the data flattened to (mesh, target). Cf direct.
+    void inverse(array_view<dcomplex, 2> gt, array_const_view<dcomplex, 2> gw, array_const_view<dcomplex, 2> moments);
+
+    /// gw = fourier(gt, known_moments), without allocation. gw : a gf or gf_view on the imfreq mesh
+    template <typename Gw, typename Gt, typename M> void direct(Gw &&gw, Gt const &gt, M const &known_moments) REQUIRES(is_gf_v<std::decay_t<Gw>>) {
+      static_assert(!std::decay_t<Gw>::target_t::is_real, "fourier_workspace : the target of G(iw) must be complex");
+      if (gw.mesh() != iw_mesh or gt.mesh() != tau_mesh) TRIQS_RUNTIME_ERROR << "fourier_workspace : the meshes are not the ones of the workspace";
+      auto out = _as_matrix_view(_check_contiguous(gw.data()));
+      _on_input(gt.data(), [&](auto in) { _on_input(known_moments, [&](auto m) { direct(out, in, m); }); });
+    }
+
+    /// gt = fourier(gw, known_moments), without allocation. gt : a gf or gf_view on the imtime mesh
+    template <typename Gt, typename Gw, typename M> void inverse(Gt &&gt, Gw const &gw, M const &known_moments) REQUIRES(is_gf_v<std::decay_t<Gt>>) {
+      static_assert(!std::decay_t<Gt>::target_t::is_real, "fourier_workspace : the target of G(tau) must be complex");
+      if (gw.mesh() != iw_mesh or gt.mesh() != tau_mesh) TRIQS_RUNTIME_ERROR << "fourier_workspace : the meshes are not the ones of the workspace";
+      auto out = _as_matrix_view(_check_contiguous(gt.data()));
+      _on_input(gw.data(), [&](auto in) { _on_input(known_moments, [&](auto m) { inverse(out, in, m); }); });
+    }
+
+    private:
+    template <typename A> static bool _is_contiguous(A const &a) { return a.indexmap().is_contiguous() and a.indexmap().memory_layout_is_c(); }
+
+    template <typename A> static A &&_check_contiguous(A &&a) {
+      if (!_is_contiguous(a)) TRIQS_RUNTIME_ERROR << "fourier_workspace : the data of the result must be contiguous";
+      return std::forward<A>(a);
+    }
+
+    // Calls f on the input a, viewed as a matrix. A non contiguous input is copied.
+    template <typename A, typename F> static void _on_input(A const &a, F &&f) {
+      if (_is_contiguous(a))
+        f(_as_matrix_view(a));
+      else
+        f(_as_matrix_view(array<dcomplex, std::decay_t<A>::rank>(a)));
+    }
+  };
+
+} // namespace triqs::gfs
@@ -22,42 +22,84 @@
 //#include "pade.hpp"
 #include <triqs/arrays.hpp>
 #include <triqs/utility/pade_approximants.hpp>
+#include <triqs/utility/parallel_for.hpp>
 
 namespace triqs {
   namespace gfs {
 
     typedef std::complex<double> dcomplex;
 
-    void pade(gf_view<refreq> gr, gf_const_view<imfreq> gw, int n_points, double freq_offset) {
+    namespace {
 
-      // make sure the GFs have the same structure
-      //assert(gw.shape() == gr.shape());
+      // The continuation of the element (n1, n2) of gw into gr
+      struct pade_task {
+        gf_view<refreq> gr;
+        gf_const_view<imfreq> gw;
+        int n1, n2;
+      };
 
-      gr() = 0.0;
+      /*
+       * The coefficients are computed in double-double arithmetic, on n_threads threads, and their accuracy is checked
+       * at the points of the real frequency mesh where they are evaluated.
+       * The few elements for which this is not accurate enough are computed afterwards in GMP arithmetic, sequentially
+       * (the GMP precision is a global setting). The continued fractions are then evaluated on n_threads threads.
+       */
+      void pade_impl(std::vector<pade_task> const &tasks, int n_points, double freq_offset, int n_threads) {
+        long n_tasks = tasks.size();
+        std::vector<arrays::vector<dcomplex>> z_in(n_tasks), u_in(n_tasks);
+        std::vector<std::optional<arrays::vector<dcomplex>>> coefs(n_tasks);
 
-      auto sh = gw.data().shape().front_pop();
-      int N1 = sh[0], N2 = sh[1];
-      for (int n1 = 0; n1 < N1; n1++) {
-        for (int n2 = 0; n2 < N2; n2++) {
+        // The points of evaluation
+        auto make_e = [freq_offset](gf_view<refreq> const &gr) {
+          auto e = arrays::array<dcomplex, 1>(gr.mesh().size());
+          for (auto om : gr.mesh()) e(om.linear_index()) = om + dcomplex(0.0, 1.0) * freq_offset;
+          return e;
+        };
 
-          arrays::vector<dcomplex> z_in(n_points); // complex points
-          arrays::vector<dcomplex> u_in(n_points); // values at these points
+        utility::parallel_for(n_tasks, n_threads, [&](long t) {
+          auto const &[gr, gw, n1, n2] = tasks[t];
+          z_in[t].resize(n_points);
+          u_in[t].resize(n_points);
+          for (int i = 0; i < n_points; ++i) z_in[t](i) = gw.mesh()[i];
+          for (int i = 0; i < n_points; ++i) u_in[t](i) = gw.on_mesh(i)(n1, n2);
+          coefs[t] = utility::pade_coefficients_dd(z_in[t], u_in[t], make_e(gr));
+        });
 
-          for (int i = 0; i < n_points; ++i) z_in(i) = gw.mesh()[i];
-          for (int i = 0; i < n_points; ++i) u_in(i) = gw.on_mesh(i)(n1, n2);
+        for (long t = 0; t < n_tasks; ++t)
+          if (!coefs[t]) coefs[t] = utility::pade_coefficients_gmp(z_in[t], u_in[t]);
 
-          triqs::utility::pade_approximant PA(z_in, u_in);
+        utility::parallel_for(n_tasks, n_threads, [&](long t) {
+          auto [gr, gw, n1, n2] = tasks[t];
+          utility::pade_evaluate(z_in[t], *coefs[t], make_e(gr), gr.data()(range(), n1, n2));
+        });
+      }
 
-          for (auto om : gr.mesh()) {
-            dcomplex e     = om + dcomplex(0.0, 1.0) * freq_offset;
-            gr[om](n1, n2) = PA(e);
-          }
-        }
+      void add_tasks(std::vector<pade_task> &tasks, gf_view<refreq> gr, gf_const_view<imfreq> gw) {
+        auto sh = gw.data().shape().front_pop();
+        if (gr.target_shape() != gw.target_shape())
+          TRIQS_RUNTIME_ERROR << "pade : the target shapes differ : " << gr.target_shape() << " and " << gw.target_shape();
+        gr() = 0.0;
+        for (int n1 = 0; n1 < sh[0]; n1++)
+          for (int n2 = 0; n2 < sh[1]; n2++) tasks.push_back({gr, gw, n1, n2});
       }
+
+    } // namespace
+
+    void pade(gf_view<refreq> gr, gf_const_view<imfreq> gw, int n_points, double freq_offset, int n_threads) {
+      std::vector<pade_task> tasks;
+      add_tasks(tasks, gr, gw);
+      pade_impl(tasks, n_points, freq_offset, n_threads);
+    }
+
+    void pade(gf_view<refreq, scalar_valued> gr, gf_const_view<imfreq, scalar_valued> gw, int n_points, double freq_offset, int n_threads) {
+      pade(reinterpret_scalar_valued_gf_as_matrix_valued(gr), reinterpret_scalar_valued_gf_as_matrix_valued(gw), n_points, freq_offset, n_threads);
     }
 
-    void pade(gf_view<refreq, scalar_valued> gr, gf_const_view<imfreq, scalar_valued> gw, int n_points, double freq_offset) {
-      pade(reinterpret_scalar_valued_gf_as_matrix_valued(gr), reinterpret_scalar_valued_gf_as_matrix_valued(gw), n_points, freq_offset);
+    void pade(block_gf_view<refreq> gr, block_gf_const_view<imfreq> gw, int n_points, double freq_offset, int n_threads) {
+      if (gr.size() != gw.size()) TRIQS_RUNTIME_ERROR << "pade : the block Green functions have " << gr.size() << " and " << gw.size() << " blocks";
+      std::vector<pade_task> tasks;
+      for (int b = 0; b < gr.size(); ++b) add_tasks(tasks, gr[b], gw[b]);
+      pade_impl(tasks, n_points, freq_offset, n_threads);
     }
 
   } // namespace gfs
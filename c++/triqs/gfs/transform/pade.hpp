@@ -22,7 +22,22 @@
 namespace triqs {
   namespace gfs {
 
-    void pade(gf_view<refreq> gr, gf_const_view<imfreq> gw, int n_points, double freq_offset);
-    void pade(gf_view<refreq, scalar_valued> gr, gf_const_view<imfreq, scalar_valued> gw, int n_points, double freq_offset);
+    /**
+     * Analytic continuation of gw to the real axis with Pade approximants, element by element
+     *
+     * The coefficients of the continued fraction are computed in double-double arithmetic, and in GMP arithmetic
+     * only for the elements where double-double is not accurate enough.
+     *
+     * @param gr           The result, on the real axis
+     * @param gw           The Green function in Matsubara frequencies
+     * @param n_points     Number of positive Matsubara frequencies used
+     * @param freq_offset  Imaginary offset of the real frequencies
+     * @param n_threads    Number of threads over which the matrix elements are distributed
+     */
+    void pade(gf_view<refreq> gr, gf_const_view<imfreq> gw, int n_points, double freq_offset, int n_threads = 1);
+    void pade(gf_view<refreq, scalar_valued> gr, gf_const_view<imfreq, scalar_valued> gw, int n_points, double freq_offset, int n_threads = 1);
+
+    /// Analytic continuation of all the blocks of gw, with the matrix elements of all the blocks distributed over the threads (cf above)
+    void pade(block_gf_view<refreq> gr, block_gf_const_view<imfreq> gw, int n_points, double freq_offset, int n_threads = 1);
   } // namespace gfs
 } // namespace triqs
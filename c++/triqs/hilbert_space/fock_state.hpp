@@ -0,0 +1,185 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Igor Krivenko, Nils Wentzell
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+// The number of bits of the fermionic Fock states, i.e. the maximal number of fundamental operators.
+// It is chosen at configure time (FOCK_STATE_BITS in cmake), as it changes the layout of all the Hilbert space classes.
+// It must then be the same in all the translation units of a program, libtriqs included.
+#ifndef TRIQS_FOCK_STATE_BITS
+#define TRIQS_FOCK_STATE_BITS 64
+#endif
+
+namespace triqs {
+  namespace hilbert_space {
+
+    /// A fixed size set of NBits bits, stored in 64 bits words (the least significant word first)
+    /**
+  It has the bitwise operations of an unsigned integer used as a fermionic Fock state.
+  @tparam NBits Number of bits, a multiple of 64
+  @include triqs/hilbert_space/fock_state.hpp
+ */
+    template <int NBits> class fock_bitset {
+      static_assert(NBits > 0 and NBits % 64 == 0, "fock_bitset : the number of bits must be a multiple of 64");
+
+      public:
+      static constexpr int n_words = NBits / 64;
+
+      /// The words, the least significant first
+      std::array<uint64_t, n_words> words = {};
+
+      fock_bitset() = default;
+
+      /// Construct from an integer, which sets the lowest 64 bits
+      fock_bitset(uint64_t x) { words[0] = x; }
+
+      /// The lowest 64 bits
+      uint64_t low_word() const { return words[0]; }
+
+      explicit operator bool() const {
+        uint64_t r = 0;
+        for (int w = 0; w < n_words; ++w) r |= words[w];
+        return r != 0;
+      }
+
+      fock_bitset &operator&=(fock_bitset const &x) {
+        for (int w = 0; w < n_words; ++w) words[w] &= x.words[w];
+        return *this;
+      }
+      fock_bitset &operator|=(fock_bitset const &x) {
+        for (int w = 0; w < n_words; ++w) words[w] |= x.words[w];
+        return *this;
+      }
+      fock_bitset &operator^=(fock_bitset const &x) {
+        for (int w = 0; w < n_words; ++w) words[w] ^= x.words[w];
+        return *this;
+      }
+
+      friend fock_bitset operator&(fock_bitset x, fock_bitset const &y) { return x &= y; }
+      friend fock_bitset operator|(fock_bitset x, fock_bitset const &y) { return x |= y; }
+      friend fock_bitset operator^(fock_bitset x, fock_bitset const &y) { return x ^= y; }
+
+      friend fock_bitset operator~(fock_bitset x) {
+        for (int w = 0; w < n_words; ++w) x.words[w] = ~x.words[w];
+        return x;
+      }
+
+      friend fock_bitset operator<<(fock_bitset const &x, int n) {
+        fock_bitset r;
+        int s = n / 64, b = n % 64;
+        for (int w = n_words - 1; w >= s; --w) {
+          r.words[w] = x.words[w - s] << b;
+          if (b != 0 and w - s - 1 >= 0) r.words[w] |= x.words[w - s - 1] >> (64 - b);
+        }
+        return r;
+      }
+
+      friend fock_bitset operator>>(fock_bitset const &x, int n) {
+        fock_bitset r;
+        int s = n / 64, b = n % 64;
+        for (int w = 0; w + s < n_words; ++w) {
+          r.words[w] = x.words[w + s] >> b;
+          if (b != 0 and w + s + 1 < n_words) r.words[w] |= x.words[w + s + 1] << (64 - b);
+        }
+        return r;
+      }
+
+      friend bool operator==(fock_bitset const &x, fock_bitset const &y) { return x.words == y.words; }
+      friend bool operator!=(fock_bitset const &x, fock_bitset const &y) { return x.words != y.words; }
+
+      // The order of the unsigned integers, i.e. the most significant word first
+      friend bool operator<(fock_bitset const &x, fock_bitset const &y) {
+        for (int w = n_words - 1; w >= 0; --w)
+          if (x.words[w] != y.words[w]) return x.words[w] < y.words[w];
+        return false;
+      }
+      friend bool operator>(fock_bitset const &x, fock_bitset const &y) { return y < x; }
+      friend bool operator<=(fock_bitset const &x, fock_bitset const &y) { return !(y < x); }
+      friend bool operator>=(fock_bitset const &x, fock_bitset const &y) { return !(x < y); }
+
+      /// Number of set bits
+      friend int popcount(fock_bitset const &x) {
+        int r = 0;
+        for (int w = 0; w < n_words; ++w) r += __builtin_popcountll(x.words[w]);
+        return r;
+      }
+
+      /// Parity of the number of set bits
+      friend bool parity(fock_bitset const &x) {
+        uint64_t r = 0;
+        for (int w = 0; w < n_words; ++w) r ^= x.words[w];
+        return __builtin_parityll(r);
+      }
+
+      /// Print in hexadecimal, the most significant word first
+      friend std::ostream &operator<<(std::ostream &out, fock_bitset const &x) {
+        auto flags = out.flags();
+        out << "0x" << std::hex;
+        bool leading = true;
+        for (int w = n_words - 1; w >= 0; --w) {
+          if (leading and x.words[w] == 0 and w > 0) continue;
+          if (!leading) {
+            out.width(16);
+            out.fill('0');
+          }
+          out << x.words[w];
+          leading = false;
+        }
+        out.flags(flags);
+        return out;
+      }
+    };
+
+    /// Number of set bits
+    inline int popcount(uint64_t x) { return __builtin_popcountll(x); }
+
+    /// Parity of the number of set bits
+    inline bool parity(uint64_t x) { return __builtin_parityll(x); }
+
+    /// The lowest 64 bits
+    inline uint64_t low_word(uint64_t x) { return x; }
+    template <int NBits> uint64_t low_word(fock_bitset<NBits> const &x) { return x.low_word(); }
+
+    /// Call L(n) for each set bit n, in increasing order
+    template <typename Lambda> void for_each_set_bit(uint64_t x, Lambda L) {
+      for (; x != 0; x &= x - 1) L(__builtin_ctzll(x));
+    }
+    template <int NBits, typename Lambda> void for_each_set_bit(fock_bitset<NBits> const &x, Lambda L) {
+      for (int w = 0; w < fock_bitset<NBits>::n_words; ++w)
+        for (uint64_t y = x.words[w]; y != 0; y &= y - 1) L(64 * w + __builtin_ctzll(y));
+    }
+
+    namespace detail {
+      template <int NBits> struct fock_state_impl { using type = fock_bitset<NBits>; };
+      template <> struct fock_state_impl<64> { using type = uint64_t; };
+    } // namespace detail
+
+    static_assert(TRIQS_FOCK_STATE_BITS == 64 or TRIQS_FOCK_STATE_BITS == 128 or TRIQS_FOCK_STATE_BITS == 256,
+                  "TRIQS_FOCK_STATE_BITS must be 64, 128 or 256");
+
+    /// Maximal number of fundamental operators
+    constexpr int fock_state_bits = TRIQS_FOCK_STATE_BITS;
+
+    /// The coding of the fermionic Fock state: a word of fock_state_bits bits in binary (a plain uint64_t for 64 bits).
+    using fock_state_t = typename detail::fock_state_impl<fock_state_bits>::type;
+
+  } // namespace hilbert_space
+} // namespace triqs
@@ -0,0 +1,235 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Igor Krivenko, Nils Wentzell
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include "./fock_state.hpp"
+
+namespace triqs {
+  namespace hilbert_space {
+
+    /// The kinds of fock_state_lookup
+    enum class lookup_kind {
+      direct,        ///< Table addressed by the bits of the window
+      combinatorial, ///< Table addressed by the rank of the state among the states with the same number of particles in the window
+      hash           ///< Open addressing hash table
+    };
+
+    /// The map from the Fock states of a Hilbert subspace to their indices
+    /**
+  The states are added one by one, and the kind of lookup is selected from the states added so far.
+  The window is the range of bits which are not the same in all the states.
+
+  * If the 2^w states of a window of w bits are not many more than the states, it uses a table
+    addressed by the bits of the window (`direct`).
+  * If all the states have the same number of particles n, and the C(w, n) such states are not many more than the states,
+    it uses a table addressed by their rank in the combinatorial number system (`combinatorial`).
+  * Otherwise it uses a hash table with linear probing (`hash`).
+
+  The table is rebuilt from all the states when the window or the kind change, which happens at most a few times per bit.
+  @include triqs/hilbert_space/fock_state_lookup.hpp
+ */
+    class fock_state_lookup {
+
+      // A table is used if it has at most max(max_load * number of states, min_table_size) entries
+      static constexpr long max_load       = 4;
+      static constexpr long min_table_size = 64;
+
+      lookup_kind kind = lookup_kind::direct;
+
+      // The bits which are set in all the states, and in some state
+      fock_state_t and_all = ~fock_state_t(0), or_all = 0;
+
+      // The window [lo, lo + w), its mask and the bits of the states outside it
+      int lo = 0, w = 0;
+      fock_state_t window_mask = 0, fixed = 0;
+
+      // The number of particles of all the states, and in the window, -1 if they differ
+      int n_total = -1, n_particles = -1;
+
+      // binom[p * (n_particles + 1) + k] = C(p, k) for p <= w, saturated (only for combinatorial)
+      std::vector<uint64_t> binom;
+
+      // The table of the indices (direct, combinatorial or hash), -1 for an empty slot
+      std::vector<int> table;
+
+      // The states of the hash slots, and the shift of the hash
+      std::vector<fock_state_t> hash_keys;
+      int hash_shift = 64;
+
+      int size = 0;
+
+      static constexpr uint64_t saturation = uint64_t(1) << 62;
+
+      static uint64_t fold(uint64_t f) { return f; }
+      template <int NBits> static uint64_t fold(fock_bitset<NBits> const &f) {
+        uint64_t r = 0;
+        for (int i = 0; i < fock_bitset<NBits>::n_words; ++i) r = (r ^ f.words[i]) * 0x9E3779B97F4A7C15ull;
+        return r;
+      }
+
+      // Fibonacci hashing on the hash_keys.size() = 2^(64 - hash_shift) slots
+      int hash_slot(fock_state_t const &f) const { return int((fold(f) * 0x9E3779B97F4A7C15ull) >> hash_shift); }
+
+      // The position of the state in the direct table
+      long direct_slot(fock_state_t const &f) const { return long(low_word(f >> lo) & ((uint64_t(1) << w) - 1)); }
+
+      // The rank of the state among the states with n_particles particles in the window
+      long combinatorial_slot(fock_state_t const &f) const {
+        uint64_t r = 0;
+        int k      = 1;
+        for_each_set_bit(f & window_mask, [&](int p) {
+          if (k <= n_particles) r += binom[(p - lo) * (n_particles + 1) + k];
+          ++k;
+        });
+        return (k == n_particles + 1 ? long(r) : -1);
+      }
+
+      // C(w, n) saturated
+      static uint64_t n_combinations(int w, int n) {
+        n          = std::min(n, w - n);
+        uint64_t r = 1;
+        for (int k = 1; k <= n; ++k) {
+          r = uint64_t((unsigned __int128)(r) * (w - n + k) / k); // exact, r = C(w - n + k, k)
+          if (r >= saturation) return saturation;
+        }
+        return r;
+      }
+
+      // Store the index i of the state f, unless f is already there
+      void insert(fock_state_t const &f, int i) {
+        if (kind == lookup_kind::hash) {
+          int mask = int(hash_keys.size()) - 1;
+          for (int s = hash_slot(f);; s = (s + 1) & mask) {
+            if (table[s] == -1) {
+              table[s]     = i;
+              hash_keys[s] = f;
+              return;
+            }
+            if (hash_keys[s] == f) return;
+          }
+        }
+        long s = (kind == lookup_kind::direct ? direct_slot(f) : combinatorial_slot(f));
+        if (table[s] == -1) table[s] = i;
+      }
+
+      // Rebuild the table of the current kind from all the states
+      void rebuild(std::vector<fock_state_t> const &fock_states) {
+        table.clear();
+        hash_keys.clear();
+        binom.clear();
+        if (kind == lookup_kind::direct)
+          table.assign(long(1) << w, -1);
+        else if (kind == lookup_kind::combinatorial) {
+          int n1 = n_particles + 1;
+          binom.assign((w + 1) * n1, 0);
+          for (int p = 0; p <= w; ++p) {
+            binom[p * n1] = 1;
+            for (int k = 1; k < n1 and p > 0; ++k) binom[p * n1 + k] = std::min(saturation, binom[(p - 1) * n1 + k - 1] + binom[(p - 1) * n1 + k]);
+          }
+          table.assign(n_combinations(w, n_particles), -1);
+        } else {
+          long n_slots = 16;
+          while (n_slots < 2 * long(fock_states.size())) n_slots *= 2;
+          hash_shift = 64 - __builtin_ctzll(n_slots);
+          table.assign(n_slots, -1);
+          hash_keys.assign(n_slots, fock_state_t(0));
+        }
+        for (int i = 0; i < fock_states.size(); ++i) insert(fock_states[i], i);
+      }
+
+      public:
+      /// Add the last state of fock_states, the list of all the states, in the order of their indices
+      /**
+   @param fock_states The states of the subspace, including the new one
+ */
+      void push_back(std::vector<fock_state_t> const &fock_states) {
+        auto const &f = fock_states.back();
+        size          = fock_states.size();
+
+        // Update the window. The bits outside of it are the same in all the states,
+        // so the states have the same number of particles in the window iff they have the same number of particles.
+        bool changed = (size == 1);
+        if ((f & and_all) != and_all or (f | or_all) != or_all) {
+          and_all &= f;
+          or_all |= f;
+          int first = -1, last = -1;
+          for_each_set_bit(and_all ^ or_all, [&](int p) {
+            if (first == -1) first = p;
+            last = p;
+          });
+          lo          = std::max(first, 0);
+          w           = last + 1 - lo;
+          window_mask = (w == fock_state_bits ? ~fock_state_t(0) : ~(~fock_state_t(0) << w) << lo);
+          fixed       = and_all & ~window_mask;
+          changed     = true;
+        }
+        int n = popcount(f);
+        if (size == 1)
+          n_total = n;
+        else if (n_total != -1 and n != n_total) {
+          n_total = -1;
+          changed = true;
+        }
+        n_particles = (n_total == -1 ? -1 : n_total - popcount(fixed));
+
+        // Select the kind of lookup. The hash table does not depend on the window, but grows with the states.
+        long max_table_size = std::max(max_load * size, min_table_size);
+        auto new_kind       = lookup_kind::hash;
+        if (w < 62 and (long(1) << w) <= max_table_size)
+          new_kind = lookup_kind::direct;
+        else if (n_particles != -1 and n_combinations(w, n_particles) <= max_table_size)
+          new_kind = lookup_kind::combinatorial;
+        if (new_kind == lookup_kind::hash) changed = (kind != lookup_kind::hash) or (2 * size > long(hash_keys.size()));
+        changed = changed or (new_kind != kind);
+        kind    = new_kind;
+
+        if (changed)
+          rebuild(fock_states);
+        else
+          insert(f, size - 1);
+      }
+
+      /// The index of a Fock state, or -1 if it is not there
+      /**
+   @param f Fock state
+   @return The index of the state
+ */
+      int find(fock_state_t const &f) const {
+        if (kind == lookup_kind::hash) {
+          if (table.empty()) return -1;
+          int mask = int(hash_keys.size()) - 1;
+          for (int s = hash_slot(f);; s = (s + 1) & mask) {
+            if (table[s] == -1 or hash_keys[s] == f) return table[s];
+          }
+        }
+        if (size == 0 or (f & ~window_mask) != fixed) return -1;
+        long s = (kind == lookup_kind::direct ? direct_slot(f) : combinatorial_slot(f));
+        return (s == -1 ? -1 : table[s]);
+      }
+
+      /// The kind of lookup
+      lookup_kind get_kind() const { return kind; }
+
+      /// Clear all the states
+      void clear() { *this = fock_state_lookup{}; }
+    };
+
+  } // namespace hilbert_space
+} // namespace triqs
@@ -21,17 +21,16 @@
 #pragma once
 
 #include <set>
-#include <boost/container/flat_map.hpp>
+#include <algorithm>
 #include <triqs/utility/exceptions.hpp>
 #include <h5/h5.hpp>
 #include "fundamental_operator_set.hpp"
+#include "fock_state.hpp"
+#include "fock_state_lookup.hpp"
 
 namespace triqs {
   namespace hilbert_space {
 
-    /// The coding of the fermionic Fock state: 64 bits word in binary.
-    using fock_state_t = uint64_t;
-
     /// A Hilbert space spanned from *all* fermionic Fock states generated by a given set of fundamental operators.
     /**
   @include triqs/hilbert_space/hilbert_space.hpp
@@ -43,11 +42,22 @@ namespace triqs {
       /// Construct a dummy Hilbert space of zero size
       hilbert_space() : dim(0) {}
 
+      /// Maximal number of fundamental operators : the dimension 2^n must be an int
+      static constexpr int max_n_operators = 30;
+
       /// Construct from a given fundamental operator set
       /**
+   The full space is stored by its dimension, so it is limited to max_n_operators operators,
+   independently of the width of the Fock states. Use sub_hilbert_space for larger sets.
+
    @param fops Generating fundamental operator set
  */
-      hilbert_space(fundamental_operator_set const &fops) : dim(1ull << fops.size()) {}
+      hilbert_space(fundamental_operator_set const &fops) : dim(0) {
+        if (fops.size() > max_n_operators)
+          TRIQS_RUNTIME_ERROR << "The full Hilbert space of " << fops.size() << " fundamental operators is too large (at most "
+                              << max_n_operators << ")";
+        dim = 1 << fops.size();
+      }
 
       /// Return the total number of the fermionic Fock states in this space
       /**
@@ -77,7 +87,7 @@ namespace triqs {
    @param f Fock state in question
    @return `true` if `f` belongs to the space, `false` otherwise
  */
-      bool has_state(fock_state_t f) const { return f < dim; }
+      bool has_state(fock_state_t f) const { return f < fock_state_t(dim); }
 
       /// Find the index of a given Fock state within this space
       /**
@@ -85,8 +95,8 @@ namespace triqs {
    @return State index
  */
       int get_state_index(fock_state_t f) const {
-        if (f >= dim) TRIQS_RUNTIME_ERROR << "This index is too big, f = " << f;
-        return f;
+        if (!has_state(f)) TRIQS_RUNTIME_ERROR << "This index is too big, f = " << f;
+        return low_word(f);
       }
 
       /// Return the `i`-th basis element as a Fock state
@@ -107,7 +117,7 @@ namespace triqs {
  */
       fock_state_t get_fock_state(fundamental_operator_set const &fops, std::set<fundamental_operator_set::indices_t> const &indices) const {
         fock_state_t f = 0;
-        for (auto const &index : indices) f += 1 << fops[index];
+        for (auto const &index : indices) f |= fock_state_t(1) << fops[index];
         return f;
       }
 
@@ -140,6 +150,31 @@ namespace triqs {
       }
     };
 
+    namespace detail {
+
+      // The Fock states of a sub_hilbert_space in HDF5 : the integers for 64 bits,
+      // and otherwise the words of all the states, the least significant first
+      inline void h5_write_fock_states(h5::group gr, std::vector<uint64_t> const &fock_states) { h5_write(gr, "fock_states", fock_states); }
+      inline void h5_read_fock_states(h5::group gr, std::vector<uint64_t> &fock_states) { h5_read(gr, "fock_states", fock_states); }
+
+      template <int NBits> void h5_write_fock_states(h5::group gr, std::vector<fock_bitset<NBits>> const &fock_states) {
+        std::vector<uint64_t> words;
+        for (auto const &f : fock_states) words.insert(words.end(), f.words.begin(), f.words.end());
+        h5_write(gr, "fock_states", words);
+      }
+
+      template <int NBits> void h5_read_fock_states(h5::group gr, std::vector<fock_bitset<NBits>> &fock_states) {
+        std::vector<uint64_t> words;
+        h5_read(gr, "fock_states", words);
+        int n_words = fock_bitset<NBits>::n_words;
+        if (words.size() % n_words != 0) TRIQS_RUNTIME_ERROR << "h5_read of sub_hilbert_space : the Fock states do not have " << NBits << " bits";
+        fock_states.resize(words.size() / n_words);
+        for (int i = 0; i < fock_states.size(); ++i)
+          std::copy(words.begin() + i * n_words, words.begin() + (i + 1) * n_words, fock_states[i].words.begin());
+      }
+
+    } // namespace detail
+
     /// Hilbert subspace, as an ordered set of basis Fock states.
     /**
   Subspaces carry an integer index, which allows them to be destinguished as parts of a full Hilbert space.
@@ -159,9 +194,9 @@ namespace triqs {
       sub_hilbert_space(sub_hilbert_space const &) = default;
       sub_hilbert_space(sub_hilbert_space &&)      = default;
       sub_hilbert_space &operator                  =(sub_hilbert_space const &x) {
-        index         = x.index;
-        fock_states   = x.fock_states;
-        fock_to_index = x.fock_to_index;
+        index       = x.index;
+        fock_states = x.fock_states;
+        lookup      = x.lookup;
         return *this;
       }
       sub_hilbert_space &operator=(sub_hilbert_space &&) = default;
@@ -172,9 +207,8 @@ namespace triqs {
    @param f Fock state to add
  */
       void add_fock_state(fock_state_t f) {
-        int ind = fock_states.size();
         fock_states.push_back(f);
-        fock_to_index.insert(std::make_pair(f, ind));
+        lookup.push_back(fock_states);
       }
 
       /// Return the total number of the fermionic Fock states in this space
@@ -205,17 +239,25 @@ namespace triqs {
 
       /// Find the index of a given Fock state within this subspace
       /**
+   The lookup is selected from the states of the subspace, see [[fock_state_lookup]].
+
    @param f Fock state in question
-   @return State index
+   @return State index, or -1 if `f` does not belong to the subspace
+ */
+      int get_state_index(fock_state_t f) const { return lookup.find(f); }
+
+      /// Return the kind of lookup used by `get_state_index`
+      /**
+   @return Kind of lookup
  */
-      int get_state_index(fock_state_t f) const { return fock_to_index.find(f)->second; }
+      lookup_kind get_lookup_kind() const { return lookup.get_kind(); }
 
       /// Check if a given Fock state belongs to this subspace
       /**
    @param f Fock state in question
    @return `true` if `f` belongs to the subspace, `false` otherwise
  */
-      bool has_state(fock_state_t f) const { return fock_to_index.count(f) == 1; }
+      bool has_state(fock_state_t f) const { return lookup.find(f) != -1; }
 
       /// Return the `i`-th basis element as a Fock state
       /**
@@ -250,9 +292,8 @@ namespace triqs {
       std::vector<fock_state_t> fock_states;
 
       // Reverse map to quickly find the index of a state.
-      // The boost::container::flat_map is implemented as an ordered vector,
-      // hence it is slow to insert (we don't care) but fast to look up (we do it a lot)
-      boost::container::flat_map<fock_state_t, int> fock_to_index;
+      // It is slower to insert (we don't care) but fast to look up (we do it a lot)
+      fock_state_lookup lookup;
 
       public:
       /// Return name of the HDF5 scheme
@@ -270,7 +311,7 @@ namespace triqs {
       friend void h5_write(h5::group fg, std::string const &name, sub_hilbert_space const &hs) {
         auto gr = fg.create_group(name);
         h5_write(gr, "index", hs.index);
-        h5_write(gr, "fock_states", hs.fock_states);
+        detail::h5_write_fock_states(gr, hs.fock_states);
       }
 
       /// Read a Hilbert subspace from an HDF5 group
@@ -283,9 +324,11 @@ namespace triqs {
         using h5::h5_read;
         auto gr = fg.open_group(name);
         h5_read(gr, "index", hs.index);
-        h5_read(gr, "fock_states", hs.fock_states);
-        hs.fock_to_index.clear();
-        for (auto f : hs.fock_states) hs.fock_to_index.insert(std::make_pair(f, static_cast<int>(hs.fock_to_index.size())));
+        detail::h5_read_fock_states(gr, hs.fock_states);
+        auto fock_states = std::move(hs.fock_states);
+        hs.fock_states.clear();
+        hs.lookup.clear();
+        for (auto const &f : fock_states) hs.add_fock_state(f);
       }
     };
   } // namespace hilbert_space
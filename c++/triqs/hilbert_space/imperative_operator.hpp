@@ -73,7 +73,7 @@ namespace triqs {
 
       struct one_term_t {
         scalar_t coeff;
-        uint64_t d_mask, dag_mask, d_count_mask, dag_count_mask;
+        fock_state_t d_mask, dag_mask, d_count_mask, dag_count_mask;
       };
       std::vector<one_term_t> all_terms;
 
@@ -98,28 +98,31 @@ namespace triqs {
         sub_spaces  = sub_spaces_set;
         hilbert_map = hmap;
         if ((hilbert_map.size() == 0) != !UseMap) TRIQS_RUNTIME_ERROR << "Internal error";
+        if (fops.size() > fock_state_bits)
+          TRIQS_RUNTIME_ERROR << "imperative_operator : " << fops.size() << " fundamental operators do not fit in the " << fock_state_bits
+                              << " bits of the Fock states. Reconfigure with a larger FOCK_STATE_BITS";
 
         // The goal here is to have a transcription of the many_body_operator in terms
         // of simple vectors (maybe the code below could be more elegant)
         for (auto const &term : op) {
           std::vector<int> dag, ndag;
-          uint64_t d_mask = 0, dag_mask = 0;
+          fock_state_t d_mask = 0, dag_mask = 0;
           for (auto const &canonical_op : term.monomial) {
             (canonical_op.dagger ? dag : ndag).push_back(fops[canonical_op.indices]);
-            (canonical_op.dagger ? dag_mask : d_mask) |= (uint64_t(1) << fops[canonical_op.indices]);
+            (canonical_op.dagger ? dag_mask : d_mask) |= (fock_state_t(1) << fops[canonical_op.indices]);
           }
           auto compute_count_mask = [](std::vector<int> const &d) {
-            uint64_t mask = 0;
-            bool is_on    = (d.size() % 2 == 1);
-            for (int i = 0; i < 64; ++i) {
+            fock_state_t mask = 0;
+            bool is_on        = (d.size() % 2 == 1);
+            for (int i = 0; i < fock_state_bits; ++i) {
               if (std::find(begin(d), end(d), i) != end(d))
                 is_on = !is_on;
               else if (is_on)
-                mask |= (uint64_t(1) << i);
+                mask |= (fock_state_t(1) << i);
             }
             return mask;
           };
-          uint64_t d_count_mask = compute_count_mask(ndag), dag_count_mask = compute_count_mask(dag);
+          fock_state_t d_count_mask = compute_count_mask(ndag), dag_count_mask = compute_count_mask(dag);
           all_terms.push_back(one_term_t{scalar_t(term.coef), d_mask, dag_mask, d_count_mask, dag_count_mask});
         }
       }
@@ -146,17 +149,6 @@ namespace triqs {
         return StateType(st.get_hilbert());
       }
 
-      static bool parity_number_of_bits(uint64_t v) {
-        // http://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetNaive
-        // v ^= v >> 16;
-        // only ok until 16 orbitals ! assert this or put the >> 16
-        v ^= v >> 8;
-        v ^= v >> 4;
-        v ^= v >> 2;
-        v ^= v >> 1;
-        return v & 0x01;
-      }
-
       // Forward the call to the coefficient
 #ifdef GCC_BUG_41933_WORKAROUND
       template <typename... Args>
@@ -210,7 +202,7 @@ namespace triqs {
             f2 &= ~M.d_mask;
             if (((f2 ^ M.dag_mask) & M.dag_mask) != M.dag_mask) return;
             fock_state_t f3    = ~(~f2 & ~M.dag_mask);
-            auto sign_is_minus = parity_number_of_bits((f2 & M.d_count_mask) ^ (f3 & M.dag_count_mask));
+            auto sign_is_minus = parity((f2 & M.d_count_mask) ^ (f3 & M.dag_count_mask));
             // update state vector in target Hilbert space
             auto ind = target_st.get_hilbert().get_state_index(f3);
 #ifdef GCC_BUG_41933_WORKAROUND
@@ -376,7 +376,7 @@ namespace triqs {
     template <typename TargetState, typename OriginalState> TargetState project(OriginalState const &psi, hilbert_space const &proj_hs) {
       TargetState proj_psi(proj_hs);
       auto const &hs = psi.get_hilbert();
-      foreach (psi, [&](int i, typename OriginalState::value_type v) { proj_psi(hs.get_fock_state(i)) = v; })
+      foreach (psi, [&](int i, typename OriginalState::value_type v) { proj_psi(proj_psi.get_hilbert().get_state_index(hs.get_fock_state(i))) = v; })
         ;
       return proj_psi;
     }
@@ -397,7 +397,7 @@ namespace triqs {
     template <typename A, typename B> struct __lambda1 {
       A &proj_psi;
       B const &hs;
-      template <typename VT> void operator()(int i, VT const &v) { proj_psi(hs.get_fock_state(i)) = v; }
+      template <typename VT> void operator()(int i, VT const &v) { proj_psi(proj_psi.get_hilbert().get_state_index(hs.get_fock_state(i))) = v; }
     };
     template <typename A, typename B, typename C> struct __lambda2 {
       A &proj_psi;
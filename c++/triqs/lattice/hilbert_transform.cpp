@@ -0,0 +1,288 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Michel Ferrero, Olivier Parcollet, Nils Wentzell
+
+#include "./hilbert_transform.hpp"
+#include <triqs/arrays/linalg/batched_inverse.hpp>
+#include <queue>
+
+namespace triqs {
+  namespace lattice {
+
+    using namespace arrays;
+    using gfs::gf_mesh;
+
+    namespace {
+
+      // z_w = w + mu + i eta, for all the points of the mesh
+      template <typename V> std::vector<dcomplex> shifted_frequencies(gf_mesh<V> const &m, double mu, double eta) {
+        std::vector<dcomplex> z(m.size());
+        for (auto const &w : m) z[w.linear_index()] = dcomplex(w) + mu + 1i * eta;
+        return z;
+      }
+
+      bool is_diagonal(array_const_view<dcomplex, 3> s) {
+        for (long w = 0; w < first_dim(s); ++w)
+          for (long a = 0; a < second_dim(s); ++a)
+            for (long b = 0; b < third_dim(s); ++b)
+              if (a != b and s(w, a, b) != 0.0) return false;
+        return true;
+      }
+
+      // res(w, a, a) += sum_i rho_i / (z_w - eps_i - sigma(w, a, a)), for a diagonal sigma.
+      // The inner loop runs over the frequencies, in real arithmetic, so that it vectorizes.
+      void accumulate_diagonal(std::vector<dcomplex> const &z, array_const_view<dcomplex, 3> sigma, array_const_view<double, 1> eps,
+                               array_const_view<double, 1> rho, array_view<dcomplex, 3> res) {
+        long n_w = z.size();
+        std::vector<double> zr(n_w), zi(n_w), ar(n_w), ai(n_w);
+        for (long a = 0; a < second_dim(sigma); ++a) {
+          for (long w = 0; w < n_w; ++w) {
+            zr[w] = std::real(z[w] - sigma(w, a, a));
+            zi[w] = std::imag(z[w] - sigma(w, a, a));
+            ar[w] = ai[w] = 0;
+          }
+          double const *__restrict xr = zr.data(), *__restrict xi = zi.data();
+          double *__restrict yr = ar.data(), *__restrict yi = ai.data();
+          for (long i = 0; i < first_dim(eps); ++i) {
+            double e = eps(i), r = rho(i);
+            for (long w = 0; w < n_w; ++w) {
+              double x = xr[w] - e, y = xi[w];
+              double d = r / (x * x + y * y);
+              yr[w] += x * d;
+              yi[w] -= y * d;
+            }
+          }
+          for (long w = 0; w < n_w; ++w) res(w, a, a) += dcomplex(ar[w], ai[w]);
+        }
+      }
+
+      // res(w, :, :) += sum_i rho_i [z_w - eps_hat(i) - sigma(w)]^-1.
+      // For each frequency, the matrices of all the energies are inverted together.
+      void accumulate_matrix(std::vector<dcomplex> const &z, array_const_view<dcomplex, 3> sigma, array_const_view<dcomplex, 3> eps_hat,
+                             array_const_view<double, 1> rho, array_view<dcomplex, 3> res) {
+        long n_eps = first_dim(eps_hat), n = second_dim(sigma);
+        auto M     = array<dcomplex, 3>(n_eps, n, n);
+        for (long w = 0; w < long(z.size()); ++w) {
+          for (long i = 0; i < n_eps; ++i)
+            for (long a = 0; a < n; ++a)
+              for (long b = 0; b < n; ++b) M(i, a, b) = (a == b ? z[w] : 0) - eps_hat(i, a, b) - sigma(w, a, b);
+          batched_inverse_in_place(M);
+          for (long i = 0; i < n_eps; ++i) res(w, range(), range()) += rho(i) * M(i, range(), range());
+        }
+      }
+
+      void check_sigma(array_const_view<dcomplex, 3> sigma) {
+        if (second_dim(sigma) != third_dim(sigma))
+          TRIQS_RUNTIME_ERROR << "hilbert_transform : sigma is not square but of size " << second_dim(sigma) << " x " << third_dim(sigma);
+      }
+
+      // res += sum_i rho_i [z - eps_i - sigma]^-1. diag : is sigma diagonal ?
+      void accumulate(std::vector<dcomplex> const &z, array_const_view<dcomplex, 3> sigma, bool diag, array_const_view<double, 1> eps,
+                      array_const_view<double, 1> rho, array_view<dcomplex, 3> res) {
+        if (first_dim(eps) != first_dim(rho)) TRIQS_RUNTIME_ERROR << "hilbert_transform : " << first_dim(rho) << " weights for " << first_dim(eps) << " energies";
+        if (diag) {
+          accumulate_diagonal(z, sigma, eps, rho, res);
+          return;
+        }
+        long n       = second_dim(sigma);
+        auto eps_hat = array<dcomplex, 3>(first_dim(eps), n, n);
+        eps_hat()    = 0;
+        for (long i = 0; i < first_dim(eps); ++i)
+          for (long a = 0; a < n; ++a) eps_hat(i, a, a) = eps(i);
+        accumulate_matrix(z, sigma, eps_hat, rho, res);
+      }
+
+      // -------------------------------------------------------
+
+      template <typename V> gf<V> ht_impl(array_const_view<double, 1> eps, array_const_view<double, 1> rho, gf_const_view<V> sigma, double mu, double eta) {
+        check_sigma(sigma.data());
+        auto g = gf<V>{sigma.mesh(), sigma.target_shape()};
+        g()    = 0;
+        accumulate(shifted_frequencies(sigma.mesh(), mu, eta), sigma.data(), is_diagonal(sigma.data()), eps, rho, g.data());
+        return g;
+      }
+
+      template <typename V>
+      gf<V> ht_impl(array_const_view<double, 1> rho, std::vector<matrix<dcomplex>> const &eps_hat, gf_const_view<V> sigma, double mu, double eta) {
+        check_sigma(sigma.data());
+        long n_eps = eps_hat.size(), n = second_dim(sigma.data());
+        if (n_eps != first_dim(rho)) TRIQS_RUNTIME_ERROR << "hilbert_transform : " << first_dim(rho) << " weights for " << n_eps << " matrices eps_hat";
+        auto eps_hat_arr = array<dcomplex, 3>(n_eps, n, n);
+        for (long i = 0; i < n_eps; ++i) {
+          if (first_dim(eps_hat[i]) != n or second_dim(eps_hat[i]) != n)
+            TRIQS_RUNTIME_ERROR << "hilbert_transform : the matrices eps_hat and sigma have different sizes";
+          eps_hat_arr(i, range(), range()) = eps_hat[i];
+        }
+        auto g = gf<V>{sigma.mesh(), sigma.target_shape()};
+        g()    = 0;
+        accumulate_matrix(shifted_frequencies(sigma.mesh(), mu, eta), sigma.data(), eps_hat_arr, rho, g.data());
+        return g;
+      }
+
+      // The Gauss-Kronrod (7, 15) rule on [-1, 1] (QUADPACK qk15). The 15 nodes are 0 and -+ gk_x[j], j < 7,
+      // with the Kronrod weights gk_wk. The 7 Gauss nodes are 0 and -+ gk_x[1], gk_x[3], gk_x[5], with the weights gk_wg.
+      constexpr double gk_x[8]  = {0.991455371120812639206854697526329, 0.949107912342758524526189684047851, 0.864864423359769072789712788640926,
+                                  0.741531185599394439863864773280788, 0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+                                  0.207784955007898467600689403773245, 0.0};
+      constexpr double gk_wk[8] = {0.022935322010529224963732008058970, 0.063092092629978553290700663189204, 0.104790010322250183839876322541518,
+                                   0.140653259715525918745189590510238, 0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+                                   0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+      constexpr double gk_wg[4] = {0.129484966168869693270611432679082, 0.279705391489276667901467771423780, 0.381830050505118944950369775488975,
+                                   0.417959183673469387755102040816327};
+
+      // An interval of the adaptive integration, with the error estimate of its integral
+      struct ht_interval {
+        double a, b, err;
+        bool operator<(ht_interval const &x) const { return err < x.err; }
+      };
+
+      // Calls f(e, wk, wg) for the 15 nodes e of the Gauss-Kronrod rule on [a, b], with their Kronrod weight wk,
+      // and their Gauss weight wg (0 for the 8 nodes which are not Gauss nodes)
+      template <typename F> void gk_nodes(double a, double b, F f) {
+        double c = (a + b) / 2, h = (b - a) / 2;
+        for (int j = 0; j < 8; ++j)
+          for (int s = 0; s < (j < 7 ? 2 : 1); ++s) f(c + (s == 0 ? -h : h) * gk_x[j], h * gk_wk[j], (j % 2 == 1 ? h * gk_wg[j / 2] : 0.0));
+      }
+
+      // Globally adaptive integration on [eps_min, eps_max], starting from n_min intervals.
+      // rule(a, b) computes the integral on [a, b] and returns its error estimate, add(s) adds s times this last integral
+      // to the result, and converged(err) tells whether the sum err of the error estimates is small enough.
+      // Until then, or until there are n_max intervals, the interval of largest error is split in two. Its integral is
+      // recomputed to be removed from the result, so that only the bounds and the errors of the intervals are kept.
+      template <typename R, typename A, typename C>
+      void gk_adaptive(double eps_min, double eps_max, long n_min, long n_max, R const &rule, A const &add, C const &converged) {
+        if (!(eps_max > eps_min)) TRIQS_RUNTIME_ERROR << "adaptive integration : empty interval [" << eps_min << ", " << eps_max << "]";
+        if (n_min < 1) TRIQS_RUNTIME_ERROR << "adaptive integration : n_min must be >= 1";
+
+        std::priority_queue<ht_interval> intervals;
+        double err = 0, l = (eps_max - eps_min) / n_min;
+        for (long i = 0; i < n_min; ++i) {
+          double a = eps_min + i * l, b = (i == n_min - 1 ? eps_max : a + l), e = rule(a, b);
+          intervals.push({a, b, e});
+          err += e;
+          add(1);
+        }
+
+        while (!converged(err) and long(intervals.size()) < n_max) {
+          auto [a, b, e] = intervals.top();
+          double m       = (a + b) / 2;
+          if (!(m > a and m < b)) break; // the interval can not be split any more
+          intervals.pop();
+          rule(a, b);
+          add(-1);
+          err -= e;
+          for (auto [a1, b1] : {std::pair{a, m}, std::pair{m, b}}) {
+            double e1 = rule(a1, b1);
+            intervals.push({a1, b1, e1});
+            err += e1;
+            add(1);
+          }
+        }
+      }
+
+      template <typename V>
+      gf<V> ht_adaptive(std::function<double(double)> const &rho_f, double eps_min, double eps_max, gf_const_view<V> sigma, double mu, double eta,
+                        double tolerance, long n_min, long n_max) {
+        check_sigma(sigma.data());
+        auto z    = shifted_frequencies(sigma.mesh(), mu, eta);
+        bool diag = is_diagonal(sigma.data());
+
+        // The 15 points rule (into ik) and the 7 points rule (into ig) on [a, b]. Returns the error estimate max |ik - ig|
+        auto eps_k = array<double, 1>(15), rho_k = array<double, 1>(15);
+        auto eps_g = array<double, 1>(7), rho_g = array<double, 1>(7);
+        long n_w = first_dim(sigma.data()), n = second_dim(sigma.data());
+        auto ik = array<dcomplex, 3>(n_w, n, n), ig = array<dcomplex, 3>(n_w, n, n);
+        auto kronrod = [&](double a, double b) {
+          int k = 0, g = 0;
+          gk_nodes(a, b, [&](double e, double wk, double wg) {
+            double r = rho_f(e);
+            eps_k(k) = e;
+            rho_k(k++) = wk * r;
+            if (wg == 0) return;
+            eps_g(g)   = e;
+            rho_g(g++) = wg * r;
+          });
+          ik() = 0;
+          ig() = 0;
+          accumulate(z, sigma.data(), diag, eps_k, rho_k, ik);
+          accumulate(z, sigma.data(), diag, eps_g, rho_g, ig);
+          return max_element(abs(ik - ig));
+        };
+
+        auto g = gf<V>{sigma.mesh(), sigma.target_shape()};
+        g()    = 0;
+        gk_adaptive(
+           eps_min, eps_max, n_min, n_max, kronrod, [&](int s) {
+             if (s > 0)
+               g.data() += ik;
+             else
+               g.data() -= ik;
+           },
+           [&](double err) { return err <= tolerance * max_element(abs(g.data())); });
+        return g;
+      }
+
+    } // namespace
+
+    //------------------------------------------------------
+
+    gf<imfreq> hilbert_transform(array_const_view<double, 1> eps, array_const_view<double, 1> rho, gf_const_view<imfreq> sigma, double mu, double eta) {
+      return ht_impl(eps, rho, sigma, mu, eta);
+    }
+
+    gf<refreq> hilbert_transform(array_const_view<double, 1> eps, array_const_view<double, 1> rho, gf_const_view<refreq> sigma, double mu, double eta) {
+      return ht_impl(eps, rho, sigma, mu, eta);
+    }
+
+    gf<imfreq> hilbert_transform(array_const_view<double, 1> rho, std::vector<matrix<dcomplex>> const &eps_hat, gf_const_view<imfreq> sigma, double mu,
+                                 double eta) {
+      return ht_impl(rho, eps_hat, sigma, mu, eta);
+    }
+
+    gf<refreq> hilbert_transform(array_const_view<double, 1> rho, std::vector<matrix<dcomplex>> const &eps_hat, gf_const_view<refreq> sigma, double mu,
+                                 double eta) {
+      return ht_impl(rho, eps_hat, sigma, mu, eta);
+    }
+
+    gf<imfreq> hilbert_transform(std::function<double(double)> const &rho, double eps_min, double eps_max, gf_const_view<imfreq> sigma, double mu,
+                                 double eta, double tolerance, long n_min, long n_max) {
+      return ht_adaptive(rho, eps_min, eps_max, sigma, mu, eta, tolerance, n_min, n_max);
+    }
+
+    gf<refreq> hilbert_transform(std::function<double(double)> const &rho, double eps_min, double eps_max, gf_const_view<refreq> sigma, double mu,
+                                 double eta, double tolerance, long n_min, long n_max) {
+      return ht_adaptive(rho, eps_min, eps_max, sigma, mu, eta, tolerance, n_min, n_max);
+    }
+
+    double dos_integral(std::function<double(double)> const &rho, double eps_min, double eps_max, double tolerance, long n_min, long n_max) {
+      double res = 0, ik = 0;
+      auto kronrod = [&](double a, double b) {
+        double ig = 0;
+        ik        = 0;
+        gk_nodes(a, b, [&](double e, double wk, double wg) {
+          double r = rho(e);
+          ik += wk * r;
+          ig += wg * r;
+        });
+        return std::abs(ik - ig);
+      };
+      gk_adaptive(
+         eps_min, eps_max, n_min, n_max, kronrod, [&](int s) { res += s * ik; }, [&](double err) { return err <= tolerance * std::abs(res); });
+      return res;
+    }
+
+  } // namespace lattice
+} // namespace triqs
@@ -0,0 +1,116 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Michel Ferrero, Olivier Parcollet, Nils Wentzell
+
+#pragma once
+#include "../gfs.hpp"
+#include <functional>
+
+namespace triqs {
+  namespace lattice {
+
+    using gfs::gf;
+    using gfs::gf_const_view;
+    using gfs::imfreq;
+    using gfs::refreq;
+
+    /**
+     * Hilbert transform of a density of states, on a grid of energies
+     *
+     * $$ G(\omega) = \sum_i \rho_i [(\omega + \mu + i\eta) \mathbf{1} - \epsilon_i \mathbf{1} - \Sigma(\omega)]^{-1} $$
+     *
+     * If $\Sigma(\omega)$ is diagonal, the sum is done element by element, without matrix inversion,
+     * in a loop over the frequencies which the compiler vectorizes.
+     * Otherwise, for each frequency, the matrices of all the energies are inverted together (cf batched_inverse_in_place).
+     *
+     * @param eps    The energies $\epsilon_i$
+     * @param rho    The weights $\rho_i$ of the energies, i.e. the density of states times the integration weights
+     * @param sigma  The self-energy
+     * @param mu     The chemical potential
+     * @param eta    The broadening
+     */
+    gf<imfreq> hilbert_transform(arrays::array_const_view<double, 1> eps, arrays::array_const_view<double, 1> rho, gf_const_view<imfreq> sigma,
+                                 double mu, double eta = 0);
+
+    /// Hilbert transform of a density of states on a grid of energies, on the real axis (cf above)
+    gf<refreq> hilbert_transform(arrays::array_const_view<double, 1> eps, arrays::array_const_view<double, 1> rho, gf_const_view<refreq> sigma,
+                                 double mu, double eta = 0);
+
+    /**
+     * Hilbert transform of a density of states, with a matrix $\hat\epsilon_i$ for each energy
+     *
+     * $$ G(\omega) = \sum_i \rho_i [(\omega + \mu + i\eta) \mathbf{1} - \hat\epsilon_i - \Sigma(\omega)]^{-1} $$
+     *
+     * @param rho      The weights $\rho_i$ of the energies
+     * @param eps_hat  The matrices $\hat\epsilon_i$
+     * @param sigma    The self-energy
+     * @param mu       The chemical potential
+     * @param eta      The broadening
+     */
+    gf<imfreq> hilbert_transform(arrays::array_const_view<double, 1> rho, std::vector<arrays::matrix<dcomplex>> const &eps_hat, gf_const_view<imfreq> sigma,
+                                 double mu, double eta = 0);
+
+    /// Hilbert transform of a density of states with a matrix for each energy, on the real axis (cf above)
+    gf<refreq> hilbert_transform(arrays::array_const_view<double, 1> rho, std::vector<arrays::matrix<dcomplex>> const &eps_hat, gf_const_view<refreq> sigma,
+                                 double mu, double eta = 0);
+
+    /**
+     * Hilbert transform of a density of states given as a function, by adaptive quadrature
+     *
+     * $$ G(\omega) = \int_{\epsilon_{min}}^{\epsilon_{max}} d\epsilon \rho(\epsilon) [(\omega + \mu + i\eta) \mathbf{1} - \epsilon \mathbf{1} - \Sigma(\omega)]^{-1} $$
+     *
+     * The integral is computed with the Gauss-Kronrod (7, 15) rule on n_min intervals. The interval of largest
+     * error estimate (the largest change of G between the 7 and 15 points rules) is then split in two,
+     * until the sum of the error estimates is below tolerance * max |G|, or until there are n_max intervals.
+     * The refinement is local : the intervals are only split around the singularities of the density of states
+     * (e.g. a Van Hove singularity or a band edge), and rho is never evaluated at the bounds of the intervals.
+     *
+     * @param rho        The density of states
+     * @param eps_min    The lower bound of the integral
+     * @param eps_max    The upper bound of the integral
+     * @param sigma      The self-energy
+     * @param mu         The chemical potential
+     * @param eta        The broadening
+     * @param tolerance  The relative tolerance of the integral
+     * @param n_min      The initial number of intervals
+     * @param n_max      The maximal number of intervals
+     */
+    gf<imfreq> hilbert_transform(std::function<double(double)> const &rho, double eps_min, double eps_max, gf_const_view<imfreq> sigma, double mu,
+                                 double eta = 0, double tolerance = 1.e-8, long n_min = 16, long n_max = 1 << 16);
+
+    /// Hilbert transform of a density of states given as a function, on the real axis (cf above)
+    gf<refreq> hilbert_transform(std::function<double(double)> const &rho, double eps_min, double eps_max, gf_const_view<refreq> sigma, double mu,
+                                 double eta = 0, double tolerance = 1.e-8, long n_min = 16, long n_max = 1 << 16);
+
+    /**
+     * Integral of a density of states given as a function, by the adaptive quadrature of hilbert_transform (cf above)
+     *
+     * $$ \int_{\epsilon_{min}}^{\epsilon_{max}} d\epsilon \rho(\epsilon) $$
+     *
+     * It normalizes the density of states consistently with its Hilbert transform.
+     *
+     * @param rho        The density of states
+     * @param eps_min    The lower bound of the integral
+     * @param eps_max    The upper bound of the integral
+     * @param tolerance  The relative tolerance of the integral
+     * @param n_min      The initial number of intervals
+     * @param n_max      The maximal number of intervals
+     */
+    double dos_integral(std::function<double(double)> const &rho, double eps_min, double eps_max, double tolerance = 1.e-8, long n_min = 16,
+                        long n_max = 1 << 16);
+
+  } // namespace lattice
+} // namespace triqs
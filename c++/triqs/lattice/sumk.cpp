@@ -0,0 +1,127 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Michel Ferrero, Olivier Parcollet, Nils Wentzell
+
+#include "./sumk.hpp"
+#include <triqs/arrays/linalg/batched_inverse.hpp>
+#include <triqs/utility/parallel_for.hpp>
+
+namespace triqs {
+  namespace lattice {
+
+    using namespace arrays;
+    using gfs::gf;
+    using gfs::gf_mesh;
+
+    namespace {
+
+      // The range [k0, k1) of the k-points of this node
+      std::pair<long, long> node_k_range(long n_k, mpi::communicator c) { return {(n_k * c.rank()) / c.size(), (n_k * (c.rank() + 1)) / c.size()}; }
+
+      /*
+       * out(w, a, b) += sum_{k in [k0, k1)} w_k [iw + mu - eps_k(a, b, k) - sigma(k, w, a, b)]^{-1}
+       *
+       * sigma_of_k(k) returns the (w, a, b) data of the self-energy at k.
+       * For each frequency, the matrices of all the k-points are gathered and inverted together.
+       */
+      template <typename SigmaOfK>
+      void sumk_block(array_const_view<dcomplex, 3> eps_k, array_const_view<double, 1> weights, gf_mesh<imfreq> const &mesh, SigmaOfK sigma_of_k,
+                      double mu, long k0, long k1, array_view<dcomplex, 3> out, int n_threads) {
+        long n = first_dim(eps_k), n_w = mesh.size();
+        if (second_dim(out) != n or third_dim(out) != n)
+          TRIQS_RUNTIME_ERROR << "sumk : the blocks of sigma are of size " << second_dim(out) << " x " << third_dim(out) << " instead of " << n << " x "
+                              << n;
+
+        std::vector<dcomplex> iw(n_w);
+        for (auto const &w : mesh) iw[w.linear_index()] = w;
+
+        utility::parallel_for_chunks(n_w, n_threads, [&](long w0, long w1) {
+          auto M = array<dcomplex, 3>(k1 - k0, n, n);
+          for (long w = w0; w < w1; ++w) {
+            for (long k = k0; k < k1; ++k) {
+              auto const &s = sigma_of_k(k);
+              for (long a = 0; a < n; ++a)
+                for (long b = 0; b < n; ++b) M(k - k0, a, b) = (a == b ? iw[w] + mu : 0) - eps_k(a, b, k) - s(w, a, b);
+            }
+            batched_inverse_in_place(M);
+            for (long k = k0; k < k1; ++k) out(w, range(), range()) += weights(k) * M(k - k0, range(), range());
+          }
+        });
+      }
+
+    } // namespace
+
+    //------------------------------------------------------
+
+    block_gf<imfreq> sumk(array_const_view<dcomplex, 3> eps_k, array_const_view<double, 1> weights, block_gf_const_view<imfreq> sigma, double mu,
+                          int n_threads, mpi::communicator c) {
+      long n_k = third_dim(eps_k);
+      if (first_dim(eps_k) != second_dim(eps_k)) TRIQS_RUNTIME_ERROR << "sumk : eps_k(a, b, k) is not square in (a, b)";
+      if (first_dim(weights) != n_k) TRIQS_RUNTIME_ERROR << "sumk : " << first_dim(weights) << " weights for " << n_k << " k-points";
+      auto [k0, k1] = node_k_range(n_k, c);
+
+      std::vector<gf<imfreq>> g_vec;
+      for (auto const &s : sigma) {
+        auto g = gf<imfreq>{s.mesh(), s.target_shape()};
+        g()    = 0;
+        sumk_block(eps_k, weights, s.mesh(), [&s](long) { return s.data(); }, mu, k0, k1, g.data(), n_threads);
+        g = mpi::all_reduce(g, c);
+        g_vec.push_back(std::move(g));
+      }
+      return {sigma.block_names(), std::move(g_vec)};
+    }
+
+    //------------------------------------------------------
+
+    block_gf<imfreq> sumk(tight_binding const &tb, array_const_view<double, 2> k_stack, array_const_view<double, 1> weights,
+                          block_gf_const_view<imfreq> sigma, double mu, int n_threads, mpi::communicator c) {
+      return sumk(hopping_stack(tb, k_stack), weights, sigma, mu, n_threads, c);
+    }
+
+    //------------------------------------------------------
+
+    block_gf<imfreq> sumk(tight_binding const &tb, block_gf_const_view<cartesian_product<brillouin_zone, imfreq>> sigma_k, double mu, int n_threads,
+                          mpi::communicator c) {
+      if (sigma_k.size() == 0) return {};
+      auto const &k_mesh = std::get<0>(sigma_k[0].mesh());
+      for (auto const &s : sigma_k)
+        if (std::get<0>(s.mesh()) != k_mesh) TRIQS_RUNTIME_ERROR << "sumk : the blocks of sigma_k have different k meshes";
+
+      // The k-points of the mesh, in the basis of the reciprocal lattice, and eps(k) on them
+      long n_k = k_mesh.size();
+      int dim  = tb.lattice().dim();
+      auto ks  = array<double, 2>(dim, n_k);
+      for (auto const &k : k_mesh) ks(range(), k.linear_index()) = k_mesh.domain().real_to_lattice_coordinates(k_t(k)(range(0, dim)))(range(0, dim));
+      auto eps_k   = hopping_stack(tb, ks);
+      auto weights = array<double, 1>(n_k);
+      weights()    = 1.0 / n_k;
+      auto [k0, k1] = node_k_range(n_k, c);
+
+      std::vector<gf<imfreq>> g_vec;
+      for (auto const &s : sigma_k) {
+        auto const &w_mesh = std::get<1>(s.mesh());
+        auto g             = gf<imfreq>{w_mesh, s.target_shape()};
+        g()                = 0;
+        auto sigma_of_k    = [d = s.data()](long k) { return d(k, range(), range(), range()); };
+        sumk_block(eps_k, weights, w_mesh, sigma_of_k, mu, k0, k1, g.data(), n_threads);
+        g = mpi::all_reduce(g, c);
+        g_vec.push_back(std::move(g));
+      }
+      return {sigma_k.block_names(), std::move(g_vec)};
+    }
+
+  } // namespace lattice
+} // namespace triqs
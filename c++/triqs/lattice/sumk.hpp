@@ -0,0 +1,86 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Michel Ferrero, Olivier Parcollet, Nils Wentzell
+
+#pragma once
+#include "./tight_binding.hpp"
+#include "../gfs.hpp"
+#include <mpi/mpi.hpp>
+
+namespace triqs {
+  namespace lattice {
+
+    using gfs::block_gf;
+    using gfs::block_gf_const_view;
+    using gfs::cartesian_product;
+    using gfs::imfreq;
+
+    /**
+     * The lattice Dyson sum with a local self-energy
+     *
+     * $$ G_b(i\omega) = \sum_k w_k [i\omega + \mu - \epsilon(k) - \Sigma_b(i\omega)]^{-1} $$
+     *
+     * for all blocks b, with the same $\epsilon(k)$ for all blocks.
+     *
+     * The k-points are distributed over the nodes of the communicator, and the frequencies of each node over n_threads threads.
+     * For each frequency, the matrices of all the k-points of the node are inverted together (cf batched_inverse_in_place).
+     * The result is reduced over the communicator once, at the end.
+     *
+     * @param eps_k     $\epsilon(k)$ for all k, as eps_k(a, b, k), i.e. the layout of hopping_stack
+     * @param weights   The weights $w_k$
+     * @param sigma     The self-energy. The blocks must be of the size of $\epsilon(k)$
+     * @param mu        The chemical potential
+     * @param n_threads Number of threads on each node
+     * @param c         The communicator
+     * @return G, on all nodes, with the block structure of sigma
+     */
+    block_gf<imfreq> sumk(arrays::array_const_view<dcomplex, 3> eps_k, arrays::array_const_view<double, 1> weights, block_gf_const_view<imfreq> sigma, double mu,
+                          int n_threads = 1, mpi::communicator c = {});
+
+    /**
+     * The lattice Dyson sum with a local self-energy, for a tight-binding model
+     *
+     * The hoppings $\epsilon(k)$ are computed once with hopping_stack (cf sumk above).
+     *
+     * @param tb        The tight-binding model
+     * @param k_stack   The k-points : k_stack(:, n) is the nth k-point, in the basis of the reciprocal lattice
+     * @param weights   The weights $w_k$
+     * @param sigma     The self-energy. The blocks must be of size tb.n_bands()
+     * @param mu        The chemical potential
+     * @param n_threads Number of threads on each node
+     * @param c         The communicator
+     */
+    block_gf<imfreq> sumk(tight_binding const &tb, arrays::array_const_view<double, 2> k_stack, arrays::array_const_view<double, 1> weights,
+                          block_gf_const_view<imfreq> sigma, double mu, int n_threads = 1, mpi::communicator c = {});
+
+    /**
+     * The lattice Dyson sum with a k-dependent self-energy, for a tight-binding model
+     *
+     * $$ G_b(i\omega) = \frac{1}{N_k} \sum_k [i\omega + \mu - \epsilon(k) - \Sigma_b(k, i\omega)]^{-1} $$
+     *
+     * where the sum runs over the k-points of the Brillouin zone mesh of sigma.
+     *
+     * @param tb        The tight-binding model
+     * @param sigma_k   The self-energy $\Sigma(k, i\omega)$. The blocks must be of size tb.n_bands()
+     * @param mu        The chemical potential
+     * @param n_threads Number of threads on each node
+     * @param c         The communicator
+     */
+    block_gf<imfreq> sumk(tight_binding const &tb, block_gf_const_view<cartesian_product<brillouin_zone, imfreq>> sigma_k, double mu,
+                          int n_threads = 1, mpi::communicator c = {});
+
+  } // namespace lattice
+} // namespace triqs
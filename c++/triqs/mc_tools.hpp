@@ -20,6 +20,7 @@
 #define TRIQS_MC_TOOLS_ALL_H
 
 #include <triqs/mc_tools/mc_generic.hpp>
+#include <triqs/mc_tools/mc_multi_walker.hpp>
 #include <triqs/utility/callbacks.hpp>
 
 #endif
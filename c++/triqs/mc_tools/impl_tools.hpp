@@ -118,6 +118,19 @@ namespace triqs {
 
 #endif
 
+    // ----------------- merge detection -----------------------
+    // A measure may provide void merge(T const &) to be combined with the same measure of another walker (cf mc_multi_walker).
+
+    template <typename T, typename = void> struct synth_merge {
+      static std::function<void(void const *)> invoke(T *p) { return {}; }
+    };
+    template <typename T> struct synth_merge<T, decltype(std::declval<T>().merge(std::declval<T const &>()))> {
+      static std::function<void(void const *)> invoke(T *p) {
+        return [p](void const *q) { p->merge(*static_cast<T const *>(q)); };
+      }
+    };
+    template <typename T> std::function<void(void const *)> make_merge(T *p) { return synth_merge<T>::invoke(p); }
+
       // move_construtible is not in gcc 4.6 std lib
       //template <class T> struct is_move_constructible : std::is_constructible<T, typename std::add_rvalue_reference<T>::type> {};
     } // namespace mc_tools
@@ -30,17 +30,25 @@
 #include "./mc_measure_aux_set.hpp"
 #include "./mc_measure_set.hpp"
 #include "./mc_move_set.hpp"
+#include "./mc_static_move_set.hpp"
 #include "./random_generator.hpp"
 
 namespace triqs::mc_tools {
 
+  template <typename MCSignType, typename MoveSetType> class mc_multi_walker;
+
   /**
   * \brief Generic Monte Carlo class.
   *
   * TBR
+  *
+  * @tparam MCSignType   Type of the sign of the weights (double or std::complex<double>)
+  * @tparam MoveSetType  The set of moves. By default, the type erased move_set, which accepts any move.
+  *                      static_move_set<MCSignType, Moves...> fixes the types of the moves at compile time,
+  *                      so that the Metropolis loop is fully inlined.
   * @include triqs/mc_tools.hpp
   */
-  template <typename MCSignType> class mc_generic {
+  template <typename MCSignType, typename MoveSetType = move_set<MCSignType>> class mc_generic {
 
 #ifdef TRIQS_MCTOOLS_DEBUG
     static constexpr bool debug = true;
@@ -60,6 +68,15 @@ namespace triqs::mc_tools {
        : RandomGenerator(random_name, random_seed), AllMoves(RandomGenerator), AllMeasures(), AllMeasuresAux(), report(&std::cout, verbosity) {}
 
     /**
+    * Constructor
+    *
+    * @param rng             The random generator, e.g. one stream of a philox4x32 generator.
+    * @param verbosity       Verbosity level. 0 : None, ... TBA
+    */
+    mc_generic(random_generator rng, int verbosity)
+       : RandomGenerator(std::move(rng)), AllMoves(RandomGenerator), AllMeasures(), AllMeasuresAux(), report(&std::cout, verbosity) {}
+
+    /**
    * Register a move
    *
    * If the move m is an rvalue, it is moved into the mc_generic, otherwise is copied into it.
@@ -70,10 +87,16 @@ namespace triqs::mc_tools {
    * @param proposition_probability  Probability that the move will be proposed. Precondition : >0
    *                                 NB it but does not need to be normalized.
    *                                 Normalization is automatically done with all the added moves before starting the run.
+   *
+   * @param enable_statistics        Record the time spent in attempt/accept/reject and the histogram of the Metropolis ratios
+   *                                 of this move, reported in the statistics of the moves (cf move_statistics).
+   *
+   * With a static_move_set, MoveType must be one of its Moves, and all of them must be added before the run.
    */
-    template <typename MoveType> void add_move(MoveType &&m, std::string name, double proposition_probability = 1.0) {
+    template <typename MoveType>
+    void add_move(MoveType &&m, std::string name, double proposition_probability = 1.0, bool enable_statistics = false) {
       static_assert(!std::is_pointer<MoveType>::value, "add_move in mc_generic takes ONLY values !");
-      AllMoves.add(std::forward<MoveType>(m), name, proposition_probability);
+      AllMoves.add(std::forward<MoveType>(m), name, proposition_probability, enable_statistics);
     }
 
     /**
@@ -110,6 +133,47 @@ namespace triqs::mc_tools {
    */
     void set_after_cycle_duty(std::function<void()> f) { after_cycle_duty = f; }
 
+    /**
+   * Fast run mode.
+   *
+   * The random numbers for the choice of the moves and for the Metropolis tests are drawn in advance,
+   * by chunks of n steps, and the signals are checked once per chunk instead of at every step.
+   * If the moves draw random numbers, it changes the order in which the random numbers are used,
+   * hence the chain itself, but not its statistics.
+   *
+   * @param n  Number of steps in a chunk. 0 (default) : the standard loop.
+   */
+    void set_step_chunk_size(uint64_t n) {
+      step_chunk_size = n;
+      chunk_moves.resize(n);
+      chunk_uniforms.resize(n);
+    }
+
+    /// Number of steps in a chunk in the fast run mode (0 if not used)
+    uint64_t get_step_chunk_size() const { return step_chunk_size; }
+
+    /**
+   * Tuning of the proposition probabilities of the moves during the warmup.
+   *
+   * During the warmup, the probabilities of the moves are updated 10 times to maximize the number of accepted moves
+   * per second (cf proposal_tuner). They are then frozen for the rest of the run.
+   *
+   * The moves whose Metropolis ratio depends on the proposition probability of another move (typically a move and its inverse,
+   * e.g. an insertion and a removal) must be declared in the same group : the moves of a group keep their relative probabilities,
+   * otherwise detailed balance is broken. A move in no group is tuned alone.
+   *
+   * @param max_factor  Maximal factor between the tuned and the initial probability of a move. 0 (default) : no tuning.
+   * @param groups      The groups of moves tuned together, by their names
+   */
+    void set_proposal_tuning(double max_factor, std::vector<std::vector<std::string>> groups = {}) {
+      if (max_factor != 0 and max_factor < 1) TRIQS_RUNTIME_ERROR << "set_proposal_tuning : the max_factor must be >= 1, or 0";
+      proposal_tuning_max_factor = max_factor;
+      proposal_tuning_groups     = std::move(groups);
+    }
+
+    /// The normalized proposition probabilities of the moves (after the tuning if any)
+    std::vector<double> get_proposition_probabilities() const { return AllMoves.get_proposition_probabilities(); }
+
     int warmup(uint64_t n_warmup_cycles, int64_t length_cycle, std::function<bool()> stop_callback) {
       report << "\nWarming up ..." << std::endl;
       return run(n_warmup_cycles, length_cycle, stop_callback, false);
@@ -198,28 +262,36 @@ namespace triqs::mc_tools {
       utility::timer timer;
       timer.start();
       if (n_cycles == 0) return 0;
-      triqs::signal_handler::start();
+      if (manage_signal_handler) triqs::signal_handler::start();
       done_percent = 0;
       nmeasures    = 0;
       bool stop_it = false, finished = false;
       int NC                = 0;
       double next_info_time = 0.1;
+      bool tuning           = (!do_measure and proposal_tuning_max_factor > 0);
+      uint64_t tuning_every = std::max<uint64_t>(1, n_cycles / 10);
+      if (tuning) AllMoves.start_tuning(proposal_tuning_max_factor, proposal_tuning_groups);
       for (; !stop_it; ++NC) { // do NOT reinit NC to 0
-        // Metropolis loop. Switch here for HeatBath, etc...
-        for (uint64_t k = 1; (k <= length_cycle); k++) {
-          if (triqs::signal_handler::received()) goto _final;
-          double r = AllMoves.attempt();
-          if (RandomGenerator() < std::min(1.0, r)) {
-            if (debug) std::cerr << " Move accepted " << std::endl;
-            sign *= AllMoves.accept();
-            if (debug) std::cerr << " New sign = " << sign << std::endl;
-          } else {
-            if (debug) std::cerr << " Move rejected " << std::endl;
-            AllMoves.reject();
+        if (step_chunk_size > 0) {
+          if (!run_cycle_by_chunks(length_cycle)) goto _final;
+        } else {
+          // Metropolis loop. Switch here for HeatBath, etc...
+          for (uint64_t k = 1; (k <= length_cycle); k++) {
+            if (triqs::signal_handler::received()) goto _final;
+            double r = AllMoves.attempt();
+            if (RandomGenerator() < std::min(1.0, r)) {
+              if (debug) std::cerr << " Move accepted " << std::endl;
+              sign *= AllMoves.accept();
+              if (debug) std::cerr << " New sign = " << sign << std::endl;
+            } else {
+              if (debug) std::cerr << " Move rejected " << std::endl;
+              AllMoves.reject();
+            }
+            ++config_id;
           }
-          ++config_id;
         }
         if (after_cycle_duty) { after_cycle_duty(); }
+        if (tuning and (NC + 1) % tuning_every == 0) AllMoves.update_tuning();
         if (do_measure) {
           nmeasures++;
           for (auto &x : AllMeasuresAux) x();
@@ -238,7 +310,13 @@ namespace triqs::mc_tools {
         stop_it  = (stop_callback() || triqs::signal_handler::received() || finished);
       }
       int status = (finished ? 0 : (triqs::signal_handler::received() ? 2 : 1));
-      triqs::signal_handler::stop();
+      if (tuning) {
+        AllMoves.stop_tuning();
+        report(3) << "Tuned proposition probabilities :";
+        for (auto p : AllMoves.get_proposition_probabilities()) report(3) << " " << p;
+        report(3) << "\n";
+      }
+      if (manage_signal_handler) triqs::signal_handler::stop();
       current_cycle_number += NC;
       timer.stop();
       if (do_measure) {
@@ -255,6 +333,27 @@ namespace triqs::mc_tools {
       return status;
     }
 
+    // One cycle of the fast run mode. Returns false if a signal was received.
+    bool run_cycle_by_chunks(uint64_t length_cycle) {
+      for (uint64_t k = 0; k < length_cycle; k += step_chunk_size) {
+        if (triqs::signal_handler::received()) return false;
+        uint64_t n = std::min(step_chunk_size, length_cycle - k);
+        for (uint64_t i = 0; i < n; ++i) {
+          chunk_moves[i]    = AllMoves.select(RandomGenerator());
+          chunk_uniforms[i] = RandomGenerator();
+        }
+        for (uint64_t i = 0; i < n; ++i) {
+          double r = AllMoves.attempt_move(chunk_moves[i]);
+          if (chunk_uniforms[i] < std::min(1.0, r))
+            sign *= AllMoves.accept();
+          else
+            AllMoves.reject();
+        }
+        config_id += n;
+      }
+      return true;
+    }
+
     public:
     /// Reduce the results of the measures, and reports some statistics
     void collect_results(mpi::communicator const &c) {
@@ -272,6 +371,22 @@ namespace triqs::mc_tools {
       if (c.rank() == 0) report(2) << "Total number of measures: " << nmeasures_tot << std::endl;
     }
 
+    /**
+   * Merge the measures and the move statistics of another walker into this one.
+   *
+   * Both objects must have the same moves and measures (same names, same types).
+   * Every measure must provide a method void merge(MeasureType const &), adding the data accumulated
+   * by the other walker. Call it before collect_results, which then reduces the merged data over MPI.
+   * The counters of the chain (cycle number, configuration id) are not merged : this walker can be run again.
+   *
+   * @param mc The other walker. It is left unchanged.
+   */
+    void merge(mc_generic const &mc) {
+      AllMeasures.merge(mc.AllMeasures);
+      AllMoves.merge_statistics(mc.AllMoves);
+      nmeasures += mc.nmeasures;
+    }
+
     /**
    * The acceptance rates of all move
    *
@@ -329,10 +444,11 @@ namespace triqs::mc_tools {
    */
     auto get_accumulation_time_HHMMSS() const { return hours_minutes_seconds_from_seconds(timer_accumulation); }
 
-    /// HDF5 interface
+    /// HDF5 interface. The detailed statistics of the moves, if any, are written in the subgroup move_statistics.
     friend void h5_write(h5::group g, std::string const &name, mc_generic const &mc) {
       auto gr = g.create_group(name);
       h5_write(gr, "moves", mc.AllMoves);
+      mc.AllMoves.write_statistics(gr, "move_statistics");
       h5_write(gr, "measures", mc.AllMeasures);
       h5_write(gr, "number_cycle_done", mc.current_cycle_number);
       h5_write(gr, "number_measure_done", mc.nmeasures);
@@ -350,16 +466,26 @@ namespace triqs::mc_tools {
     }
 
     private:
+    friend class mc_multi_walker<MCSignType, MoveSetType>;
     random_generator RandomGenerator;
-    move_set<MCSignType> AllMoves;
+    MoveSetType AllMoves;
     measure_set<MCSignType> AllMeasures;
     std::vector<measure_aux> AllMeasuresAux;
     utility::report_stream report;
-    uint64_t nmeasures, current_cycle_number = 0;
+    uint64_t nmeasures = 0, current_cycle_number = 0;
     utility::timer timer_accumulation, timer_warmup;
     std::function<void()> after_cycle_duty;
     MCSignType sign       = 1;
     uint64_t done_percent = 0;
     uint64_t config_id    = 0;
+
+    bool manage_signal_handler = true; // false when run as one walker of a mc_multi_walker
+
+    double proposal_tuning_max_factor = 0;
+    std::vector<std::vector<std::string>> proposal_tuning_groups;
+
+    uint64_t step_chunk_size = 0; // fast run mode
+    std::vector<size_t> chunk_moves;
+    std::vector<double> chunk_uniforms;
   };
 } // namespace triqs::mc_tools
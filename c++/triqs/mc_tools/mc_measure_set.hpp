@@ -24,6 +24,7 @@
 #include <triqs/utility/timer.hpp>
 #include <functional>
 #include <map>
+#include <typeinfo>
 #include <cassert>
 #include "./impl_tools.hpp"
 
@@ -36,7 +37,9 @@ namespace triqs {
       std::shared_ptr<void> impl_;
       std::function<void(MCSignType const &)> accumulate_;
       std::function<void(mpi::communicator const &)> collect_results_;
+      std::function<void(void const *)> merge_;
       std::function<void(h5::group, std::string const &)> h5_r, h5_w;
+      std::type_info const *type_;
 
       uint64_t count_;
       bool enable_timer;
@@ -53,6 +56,8 @@ namespace triqs {
         accumulate_      = [p](MCSignType const &x) { p->accumulate(x); };
         count_           = 0;
         collect_results_ = [p](mpi::communicator const &c) { p->collect_results(c); };
+        merge_           = make_merge(p); // cf impl_tools
+        type_            = &typeid(m_t);
         h5_r             = make_h5_read(p);
         h5_w             = make_h5_write(p);
       }
@@ -76,6 +81,14 @@ namespace triqs {
         if(enable_timer) Timer.stop();
       }
 
+      // Add the accumulated data of m (the same measure of another walker) into this one.
+      void merge(measure const &m) {
+        if (!merge_) TRIQS_RUNTIME_ERROR << "measure : merge : the measure " << type_->name() << " has no merge method";
+        if (*type_ != *m.type_) TRIQS_RUNTIME_ERROR << "measure : merge : type mismatch " << type_->name() << " vs " << m.type_->name();
+        merge_(m.impl_.get());
+        count_ += m.count_;
+      }
+
       uint64_t count() const { return count_; }
       double duration() const { return double(Timer); }
 
@@ -153,6 +166,16 @@ namespace triqs {
         return s.str();
       }
 
+      /// Merge the measures of another walker, matched by name, into this set
+      void merge(measure_set const &ms) {
+        if (ms.m_map.size() != m_map.size()) TRIQS_RUNTIME_ERROR << "measure_set : merge : the two sets have a different number of measures";
+        for (auto &nmp : ms.m_map) {
+          auto it = m_map.find(nmp.first);
+          if (it == m_map.end()) TRIQS_RUNTIME_ERROR << "measure_set : merge : no measure named '" << nmp.first << "'";
+          it->second.merge(nmp.second);
+        }
+      }
+
       // gather result for all measure, on communicator c
       void collect_results(mpi::communicator const &c) {
         for (auto &nmp : m_map) nmp.second.collect_results(c);
@@ -22,8 +22,11 @@
 #include <triqs/utility/exceptions.hpp>
 #include <mpi/mpi.hpp>
 #include <functional>
+#include <memory>
 #include "./random_generator.hpp"
 #include "./impl_tools.hpp"
+#include "./mc_move_statistics.hpp"
+#include "./mc_proposal_tuner.hpp"
 
 namespace triqs {
   namespace mc_tools {
@@ -47,6 +50,7 @@ namespace triqs {
 
       uint64_t NProposed, Naccepted;
       double acceptance_rate_;
+      std::unique_ptr<move_statistics> stats_; // null if not enabled
       bool is_move_set_; // need to remember if the move was a move_set for printing details later.
 
 #ifdef TRIQS_MCTOOLS_DEBUG
@@ -57,7 +61,7 @@ namespace triqs {
 
       public:
       /// Construct from any m modeling MoveType. bool is here to disambiguate with basic copy/move construction.
-      template <typename MoveType> move(bool, MoveType &&m) {
+      template <typename MoveType> move(bool, MoveType &&m, bool enable_statistics = false) {
         static_assert(std::is_move_constructible<MoveType>::value, "This move is not MoveConstructible");
         static_assert(has_attempt<MCSignType, MoveType>::value, "This move has no attempt method (or is has an incorrect signature) !");
         static_assert(has_accept<MCSignType, MoveType>::value, "This move has no accept method (or is has an incorrect signature) !");
@@ -75,6 +79,7 @@ namespace triqs {
         Naccepted           = 0;
         acceptance_rate_    = -1;
         is_move_set_        = std::is_same<MoveType, move_set<MCSignType>>::value;
+        if (enable_statistics) stats_ = std::make_unique<move_statistics>();
       }
 
       // no default constructor.
@@ -85,13 +90,29 @@ namespace triqs {
 
       MCSignType attempt() {
         NProposed++;
-        return attempt_();
+        if (!stats_) return attempt_();
+        auto t0      = move_statistics::now();
+        MCSignType r = attempt_();
+        stats_->add_attempt(t0, std::abs(r));
+        return r;
       }
       MCSignType accept() {
         Naccepted++;
-        return accept_();
+        if (!stats_) return accept_();
+        auto t0      = move_statistics::now();
+        MCSignType r = accept_();
+        stats_->add_accept(t0);
+        return r;
+      }
+      void reject() {
+        if (!stats_) return reject_();
+        auto t0 = move_statistics::now();
+        reject_();
+        stats_->add_reject(t0);
       }
-      void reject() { reject_(); }
+
+      /// The detailed statistics, or nullptr if they are not enabled
+      move_statistics const *statistics() const { return stats_.get(); }
 
       double acceptance_rate() const { return acceptance_rate_; }
       uint64_t n_proposed_config() const { return NProposed; }
@@ -101,9 +122,19 @@ namespace triqs {
         uint64_t nacc_tot  = mpi::all_reduce(Naccepted, c);
         uint64_t nprop_tot = mpi::all_reduce(NProposed, c);
         acceptance_rate_   = nacc_tot / static_cast<double>(nprop_tot);
+        if (stats_) stats_->collect_results(c);
         if (collect_statistics_) collect_statistics_(c);
       }
 
+      // Add the counters of m (the same move of another walker) to this one.
+      void merge_statistics(move const &m) {
+        NProposed += m.NProposed;
+        Naccepted += m.Naccepted;
+        if (stats_ && m.stats_) stats_->merge(*m.stats_);
+        auto ms = as_move_set(), ms_m = m.as_move_set();
+        if (ms && ms_m) ms->merge_statistics(*ms_m);
+      }
+
       move_set<MCSignType> *as_move_set() const { return is_move_set_ ? static_cast<move_set<MCSignType> *>(impl_.get()) : nullptr; }
 
       // redirect the h5 call to the object lambda, if it not empty (i.e. if the underlying object can be called with h5_read/write
@@ -127,6 +158,7 @@ namespace triqs {
       std::vector<double> Proba_Moves, Proba_Moves_Acc_Sum;
       MCSignType try_sign_ratio;
       uint64_t debug_counter;
+      std::unique_ptr<proposal_tuner> tuner; // only during the tuning of Proba_Moves
 
 #ifdef TRIQS_MCTOOLS_DEBUG
       static constexpr bool debug = true;
@@ -151,9 +183,10 @@ namespace triqs {
    * NB : the proposition_probability needs to be >0 but does not need to be
    * normalized. Normalization is automatically done with all the added moves
    * before starting the run
+   * If enable_statistics, the time spent in the move and its Metropolis ratios are recorded (cf move_statistics).
    */
-      template <typename MoveType> void add(MoveType &&M, std::string name, double proposition_probability) {
-        move_vec.emplace_back(true, std::forward<MoveType>(M));
+      template <typename MoveType> void add(MoveType &&M, std::string name, double proposition_probability, bool enable_statistics = false) {
+        move_vec.emplace_back(true, std::forward<MoveType>(M), enable_statistics);
         assert(proposition_probability >= 0);
         Proba_Moves.push_back(proposition_probability);
         names_.push_back(name);
@@ -179,23 +212,29 @@ namespace triqs {
    *  - Returns the metropolis ratio R (see move concept).
    *    The sign ratio returned by the try method of the move is kept.
    */
-      double attempt() {
+      double attempt() { return attempt_move(select((*RNG)())); }
+
+      /// The number of the move chosen for proba, a random number uniform in [0,1[
+      size_t select(double proba) const {
+        assert(proba >= 0);
+        size_t n = 0;
+        while (proba >= Proba_Moves_Acc_Sum[n]) { n++; }
+        assert(n > 0);
+        assert(n <= move_vec.size());
+        return n - 1;
+      }
+
+      /// As attempt, for the move number n (cf select)
+      double attempt_move(size_t n) {
         assert(Proba_Moves_Acc_Sum.size() > 0);
         if (move_vec.size() == 0) TRIQS_RUNTIME_ERROR << "ERROR in attempting Monte-Carlo Move: No move was registered!";
-        // Choice of move with its probability
-        double proba = (*RNG)();
-        assert(proba >= 0);
-        current_move_number = 0;
-        while (proba >= Proba_Moves_Acc_Sum[current_move_number]) { current_move_number++; }
-        assert(current_move_number > 0);
-        assert(current_move_number <= move_vec.size());
-        current_move_number--;
-        current = &move_vec[current_move_number];
+        current_move_number = n;
+        current             = &move_vec[current_move_number];
+        if (tuner) tuner->start(n);
         if (debug) {
           std::cerr << "*******************************************************" << std::endl;
           std::cerr << "move number : " << debug_counter++ << std::endl;
           std::cerr << "Name of the proposed move: " << name_of_currently_selected() << std::endl;
-          std::cerr << "  Proposition probability = " << proba << std::endl;
         }
         MCSignType rate_ratio = current->attempt();
         double abs_rate_ratio;
@@ -226,6 +265,7 @@ namespace triqs {
           std::cerr << "   accept_sign_ratio = " << accept_sign_ratio << std::endl;
           std::cerr << "   their product  =  " << try_sign_ratio * accept_sign_ratio << std::endl;
         }
+        if (tuner) tuner->end(true);
         return try_sign_ratio * accept_sign_ratio;
       }
 
@@ -234,6 +274,35 @@ namespace triqs {
       void reject() {
         if (debug) std::cerr << " ... Move rejected" << std::endl;
         current->reject();
+        if (tuner) tuner->end(false);
+      }
+
+      /// Start to measure the efficiency of the moves, to tune their proposition probabilities (cf proposal_tuner)
+      void start_tuning(double max_factor, std::vector<std::vector<std::string>> const &groups = {}) {
+        tuner = std::make_unique<proposal_tuner>(std::vector<double>(Proba_Moves.begin() + 1, Proba_Moves.end()), max_factor, names_, groups);
+      }
+
+      /// Set the proposition probabilities to the tuned ones
+      void update_tuning() {
+        if (!tuner) return;
+        auto p = tuner->probabilities();
+        for (size_t u = 0; u < p.size(); ++u) Proba_Moves[u + 1] = p[u];
+        normaliseProba();
+      }
+
+      /// Last update of the proposition probabilities, which are then fixed.
+      void stop_tuning() {
+        update_tuning();
+        tuner.reset();
+      }
+
+      /// The normalized proposition probabilities of the moves, in the order of add
+      std::vector<double> get_proposition_probabilities() const {
+        double acc = 0;
+        for (auto p : Proba_Moves) acc += p;
+        std::vector<double> r(Proba_Moves.begin() + 1, Proba_Moves.end());
+        for (auto &x : r) x /= acc;
+        return r;
       }
 
       ///
@@ -241,6 +310,15 @@ namespace triqs {
         for (auto &m : move_vec) m.collect_statistics(c);
       }
 
+      /// Add the proposed/accepted counters of the moves of another walker (same moves, same order)
+      void merge_statistics(move_set const &ms) {
+        if (ms.move_vec.size() != move_vec.size()) TRIQS_RUNTIME_ERROR << "move_set : merge_statistics : the two sets have a different number of moves";
+        for (size_t u = 0; u < move_vec.size(); ++u) move_vec[u].merge_statistics(ms.move_vec[u]);
+      }
+
+      /// The detailed statistics of the move number u (in the order of add), or nullptr if they are not enabled
+      move_statistics const *statistics(size_t u) const { return move_vec.at(u).statistics(); }
+
       /// Acceptance rate of all moves as a map name:string -> acceptance_rate:double
       std::map<std::string, double> get_acceptance_rates() const {
         std::map<std::string, double> r;
@@ -261,6 +339,7 @@ namespace triqs {
         for (unsigned int u = 0; u < move_vec.size(); ++u) {
           auto ms = move_vec[u].as_move_set();
           s << decal << "Move " << (ms ? "set " : " ") << names_[u] << ": " << move_vec[u].acceptance_rate() << "\n";
+          if (auto st = move_vec[u].statistics()) s << st->print(decal);
           if (ms) s << ms->get_statistics(decal + "  ");
         }
         return s.str();
@@ -290,6 +369,20 @@ namespace triqs {
         for (size_t u = 0; u < ms.move_vec.size(); ++u) h5_write(gr, ms.names_[u], ms.move_vec[u]);
       }
 
+      /**
+       * Write the detailed statistics of the moves, if any, in the subgroup name of g, one subgroup per move.
+       * They are apart from the group of the moves (cf h5_write), whose subgroups are named by the user.
+       * The statistics of the moves of a nested move set are not written.
+       */
+      void write_statistics(h5::group g, std::string const &name) const {
+        bool has_stats = false;
+        for (auto const &m : move_vec) has_stats |= (m.statistics() != nullptr);
+        if (!has_stats) return;
+        auto gs = g.create_group(name);
+        for (size_t u = 0; u < move_vec.size(); ++u)
+          if (auto st = move_vec[u].statistics()) h5_write(gs, names_[u], *st);
+      }
+
       friend void h5_read(h5::group g, std::string const &name, move_set &ms) {
         auto gr = g.open_group(name);
         for (size_t u = 0; u < ms.move_vec.size(); ++u) h5_read(gr, ms.names_[u], ms.move_vec[u]);
@@ -0,0 +1,106 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#pragma once
+#include <triqs/utility/first_include.hpp>
+#include <h5/h5.hpp>
+#include <mpi/mpi.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace triqs::mc_tools {
+
+  /**
+   * Detailed statistics of a move, enabled on demand (cf add_move) :
+   *   - the wall time spent in attempt, accept and reject,
+   *   - the histogram of log10 |R|, for the Metropolis ratios R returned by attempt,
+   *     with n_bins bins in [log10_min, log10_max]. The ratios outside are counted in the first/last bin, and R = 0 in the first one.
+   *
+   * The data are local to the process until collect_results, which reduces them over the communicator.
+   */
+  class move_statistics {
+    public:
+    using clock_t                     = std::chrono::steady_clock;
+    static constexpr int n_bins       = 20;
+    static constexpr double log10_min = -10, log10_max = 10;
+
+    private:
+    std::array<double, 3> time = {}, time_tot = {}; // attempt, accept, reject
+    std::array<uint64_t, n_bins> histo = {}, histo_tot = {};
+
+    static double seconds_since(clock_t::time_point t0) { return std::chrono::duration<double>(clock_t::now() - t0).count(); }
+
+    public:
+    static clock_t::time_point now() { return clock_t::now(); }
+
+    void add_attempt(clock_t::time_point t0, double abs_ratio) {
+      time[0] += seconds_since(t0);
+      double l = (abs_ratio > 0 ? std::log10(abs_ratio) : log10_min);
+      int b    = 0;
+      if (!(l < log10_max)) // also inf and nan
+        b = n_bins - 1;
+      else if (l > log10_min)
+        b = std::min(int((l - log10_min) * n_bins / (log10_max - log10_min)), n_bins - 1);
+      ++histo[b];
+    }
+    void add_accept(clock_t::time_point t0) { time[1] += seconds_since(t0); }
+    void add_reject(clock_t::time_point t0) { time[2] += seconds_since(t0); }
+
+    /// Add the data of the same move in another walker
+    void merge(move_statistics const &s) {
+      for (int i = 0; i < 3; ++i) time[i] += s.time[i];
+      for (int b = 0; b < n_bins; ++b) histo[b] += s.histo[b];
+    }
+
+    /// Reduce the data over c
+    void collect_results(mpi::communicator const &c) {
+      for (int i = 0; i < 3; ++i) time_tot[i] = mpi::all_reduce(time[i], c);
+      for (int b = 0; b < n_bins; ++b) histo_tot[b] = mpi::all_reduce(histo[b], c);
+    }
+
+    /// Time spent in attempt, accept, reject [after collect_results]
+    std::array<double, 3> const &get_times() const { return time_tot; }
+
+    /// Histogram of log10 |R| [after collect_results]
+    std::array<uint64_t, n_bins> const &get_histogram() const { return histo_tot; }
+
+    /// Pretty printing
+    std::string print(std::string const &decal) const {
+      std::ostringstream s;
+      s << decal << "  time attempt/accept/reject (s) : " << time_tot[0] << " / " << time_tot[1] << " / " << time_tot[2] << "\n";
+      s << decal << "  histogram of log10|R| in [" << log10_min << ", " << log10_max << "] :";
+      for (auto h : histo_tot) s << " " << h;
+      s << "\n";
+      return s.str();
+    }
+
+    friend void h5_write(h5::group g, std::string const &name, move_statistics const &s) {
+      auto gr = g.create_group(name);
+      h5_write(gr, "time_attempt", s.time_tot[0]);
+      h5_write(gr, "time_accept", s.time_tot[1]);
+      h5_write(gr, "time_reject", s.time_tot[2]);
+      h5_write(gr, "histogram_log10_ratio", std::vector<long>(s.histo_tot.begin(), s.histo_tot.end()));
+      h5_write(gr, "histogram_log10_ratio_bounds", std::vector<double>{log10_min, log10_max});
+    }
+  };
+
+} // namespace triqs::mc_tools
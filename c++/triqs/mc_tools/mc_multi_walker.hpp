@@ -0,0 +1,191 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "./mc_generic.hpp"
+
+namespace triqs::mc_tools {
+
+  /**
+  * \brief Several independent Monte Carlo chains (walkers) run in one process on a pool of threads.
+  *
+  * Each walker is a full mc_generic, with its own moves, measures and random generator.
+  * With the counter-based generator philox4x32, the walker w uses the stream w of random_seed : the walkers
+  * never share random numbers. For other generators, the walker w is seeded with random_seed + w, so the usual
+  * convention random_seed = seed0 + K * rank gives distinct seeds on all ranks as long as K > n_walkers.
+  *
+  * Usage : build the object, then for each walker w, build a configuration and register moves and measures
+  * on walker(w), exactly as for a single mc_generic. Then run, and call collect_results, which merges all walkers
+  * into walker(0) (cf mc_generic::merge) and reduces over MPI. The final results are in the measures of walker(0).
+  *
+  * The walkers are advanced concurrently : the moves and measures of different walkers must not share
+  * any mutable state.
+  *
+  * With fewer threads than walkers, each thread runs a walker to the end before taking the next one.
+  * When a run is stopped (stop_callback or signal), the walkers which have not started yet are skipped :
+  * they stay idle in all the following runs (so that a walker never accumulates without its warmup),
+  * and collect_results does not merge them.
+  */
+  template <typename MCSignType, typename MoveSetType = move_set<MCSignType>> class mc_multi_walker {
+
+    using mc_t = mc_generic<MCSignType, MoveSetType>;
+    std::vector<std::unique_ptr<mc_t>> walkers; // unique_ptr : the move_set keeps a pointer to the rng
+    std::vector<int> idle; // idle[w] : the walker w was skipped by a stopped run. It is not run anymore, nor merged.
+    int n_threads;
+    utility::report_stream report;
+
+    public:
+    /**
+    * Constructor
+    *
+    * @param n_walkers       Number of independent walkers. Precondition : > 0
+    * @param random_name     Name of the random generator (cf doc).
+    * @param random_seed     Seed for the random generator. Walker w uses its stream w, or random_seed + w (cf above).
+    * @param verbosity       Verbosity level. Only walker 0 reports its progress.
+    * @param n_threads       Number of threads used to advance the walkers. 0 means one thread per walker.
+    *                        With fewer threads than walkers, the walkers are run by batches (cf above).
+    */
+    mc_multi_walker(int n_walkers, std::string random_name, int random_seed, int verbosity, int n_threads = 0)
+       : idle(n_walkers, 0), n_threads(n_threads), report(&std::cout, verbosity) {
+      if (n_walkers <= 0) TRIQS_RUNTIME_ERROR << "mc_multi_walker : the number of walkers must be > 0";
+      if (n_threads < 0) TRIQS_RUNTIME_ERROR << "mc_multi_walker : the number of threads must be >= 0";
+      random_generator rng0(random_name, random_seed);
+      bool has_streams = rng0.is_splittable();
+      for (int w = 0; w < n_walkers; ++w) {
+        auto rng = (w == 0 ? std::move(rng0) :
+                             (has_streams ? random_generator(random_name, random_seed, w) : random_generator(random_name, random_seed + w)));
+        walkers.push_back(std::make_unique<mc_t>(std::move(rng), (w == 0 ? verbosity : 0)));
+        walkers.back()->manage_signal_handler = false;
+      }
+    }
+
+    mc_multi_walker(mc_multi_walker const &) = delete;
+    mc_multi_walker &operator=(mc_multi_walker const &) = delete;
+
+    /// Number of walkers
+    int n_walkers() const { return walkers.size(); }
+
+    /// Access to the walker w, e.g. to add moves and measures
+    mc_t &walker(int w) { return *walkers.at(w); }
+    mc_t const &walker(int w) const { return *walkers.at(w); }
+
+    /// Was the walker w skipped by a stopped run ? (cf above)
+    bool is_idle(int w) const { return idle.at(w); }
+
+    /**
+     * Warmup all walkers
+     *
+     * @param n_warmup_cycles         Number of QMC cycles in the warmup, for each walker
+     * @param length_cycle            Number of QMC move attempts in one cycle
+     * @param stop_callback           A callback function () -> bool. It is called after each cycle of every walker
+     *                                (never concurrently) and all walkers stop when it returns true.
+     *
+     * @return As mc_generic::warmup. The largest status of all walkers.
+     */
+    int warmup(uint64_t n_warmup_cycles, int64_t length_cycle, std::function<bool()> stop_callback) {
+      report << "\nWarming up " << walkers.size() << " walkers ..." << std::endl;
+      return run(n_warmup_cycles, length_cycle, stop_callback, false);
+    }
+
+    /**
+     * Accumulate/Measure with all walkers
+     *
+     * @param n_accumulation_cycles   Number of QMC cycles in the accumulation, for each walker
+     * @param length_cycle            Number of QMC move attempts in one cycle
+     * @param stop_callback           As in warmup
+     *
+     * @return As mc_generic::accumulate. The largest status of all walkers.
+     */
+    int accumulate(uint64_t n_accumulation_cycles, int64_t length_cycle, std::function<bool()> stop_callback) {
+      report << "\nAccumulating with " << walkers.size() << " walkers ..." << std::endl;
+      return run(n_accumulation_cycles, length_cycle, stop_callback, true);
+    }
+
+    /// Warmup and accumulate. cf warmup and accumulate
+    int warmup_and_accumulate(uint64_t n_warmup_cycles, uint64_t n_accumulation_cycles, uint64_t length_cycle, std::function<bool()> stop_callback) {
+      int status = warmup(n_warmup_cycles, length_cycle, stop_callback);
+      if (status == 0) status = accumulate(n_accumulation_cycles, length_cycle, stop_callback);
+      return status;
+    }
+
+    /// Merge all the walkers which are not idle into walker 0, then reduce the results of its measures over c.
+    void collect_results(mpi::communicator const &c) {
+      int n_idle = std::count(idle.begin(), idle.end(), 1);
+      if (n_idle > 0) report << "mc_multi_walker : " << n_idle << " walkers were skipped by a stopped run and are not merged" << std::endl;
+      for (size_t w = 1; w < walkers.size(); ++w)
+        if (!idle[w]) walkers[0]->merge(*walkers[w]);
+      walkers[0]->collect_results(c);
+    }
+
+    private:
+    int run(uint64_t n_cycles, uint64_t length_cycle, std::function<bool()> stop_callback, bool do_measure) {
+
+      int n_walk = walkers.size();
+      int n_th   = std::min(n_walk, (n_threads == 0 ? n_walk : n_threads));
+
+      // The walkers call the callback after each of their cycles : serialize the calls,
+      // and stop everyone as soon as it has returned true once.
+      std::mutex callback_mutex;
+      std::atomic<bool> stop_all{false};
+      auto shared_callback = [&]() {
+        if (stop_all) return true;
+        std::lock_guard<std::mutex> lock{callback_mutex};
+        if (stop_callback()) stop_all = true;
+        return bool(stop_all);
+      };
+
+      std::vector<int> status(n_walk, 0);
+      std::vector<std::exception_ptr> errors(n_walk);
+      std::atomic<int> next_walker{0};
+
+      // Each thread takes the next walker not yet run and runs it to the end.
+      // Once the run is stopped, the walkers not yet started are skipped, and become idle.
+      auto worker = [&]() {
+        for (int w = next_walker++; w < n_walk; w = next_walker++) {
+          if (stop_all or idle[w]) {
+            idle[w] = 1;
+            continue;
+          }
+          try {
+            status[w] = walkers[w]->run(n_cycles, length_cycle, shared_callback, do_measure);
+          } catch (...) {
+            errors[w] = std::current_exception();
+            stop_all  = true;
+          }
+        }
+      };
+
+      triqs::signal_handler::start();
+      std::vector<std::thread> pool;
+      for (int t = 1; t < n_th; ++t) pool.emplace_back(worker);
+      worker(); // the calling thread is part of the pool
+      for (auto &th : pool) th.join();
+      triqs::signal_handler::stop();
+
+      for (auto &e : errors)
+        if (e) std::rethrow_exception(e);
+      return *std::max_element(status.begin(), status.end());
+    }
+  };
+} // namespace triqs::mc_tools
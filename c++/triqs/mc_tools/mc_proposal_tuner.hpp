@@ -0,0 +1,119 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#pragma once
+#include <triqs/utility/exceptions.hpp>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace triqs::mc_tools {
+
+  /**
+   * Tuning of the proposition probabilities of the moves of a move set, during the warmup.
+   *
+   * For each move u, it measures the cost (wall time from attempt to the end of accept/reject)
+   * and the number of accepted moves. The moves are tuned by groups : the efficiency of a group is its
+   * number of accepted moves per second, and the probabilities of all the moves of the group are multiplied
+   * by the ratio of its efficiency to the efficiency of the whole set, this factor being clipped to
+   * [1/max_factor, max_factor], so that no move is ever switched off (ergodicity).
+   *
+   * The Metropolis ratio of a move often depends on the proposition probability of its inverse move,
+   * e.g. an insertion and a removal assume that they are proposed with the same probability.
+   * Such moves must be in the same group, which keeps their relative probabilities.
+   * Changing the probabilities of the groups is then a change of the weights of a mixture of kernels,
+   * each of them satisfying detailed balance on its own.
+   * A move in no group is its own group, i.e. its Metropolis ratio must not depend on the probabilities of the other moves.
+   *
+   * The move set must stop the tuning before the accumulation : the probabilities are then fixed during the accumulation.
+   */
+  class proposal_tuner {
+    using clock_t = std::chrono::steady_clock;
+
+    std::vector<double> p0, time;
+    std::vector<uint64_t> n_proposed, n_accepted;
+    std::vector<size_t> group_of; // the group of each move
+    size_t n_groups;
+    double max_factor;
+    clock_t::time_point t0;
+    size_t current = 0;
+
+    public:
+    /**
+     * @param p0_          The initial proposition probabilities (not necessarily normalized)
+     * @param max_factor_  Maximal change of a probability (factor). Precondition : >= 1
+     * @param names        The names of the moves
+     * @param groups       The groups of moves tuned together, by their names (cf above)
+     */
+    proposal_tuner(std::vector<double> p0_, double max_factor_, std::vector<std::string> const &names = {},
+                   std::vector<std::vector<std::string>> const &groups = {})
+       : p0(std::move(p0_)), time(p0.size(), 0), n_proposed(p0.size(), 0), n_accepted(p0.size(), 0), group_of(p0.size(), size_t(-1)), max_factor(max_factor_) {
+      n_groups = 0;
+      for (auto const &g : groups) {
+        for (auto const &name : g) {
+          auto it = std::find(names.begin(), names.end(), name);
+          if (it == names.end()) TRIQS_RUNTIME_ERROR << "proposal_tuner : the move " << name << " of a group is not in the move set";
+          size_t u = it - names.begin();
+          if (group_of[u] != size_t(-1)) TRIQS_RUNTIME_ERROR << "proposal_tuner : the move " << name << " is in several groups";
+          group_of[u] = n_groups;
+        }
+        if (!g.empty()) ++n_groups;
+      }
+      for (auto &g : group_of)
+        if (g == size_t(-1)) g = n_groups++;
+    }
+
+    /// The move u is attempted
+    void start(size_t u) {
+      current = u;
+      ++n_proposed[u];
+      t0 = clock_t::now();
+    }
+
+    /// The move attempted last has been accepted/rejected
+    void end(bool accepted) {
+      time[current] += std::chrono::duration<double>(clock_t::now() - t0).count();
+      if (accepted) ++n_accepted[current];
+    }
+
+    /// The tuned proposition probabilities (not normalized)
+    std::vector<double> probabilities() const {
+      std::vector<double> t(n_groups, 0), acc(n_groups, 0);
+      std::vector<uint64_t> prop(n_groups, 0);
+      double t_tot = 0, acc_tot = 0;
+      for (size_t u = 0; u < p0.size(); ++u) {
+        t[group_of[u]] += time[u];
+        acc[group_of[u]] += n_accepted[u];
+        prop[group_of[u]] += n_proposed[u];
+        t_tot += time[u];
+        acc_tot += n_accepted[u];
+      }
+      auto p = p0;
+      if (t_tot <= 0 or acc_tot <= 0) return p; // nothing measured yet
+      double eff_tot = acc_tot / t_tot;
+      for (size_t u = 0; u < p.size(); ++u) {
+        auto g = group_of[u];
+        if (prop[g] == 0 or t[g] <= 0) continue;
+        double f = (acc[g] / t[g]) / eff_tot;
+        p[u] *= std::clamp(f, 1 / max_factor, max_factor);
+      }
+      return p;
+    }
+  };
+
+} // namespace triqs::mc_tools
@@ -0,0 +1,339 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#pragma once
+#include <triqs/utility/exceptions.hpp>
+#include <mpi/mpi.hpp>
+#include <array>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <tuple>
+#include <typeinfo>
+#include <vector>
+#include "./random_generator.hpp"
+#include "./impl_tools.hpp"
+#include "./mc_move_statistics.hpp"
+#include "./mc_proposal_tuner.hpp"
+
+namespace triqs::mc_tools {
+
+  /**
+   * A set of moves whose types are known at compile time.
+   *
+   * Same interface as move_set, which it can replace in mc_generic (second template parameter).
+   * The moves are stored by value in a tuple, and called directly, without type erasure,
+   * so that the attempt/accept/reject of the moves can be inlined in the Metropolis loop.
+   * The move is chosen in O(1) with the alias method (Walker/Vose), with one random number per attempt.
+   *
+   * The moves are added with add, exactly as for move_set : a move of type M fills the first empty slot
+   * of type M in Moves... (the same type may appear several times). All slots must be filled before the run.
+   *
+   * @tparam MCSignType  Type of the sign of the weights
+   * @tparam Moves       The types of the moves. They must model the Move concept.
+   */
+  template <typename MCSignType, typename... Moves> class static_move_set {
+
+    static constexpr size_t N = sizeof...(Moves);
+    static_assert(N > 0, "static_move_set : no moves");
+    static_assert((has_attempt<MCSignType, Moves>::value && ...), "A move has no attempt method (or is has an incorrect signature) !");
+    static_assert((has_accept<MCSignType, Moves>::value && ...), "A move has no accept method (or is has an incorrect signature) !");
+    static_assert((has_reject<Moves>::value && ...), "A move has no reject method (or is has an incorrect signature) !");
+
+    std::tuple<std::optional<Moves>...> moves;
+    std::array<std::string, N> names_;
+    std::array<double, N> Proba_Moves = {};
+    std::array<double, N> alias_proba = {}; // alias table, built when all the moves are added
+    std::array<size_t, N> alias       = {};
+    std::array<uint64_t, N> NProposed = {}, Naccepted = {};
+    std::array<double, N> acceptance_rates_;
+    std::array<std::unique_ptr<move_statistics>, N> stats; // null if not enabled
+    std::unique_ptr<proposal_tuner> tuner;                  // only during the tuning of Proba_Moves
+    size_t n_added = 0, current = 0;
+    random_generator *RNG;
+    MCSignType try_sign_ratio;
+
+    public:
+    /// Need a random_generator for attempt, as move_set
+    static_move_set(random_generator &R) : RNG(&R) { acceptance_rates_.fill(-1); }
+
+    static_move_set(static_move_set const &rhs) = delete;
+    static_move_set(static_move_set &&rhs)      = default;
+    static_move_set &operator=(static_move_set const &rhs) = delete;
+    static_move_set &operator=(static_move_set &&rhs) = default;
+
+    /**
+     * Add move M with its probability of being proposed.
+     * NB : the proposition_probability needs to be >=0 but does not need to be
+     * normalized.
+     * If enable_statistics, the time spent in the move and its Metropolis ratios are recorded (cf move_statistics).
+     */
+    template <typename MoveType> void add(MoveType &&M, std::string name, double proposition_probability, bool enable_statistics = false) {
+      using m_t = std::decay_t<MoveType>;
+      static_assert((std::is_same_v<m_t, Moves> || ...), "static_move_set : the type of this move is not one of the Moves of the set");
+      if (proposition_probability < 0) TRIQS_RUNTIME_ERROR << "static_move_set : negative proposition probability for move " << name;
+      bool placed = false;
+      size_t u    = 0;
+      auto place  = [&](auto &slot) {
+        if constexpr (std::is_same_v<typename std::decay_t<decltype(slot)>::value_type, m_t>) {
+          if (!placed && !slot) {
+            slot.emplace(std::forward<MoveType>(M));
+            names_[u]      = name;
+            Proba_Moves[u] = proposition_probability;
+            if (enable_statistics) stats[u] = std::make_unique<move_statistics>();
+            placed = true;
+          }
+        }
+        ++u;
+      };
+      std::apply([&place](auto &... slot) { (place(slot), ...); }, moves);
+      if (!placed) TRIQS_RUNTIME_ERROR << "static_move_set : no free slot for the move " << name;
+      if (++n_added == N) make_alias_table();
+    }
+
+    /**
+     *  - Picks up one of the move at random (weighted by their proposition probability),
+     *  - Call attempt method of that move
+     *  - Returns the metropolis ratio R (see move concept).
+     *    The sign ratio returned by the try method of the move is kept.
+     */
+    double attempt() { return attempt_move(select((*RNG)())); }
+
+    /// The number of the move chosen for proba, a random number uniform in [0,1[
+    size_t select(double proba) const {
+      double x = proba * N;
+      size_t i = std::min(size_t(x), N - 1);
+      return (x - i < alias_proba[i] ? i : alias[i]);
+    }
+
+    /// As attempt, for the move number n (cf select)
+    double attempt_move(size_t n) {
+      if (n_added != N) TRIQS_RUNTIME_ERROR << "ERROR in attempting Monte-Carlo Move: " << N - n_added << " moves of the static_move_set were not added";
+      current = n;
+      ++NProposed[current];
+      if (tuner) tuner->start(n);
+      auto st = stats[current].get();
+      auto t0 = (st ? move_statistics::now() : move_statistics::clock_t::time_point{});
+      MCSignType rate_ratio;
+      visit_current([&rate_ratio](auto &m) { rate_ratio = m.attempt(); });
+      if (st) st->add_attempt(t0, std::abs(rate_ratio));
+      double abs_rate_ratio;
+      if (attempt_treat_infinite_ratio(rate_ratio, abs_rate_ratio)) { // in case the ratio is infinite
+        if (!std::isfinite(std::abs(rate_ratio)))
+          TRIQS_RUNTIME_ERROR << "Monte Carlo Error : the rate (" << rate_ratio << ") is not finite in move " << names_[current];
+        abs_rate_ratio = std::abs(rate_ratio);
+        try_sign_ratio = (abs_rate_ratio > 1.e-14 ? rate_ratio / abs_rate_ratio : 1); // keep the sign
+      }
+      return abs_rate_ratio;
+    }
+
+    /// Accept the move previously selected and tried. Returns the sign, cf move_set
+    MCSignType accept() {
+      ++Naccepted[current];
+      auto st = stats[current].get();
+      auto t0 = (st ? move_statistics::now() : move_statistics::clock_t::time_point{});
+      MCSignType accept_sign_ratio;
+      visit_current([&accept_sign_ratio](auto &m) { accept_sign_ratio = m.accept(); });
+      if (st) st->add_accept(t0);
+      if (tuner) tuner->end(true);
+      return try_sign_ratio * accept_sign_ratio;
+    }
+
+    /// Reject the move previously selected and tried
+    void reject() {
+      auto st = stats[current].get();
+      auto t0 = (st ? move_statistics::now() : move_statistics::clock_t::time_point{});
+      visit_current([](auto &m) { m.reject(); });
+      if (st) st->add_reject(t0);
+      if (tuner) tuner->end(false);
+    }
+
+    /// Start to measure the efficiency of the moves, to tune their proposition probabilities (cf proposal_tuner)
+    void start_tuning(double max_factor, std::vector<std::vector<std::string>> const &groups = {}) {
+      tuner = std::make_unique<proposal_tuner>(std::vector<double>(Proba_Moves.begin(), Proba_Moves.end()), max_factor,
+                                               std::vector<std::string>(names_.begin(), names_.end()), groups);
+    }
+
+    /// Set the proposition probabilities to the tuned ones
+    void update_tuning() {
+      if (!tuner) return;
+      auto p = tuner->probabilities();
+      std::copy(p.begin(), p.end(), Proba_Moves.begin());
+      if (n_added == N) make_alias_table();
+    }
+
+    /// Last update of the proposition probabilities, which are then fixed.
+    void stop_tuning() {
+      update_tuning();
+      tuner.reset();
+    }
+
+    /// The normalized proposition probabilities of the moves
+    std::vector<double> get_proposition_probabilities() const {
+      double acc = 0;
+      for (auto p : Proba_Moves) acc += p;
+      std::vector<double> r(N);
+      for (size_t u = 0; u < N; ++u) r[u] = Proba_Moves[u] / acc;
+      return r;
+    }
+
+    /// The detailed statistics of the move number u, or nullptr if they are not enabled
+    move_statistics const *statistics(size_t u) const { return stats[u].get(); }
+
+    ///
+    void collect_statistics(mpi::communicator c) {
+      for (size_t u = 0; u < N; ++u) {
+        uint64_t nacc_tot    = mpi::all_reduce(Naccepted[u], c);
+        uint64_t nprop_tot   = mpi::all_reduce(NProposed[u], c);
+        acceptance_rates_[u] = nacc_tot / static_cast<double>(nprop_tot);
+        if (stats[u]) stats[u]->collect_results(c);
+      }
+      for_each_move([&c](size_t, auto &m) {
+        auto f = make_collect_statistics(&m); // cf impl_tools
+        if (f) f(c);
+      });
+    }
+
+    /// Add the proposed/accepted counters of the moves of another walker
+    void merge_statistics(static_move_set const &ms) {
+      for (size_t u = 0; u < N; ++u) {
+        NProposed[u] += ms.NProposed[u];
+        Naccepted[u] += ms.Naccepted[u];
+        if (stats[u] && ms.stats[u]) stats[u]->merge(*ms.stats[u]);
+      }
+    }
+
+    /// Acceptance rate of all moves as a map name:string -> acceptance_rate:double
+    std::map<std::string, double> get_acceptance_rates() const {
+      std::map<std::string, double> r;
+      for (size_t u = 0; u < N; ++u) r.insert({names_[u], acceptance_rates_[u]});
+      return r;
+    }
+
+    /// Pretty printing of the acceptance probability of the moves.
+    std::string get_statistics(std::string decal = "") const {
+      std::ostringstream s;
+      for (size_t u = 0; u < N; ++u) {
+        s << decal << "Move  " << names_[u] << ": " << acceptance_rates_[u] << "\n";
+        if (stats[u]) s << stats[u]->print(decal);
+      }
+      return s.str();
+    }
+
+    private:
+    // Call f on the currently selected move. The chain of comparisons with the constants Is
+    // is compiled into a switch over the (few) moves.
+    template <typename F> void visit_current(F &&f) { visit_current_impl(f, std::index_sequence_for<Moves...>{}); }
+    template <typename F, size_t... Is> void visit_current_impl(F &f, std::index_sequence<Is...>) {
+      ((current == Is ? (f(*std::get<Is>(moves)), true) : false) || ...);
+    }
+
+    // Call f(u, move) for all moves. All the moves must have been added.
+    template <typename F> void for_each_move(F &&f) {
+      check_all_added();
+      size_t u = 0;
+      std::apply([&](auto &... slot) { (f(u++, *slot), ...); }, moves);
+    }
+    template <typename F> void for_each_move(F &&f) const {
+      check_all_added();
+      size_t u = 0;
+      std::apply([&](auto const &... slot) { (f(u++, *slot), ...); }, moves);
+    }
+
+    // The moves have no name before they are added : the error names the first missing one by its number and type
+    void check_all_added() const {
+      if (n_added == N) return;
+      size_t u = 0;
+      auto check = [&u](auto const &slot) {
+        if (!slot)
+          TRIQS_RUNTIME_ERROR << "static_move_set : the move number " << u << " of type "
+                              << typeid(typename std::decay_t<decltype(slot)>::value_type).name() << " was not added";
+        ++u;
+      };
+      std::apply([&check](auto const &... slot) { (check(slot), ...); }, moves);
+    }
+
+    bool attempt_treat_infinite_ratio(std::complex<double>, double &) { return true; }
+
+    bool attempt_treat_infinite_ratio(double rate_ratio, double &abs_rate_ratio) {
+      bool is_inf = std::isinf(rate_ratio);
+      if (is_inf) {                                           // in case the ratio is infinite
+        abs_rate_ratio = 100;                                 // >1 for metropolis
+        try_sign_ratio = (std::signbit(rate_ratio) ? -1 : 1); // signbit -> true iif the number is negative
+      }
+      return !is_inf;
+    }
+
+    // Vose's construction of the alias table from Proba_Moves
+    void make_alias_table() {
+      double acc = 0;
+      for (auto p : Proba_Moves) acc += p;
+      if (acc <= 0) TRIQS_RUNTIME_ERROR << "static_move_set : the sum of the proposition probabilities is not > 0";
+      std::array<double, N> q;
+      std::vector<size_t> small, large;
+      for (size_t u = 0; u < N; ++u) {
+        q[u] = Proba_Moves[u] * N / acc;
+        (q[u] < 1 ? small : large).push_back(u);
+      }
+      while (!small.empty() && !large.empty()) {
+        size_t s = small.back(), l = large.back();
+        small.pop_back();
+        large.pop_back();
+        alias_proba[s] = q[s];
+        alias[s]       = l;
+        q[l]           = (q[l] + q[s]) - 1;
+        (q[l] < 1 ? small : large).push_back(l);
+      }
+      // the remaining ones are 1 up to rounding errors
+      for (auto const &v : {small, large})
+        for (auto u : v) {
+          alias_proba[u] = 1;
+          alias[u]       = u;
+        }
+    }
+
+    public:
+    // HDF5 interface
+    friend void h5_write(h5::group g, std::string const &name, static_move_set const &ms) {
+      auto gr = g.create_group(name);
+      ms.for_each_move([&](size_t u, auto const &m) {
+        auto f = make_h5_write(&m);
+        if (f) f(gr, ms.names_[u]);
+      });
+    }
+
+    /// Write the detailed statistics of the moves, if any, in the subgroup name of g (cf move_set::write_statistics)
+    void write_statistics(h5::group g, std::string const &name) const {
+      bool has_stats = false;
+      for (auto const &st : stats) has_stats |= bool(st);
+      if (!has_stats) return;
+      auto gs = g.create_group(name);
+      for (size_t u = 0; u < N; ++u)
+        if (stats[u]) h5_write(gs, names_[u], *stats[u]);
+    }
+
+    friend void h5_read(h5::group g, std::string const &name, static_move_set &ms) {
+      auto gr = g.open_group(name);
+      ms.for_each_move([&](size_t u, auto &m) {
+        auto f = make_h5_read(&m);
+        if (f) f(gr, ms.names_[u]);
+      });
+    }
+  };
+
+} // namespace triqs::mc_tools
@@ -0,0 +1,144 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace triqs::mc_tools {
+
+  /**
+   * Counter-based random generator Philox4x32-10.
+   *
+   * Ref : J. K. Salmon, M. A. Moraes, R. O. Dror, D. E. Shaw, "Parallel random numbers: as easy as 1, 2, 3", SC11 (2011).
+   *
+   * The generator is a bijection of a 128 bits counter, parametrized by a 64 bits key (the seed).
+   * The counter is made of a position (64 bits) and of a stream number (64 bits).
+   * Hence, for a given seed :
+   *   - different streams never overlap (they use different counters), each stream has 2^64 blocks of 4 x 32 bits,
+   *   - jump(n) is O(1) : it only moves the position.
+   *
+   * split() returns a generator with a new key, derived from the key, the stream and the number of previous splits.
+   * It is meant for hierarchical decompositions (rank -> thread -> walker), when the stream numbers are not known
+   * in advance.
+   *
+   * The state is 4 integers : the generator is cheap to copy, and its result only depends on (seed, stream, position),
+   * so that the numbers given to e.g. walker w of rank r are independent of the number of ranks.
+   */
+  class philox4x32 {
+
+    using block_t = std::array<uint32_t, 4>;
+    using key_t   = std::array<uint32_t, 2>;
+
+    key_t key;
+    uint64_t position = 0, stream = 0, n_splits = 0;
+
+    static constexpr uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57, W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+
+    public:
+    /**
+     * @param seed    The seed (the key of the bijection)
+     * @param stream  The stream number
+     */
+    philox4x32(uint64_t seed, uint64_t stream = 0) : key{uint32_t(seed), uint32_t(seed >> 32)}, stream(stream) {}
+
+    /// The bijection. Counter c, key k.
+    static block_t block(block_t c, key_t k) {
+      for (int r = 0; r < 10; ++r) {
+        if (r > 0) {
+          k[0] += W0;
+          k[1] += W1;
+        }
+        uint64_t p0 = uint64_t(M0) * c[0], p1 = uint64_t(M1) * c[2];
+        c = {uint32_t(p1 >> 32) ^ c[1] ^ k[0], uint32_t(p1), uint32_t(p0 >> 32) ^ c[3] ^ k[1], uint32_t(p0)};
+      }
+      return c;
+    }
+
+    /// The next block of 4 random 32 bits integers
+    block_t operator()() { return block(counter(position++), key); }
+
+    /// Skip n blocks
+    void jump(uint64_t n) { position += n; }
+
+    /// Current position (in blocks) in the stream
+    uint64_t get_position() const { return position; }
+
+    /// The stream number
+    uint64_t get_stream() const { return stream; }
+
+    /// A generator with a new key, at position 0 of the same stream. Successive calls give different keys.
+    philox4x32 split() {
+      // The block of the split number in the stream, with a modified key, is used as the new key.
+      auto b = block({uint32_t(n_splits), uint32_t(n_splits >> 32), uint32_t(stream), uint32_t(stream >> 32)}, {~key[0], ~key[1]});
+      ++n_splits;
+      auto r = *this;
+      r.key      = {b[0], b[1]};
+      r.position = 0;
+      r.n_splits = 0;
+      return r;
+    }
+
+    /**
+     * Fill x[0:n] with doubles uniformly distributed in [0,1[, with 53 bits of randomness.
+     * Each block gives 2 doubles (n odd wastes half a block). The blocks are computed by batches of independent
+     * counters, in a layout that the compiler vectorizes.
+     */
+    void fill(double *x, size_t n) {
+      constexpr int B = 8; // batch of blocks
+      auto to_double  = [](uint32_t hi, uint32_t lo) { return ((uint64_t(hi) << 32 | lo) >> 11) * 0x1.0p-53; };
+      size_t i        = 0;
+      for (; i + 2 * B <= n; i += 2 * B) {
+        uint32_t c0[B], c1[B], c2[B], c3[B];
+        for (int j = 0; j < B; ++j) {
+          auto c = counter(position + j);
+          c0[j] = c[0], c1[j] = c[1], c2[j] = c[2], c3[j] = c[3];
+        }
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int r = 0; r < 10; ++r) {
+          if (r > 0) {
+            k0 += W0;
+            k1 += W1;
+          }
+          for (int j = 0; j < B; ++j) {
+            uint64_t p0 = uint64_t(M0) * c0[j], p1 = uint64_t(M1) * c2[j];
+            uint32_t n0 = uint32_t(p1 >> 32) ^ c1[j] ^ k0, n2 = uint32_t(p0 >> 32) ^ c3[j] ^ k1;
+            c1[j] = uint32_t(p1);
+            c3[j] = uint32_t(p0);
+            c0[j] = n0;
+            c2[j] = n2;
+          }
+        }
+        for (int j = 0; j < B; ++j) {
+          x[i + 2 * j]     = to_double(c0[j], c1[j]);
+          x[i + 2 * j + 1] = to_double(c2[j], c3[j]);
+        }
+        position += B;
+      }
+      for (; i < n; i += 2) { // the rest, block by block
+        auto b = (*this)();
+        x[i]   = to_double(b[0], b[1]);
+        if (i + 1 < n) x[i + 1] = to_double(b[2], b[3]);
+      }
+    }
+
+    private:
+    block_t counter(uint64_t pos) const { return {uint32_t(pos), uint32_t(pos >> 32), uint32_t(stream), uint32_t(stream >> 32)}; }
+  };
+
+} // namespace triqs::mc_tools
@@ -38,9 +38,16 @@
 namespace triqs {
   namespace mc_tools {
 
-    random_generator::random_generator(std::string const &RandomGeneratorName, uint32_t seed_) {
+    random_generator::random_generator(std::string const &RandomGeneratorName, uint32_t seed_, uint64_t stream) {
       _name = RandomGeneratorName;
 
+      if (RandomGeneratorName == "philox4x32") {
+        *this = random_generator(philox4x32(seed_, stream));
+        return;
+      }
+
+      if (stream != 0) TRIQS_RUNTIME_ERROR << "The random generator " << RandomGeneratorName << " has no streams. Use philox4x32";
+
       if (RandomGeneratorName == "") {
         gen = utility::buffered_function<double>(mc_tools::RandomGenerators::RandMT(seed_));
         return;
@@ -62,15 +69,55 @@ namespace triqs {
 
     //---------------------------------------------
 
+    // The buffer is filled in bulk, by the vectorized philox4x32::fill
+    random_generator::random_generator(philox4x32 const &p) : _name("philox4x32"), philox(std::make_shared<philox4x32>(p)) {
+      gen = utility::buffered_function<double>([p = philox](double *x, size_t n) { p->fill(x, n); });
+    }
+
+    //---------------------------------------------
+
+    // The copy of gen refills from a copy of the state of philox4x32, not from the state of the original
+    random_generator::random_generator(random_generator const &p) : gen(p.gen), _name(p._name) {
+      if (!p.philox) return;
+      philox = std::make_shared<philox4x32>(*p.philox);
+      gen.rebind([s = philox](double *x, size_t n) { s->fill(x, n); });
+    }
+
+    //---------------------------------------------
+
+    random_generator random_generator::split() {
+      if (!philox) TRIQS_RUNTIME_ERROR << "The random generator " << _name << " can not be split. Use philox4x32";
+      return random_generator(philox->split());
+    }
+
+    //---------------------------------------------
+
+    void random_generator::jump(uint64_t n) {
+      if (!philox) TRIQS_RUNTIME_ERROR << "The random generator " << _name << " can not jump. Use philox4x32";
+      // the numbers still in the buffer come first. Then each block of the generator gives 2 numbers.
+      uint64_t r = gen.available();
+      if (n <= r) {
+        gen.drop(n);
+        return;
+      }
+      n -= r;
+      gen.invalidate();
+      philox->jump(n / 2);
+      gen.drop(n % 2);
+    }
+
+    //---------------------------------------------
+
     std::string random_generator_names(std::string const &sep) {
 #define PR(r, sep, p, XX) BOOST_PP_IF(p, +sep +, ) std::string(AS_STRING(XX))
-      return BOOST_PP_SEQ_FOR_EACH_I(PR, sep, RNG_LIST);
+      return BOOST_PP_SEQ_FOR_EACH_I(PR, sep, RNG_LIST) + sep + "philox4x32";
     }
 
     std::vector<std::string> random_generator_names_list() {
       std::vector<std::string> res;
 #define PR2(r, sep, p, XX) res.push_back(AS_STRING(XX));
       BOOST_PP_SEQ_FOR_EACH_I(PR2, sep, RNG_LIST);
+      res.push_back("philox4x32");
       return res;
     }
   } // namespace mc_tools
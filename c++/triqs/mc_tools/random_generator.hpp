@@ -21,7 +21,9 @@
 #include <triqs/utility/first_include.hpp>
 #include "../utility/exceptions.hpp"
 #include "../utility/buffered_function.hpp"
+#include "./philox.hpp"
 #include <cmath>
+#include <memory>
 #include <string>
 #include <assert.h>
 #include <type_traits>
@@ -38,31 +40,52 @@ namespace triqs {
   *
   * The name of the generator is given at construction, and its type is erased in this class.
   * For performance, the call to the generator is bufferized, with chunks of 1000 numbers.
+  *
+  * The counter-based generator "philox4x32" (cf philox.hpp) also has independent streams,
+  * and supports split and jump.
   */
     class random_generator {
       utility::buffered_function<double> gen;
       std::string _name;
+      std::shared_ptr<philox4x32> philox; // the state of the generator, if it is philox4x32. Shared with the refill of gen, not with the copies.
 
       public:
       /** Constructor
-   *  @param RandomGeneratorName : Name of a boost generator e.g. mt19937, or "" (another Mersenne Twister).
+   *  @param RandomGeneratorName : Name of a boost generator e.g. mt19937, "" (another Mersenne Twister), or philox4x32.
    *  @param seed : The seed of the random generator
+   *  @param stream : The stream number. Only for philox4x32 : the streams of a given seed never overlap.
    */
-      random_generator(std::string const &RandomGeneratorName, uint32_t seed_);
+      random_generator(std::string const &RandomGeneratorName, uint32_t seed_, uint64_t stream = 0);
 
       random_generator() : random_generator("mt19937", 198) {}
 
-      ///
+      /// A copy continues the same sequence as the original, independently of it
       random_generator(random_generator const &p);
 
       random_generator(random_generator &&) = default;
 
+      ///
+      random_generator &operator=(random_generator const &p) { return *this = random_generator(p); }
+
       //
       random_generator &operator=(random_generator &&) = default;
 
       /// Name of the random generator
       std::string name() const { return _name; }
 
+      /// Does the generator support streams, split and jump ?
+      bool is_splittable() const { return bool(philox); }
+
+      /// A new generator, independent of this one (cf philox4x32::split). Only for philox4x32.
+      random_generator split();
+
+      /// Skip the next n numbers. O(1). Only for philox4x32.
+      void jump(uint64_t n);
+
+      private:
+      random_generator(philox4x32 const &p);
+
+      public:
       /// Returns a integer in [0,i-1] with flat distribution
       template <typename T> typename std::enable_if<std::is_integral<T>::value, T>::type operator()(T i) {
         return (i == 1 ? 0 : T(floor(i * (gen()))));
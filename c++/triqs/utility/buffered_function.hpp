@@ -21,6 +21,8 @@
 #include "./first_include.hpp"
 #include <vector>
 #include <functional>
+#include <algorithm>
+#include <type_traits>
 
 namespace triqs {
   namespace utility {
@@ -28,6 +30,8 @@ namespace triqs {
     /**
   * A simple buffer for a generator.
   * Given a function, it provides a buffer of this function
+  * The function is either a generator () -> R, called once per element,
+  * or a bulk filler (R *, size_t n) -> void, which fills the whole buffer at once.
   * Advantage :
   *  - do not pay the indirection cost at each call, but once every size call.
   *  - erase the function type
@@ -45,11 +49,19 @@ namespace triqs {
    * @param size : size of the buffer [optional]
    */
       template <typename Function> buffered_function(Function f, size_t size = 1000) : buffer(size) {
+        rebind(std::move(f));
+        refill(this); // first filling of the buffer
+      }
+
+      /// Replace the function, keeping the elements still in the buffer
+      template <typename Function> void rebind(Function f) {
         refill = [f](buffered_function *bf) mutable { // without the mutable, the () of the lambda object is const, hence f
-          for (auto &x : bf->buffer) x = f();
+          if constexpr (std::is_invocable_v<Function &, R *, size_t>)
+            f(bf->buffer.data(), bf->buffer.size());
+          else
+            for (auto &x : bf->buffer) x = f();
           bf->index= 0;
         };
-        refill(this); // first filling of the buffer
       }
 
       /// Returns the next element. Refills the buffer if necessary.
@@ -64,6 +76,22 @@ namespace triqs {
         return buffer[index];
       }
 
+      /// Number of elements still in the buffer
+      size_t available() const { return buffer.size() - index; }
+
+      /// Skip the next n elements. Refills the buffer if necessary.
+      void drop(size_t n) {
+        while (n > 0) {
+          if (index > buffer.size() - 1) refill(this);
+          size_t k = std::min(n, available());
+          index += k;
+          n -= k;
+        }
+      }
+
+      /// Forget the content of the buffer : it will be refilled at the next call.
+      void invalidate() { index = buffer.size(); }
+
       private:
       size_t index;
       std::vector<R> buffer;
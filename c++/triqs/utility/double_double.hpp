@@ -0,0 +1,112 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#pragma once
+#include <cmath>
+#include <complex>
+
+namespace triqs {
+  namespace utility {
+
+    /**
+     * A double-double number : the unevaluated sum hi + lo of two doubles, with |lo| <= ulp(hi) / 2.
+     *
+     * It has about 106 bits of mantissa (32 decimal digits), with the exponent range of a double.
+     * The operations are the error-free transformations of Dekker and Knuth (two_sum, two_prod with fma),
+     * cf. Y. Hida, X. S. Li, D. H. Bailey, "Library for double-double and quad-double arithmetic" (2007).
+     */
+    struct dd_real {
+      double hi = 0, lo = 0;
+
+      dd_real() = default;
+      dd_real(double x) : hi(x), lo(0) {}
+      dd_real(double h, double l) : hi(h), lo(l) {}
+
+      explicit operator double() const { return hi + lo; }
+
+      // s + e = a + b exactly
+      static dd_real two_sum(double a, double b) {
+        double s = a + b, v = s - a;
+        return {s, (a - (s - v)) + (b - v)};
+      }
+
+      // s + e = a + b exactly, assuming |a| >= |b|
+      static dd_real quick_two_sum(double a, double b) {
+        double s = a + b;
+        return {s, b - (s - a)};
+      }
+
+      // p + e = a * b exactly
+      static dd_real two_prod(double a, double b) {
+        double p = a * b;
+        return {p, std::fma(a, b, -p)};
+      }
+
+      friend dd_real operator+(dd_real const &a, dd_real const &b) {
+        dd_real s = two_sum(a.hi, b.hi), t = two_sum(a.lo, b.lo);
+        s         = quick_two_sum(s.hi, s.lo + t.hi);
+        return quick_two_sum(s.hi, s.lo + t.lo);
+      }
+
+      friend dd_real operator-(dd_real const &a) { return {-a.hi, -a.lo}; }
+      friend dd_real operator-(dd_real const &a, dd_real const &b) { return a + (-b); }
+
+      friend dd_real operator*(dd_real const &a, dd_real const &b) {
+        dd_real p = two_prod(a.hi, b.hi);
+        return quick_two_sum(p.hi, p.lo + (a.hi * b.lo + a.lo * b.hi));
+      }
+
+      friend dd_real operator/(dd_real const &a, dd_real const &b) {
+        double q1 = a.hi / b.hi;
+        dd_real r = a - b * q1;
+        double q2 = r.hi / b.hi;
+        r         = r - b * q2;
+        double q3 = r.hi / b.hi;
+        return quick_two_sum(q1, q2) + q3;
+      }
+
+      friend bool operator==(dd_real const &a, dd_real const &b) { return a.hi == b.hi and a.lo == b.lo; }
+      friend bool operator!=(dd_real const &a, dd_real const &b) { return !(a == b); }
+      friend bool operator<(dd_real const &a, dd_real const &b) { return a.hi < b.hi or (a.hi == b.hi and a.lo < b.lo); }
+
+      friend dd_real abs(dd_real const &a) { return (a.hi < 0 ? -a : a); }
+    };
+
+    /// A complex number of double-double
+    struct dd_complex {
+      dd_real re, im;
+
+      dd_complex() = default;
+      dd_complex(dd_real r, dd_real i = 0) : re(r), im(i) {}
+      dd_complex(std::complex<double> const &z) : re(z.real()), im(z.imag()) {}
+
+      explicit operator std::complex<double>() const { return {double(re), double(im)}; }
+
+      friend dd_complex operator+(dd_complex const &a, dd_complex const &b) { return {a.re + b.re, a.im + b.im}; }
+      friend dd_complex operator-(dd_complex const &a, dd_complex const &b) { return {a.re - b.re, a.im - b.im}; }
+      friend dd_complex operator*(dd_complex const &a, dd_complex const &b) { return {a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re}; }
+      friend dd_complex operator/(dd_complex const &a, dd_complex const &b) {
+        dd_real r = dd_real(1) / (b.re * b.re + b.im * b.im);
+        return {(a.re * b.re + a.im * b.im) * r, (a.im * b.re - a.re * b.im) * r};
+      }
+
+      /// |z|^2
+      dd_real norm() const { return re * re + im * im; }
+    };
+
+  } // namespace utility
+} // namespace triqs
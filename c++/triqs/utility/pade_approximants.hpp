@@ -24,7 +24,9 @@
 #include "pade_approximants.hpp"
 #include <triqs/utility/exceptions.hpp>
 #include <triqs/arrays.hpp>
+#include "./double_double.hpp"
 #include <gmpxx.h>
+#include <optional>
 
 namespace triqs {
   namespace utility {
@@ -61,50 +63,160 @@ namespace triqs {
       }
     };
 
-    class pade_approximant {
-
-      arrays::vector<dcomplex> z_in; // Input complex frequency points
-      arrays::vector<dcomplex> a;    // Pade coefficients
-
-      public:
-      static const int GMP_default_prec = 256; // Precision of GMP floats to use during a Pade coefficients calculation.
+    namespace pade_impl {
 
-      pade_approximant(const arrays::vector<dcomplex> &z_in_, const arrays::vector<dcomplex> &u_in) : z_in(z_in_), a(z_in.size()) {
+      // |z|^2, for the complex types used in the recursion
+      inline double norm(dcomplex const &z) { return std::norm(z); }
+      template <typename C> auto norm(C const &z) { return z.norm(); }
 
+      /*
+       * The coefficients a_j = g(j, j) of the continued fraction, with the recursion
+       *    g(0, j) = u_j,   g(p, j) = (g(p - 1, p - 1) / g(p - 1, j) - 1) / (z_j - z_{p - 1})
+       * in the arithmetic of the complex type C. Only the row g(p - 1, .) is needed to compute g(p, .), it is updated in place.
+       * If |g(p, p)| is very small, the continued fraction is truncated : the next coefficients are 0.
+       * Returns the coefficients and their number before the truncation.
+       */
+      template <typename C> std::pair<std::vector<C>, int> coefficients(arrays::vector<dcomplex> const &z_in, arrays::vector<dcomplex> const &u_in) {
         int N = z_in.size();
-
-        // Change the default precision of GMP floats.
-        unsigned long old_prec = mpf_get_default_prec();
-        mpf_set_default_prec(GMP_default_prec); // How do we determine it?
-
-        arrays::array<gmp_complex, 2> g(N, N);
-        gmp_complex MP_0 = {0.0, 0.0};
-        g()              = MP_0;
-        for (int f = 0; f < N; ++f) { g(0, f) = u_in(f); };
-
-        gmp_complex MP_1 = {1.0, 0.0};
+        std::vector<C> g(N), a(N);
+        C zero, one;
+        zero = dcomplex(0.0);
+        one  = dcomplex(1.0);
+        for (int f = 0; f < N; ++f) {
+          g[f] = u_in(f);
+          a[f] = zero;
+        }
+        if (N == 0) return {a, 0};
+        a[0] = g[0];
 
         for (int p = 1; p < N; ++p) {
 
           // If |g| is very small, the continued fraction should be truncated.
-          if (g(p - 1, p - 1).norm() < 1.0e-20) break;
+          if (norm(a[p - 1]) < 1.0e-20) return {a, p};
 
           for (int j = p; j < N; ++j) {
-            gmp_complex x = g(p - 1, p - 1) / g(p - 1, j) - MP_1;
-            gmp_complex y;
-            y       = z_in(j) - z_in(p - 1);
-            g(p, j) = x / y;
+            C y;
+            y    = z_in(j) - z_in(p - 1);
+            g[j] = (a[p - 1] / g[j] - one) / y;
           }
+          a[p] = g[p];
         }
+        return {a, N};
+      }
 
-        for (int j = 0; j < N; ++j) {
-          gmp_complex gj = g(j, j);
-          a(j)           = dcomplex(real(gj).get_d(), imag(gj).get_d());
-        }
+    } // namespace pade_impl
+
+    /**
+     * The Pade coefficients, computed in GMP arithmetic with gmp_prec bits.
+     *
+     * NB : it changes temporarily the default precision of the GMP floats, so it is not thread-safe.
+     */
+    inline arrays::vector<dcomplex> pade_coefficients_gmp(arrays::vector<dcomplex> const &z_in, arrays::vector<dcomplex> const &u_in,
+                                                          int gmp_prec = 256) {
+      // Change the default precision of GMP floats.
+      unsigned long old_prec = mpf_get_default_prec();
+      mpf_set_default_prec(gmp_prec);
+
+      auto a_mp = pade_impl::coefficients<gmp_complex>(z_in, u_in).first;
+      arrays::vector<dcomplex> a(a_mp.size());
+      for (int j = 0; j < a.size(); ++j) a(j) = dcomplex(real(a_mp[j]).get_d(), imag(a_mp[j]).get_d());
+
+      // Restore the precision.
+      mpf_set_default_prec(old_prec);
+      return a;
+    }
+
+    /**
+     * The Pade continued fraction with coefficients a at all the points e : out(k) = PA(e(k))
+     *
+     * The recursion runs for all the points together, in real arithmetic, so that the loop over the points vectorizes.
+     */
+    inline void pade_evaluate(arrays::vector<dcomplex> const &z_in, arrays::vector<dcomplex> const &a, arrays::array_const_view<dcomplex, 1> e,
+                              arrays::array_view<dcomplex, 1> out) {
+      long n_e = e.size();
+      int N    = a.size();
+      std::vector<double> er(n_e), ei(n_e), a1r(n_e, 0), a1i(n_e, 0), a2r(n_e, a(0).real()), a2i(n_e, a(0).imag()), b1r(n_e, 1), b1i(n_e, 0);
+      for (long k = 0; k < n_e; ++k) {
+        er[k] = e(k).real();
+        ei[k] = e(k).imag();
+      }
 
-        // Restore the precision.
-        mpf_set_default_prec(old_prec);
+      for (int i = 0; i <= N - 2; ++i) {
+        double zr = z_in(i).real(), zi = z_in(i).imag(), ar = a(i + 1).real(), ai = a(i + 1).imag();
+        for (long k = 0; k < n_e; ++k) {
+          double xr = er[k] - zr, xi = ei[k] - zi;
+          double cr = xr * ar - xi * ai, ci = xr * ai + xi * ar;
+          double nr = a2r[k] + cr * a1r[k] - ci * a1i[k], ni = a2i[k] + cr * a1i[k] + ci * a1r[k]; // A2 + c A1
+          double br = 1 + cr * b1r[k] - ci * b1i[k], bi = cr * b1i[k] + ci * b1r[k];               // 1 + c B1
+          double d = br * br + bi * bi, ir = br / d, ii = -bi / d;                                  // 1 / Bnew
+          double a2r_k = a2r[k], a2i_k = a2i[k];
+          a1r[k] = a2r_k * ir - a2i_k * ii;
+          a1i[k] = a2r_k * ii + a2i_k * ir;
+          a2r[k] = nr * ir - ni * ii;
+          a2i[k] = nr * ii + ni * ir;
+          b1r[k] = ir;
+          b1i[k] = ii;
+        }
       }
+      for (long k = 0; k < n_e; ++k) out(k) = dcomplex(a2r[k], a2i[k]);
+    }
+
+    /**
+     * The Pade coefficients, computed in double-double arithmetic.
+     *
+     * Their accuracy is estimated by precision doubling : the coefficients are also computed in double precision,
+     * and the two continued fractions are compared at the points e, where the approximant is to be evaluated.
+     * To first order, the rounding errors are proportional to the unit roundoff, so the error of the double-double
+     * result is about 2^-53 times the difference d of the two. This estimate requires the double-precision result
+     * to be still roughly correct, hence the conditions d <= 1e-3 * max |u_in| and 2^-53 d <= tolerance * max |u_in|.
+     * Returns an empty optional if they are not met. Thread-safe.
+     */
+    inline std::optional<arrays::vector<dcomplex>> pade_coefficients_dd(arrays::vector<dcomplex> const &z_in, arrays::vector<dcomplex> const &u_in,
+                                                                        arrays::array_const_view<dcomplex, 1> e, double tolerance = 1.e-14) {
+      auto a_dd = pade_impl::coefficients<dd_complex>(z_in, u_in).first;
+      auto a_d  = pade_impl::coefficients<dcomplex>(z_in, u_in).first;
+
+      arrays::vector<dcomplex> a(a_dd.size()), a_check(a_d.size());
+      for (int j = 0; j < a.size(); ++j) a(j) = dcomplex(a_dd[j]);
+      for (int j = 0; j < a_check.size(); ++j) a_check(j) = a_d[j];
+      if (a.size() == 0) return a;
+
+      auto r = arrays::array<dcomplex, 1>(e.size()), r_check = arrays::array<dcomplex, 1>(e.size());
+      pade_evaluate(z_in, a, e, r);
+      pade_evaluate(z_in, a_check, e, r_check);
+
+      double u_max = 0;
+      for (int j = 0; j < u_in.size(); ++j) u_max = std::max(u_max, std::abs(u_in(j)));
+      double d_max = std::min(1.e-3, tolerance * std::ldexp(1.0, 53)) * u_max;
+      for (int k = 0; k < e.size(); ++k)
+        if (!(std::abs(r(k) - r_check(k)) <= d_max)) return {};
+      return a;
+    }
+
+    /// The Pade coefficients, in double-double arithmetic, or in GMP arithmetic when the former are not accurate enough at e (not thread-safe)
+    inline arrays::vector<dcomplex> pade_coefficients(arrays::vector<dcomplex> const &z_in, arrays::vector<dcomplex> const &u_in,
+                                                      arrays::array_const_view<dcomplex, 1> e) {
+      if (auto a = pade_coefficients_dd(z_in, u_in, e)) return std::move(*a);
+      return pade_coefficients_gmp(z_in, u_in);
+    }
+
+    class pade_approximant {
+
+      arrays::vector<dcomplex> z_in; // Input complex frequency points
+      arrays::vector<dcomplex> a;    // Pade coefficients
+
+      public:
+      static const int GMP_default_prec = 256; // Precision of GMP floats to use during a Pade coefficients calculation.
+
+      /// The coefficients are computed in GMP arithmetic : the points of evaluation are not known, so the accuracy
+      /// of the double-double coefficients can not be checked (it can be lost on the real axis, at low temperature)
+      pade_approximant(const arrays::vector<dcomplex> &z_in_, const arrays::vector<dcomplex> &u_in)
+         : z_in(z_in_), a(pade_coefficients_gmp(z_in_, u_in, GMP_default_prec)) {}
+
+      /// The coefficients are computed in double-double arithmetic if they are accurate enough at the points e,
+      /// where the approximant is to be evaluated, and in GMP arithmetic otherwise (cf pade_coefficients)
+      pade_approximant(const arrays::vector<dcomplex> &z_in_, const arrays::vector<dcomplex> &u_in, arrays::array_const_view<dcomplex, 1> e)
+         : z_in(z_in_), a(pade_coefficients(z_in_, u_in, e)) {}
 
       // give the value of the pade continued fraction at complex number e
       dcomplex operator()(dcomplex e) const {
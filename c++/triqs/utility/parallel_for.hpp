@@ -0,0 +1,101 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace triqs {
+  namespace utility {
+
+    /**
+     * Calls f(t) on the threads t = 0, ..., n_threads - 1, and joins them
+     *
+     * If a call throws, the error of the first thread (in the order of t) is rethrown after all threads are joined.
+     * With n_threads <= 1, f(0) is simply called.
+     *
+     * @param n_threads Number of threads
+     * @param f The callable, f(int)
+     */
+    template <typename F> void run_on_threads(int n_threads, F const &f) {
+      if (n_threads <= 1) {
+        f(0);
+        return;
+      }
+      std::vector<std::thread> threads;
+      std::vector<std::exception_ptr> errors(n_threads);
+      for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&f, &errors, t]() {
+          try {
+            f(t);
+          } catch (...) { errors[t] = std::current_exception(); }
+        });
+      }
+      for (auto &th : threads) th.join();
+      for (auto &e : errors)
+        if (e) std::rethrow_exception(e);
+    }
+
+    /**
+     * Calls f(i0, i1) on n_threads contiguous chunks [i0, i1) of [0, n), one per thread
+     *
+     * For uniform work, e.g. the points of a mesh. The first error is rethrown, cf run_on_threads.
+     *
+     * @param n Size of the range
+     * @param n_threads Number of threads (at most n are started)
+     * @param f The callable, f(long, long)
+     */
+    template <typename F> void parallel_for_chunks(long n, int n_threads, F const &f) {
+      if (n <= 0) return;
+      int n_th = std::max(1l, std::min<long>(n_threads, n));
+      run_on_threads(n_th, [&f, n, n_th](int t) { f((n * t) / n_th, (n * (t + 1)) / n_th); });
+    }
+
+    /**
+     * Calls f(i) for i = 0, ..., n - 1 on n_threads threads
+     *
+     * The indices are taken in increasing order, each thread taking the next one as soon as it is free,
+     * so the costly tasks should come first. After an error, the remaining indices are not started.
+     * The first error is rethrown, cf run_on_threads.
+     *
+     * @param n Number of indices
+     * @param n_threads Number of threads (at most n are started)
+     * @param f The callable, f(long)
+     */
+    template <typename F> void parallel_for(long n, int n_threads, F const &f) {
+      if (n <= 0) return;
+      int n_th = std::max(1l, std::min<long>(n_threads, n));
+      if (n_th == 1) {
+        for (long i = 0; i < n; ++i) f(i);
+        return;
+      }
+      std::atomic<long> next = 0;
+      run_on_threads(n_th, [&f, &next, n](int) {
+        try {
+          for (long i = next++; i < n; i = next++) f(i);
+        } catch (...) {
+          next = n;
+          throw;
+        }
+      });
+    }
+
+  } // namespace utility
+} // namespace triqs
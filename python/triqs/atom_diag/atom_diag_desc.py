@@ -60,10 +60,10 @@ for c_py, c_cpp, in (('Real','false'),('Complex','true')):
         doc = "Lightweight exact diagonalization solver (%s version)" % c_py
     )
 
-    c.add_constructor("(many_body_operator h, fundamental_operator_set fops)",
+    c.add_constructor("(many_body_operator h, fundamental_operator_set fops, int n_threads = 1)",
                       doc = "Reduce a given Hamiltonian to a block-diagonal form and diagonalize it")
 
-    c.add_constructor("(many_body_operator h, fundamental_operator_set fops, std::vector<%s::many_body_op_t> qn_vector)" % c_type,
+    c.add_constructor("(many_body_operator h, fundamental_operator_set fops, std::vector<%s::many_body_op_t> qn_vector, int n_threads = 1)" % c_type,
                       doc = "Reduce a given Hamiltonian to a block-diagonal form and diagonalize it using quantum numbers")
 
     c.add_method("int get_subspace_dim (int sp_index)", doc = "The dimension of subspace sp_index")
@@ -0,0 +1,84 @@
+from cpp2py.wrap_generator import *
+
+# triqs.dos.dos_tools module
+module = module_(full_name = "triqs.dos.dos_tools",
+                 doc = "C++ kernels of the Hilbert transforms",
+                 app_name = "triqs")
+
+module.add_imports("triqs.gf")
+
+module.add_include("<triqs/lattice/hilbert_transform.hpp>")
+
+module.add_include("<cpp2py/converters/vector.hpp>")
+module.add_include("<cpp2py/converters/function.hpp>")
+module.add_include("<triqs/cpp2py_converters.hpp>")
+
+module.add_using("namespace triqs::lattice")
+module.add_using("namespace triqs::arrays")
+module.add_using("namespace triqs::gfs")
+
+doc = r"""
+    The Hilbert transform :math:`G(\omega) = \sum_i \rho_i [(\omega + \mu + i\eta) - \hat\epsilon_i - \Sigma(\omega)]^{-1}`
+
+    Parameters
+    ----------
+    eps : array, float
+        The energies :math:`\epsilon_i`, with :math:`\hat\epsilon_i = \epsilon_i \mathbf{1}`.
+        If Sigma is diagonal, the sum is done without matrix inversion.
+    eps_hat : list of matrices
+        The matrices :math:`\hat\epsilon_i`, instead of eps.
+    rho : array, float
+        The weights of the energies.
+    sigma : Gf
+        The self-energy, on a Matsubara or a real frequency mesh.
+    mu : float
+        The chemical potential.
+    eta : float
+        The broadening.
+"""
+
+for mesh in ["imfreq", "refreq"]:
+    module.add_function("gf<%s> hilbert_transform(array_const_view<double, 1> eps, array_const_view<double, 1> rho, gf_view<%s> sigma, double mu, double eta = 0)"%(mesh, mesh),
+                        doc = doc)
+    module.add_function("gf<%s> hilbert_transform(array_const_view<double, 1> rho, std::vector<matrix<dcomplex>> eps_hat, gf_view<%s> sigma, double mu, double eta = 0)"%(mesh, mesh),
+                        doc = doc)
+
+doc_adaptive = r"""
+    The Hilbert transform :math:`G(\omega) = \int_{\epsilon_{min}}^{\epsilon_{max}} d\epsilon \rho(\epsilon) [(\omega + \mu + i\eta) - \epsilon - \Sigma(\omega)]^{-1}`
+    of a density of states given as a function, by adaptive Gauss-Kronrod quadrature.
+
+    Parameters
+    ----------
+    rho : function
+        The density of states :math:`\rho(\epsilon)`.
+    eps_min : float
+        The lower bound of the integral.
+    eps_max : float
+        The upper bound of the integral.
+    sigma : Gf
+        The self-energy, on a Matsubara or a real frequency mesh.
+    mu : float
+        The chemical potential.
+    eta : float
+        The broadening.
+    tolerance : float
+        The relative tolerance of the integral.
+    n_min : int
+        The initial number of intervals.
+    n_max : int
+        The maximal number of intervals.
+"""
+
+for mesh in ["imfreq", "refreq"]:
+    module.add_function("gf<%s> hilbert_transform(std::function<double(double)> rho, double eps_min, double eps_max, gf_view<%s> sigma, double mu, double eta = 0, double tolerance = 1.e-8, long n_min = 16, long n_max = 65536)"%(mesh, mesh),
+                        doc = doc_adaptive)
+
+module.add_function("double dos_integral(std::function<double(double)> rho, double eps_min, double eps_max, double tolerance = 1.e-8, long n_min = 16, long n_max = 65536)",
+                    doc = r"""The integral of a density of states given as a function, by the adaptive quadrature of hilbert_transform.""")
+
+########################
+##   Code generation
+########################
+
+if __name__ == '__main__' :
+   module.generate_code()
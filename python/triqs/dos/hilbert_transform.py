@@ -21,6 +21,7 @@
 from triqs.gf import *
 import types, string, inspect, itertools
 from triqs.dos import DOS, DOSFromFunction
+from .dos_tools import hilbert_transform, dos_integral
 import triqs.utility.mpi as mpi
 import numpy
 
@@ -82,7 +83,11 @@ class HilbertTransform:
                             Used only when DOS is a DOSFromFunction:
         n_points_integral: How many points to use. If None, use the Npts of construction
         test_convergence: If defined, it will refine the grid until CV is reached
-                          starting from n_points_integral and multiplying by 2
+                          starting from n_points_integral and multiplying by 2.
+                          For a Gf Sigma on a frequency mesh, without field and epsilon_hat,
+                          the integral of the function is instead computed by the adaptive
+                          quadrature of the C++ kernel, with the relative tolerance test_convergence.
+                          As on the grid, the function is normalized, by its integral with the same quadrature.
 
         Returns
         --------
@@ -125,6 +130,20 @@ class HilbertTransform:
 
         def HT(res):
             import triqs.utility.mpi as mpi
+
+            # Sigma given as a Gf in frequencies : the C++ kernel, on the slice of the energies of the node
+            if not(Sigma_fnt) and field is None and isinstance(Sigma.mesh, (MeshImFreq, MeshReFreq)):
+                rho_sl = mpi.slice_array(self.rho_for_sum)
+                if len(rho_sl) == 0:
+                    res.zero()
+                elif epsilon_hat:
+                    res << hilbert_transform(rho_sl, [numpy.array(e, dtype=complex) for e in mpi.slice_array(epsilon_hat(self.dos.eps))], Sigma, mu, eta)
+                else:
+                    res << hilbert_transform(mpi.slice_array(self.dos.eps), rho_sl, Sigma, mu, eta)
+                res << mpi.all_reduce(mpi.world, res, lambda x, y: x+y)
+                mpi.barrier()
+                return
+
             # First compute the eps_hat array
             eps_hat = epsilon_hat(self.dos.eps) if epsilon_hat else numpy.array( [ x* numpy.identity (N1) for x in self.dos.eps] )
             assert eps_hat.shape[0] == self.dos.eps.shape[0], "epsilon_hat function behaves incorrectly"
@@ -165,6 +184,13 @@ class HilbertTransform:
 
         if isinstance (self.dos, DOSFromFunction):
 
+            # The adaptive integration of the function by the C++ kernel. All nodes compute the whole integral
+            if test_convergence and not(Sigma_fnt) and field is None and epsilon_hat is None and isinstance(Sigma.mesh, (MeshImFreq, MeshReFreq)):
+                f, x_min, x_max = self.dos.function, self.dos.x_min, self.dos.x_max
+                norm = dos_integral(f, x_min, x_max, test_convergence)
+                result << hilbert_transform(lambda e: f(e) / norm, x_min, x_max, Sigma, mu, eta, test_convergence)
+                return result
+
             if not(n_points_integral): # if not defined, use the defaults given at construction of the dos
                 n_points_integral=  len(self.dos.eps)
             else:
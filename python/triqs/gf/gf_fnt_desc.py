@@ -105,8 +105,8 @@ for Target in  ["scalar_valued", "matrix_valued", "tensor_valued<3>", "tensor_va
                 doc = """Fills self with the legendre transform of gt""")
 
     # set_from_pade
-    m.add_function("void set_from_pade (gf_view<refreq, matrix_valued> gw, gf_view<imfreq, matrix_valued> giw, int n_points = 100, double freq_offset = 0.0)",
-                calling_pattern = "pade(gw, giw, n_points, freq_offset)",
+    m.add_function("void set_from_pade (gf_view<refreq, matrix_valued> gw, gf_view<imfreq, matrix_valued> giw, int n_points = 100, double freq_offset = 0.0, int n_threads = 1)",
+                calling_pattern = "pade(gw, giw, n_points, freq_offset, n_threads)",
                 doc = """""")
 
 # rebinning_tau
@@ -27,6 +27,16 @@ r.add_constructor(signature = "(std::string name, int seed)",
                   seed Random number seed
                   """)
 
+r.add_constructor(signature = "(std::string name, int seed, int stream)",
+                  doc =
+                  """
+                  A random number generator with several independent streams (only for philox4x32).
+
+                  name Name of the random number generator
+                  seed Random number seed
+                  stream Stream number
+                  """)
+
 r.add_call(signature = "int(int N)", doc = """Generate an integer random number in [0,N-1]""") 
 r.add_call(signature = "double()", doc = """Generate a float random number in [0,1[""")
  
@@ -21,6 +21,7 @@
 
 from triqs.gf import *
 import triqs.utility.mpi as mpi
+from .sumk_tools import sumk
 from itertools import *
 import inspect
 import copy,numpy
@@ -70,7 +71,7 @@ class SumkDiscrete:
 
     #-------------------------------------------------------------
 
-    def __call__ (self, Sigma, mu=0, eta=0, field=None, epsilon_hat=None, result=None, selected_blocks=()):
+    def __call__ (self, Sigma, mu=0, eta=0, field=None, epsilon_hat=None, result=None, selected_blocks=(), n_threads=1):
         """
         - Computes:
            result <- \[ \sum_k (\omega + \mu - field - t(k) - Sigma(k,\omega)) \]
@@ -97,6 +98,8 @@ class SumkDiscrete:
                if selected_blocks ==None: 'up' and 'down' are calculated
                if selected_blocks == ['up']: only 'up' is calculated. 'down' is 0.
 
+        - n_threads: Number of threads on each node. When Sigma is a BlockGf on a Matsubara mesh,
+          and there is no field and no epsilon_hat, the sum is done in one pass by the C++ engine (sumk).
 
         """
 
@@ -130,6 +133,11 @@ class SumkDiscrete:
         assert self.bz_weights.shape[0] == self.n_kpts(), "Internal Error"
         no = list(set([g.target_shape[0] for i,g in G]))[0]
 
+        # Local Sigma in Matsubara frequencies : the C++ engine
+        if not Sigma_fnt and field is None and epsilon_hat is None and all(isinstance(g.mesh, MeshImFreq) for n, g in Sigma):
+            G << sumk(numpy.ascontiguousarray(self.hopping.transpose(1, 2, 0)), self.bz_weights, Sigma, mu, n_threads)
+            return G
+
         # Initialize
         G.zero()
         tmp,tmp2 = G.copy(),G.copy()
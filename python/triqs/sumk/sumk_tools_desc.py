@@ -0,0 +1,50 @@
+from cpp2py.wrap_generator import *
+
+# triqs.sumk.sumk_tools module
+module = module_(full_name = "triqs.sumk.sumk_tools",
+                 doc = "C++ engine of the lattice Dyson sums",
+                 app_name = "triqs")
+
+module.add_imports("triqs.gf")
+
+module.add_include("<triqs/lattice/sumk.hpp>")
+
+module.add_include("<triqs/cpp2py_converters.hpp>")
+
+module.add_using("namespace triqs::lattice")
+module.add_using("namespace triqs::arrays")
+module.add_using("namespace triqs::gfs")
+
+module.add_function("block_gf<imfreq> sumk(array_const_view<dcomplex, 3> eps_k, array_const_view<double, 1> weights, block_gf_view<imfreq> sigma, double mu, int n_threads = 1)",
+                    calling_pattern = "auto result = sumk(eps_k, weights, sigma, mu, n_threads)",
+                    doc = r"""
+    The lattice Dyson sum :math:`G_b(i\omega) = \sum_k w_k [i\omega + \mu - \epsilon(k) - \Sigma_b(i\omega)]^{-1}`
+
+    The k-points are distributed over the MPI nodes, and the frequencies over n_threads threads on each node.
+    The result is reduced over the nodes once, at the end.
+
+    Parameters
+    ----------
+    eps_k : array, complex
+        :math:`\epsilon(k)` as eps_k[a, b, k] (the layout of hopping_stack).
+    weights : array, float
+        The weights of the k-points.
+    sigma : BlockGf
+        The local self-energy, on a Matsubara mesh. The blocks must be of the size of :math:`\epsilon(k)`.
+    mu : float
+        The chemical potential.
+    n_threads : int
+        Number of threads on each node.
+
+    Returns
+    -------
+    G : BlockGf
+        The lattice sum, with the block structure of sigma, on all nodes.
+""")
+
+########################
+##   Code generation
+########################
+
+if __name__ == '__main__' :
+   module.generate_code()
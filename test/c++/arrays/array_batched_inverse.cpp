@@ -0,0 +1,77 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include "./array_test_common.hpp"
+
+// A batch of n_mat well conditioned matrices of size n
+template <typename T> array<T, 3> make_batch(long n_mat, long n) {
+  array<T, 3> a(n_mat, n, n);
+  for (long i = 0; i < n_mat; ++i)
+    for (long r = 0; r < n; ++r)
+      for (long c = 0; c < n; ++c) {
+        a(i, r, c) = std::sin(1 + i + 3 * r + 7 * c) + (r == c ? n + 0.1 * i : 0);
+        if constexpr (triqs::is_complex<T>::value) a(i, r, c) += std::complex<double>(0, std::cos(i + r * c));
+      }
+  return a;
+}
+
+// Compare to the inverse of each matrix
+template <typename T> void check(array<T, 3> const &a, array<T, 3> const &a_inv) {
+  for (long i = 0; i < first_dim(a); ++i) {
+    matrix<T> m = a(i, _, _);
+    EXPECT_ARRAY_NEAR(matrix<T>{a_inv(i, _, _)}, matrix<T>{inverse(m)}, 1.e-12);
+  }
+}
+
+template <typename T> void test_batched_inverse() {
+  for (long n = 1; n <= 6; ++n) {
+    for (int n_threads : {1, 3}) {
+      auto a   = make_batch<T>(21, n); // not a multiple of the number of lanes of the closed-form kernels
+      auto inv = a;
+      batched_inverse_in_place(inv, n_threads);
+      check(a, inv);
+
+      // non contiguous matrices
+      auto b     = array<T, 3>(21, n, 2 * n);
+      b()        = 0;
+      auto b_sl  = b(_, _, range(0, 2 * n, 2));
+      b_sl       = a;
+      batched_inverse_in_place(b_sl, n_threads);
+      check(a, array<T, 3>{b_sl});
+
+      // transposed matrices
+      auto c = array<T, 3>(a, make_memory_layout(0, 2, 1));
+      batched_inverse_in_place(c, n_threads);
+      check(a, array<T, 3>{c});
+    }
+  }
+}
+
+TEST(BatchedInverse, Double) { test_batched_inverse<double>(); }
+TEST(BatchedInverse, Complex) { test_batched_inverse<std::complex<double>>(); }
+
+TEST(BatchedInverse, Singular) {
+  for (long n : {2, 5}) {
+    auto a        = make_batch<double>(10, n);
+    a(7, _, _)    = 0;
+    EXPECT_THROW(batched_inverse_in_place(a), triqs::runtime_error);
+    EXPECT_THROW(batched_inverse_in_place(a, 4), triqs::runtime_error);
+  }
+  EXPECT_THROW(batched_inverse_in_place(array<double, 3>(2, 2, 3)), triqs::runtime_error);
+}
+
+MAKE_MAIN;
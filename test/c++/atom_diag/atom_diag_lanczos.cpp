@@ -0,0 +1,259 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Igor Krivenko, Nils Wentzell
+
+#include <triqs/test_tools/gfs.hpp>
+#include <triqs/atom_diag/atom_diag.hpp>
+#include <triqs/atom_diag/functions.hpp>
+#include <triqs/atom_diag/gf.hpp>
+#include <triqs/atom_diag/impl/lanczos.hpp>
+
+#include "./hamiltonian.hpp"
+
+using namespace triqs::arrays;
+using namespace triqs::hilbert_space;
+using namespace triqs::atom_diag;
+
+using atom_diag_real = triqs::atom_diag::atom_diag<false>;
+using atom_diag_cplx = triqs::atom_diag::atom_diag<true>;
+
+// A sparse hermitian matrix of dimension 2 n, made of two copies of the same block :
+// all its eigenvalues are twice degenerate
+template <typename T> csr_matrix<T> make_degenerate_matrix(int n, T t) {
+  csr_matrix<T> A;
+  T tc = lanczos_impl::conj_(t);
+  for (int copy = 0; copy < 2; ++copy)
+    for (int i = 0; i < n; ++i) {
+      auto add = [&](int j, T v) {
+        if (j < 0 or j >= n) return;
+        A.col.push_back(copy * n + j);
+        A.val.push_back(v);
+      };
+      add(i - 7, tc * 0.3);
+      add(i - 1, tc);
+      add(i, 3 * std::sin(i));
+      add(i + 1, t);
+      add(i + 7, t * 0.3);
+      A.end_row();
+    }
+  return A;
+}
+
+template <typename T> void check_lanczos(csr_matrix<T> const &A, int n_ev) {
+  auto [ev, U] = lanczos_lowest(A, n_ev, 4, 40, 1e-10, 1000);
+  auto dense   = A.to_dense();
+  auto ev_ref  = linalg::eigenvalues(dense);
+  ASSERT_EQ(ev.size(), n_ev);
+  for (int i = 0; i < n_ev; ++i) EXPECT_NEAR(ev(i), ev_ref(i), 1e-9);
+  // Orthonormal eigenvectors
+  EXPECT_ARRAY_NEAR(matrix<T>(dagger(U) * U), make_unit_matrix<T>(n_ev), 1e-10);
+  auto U_ev = U;
+  for (int i = 0; i < n_ev; ++i) U_ev(range(), i) *= ev(i);
+  EXPECT_ARRAY_NEAR(matrix<T>(dense * U), U_ev, 1e-8);
+}
+
+TEST(atom_diag, lanczos_lowest) { // NOLINT
+  check_lanczos(make_degenerate_matrix<double>(150, 1.0), 6);
+  check_lanczos(make_degenerate_matrix<std::complex<double>>(150, {0.6, 0.8}), 5);
+}
+
+// ----------------------------------------------------------------------
+
+// The spectrum of the Lanczos subspaces is the bottom of the full one
+template <typename AD> void check_truncated(AD const &ad, AD const &ad_ref, lanczos_params_t const &p, typename AD::many_body_op_t const &h) {
+  ASSERT_EQ(ad.n_subspaces(), ad_ref.n_subspaces());
+  EXPECT_NEAR(ad.get_gs_energy(), ad_ref.get_gs_energy(), 1e-10);
+  int n_truncated = 0;
+  for (int sp = 0; sp < ad.n_subspaces(); ++sp) {
+    int dim = ad_ref.get_subspace_dim(sp), n_kept = ad.get_subspace_dim(sp);
+    if (ad.get_fock_states()[sp].size() < p.min_dim) {
+      EXPECT_EQ(n_kept, dim);
+    } else {
+      // n_states among the n_states + block_size computed states, extended to the end of the last multiplet,
+      // or reduced to its start if it reaches the last computed state
+      auto E   = [&](int i) { return ad_ref.get_eigenvalue(sp, i); };
+      int m    = std::min(p.n_states + p.block_size, dim), n_lcz = std::min(p.n_states, m);
+      while (n_lcz < m and E(n_lcz) - E(n_lcz - 1) <= 1e-8) ++n_lcz;
+      if (n_lcz == m and m < dim) {
+        while (n_lcz > 0 and E(m - 1) - E(n_lcz - 1) <= 1e-8) --n_lcz;
+        if (n_lcz == 0) n_lcz = m;
+      }
+      int n = 1;
+      while (n < n_lcz and E(n) <= p.energy_window) ++n;
+      while (n < n_lcz and E(n) - E(n - 1) <= 1e-8) ++n;
+      EXPECT_EQ(n_kept, n);
+      n_truncated += (n_kept < dim);
+      if (n_kept < dim) EXPECT_GT(E(n_kept) - E(n_kept - 1), 1e-8); // no multiplet is split
+    }
+    for (int i = 0; i < n_kept; ++i) EXPECT_NEAR(ad.get_eigenvalue(sp, i), ad_ref.get_eigenvalue(sp, i), 1e-9);
+    EXPECT_EQ(second_dim(ad.get_unitary_matrices()[sp]), n_kept);
+  }
+  EXPECT_GT(n_truncated, 0);
+
+  // The c matrices are those of the kept eigenstates : gauge invariant check on the subspaces
+  // which are not truncated within a degenerate multiplet
+  auto clean_cut = [&](int sp) {
+    int n = ad.get_subspace_dim(sp);
+    return n == ad_ref.get_subspace_dim(sp) or ad_ref.get_eigenvalue(sp, n) - ad_ref.get_eigenvalue(sp, n - 1) > 1e-6;
+  };
+  for (int n = 0; n < ad.get_fops().size(); ++n)
+    for (int B = 0; B < ad.n_subspaces(); ++B) {
+      auto Bp = ad.c_connection(n, B);
+      ASSERT_EQ(Bp, ad_ref.c_connection(n, B));
+      if (Bp == -1 or !clean_cut(B) or !clean_cut(Bp)) continue;
+      auto const &c = ad.c_matrix(n, B);
+      auto c_ref    = ad_ref.c_matrix(n, B)(range(0, first_dim(c)), range(0, second_dim(c)));
+      EXPECT_NEAR(sum(abs2(c)), sum(abs2(c_ref)), 1e-10);
+    }
+
+  // The operators in the truncated eigenbasis : H is diagonal, and n_up_0 is the block of the kept states, up to a gauge
+  auto h_mat = ad.get_op_mat(h);
+  auto n_mat = ad.get_op_mat(n("up", 0)), n_mat_ref = ad_ref.get_op_mat(n("up", 0));
+  for (int sp = 0; sp < ad.n_subspaces(); ++sp) {
+    int n_kept  = ad.get_subspace_dim(sp);
+    auto h_diag = matrix<typename AD::scalar_t>(n_kept, n_kept);
+    h_diag()    = 0;
+    for (int i = 0; i < n_kept; ++i) h_diag(i, i) = ad.get_eigenvalue(sp, i) + ad.get_gs_energy();
+    if (h_mat.connection(sp) == -1) { // H vanishes on the subspace
+      EXPECT_NEAR(max_element(abs(h_diag)), 0, 1e-9);
+    } else {
+      EXPECT_EQ(h_mat.connection(sp), sp);
+      EXPECT_ARRAY_NEAR(h_mat.block_mat[sp], h_diag, 1e-9);
+    }
+
+    ASSERT_EQ(n_mat.connection(sp), n_mat_ref.connection(sp));
+    if (n_mat.connection(sp) == -1 or !clean_cut(sp)) continue;
+    auto const &m = n_mat.block_mat[sp];
+    auto m_ref    = n_mat_ref.block_mat[sp](range(0, n_kept), range(0, n_kept));
+    EXPECT_NEAR(std::abs(trace(m)), std::abs(trace(m_ref)), 1e-9);
+    EXPECT_NEAR(sum(abs2(m)), sum(abs2(m_ref)), 1e-9);
+  }
+
+  // Consistent vacuum and partition function
+  EXPECT_EQ(ad.get_vacuum_state().size(), ad.index_range_of_subspace(ad.n_subspaces() - 1).last());
+  EXPECT_NEAR(partition_function(ad, 100), partition_function(ad_ref, 100), 1e-10);
+
+  // An expectation value of a product of operators, whose intermediate states are not all kept
+  typename AD::many_body_op_t nn = n("up", 0) * n("dn", 0);
+  auto nn_val = trace_rho_op(atomic_density_matrix(ad, 100), nn, ad), nn_ref = trace_rho_op(atomic_density_matrix(ad_ref, 100), nn, ad_ref);
+  EXPECT_NEAR(std::abs(nn_val - nn_ref), 0, 1e-9);
+}
+
+TEST(atom_diag, lanczos_real) { // NOLINT
+  auto fops = make_fops();
+  auto h    = make_hamiltonian<many_body_operator_real>(0.7, 3.0, 0.3, 0.03, -0.1);
+
+  auto N = many_body_operator_real{};
+  for (int o : range(3)) N += n("up", o) + n("dn", o);
+  auto qn = std::vector<many_body_operator_real>{N};
+
+  auto p          = lanczos_params_t{};
+  p.min_dim       = 15;
+  p.n_states      = 4;
+  p.block_size    = 2;
+  p.krylov_dim    = 10;
+  p.energy_window = 5.5;
+  check_truncated(atom_diag_real(h, fops, qn, 1, p), atom_diag_real(h, fops, qn), p, h);
+}
+
+TEST(atom_diag, lanczos_complex) { // NOLINT
+  auto fops = make_fops();
+  auto h    = make_hamiltonian<many_body_operator_complex>(0.7, 3.0, 0.3, 0.03, -0.1 + 0.2i);
+
+  auto N = many_body_operator_complex{};
+  for (int o : range(3)) N += n("up", o) + n("dn", o);
+  auto qn = std::vector<many_body_operator_complex>{N};
+
+  auto p       = lanczos_params_t{};
+  p.min_dim    = 15;
+  p.n_states   = 3;
+  p.krylov_dim = 10;
+  check_truncated(atom_diag_cplx(h, fops, qn, 2, p), atom_diag_cplx(h, fops, qn), p, h);
+}
+
+// ----------------------------------------------------------------------
+
+// The Lehmann representation of G of the truncated spectrum has the poles and weights of the kept states.
+// The parameters are such that no degenerate multiplet is cut, so that the sums of the residues on each pole
+// do not depend on the basis of the multiplets.
+TEST(atom_diag, lanczos_gf) { // NOLINT
+  auto fops = make_fops();
+  auto h    = make_hamiltonian<many_body_operator_real>(0.7, 3.0, 0.3, 0.03, -0.1);
+
+  auto N = many_body_operator_real{};
+  for (int o : range(3)) N += n("up", o) + n("dn", o);
+  auto qn = std::vector<many_body_operator_real>{N};
+
+  auto p          = lanczos_params_t{};
+  p.min_dim       = 15;
+  p.n_states      = 6;
+  p.block_size    = 2;
+  p.krylov_dim    = 10;
+  p.energy_window = 5.5;
+  auto ad         = atom_diag_real(h, fops, qn, 1, p);
+  auto ad_ref     = atom_diag_real(h, fops, qn);
+
+  // The reference excludes the states which are not kept. At this beta, their Boltzmann weights are negligible.
+  double beta = 30;
+  excluded_states_t excluded;
+  int n_truncated = 0;
+  for (int sp = 0; sp < ad.n_subspaces(); ++sp) {
+    int n_kept = ad.get_subspace_dim(sp), dim = ad_ref.get_subspace_dim(sp);
+    if (n_kept < dim) {
+      ++n_truncated;
+      ASSERT_TRUE(ad_ref.get_eigenvalue(sp, n_kept) - ad_ref.get_eigenvalue(sp, n_kept - 1) > 1e-6);
+    }
+    for (int i = n_kept; i < dim; ++i) excluded.emplace_back(sp, i);
+  }
+  EXPECT_GT(n_truncated, 0);
+
+  auto gf_struct = gf_struct_t{{"up", {0, 1, 2}}, {"dn", {0, 1, 2}}};
+  auto g         = atomic_g_lehmann(ad, beta, gf_struct);
+  auto g_ref     = atomic_g_lehmann(ad_ref, beta, gf_struct, excluded);
+
+  // The poles, merged within 1e-8, with the sum of their residues
+  auto merged = [](auto terms) {
+    std::sort(terms.begin(), terms.end(), [](auto const &x, auto const &y) { return x.first < y.first; });
+    std::vector<std::pair<double, double>> r;
+    for (auto const &[pole, residue] : terms) {
+      if (r.empty() or pole - r.back().first > 1e-8)
+        r.emplace_back(pole, residue);
+      else
+        r.back().second += residue;
+    }
+    r.erase(std::remove_if(r.begin(), r.end(), [](auto const &x) { return std::abs(x.second) < 1e-12; }), r.end());
+    return r;
+  };
+
+  for (int bl = 0; bl < gf_struct.size(); ++bl)
+    for (int i = 0; i < 3; ++i)
+      for (int j = 0; j < 3; ++j) {
+        auto terms = merged(g[bl](i, j)), terms_ref = merged(g_ref[bl](i, j));
+        ASSERT_EQ(terms.size(), terms_ref.size());
+        for (int k = 0; k < terms.size(); ++k) {
+          EXPECT_NEAR(terms[k].first, terms_ref[k].first, 1e-8);
+          EXPECT_NEAR(terms[k].second, terms_ref[k].second, 1e-8);
+        }
+      }
+
+  // Hence the same G(tau)
+  auto mesh    = gf_mesh<imtime>{beta, Fermion, 201};
+  auto g_tau   = atomic_g_tau<false>(g, gf_struct, mesh);
+  auto g_tau_r = atomic_g_tau<false>(g_ref, gf_struct, mesh);
+  for (int bl = 0; bl < gf_struct.size(); ++bl) EXPECT_GF_NEAR(g_tau[bl], g_tau_r[bl], 1e-8);
+}
+
+MAKE_MAIN;
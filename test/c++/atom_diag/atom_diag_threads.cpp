@@ -0,0 +1,64 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Igor Krivenko, Nils Wentzell
+
+#include <triqs/test_tools/gfs.hpp>
+#include <triqs/atom_diag/atom_diag.hpp>
+
+#include "./hamiltonian.hpp"
+
+using namespace triqs::arrays;
+using namespace triqs::hilbert_space;
+
+using atom_diag_real = triqs::atom_diag::atom_diag<false>;
+using atom_diag_cplx = triqs::atom_diag::atom_diag<true>;
+
+// The atom_diag constructed with several threads is the one constructed with one thread
+template <typename AD> void check_same(AD const &ad1, AD const &ad2) {
+  ASSERT_EQ(ad1.n_subspaces(), ad2.n_subspaces());
+  EXPECT_EQ(ad1.get_fock_states(), ad2.get_fock_states());
+  EXPECT_EQ(ad1.get_gs_energy(), ad2.get_gs_energy());
+  EXPECT_EQ(ad1.get_energies(), ad2.get_energies());
+  for (int sp = 0; sp < ad1.n_subspaces(); ++sp) EXPECT_ARRAY_NEAR(ad1.get_unitary_matrices()[sp], ad2.get_unitary_matrices()[sp], 1e-14);
+  for (int n = 0; n < ad1.get_fops().size(); ++n)
+    for (int sp = 0; sp < ad1.n_subspaces(); ++sp) {
+      EXPECT_EQ(ad1.c_connection(n, sp), ad2.c_connection(n, sp));
+      EXPECT_EQ(ad1.cdag_connection(n, sp), ad2.cdag_connection(n, sp));
+      if (ad1.c_connection(n, sp) != -1) EXPECT_ARRAY_NEAR(ad1.c_matrix(n, sp), ad2.c_matrix(n, sp), 1e-14);
+      if (ad1.cdag_connection(n, sp) != -1) EXPECT_ARRAY_NEAR(ad1.cdag_matrix(n, sp), ad2.cdag_matrix(n, sp), 1e-14);
+    }
+}
+
+TEST(atom_diag, threads_real) { // NOLINT
+  auto fops = make_fops();
+  auto h    = make_hamiltonian<many_body_operator_real>(0.7, 3.0, 0.3, 0.03, -0.1);
+
+  check_same(atom_diag_real(h, fops), atom_diag_real(h, fops, 4));
+
+  auto N = many_body_operator_real{};
+  for (int o : range(3)) N += n("up", o) + n("dn", o);
+  auto qn = std::vector<many_body_operator_real>{N};
+  check_same(atom_diag_real(h, fops, qn), atom_diag_real(h, fops, qn, 3));
+}
+
+TEST(atom_diag, threads_complex) { // NOLINT
+  auto fops = make_fops();
+  auto h    = make_hamiltonian<many_body_operator_complex>(0.7, 3.0, 0.3, 0.03, -0.1 + 0.2i);
+
+  check_same(atom_diag_cplx(h, fops), atom_diag_cplx(h, fops, 2));
+}
+
+MAKE_MAIN;
@@ -0,0 +1,99 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/det_manip/det_manip.hpp>
+#include <random>
+
+struct fun {
+
+  using result_type   = double;
+  using argument_type = double;
+
+  double operator()(double x, double y) const { return std::exp(-std::abs(x - y)); }
+};
+
+using d_t = triqs::det_manip::det_manip<fun>;
+
+// Random change_col/change_row : x_i, y_i stay close to 1.5 * i, so the matrix stays well conditioned
+void run(d_t &d, int n_moves) {
+  std::mt19937 gen(1234);
+  std::uniform_real_distribution<> dis(-0.3, 0.3);
+  auto rng = [&gen](int n) { return std::uniform_int_distribution<>(0, n - 1)(gen); };
+  for (int n = 0; n < n_moves; ++n) {
+    int i = rng(d.size());
+    if (rng(2))
+      d.change_col(i, 1.5 * i + dis(gen));
+    else
+      d.change_row(i, 1.5 * i + dis(gen));
+  }
+}
+
+TEST(DetManip, AdaptiveCheck) {
+  std::vector<double> X, Y;
+  for (int i = 0; i < 30; ++i) {
+    X.push_back(1.5 * i);
+    Y.push_back(1.5 * i);
+  }
+
+  d_t d_fixed{fun{}, X, Y}, d{fun{}, X, Y};
+  d.set_adaptive_check(true);
+  EXPECT_TRUE(d.get_adaptive_check());
+
+  run(d_fixed, 5000);
+  run(d, 5000);
+
+  // the fixed policy regenerates after every 100 operations, the adaptive one only if the inverse has drifted
+  EXPECT_EQ(d_fixed.get_n_regenerations(), 5000 / 101);
+  EXPECT_EQ(d_fixed.get_n_residual_checks(), 0);
+  EXPECT_LT(d.get_n_regenerations(), 5);
+  EXPECT_GT(d.get_n_residual_checks(), 0);
+  // the period of the adaptive check is bounded by the setting, which is not changed
+  EXPECT_GE(d.get_n_residual_checks(), 5000 / 101);
+  EXPECT_EQ(d.get_n_operations_before_check(), 100);
+  EXPECT_GE(d.get_regeneration_time(), 0);
+
+  EXPECT_ARRAY_NEAR(d.inverse_matrix(), make_matrix(inverse(d.matrix())), 1.e-10);
+  EXPECT_NEAR(d.determinant(), triqs::arrays::determinant(d.matrix()), 1.e-10 * std::abs(d.determinant()));
+
+  // explicit regenerations are counted
+  auto n = d.get_n_regenerations();
+  d.regenerate();
+  EXPECT_EQ(d.get_n_regenerations(), n + 1);
+
+  // with an unreachable precision, the first residual check triggers a regeneration,
+  // then the residual is compared to its value just after the regeneration
+  d_t d2{fun{}, X, Y};
+  d2.set_adaptive_check(true);
+  d2.set_precision_warning(1.e-30);
+  run(d2, 1000);
+  EXPECT_GE(d2.get_n_regenerations(), 1);
+  EXPECT_LT(d2.get_n_regenerations(), d2.get_n_residual_checks());
+  EXPECT_ARRAY_NEAR(d2.inverse_matrix(), make_matrix(inverse(d2.matrix())), 1.e-10);
+  EXPECT_EQ(d2.get_n_operations_before_check(), 100);
+
+  // a longer period set by the user
+  d_t d3{fun{}, X, Y};
+  d3.set_adaptive_check(true);
+  d3.set_n_operations_before_check(1000);
+  run(d3, 5000);
+  EXPECT_EQ(d3.get_n_residual_checks(), 5000 / 1001);
+  EXPECT_EQ(d3.get_n_regenerations(), 0);
+  EXPECT_EQ(d3.get_n_operations_before_check(), 1000);
+}
+
+MAKE_MAIN;
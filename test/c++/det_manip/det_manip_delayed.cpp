@@ -0,0 +1,139 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/det_manip/det_manip.hpp>
+#include <random>
+
+struct fun {
+
+  using result_type   = double;
+  using argument_type = double;
+
+  double operator()(double x, double y) const {
+    const double pi   = acos(-1);
+    const double beta = 10.0;
+    const double epsi = 0.1;
+    double tau        = x - y;
+    bool s            = (tau > 0);
+    tau               = (s ? tau : beta + tau);
+    double r          = epsi + tau / beta * (1 - 2 * epsi);
+    return -2 * (pi / beta) / std::sin(pi * r);
+  }
+};
+
+using d_t              = triqs::det_manip::det_manip<fun>;
+const double precision = 1.e-8;
+
+// Run the same random sequence of operations on a det_manip with and without delayed updates
+void run_and_compare(int n_delayed) {
+
+  d_t d{fun{}, 10}, d_ref{fun{}, 10};
+  d.set_n_delayed_updates(n_delayed);
+  d.set_n_operations_before_check(1000000);
+  d_ref.set_n_operations_before_check(1000000);
+
+  std::mt19937 gen(23432);
+  std::uniform_real_distribution<> dis(0.0, 10.0);
+  auto rng = [&gen](int n) { return std::uniform_int_distribution<>(0, n - 1)(gen); };
+
+  for (int n = 0; n < 2000; ++n) {
+    long s = d.size();
+    double r = 0, r_ref = 0;
+    int op = (s < 10 ? 0 : rng(7));
+    if (s < 2 and (op == 1 or op == 3)) op = 0;
+    switch (op) {
+      case 0: {
+        auto x = dis(gen), y = dis(gen);
+        auto i = rng(s + 1), j = rng(s + 1);
+        r     = d.try_insert(i, j, x, y);
+        r_ref = d_ref.try_insert(i, j, x, y);
+      } break;
+      case 1: {
+        auto i = rng(s), j = rng(s);
+        r     = d.try_remove(i, j);
+        r_ref = d_ref.try_remove(i, j);
+      } break;
+      case 2: {
+        auto x0 = dis(gen), x1 = dis(gen), y0 = dis(gen), y1 = dis(gen);
+        auto i0 = rng(s + 1), j0 = rng(s + 1), i1 = rng(s + 2), j1 = rng(s + 2);
+        if (i0 == i1 or j0 == j1) continue;
+        r     = d.try_insert2(i0, i1, j0, j1, x0, x1, y0, y1);
+        r_ref = d_ref.try_insert2(i0, i1, j0, j1, x0, x1, y0, y1);
+      } break;
+      case 3: {
+        auto i0 = rng(s), j0 = rng(s), i1 = rng(s), j1 = rng(s);
+        if (i0 == i1 or j0 == j1) continue;
+        r     = d.try_remove2(i0, i1, j0, j1);
+        r_ref = d_ref.try_remove2(i0, i1, j0, j1);
+      } break;
+      case 4: {
+        auto j = rng(s);
+        auto y = dis(gen);
+        r      = d.try_change_col(j, y);
+        r_ref  = d_ref.try_change_col(j, y);
+      } break;
+      case 5: {
+        auto i = rng(s);
+        auto x = dis(gen);
+        r      = d.try_change_row(i, x);
+        r_ref  = d_ref.try_change_row(i, x);
+      } break;
+      case 6: {
+        auto i = rng(s), j = rng(s);
+        auto x = dis(gen), y = dis(gen);
+        r      = d.try_change_col_row(i, j, x, y);
+        r_ref  = d_ref.try_change_col_row(i, j, x, y);
+      } break;
+    }
+    EXPECT_NEAR(r, r_ref, precision * std::max(1.0, std::abs(r_ref)));
+    if (std::abs(r * d_ref.determinant()) > 1.e-3 and rng(3) > 0) {
+      d.complete_operation();
+      d_ref.complete_operation();
+    } else {
+      d.reject_last_try();
+      d_ref.reject_last_try();
+    }
+    EXPECT_NEAR(d.determinant(), d_ref.determinant(), precision * std::abs(d_ref.determinant()));
+  }
+
+  ASSERT_EQ(d.size(), d_ref.size());
+  EXPECT_ARRAY_NEAR(d.inverse_matrix(), d_ref.inverse_matrix(), precision);
+  EXPECT_ARRAY_NEAR(d.inverse_matrix(), make_matrix(inverse(d.matrix())), precision);
+}
+
+TEST(DetManip, DelayedUpdates) {
+  for (int n_delayed : {2, 3, 8, 32}) run_and_compare(n_delayed);
+}
+
+TEST(DetManip, DelayedUpdatesFlush) {
+  std::vector<double> X{1.0, 2.1, 3.2, 4.3}, Y{0.5, 1.6, 2.7, 3.8};
+  d_t d{fun{}, X, Y};
+  d.set_n_delayed_updates(16);
+  d.change_col(1, 2.0);
+  d.change_row(2, 3.5);
+  d.insert(1, 3, 0.7, 4.1);
+  d.remove(0, 2);
+
+  // element access works on the pending updates, the full matrix is materialized
+  auto minv = d.inverse_matrix();
+  EXPECT_ARRAY_NEAR(minv, make_matrix(inverse(d.matrix())), precision);
+  d.flush_delayed_updates();
+  EXPECT_ARRAY_NEAR(d.inverse_matrix(), minv, precision);
+}
+
+MAKE_MAIN;
@@ -0,0 +1,106 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/det_manip/det_manip.hpp>
+
+// A well conditioned matrix (for x_i ~ y_i), times a scale which makes the det out of the range of double at moderate N
+struct fun {
+
+  using result_type   = double;
+  using argument_type = double;
+
+  double scale;
+
+  double operator()(double x, double y) const { return scale * std::exp(-std::abs(x - y)); }
+};
+
+using d_t = triqs::det_manip::det_manip<fun>;
+
+// log|det| and the sign computed from scratch, with the scale factored out
+std::pair<double, double> exact_log_det(d_t const &d, double scale) {
+  auto m         = make_matrix(d.matrix() / scale);
+  double det     = triqs::arrays::determinant(m);
+  double log_det = std::log(std::abs(det)) + d.size() * std::log(scale);
+  return {(det > 0 ? 1.0 : -1.0), log_det};
+}
+
+void check_log_det(double scale) {
+  d_t d{fun{scale}, 100};
+  // disable the periodic check : it is not affected by the scale
+  d.set_n_operations_before_check(1000000);
+
+  for (int i = 0; i < 40; ++i) d.insert(i % 3, i % 3, 1.3 * i, 1.3 * i);
+  d.change_col(3, d.get_y(3) + 0.2);
+  d.change_row(3, d.get_x(3) + 0.1);
+  d.change_one_row_and_one_col(7, 7, 100.0, 100.3);
+  d.remove(2, 2);
+  d.insert2(0, 1, 0, 1, 200.0, 201.5, 200.0, 201.5);
+  d.remove2(4, 5, 4, 5);
+
+  auto [s, l]         = d.log_determinant();
+  auto [s_ref, l_ref] = exact_log_det(d, scale);
+  EXPECT_EQ(s, s_ref);
+  EXPECT_NEAR(l, l_ref, 1.e-10 * std::abs(l_ref));
+
+  // the det itself is out of range, but it is not considered singular : no regeneration needed
+  EXPECT_NO_THROW(d.determinant());
+  EXPECT_ARRAY_NEAR(make_matrix(d.inverse_matrix() * scale), make_matrix(inverse(make_matrix(d.matrix() / scale))), 1.e-10);
+
+  // the regeneration gives the same log
+  d.regenerate();
+  auto [s2, l2] = d.log_determinant();
+  EXPECT_EQ(s2, s_ref);
+  EXPECT_NEAR(l2, l_ref, 1.e-10 * std::abs(l_ref));
+}
+
+TEST(DetManip, LogDetUnderflow) { check_log_det(1.e-20); }
+
+TEST(DetManip, LogDetOverflow) { check_log_det(1.e+20); }
+
+TEST(DetManip, LogDetBackInRange) {
+  // the det underflows, then comes back in the range of double : its value is recovered from the log
+  d_t d{fun{1.e-20}, 100};
+  for (int i = 0; i < 20; ++i) d.insert_at_end(1.3 * i, 1.3 * i);
+  for (int i = 0; i < 18; ++i) d.remove_at_end();
+  auto m = d.matrix();
+  EXPECT_NEAR(d.determinant(), triqs::arrays::determinant(m), 1.e-10 * std::abs(triqs::arrays::determinant(m)));
+}
+
+TEST(DetManip, LogDetH5) {
+  // the det underflows : the phase and the log of the det are restored from the file, not from the det
+  d_t d{fun{1.e-20}, 100};
+  for (int i = 0; i < 30; ++i) d.insert_at_end(1.3 * i, 1.3 * i);
+  {
+    h5::file file("det_manip_log_det.h5", 'w');
+    h5_write(file, "d", d);
+  }
+  d_t d2{fun{1.e-20}, 1};
+  {
+    h5::file file("det_manip_log_det.h5", 'r');
+    h5_read(file, "d", d2);
+  }
+  auto [s, l]   = d.log_determinant();
+  auto [s2, l2] = d2.log_determinant();
+  EXPECT_EQ(s2, s);
+  EXPECT_NEAR(l2, l, 1.e-12 * std::abs(l));
+  // the restored det is not singular, so it is not regenerated
+  EXPECT_EQ(d2.get_n_regenerations(), 0);
+  EXPECT_ARRAY_NEAR(make_matrix(d2.inverse_matrix() * 1.e-20), make_matrix(d.inverse_matrix() * 1.e-20), 1.e-12);
+}
+
+MAKE_MAIN;
@@ -0,0 +1,148 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/det_manip/det_manip.hpp>
+#include <random>
+#include <thread>
+
+struct fun {
+
+  using result_type   = double;
+  using argument_type = double;
+
+  double operator()(double x, double y) const {
+    const double pi   = acos(-1);
+    const double beta = 10.0;
+    const double epsi = 0.1;
+    double tau        = x - y;
+    bool s            = (tau > 0);
+    tau               = (s ? tau : beta + tau);
+    double r          = epsi + tau / beta * (1 - 2 * epsi);
+    return -2 * (pi / beta) / std::sin(pi * r);
+  }
+};
+
+using d_t              = triqs::det_manip::det_manip<fun>;
+const double precision = 1.e-6; // the random matrices are not so well conditioned
+
+// The const accessors, with pending updates, do not modify d : they can be called from several threads
+void check_const_access(d_t const &d, double prec) {
+  triqs::arrays::matrix<double> m1, m2;
+  std::thread t([&] { m1 = d.inverse_matrix(); });
+  m2 = d.inverse_matrix();
+  t.join();
+  EXPECT_ARRAY_EQ(m1, m2);
+  for (int i = 0; i < d.size(); ++i)
+    for (int j = 0; j < d.size(); ++j) EXPECT_NEAR(d.inverse_matrix(i, j), m1(i, j), prec);
+  double s = 0, s_ref = 0;
+  foreach (d, [&s](double, double, double m) { s += m; })
+    ;
+  for (int i = 0; i < d.size(); ++i)
+    for (int j = 0; j < d.size(); ++j) s_ref += m1(i, j);
+  EXPECT_NEAR(s, s_ref, prec * d.size() * d.size());
+  auto m_int = d.inverse_matrix_internal_order(); // a copy with the pending updates applied
+  for (int i = 0; i < d.size(); ++i)
+    for (int j = 0; j < d.size(); ++j) EXPECT_NEAR(m_int(i, j), d.inverse_matrix_internal_order(i, j), prec);
+}
+
+// Sweeps of change_col/change_row/change_col_row with the submatrix updates, compared to the usual updates
+void run_sweeps_and_compare(int n_sweep, int n_delayed) {
+
+  std::mt19937 gen(2345);
+  std::uniform_real_distribution<> dis(0.0, 10.0);
+  auto rng = [&gen](int n) { return std::uniform_int_distribution<>(0, n - 1)(gen); };
+
+  std::vector<double> X, Y;
+  for (int i = 0; i < 10; ++i) {
+    X.push_back(dis(gen));
+    Y.push_back(dis(gen));
+  }
+  d_t d{fun{}, X, Y}, d_ref{fun{}, X, Y};
+  d.set_n_sweep_updates(n_sweep);
+  d.set_n_delayed_updates(n_delayed);
+  d.set_n_operations_before_check(1000000);
+  d_ref.set_n_operations_before_check(1000000);
+
+  for (int sweep = 0; sweep < 6; ++sweep) {
+    d.begin_sweep();
+    EXPECT_TRUE(d.in_sweep());
+    // sweep 0, 3 : only columns, 1, 4 : only rows, 2, 5 : mixed, with some insertions/removals
+    for (int n = 0; n < 100; ++n) {
+      long s   = d.size();
+      double r = 0, r_ref = 0;
+      int op   = (sweep % 3 == 2 ? rng(5) : sweep % 3);
+      switch (op) {
+        case 0: {
+          auto j = rng(s);
+          auto y = dis(gen);
+          r      = d.try_change_col(j, y);
+          r_ref  = d_ref.try_change_col(j, y);
+        } break;
+        case 1: {
+          auto i = rng(s);
+          auto x = dis(gen);
+          r      = d.try_change_row(i, x);
+          r_ref  = d_ref.try_change_row(i, x);
+        } break;
+        case 2: {
+          auto i = rng(s), j = rng(s);
+          auto x = dis(gen), y = dis(gen);
+          r      = d.try_change_col_row(i, j, x, y);
+          r_ref  = d_ref.try_change_col_row(i, j, x, y);
+        } break;
+        case 3: {
+          auto x = dis(gen), y = dis(gen);
+          auto i = rng(s + 1), j = rng(s + 1);
+          r     = d.try_insert(i, j, x, y);
+          r_ref = d_ref.try_insert(i, j, x, y);
+        } break;
+        case 4: {
+          auto i = rng(s), j = rng(s);
+          r     = d.try_remove(i, j);
+          r_ref = d_ref.try_remove(i, j);
+        } break;
+      }
+      EXPECT_NEAR(r, r_ref, precision * std::max(1.0, std::abs(r_ref)));
+      if (std::abs(r) > 0.1 and rng(3) > 0) {
+        d.complete_operation();
+        d_ref.complete_operation();
+      } else {
+        d.reject_last_try();
+        d_ref.reject_last_try();
+      }
+      EXPECT_NEAR(d.determinant(), d_ref.determinant(), precision * std::abs(d_ref.determinant()));
+    }
+    // element access in the middle of a sweep
+    ASSERT_EQ(d.size(), d_ref.size());
+    auto minv = make_matrix(inverse(d.matrix()));
+    auto prec = precision * max_element(abs(minv));
+    EXPECT_ARRAY_NEAR(d.inverse_matrix(), d_ref.inverse_matrix(), prec);
+    check_const_access(d, prec);
+    d.end_sweep();
+    EXPECT_FALSE(d.in_sweep());
+    EXPECT_ARRAY_NEAR(d.inverse_matrix(), minv, prec);
+  }
+}
+
+TEST(DetManip, SweepUpdates) {
+  for (int n_sweep : {1, 4, 32}) run_sweeps_and_compare(n_sweep, 0);
+}
+
+TEST(DetManip, SweepUpdatesWithDelayed) { run_sweeps_and_compare(8, 8); }
+
+MAKE_MAIN;
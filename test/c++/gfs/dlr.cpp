@@ -0,0 +1,134 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include <triqs/test_tools/gfs.hpp>
+
+// A few poles, in [-1, 1], with matrix weights
+std::vector<double> E = {-0.8, -0.1, 0.25, 0.95};
+matrix<dcomplex> mat(dcomplex a, dcomplex b, dcomplex c, dcomplex d) { return {{a, b}, {c, d}}; }
+std::vector<matrix<dcomplex>> A = {mat(1, 0.5, 0.5, 1), mat(0.5, 0, 0, 2), mat(1, -0.5i, 0.5i, 1), mat(0.25, 0, 0, 0.1)};
+
+// exact G, with the DLR kernels
+matrix<dcomplex> g_tau(double tau, double beta) {
+  matrix<dcomplex> r = {{0, 0}, {0, 0}};
+  for (int p = 0; p < E.size(); ++p) r += A[p] * dlr_basis::k_tau(tau / beta, beta * E[p]);
+  return r;
+}
+matrix<dcomplex> g_iw(long n, double beta, statistic_enum s) {
+  matrix<dcomplex> r = {{0, 0}, {0, 0}};
+  for (int p = 0; p < E.size(); ++p) r += A[p] * beta * dlr_basis::k_iw(n, beta * E[p], s);
+  return r;
+}
+
+void test_round_trip(statistic_enum s) {
+  double beta = 100, lambda = 200, eps = 1.e-10;
+
+  // From the sampling Matsubara frequencies
+  auto g_dlr_iw = gf<dlr_imfreq, matrix_valued>{{beta, s, lambda, eps}, {2, 2}};
+  for (auto const &k : g_dlr_iw.mesh()) g_dlr_iw[k] = g_iw(g_dlr_iw.mesh().matsubara_index(k.index()), beta, s);
+  auto gc = make_gf_dlr(g_dlr_iw);
+
+  // The rank of the basis is small
+  long r = gc.mesh().size();
+  EXPECT_LT(r, 60);
+  EXPECT_GT(r, 4);
+
+  // ... and back to regular meshes
+  auto gt = make_gf_imtime(gc, 2001);
+  for (auto const &t : gt.mesh()) EXPECT_ARRAY_NEAR(matrix<dcomplex>(gt[t]), g_tau(t, beta), 1.e-8);
+  auto gw = make_gf_imfreq(gc, 2000);
+  for (auto const &w : gw.mesh()) EXPECT_ARRAY_NEAR(matrix<dcomplex>(gw[w]), g_iw(w.n, beta, s), 1.e-8);
+
+  // From the sampling points in imaginary time
+  auto g_dlr_tau = gf<dlr_imtime, matrix_valued>{gc.mesh().domain(), {2, 2}};
+  for (auto const &k : g_dlr_tau.mesh()) g_dlr_tau[k] = g_tau(g_dlr_tau.mesh().tau(k.index()), beta);
+  auto gc2 = make_gf_dlr(g_dlr_tau);
+  EXPECT_GF_NEAR(make_gf_imfreq(gc2, 2000), gw, 1.e-8);
+  EXPECT_GF_NEAR(make_gf_dlr_imtime(gc), g_dlr_tau, 1.e-8);
+  EXPECT_GF_NEAR(make_gf_dlr_imfreq(gc2), g_dlr_iw, 1.e-8);
+
+  // Least square fit on regular meshes
+  EXPECT_GF_NEAR(make_gf_imfreq(fit_gf_dlr(gt, lambda, eps), 2000), gw, 1.e-8);
+  EXPECT_GF_NEAR(make_gf_imtime(fit_gf_dlr(gw, lambda, eps), 2001), gt, 1.e-8);
+}
+
+TEST(Dlr, Fermion) { test_round_trip(Fermion); }
+TEST(Dlr, Boson) { test_round_trip(Boson); }
+
+// ----------------------------------------------------------------------
+
+TEST(Dlr, RealScalar) {
+  double beta = 20, lambda = 40, eps = 1.e-12;
+  auto gt     = gf<imtime, scalar_valued>{{beta, Fermion, 501}, {}};
+  for (auto const &t : gt.mesh()) gt[t] = dlr_basis::k_tau(t / beta, beta * 0.5) + 0.5 * dlr_basis::k_tau(t / beta, -beta * 1.5);
+  auto gt_real = real(gt);
+
+  auto gc = fit_gf_dlr(gt_real, lambda, eps);
+  EXPECT_GF_NEAR(make_gf_imtime(gc, 501), gt_real, 1.e-10);
+  EXPECT_GF_NEAR(make_gf_imtime(make_gf_dlr(make_gf_dlr_imtime(gc)), 501), gt_real, 1.e-10);
+}
+
+// ----------------------------------------------------------------------
+
+TEST(Dlr, Mesh) {
+  auto m1 = gf_mesh<dlr>{10, Fermion, 100, 1.e-8};
+  auto m2 = gf_mesh<dlr_imtime>{10, Fermion, 100, 1.e-8};
+  auto m3 = gf_mesh<dlr_imfreq>{10, Fermion, 100, 1.e-10};
+  EXPECT_EQ(m1.size(), m2.size());
+  EXPECT_TRUE(m1.domain() == m2.domain());
+  EXPECT_FALSE(m1.domain() == m3.domain());
+  EXPECT_GT(m3.size(), m1.size());
+
+  // The basis is shared
+  EXPECT_EQ(m1.domain().basis.get(), m2.domain().basis.get());
+
+  // The sampling points are sorted and within bounds
+  for (long k = 1; k < m2.size(); ++k) EXPECT_LT(m2.tau(k - 1), m2.tau(k));
+  EXPECT_GE(m2.tau(0), 0);
+  EXPECT_LE(m2.tau(m2.size() - 1), 10);
+  for (long l = 0; l < m1.size(); ++l) EXPECT_LE(std::abs(m1.omega(l)), 10);
+
+  EXPECT_THROW((gf_mesh<dlr>{10, Fermion, -1, 1.e-8}), triqs::runtime_error);
+  EXPECT_THROW(fit_gf_dlr(gf<imtime, scalar_valued>{{10, Fermion, 5}, {}}, 100, 1.e-8), triqs::runtime_error);
+}
+
+// ----------------------------------------------------------------------
+
+TEST(Dlr, H5) {
+  double beta = 50, lambda = 100, eps = 1.e-10;
+  auto g_dlr_iw = gf<dlr_imfreq, matrix_valued>{{beta, Fermion, lambda, eps}, {2, 2}};
+  for (auto const &k : g_dlr_iw.mesh()) g_dlr_iw[k] = g_iw(g_dlr_iw.mesh().matsubara_index(k.index()), beta, Fermion);
+  auto gc = make_gf_dlr(g_dlr_iw);
+
+  // The mesh is rebuilt from its domain, with the same basis
+  auto gc2 = rw_h5(gc, "dlr", "gc");
+  EXPECT_TRUE(gc2.mesh() == gc.mesh());
+  for (long l = 0; l < gc.mesh().size(); ++l) EXPECT_EQ(gc2.mesh().omega(l), gc.mesh().omega(l));
+  EXPECT_GF_NEAR(gc, gc2, 1.e-15);
+  EXPECT_GF_NEAR(make_gf_imtime(gc2, 501), make_gf_imtime(gc, 501), 1.e-14);
+
+  auto gt  = make_gf_dlr_imtime(gc);
+  auto gt2 = rw_h5(gt, "dlr_imtime", "gt");
+  EXPECT_TRUE(gt2.mesh() == gt.mesh());
+  EXPECT_GF_NEAR(gt, gt2, 1.e-15);
+
+  auto gw2 = rw_h5(g_dlr_iw, "dlr_imfreq", "gw");
+  EXPECT_TRUE(gw2.mesh() == g_dlr_iw.mesh());
+  EXPECT_GF_NEAR(g_dlr_iw, gw2, 1.e-15);
+}
+
+MAKE_MAIN;
@@ -0,0 +1,96 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Michel Ferrero, Olivier Parcollet, Nils Wentzell
+
+#include <triqs/test_tools/gfs.hpp>
+
+using namespace triqs::arrays;
+
+triqs::clef::placeholder<0> iw_;
+
+// G(iw) = 1 / (iw - eps * I - V), V hermitian, with known moments 0 and 1
+gf<imfreq> make_g(gf_mesh<imfreq> const &mesh, int n, double eps) {
+  auto g = gf<imfreq>{mesh, {n, n}};
+  auto h = matrix<dcomplex>(n, n);
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j) h(i, j) = (i == j ? eps + i : dcomplex(0.1, 0.05 * (i - j)));
+  for (auto const &w : mesh) g[w] = inverse(dcomplex(w) * make_unit_matrix<dcomplex>(n) - h);
+  return g;
+}
+
+// The high moments are ill-determined : compare the first ones only
+auto first_moments(array<dcomplex, 3> const &a) { return array<dcomplex, 3>{a(range(0, 4), ellipsis())}; }
+
+TEST(FitTailBatch, VectorOfGf) { // NOLINT
+
+  auto mesh = gf_mesh<imfreq>{10, Fermion, 200};
+
+  // e.g. G(k, iw) for a set of k-points
+  std::vector<gf<imfreq>> gs;
+  for (int k = 0; k < 20; ++k) gs.push_back(make_g(mesh, 2, std::cos(0.3 * k)));
+
+  auto [tails, err] = fit_tail(gs);
+  EXPECT_EQ(tails.size(), gs.size());
+  double max_err = 0;
+  for (int k = 0; k < gs.size(); ++k) {
+    auto [tail_k, err_k] = fit_tail(gs[k]);
+    EXPECT_ARRAY_NEAR(first_moments(tails[k]), first_moments(tail_k), 1e-10);
+    max_err = std::max(max_err, err_k);
+  }
+  EXPECT_NEAR(err, max_err, 1e-14);
+
+  // with the known moments : the first moment is the identity
+  std::vector<array<dcomplex, 3>> km(gs.size(), make_zero_tail(gs[0], 2));
+  for (auto &a : km) a(1, ellipsis()) = make_unit_matrix<dcomplex>(2);
+  auto [tails_km, err_km] = fit_tail(gs, km);
+  for (int k = 0; k < gs.size(); ++k) {
+    EXPECT_ARRAY_NEAR(first_moments(tails_km[k]), first_moments(fit_tail(gs[k], km[k]).first), 1e-10);
+    auto h = matrix<dcomplex>(2, 2);
+    h(0, 0) = std::cos(0.3 * k);
+    h(1, 1) = std::cos(0.3 * k) + 1;
+    h(0, 1) = dcomplex(0.1, -0.05);
+    h(1, 0) = dcomplex(0.1, 0.05);
+    EXPECT_ARRAY_NEAR(tails_km[k](2, ellipsis()), h, 1e-6);
+  }
+
+  // Different numbers of known moments are fitted separately
+  km[3] = make_zero_tail(gs[0], 1);
+  auto [tails_mixed, err_mixed] = fit_tail(gs, km);
+  for (int k = 0; k < gs.size(); ++k) EXPECT_ARRAY_NEAR(first_moments(tails_mixed[k]), first_moments(fit_tail(gs[k], km[k]).first), 1e-10);
+
+  EXPECT_THROW(fit_tail(gs, std::vector<array<dcomplex, 3>>(3, make_zero_tail(gs[0], 2))), triqs::runtime_error);
+}
+
+// ----------------------------------------------------------------------
+
+TEST(FitTailBatch, BlockGf) { // NOLINT
+
+  auto mesh = gf_mesh<imfreq>{10, Fermion, 200};
+  auto bg   = make_block_gf<imfreq>({"up", "dn", "ab"}, {make_g(mesh, 2, 0.5), make_g(mesh, 3, -0.2), make_g(mesh, 2, 1.5)});
+
+  auto [tails, err] = fit_tail(bg);
+  for (int b = 0; b < bg.size(); ++b) EXPECT_ARRAY_NEAR(first_moments(tails[b]), first_moments(fit_tail(bg[b]).first), 1e-10);
+
+  auto [tails_h, err_h] = fit_hermitian_tail(bg);
+  for (int b = 0; b < bg.size(); ++b) EXPECT_ARRAY_NEAR(first_moments(tails_h[b]), first_moments(fit_hermitian_tail(bg[b]).first), 1e-10);
+
+  auto km = make_zero_tail(bg, 2);
+  for (int b = 0; b < bg.size(); ++b) km[b](1, ellipsis()) = make_unit_matrix<dcomplex>(bg[b].target_shape()[0]);
+  auto [tails_km, err_km] = fit_hermitian_tail(bg, km);
+  for (int b = 0; b < bg.size(); ++b) EXPECT_ARRAY_NEAR(first_moments(tails_km[b]), first_moments(fit_hermitian_tail(bg[b], km[b]).first), 1e-10);
+}
+
+MAKE_MAIN;
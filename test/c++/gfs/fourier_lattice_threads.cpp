@@ -0,0 +1,102 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Nils Wentzell
+
+#define TRIQS_ARRAYS_ENFORCE_BOUNDCHECK
+#include <triqs/test_tools/gfs.hpp>
+#include <thread>
+
+using triqs::clef::placeholder;
+
+placeholder<0> k_;
+placeholder<1> iw_;
+
+auto make_gk_iw() {
+  auto bz  = brillouin_zone{bravais_lattice{make_unit_matrix<double>(2)}};
+  auto gkw = gf<cartesian_product<brillouin_zone, imfreq>, matrix_valued>{{{bz, 4}, {10, Fermion, 5}}, {2, 2}};
+  gkw(k_, iw_) << 1 / (iw_ - 2 * (cos(k_(0)) + cos(k_(1))));
+  return gkw;
+}
+
+TEST(FourierLatticeThreads, ThreadsGiveSameResult) {
+  auto bl = bravais_lattice{make_unit_matrix<double>(2)};
+  auto gr = gf<cyclic_lattice, matrix_valued>{{bl, 6}, {3, 3}};
+  placeholder<0> r_;
+  gr(r_) << exp(-r_(0)) + 0.5 * r_(1);
+
+  auto gk1 = make_gf_from_fourier(gr);
+  for (int n : {2, 3, 7, 100}) { // more threads than FFT : at most one per FFT
+    set_fourier_n_threads(n);
+    EXPECT_EQ(get_fourier_n_threads(), n);
+    auto gk2 = make_gf_from_fourier(gr);
+    EXPECT_GF_NEAR(gk1, gk2, 1.e-14);
+    EXPECT_GF_NEAR(gr, make_gf_from_fourier(gk2), 1.e-12);
+  }
+  set_fourier_n_threads(1);
+  EXPECT_THROW(set_fourier_n_threads(0), triqs::runtime_error);
+}
+
+TEST(FourierLatticeThreads, BatchedOverFrequencies) {
+  auto gkw = make_gk_iw();
+
+  // reference : the transform of the first mesh, through the general Fourier
+  auto grw_ref = make_gf_from_fourier<0>(gkw, make_adjoint_mesh(std::get<0>(gkw.mesh())));
+
+  for (int n_threads : {0, 1, 3}) {
+    auto grw = make_gf_from_lattice_fourier(gkw, n_threads);
+    EXPECT_GF_NEAR(grw, grw_ref, 1.e-13);
+
+    // and back
+    auto gkw2 = make_gf_from_lattice_fourier(grw(), n_threads);
+    EXPECT_GF_NEAR(gkw, gkw2, 1.e-12);
+  }
+}
+
+TEST(FourierLatticeThreads, BatchedNonContiguousAndReal) {
+  auto gkw = make_gk_iw();
+
+  // a non contiguous view : the data are copied
+  auto g01   = slice_target(gkw, range(0, 1), range(0, 2));
+  auto g_ref = make_gf_from_fourier<0>(g01, make_adjoint_mesh(std::get<0>(gkw.mesh())));
+  EXPECT_GF_NEAR(make_gf_from_lattice_fourier(g01), g_ref, 1.e-13);
+
+  // real valued
+  auto gre = gf<cartesian_product<brillouin_zone, imfreq>, matrix_real_valued>{gkw.mesh(), {1, 1}};
+  for (long i : range(first_dim(gre.data())))
+    for (long j : range(second_dim(gre.data()))) gre.data()(i, j, 0, 0) = real(gkw.data()(i, j, 0, 0));
+  auto gre_c = gf<cartesian_product<brillouin_zone, imfreq>, matrix_valued>{gkw.mesh(), {1, 1}};
+  gre_c.data() = gre.data();
+  EXPECT_GF_NEAR(make_gf_from_lattice_fourier(gre), make_gf_from_lattice_fourier(gre_c), 1.e-14);
+}
+
+// The threaded transforms of several calling threads share the pool of workers
+TEST(FourierLatticeThreads, ConcurrentCallers) {
+  auto gkw     = make_gk_iw();
+  auto grw_ref = make_gf_from_lattice_fourier(gkw, 1);
+  std::vector<int> n_errors(3, 0);
+  std::vector<std::thread> callers;
+  for (int c = 0; c < 3; ++c)
+    callers.emplace_back([&, c] {
+      for (int i = 0; i < 20; ++i) {
+        auto grw = make_gf_from_lattice_fourier(gkw, 2 + c);
+        if (max_element(abs(grw.data() - grw_ref.data())) > 1.e-14) ++n_errors[c];
+      }
+    });
+  for (auto &t : callers) t.join();
+  EXPECT_EQ(n_errors, (std::vector<int>{0, 0, 0}));
+}
+
+MAKE_MAIN;
@@ -0,0 +1,137 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Nils Wentzell
+
+#include <triqs/test_tools/gfs.hpp>
+#include <triqs/gfs/transform/fourier_common.hpp>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+triqs::clef::placeholder<0> iw_;
+
+auto make_gw(int N_iw) {
+  auto gw = gf<imfreq, matrix_valued>{{10, Fermion, N_iw}, {2, 2}};
+  gw(iw_) << 1 / (iw_ + 1) - 0.5 / (iw_ - 2);
+  return gw;
+}
+
+TEST(FourierPlanCache, ReuseAndEffort) {
+  clear_fftw_plan_cache();
+  set_fftw_planner_effort(fftw_planner_effort::estimate);
+  auto gw = make_gw(100);
+
+  auto gt1 = make_gf_from_fourier(gw, 601);
+  long n   = fftw_plan_cache_size();
+  EXPECT_GE(n, 1);
+
+  // same shape : the plan is reused, and the result is identical
+  auto gt2 = make_gf_from_fourier(gw, 601);
+  EXPECT_EQ(fftw_plan_cache_size(), n);
+  EXPECT_ARRAY_EQ(gt1.data(), gt2.data());
+
+  // another shape : a new plan
+  auto gt3 = make_gf_from_fourier(gw, 401);
+  EXPECT_EQ(fftw_plan_cache_size(), n + 1);
+
+  // a measured plan gives the same transform, and leaves the input untouched
+  set_fftw_planner_effort(fftw_planner_effort::measure);
+  auto gw_copy = gw;
+  auto gt4     = make_gf_from_fourier(gw, 601);
+  EXPECT_EQ(fftw_plan_cache_size(), n + 2);
+  EXPECT_GF_NEAR(gt1, gt4, 1.e-12);
+  EXPECT_ARRAY_EQ(gw.data(), gw_copy.data());
+
+  // the round trip still works with cached plans
+  auto gw2 = make_gf_from_fourier(gt4, 100);
+  EXPECT_GF_NEAR(gw, gw2, 1.e-8);
+
+  clear_fftw_plan_cache();
+  EXPECT_EQ(fftw_plan_cache_size(), 0);
+  set_fftw_planner_effort(fftw_planner_effort::estimate);
+}
+
+TEST(FourierPlanCache, Wisdom) {
+  std::string filename = "fourier_plan_cache.wisdom";
+  std::remove(filename.c_str());
+  EXPECT_FALSE(set_fftw_wisdom_file(filename)); // no file yet
+
+  // a new measured plan exports the wisdom
+  clear_fftw_plan_cache();
+  set_fftw_planner_effort(fftw_planner_effort::measure);
+  auto gt = make_gf_from_fourier(make_gw(50), 301);
+  EXPECT_TRUE(std::ifstream(filename).good());
+
+  // next run
+  EXPECT_TRUE(set_fftw_wisdom_file(filename));
+  EXPECT_TRUE(import_fftw_wisdom(filename));
+  EXPECT_TRUE(export_fftw_wisdom(filename));
+
+  set_fftw_wisdom_file("");
+  set_fftw_planner_effort(fftw_planner_effort::estimate);
+  std::remove(filename.c_str());
+}
+
+TEST(FourierPlanCache, MaxSize) {
+  clear_fftw_plan_cache();
+  set_fftw_plan_cache_max_size(2);
+  auto gw  = make_gw(50);
+  auto gt1 = make_gf_from_fourier(gw, 301);
+  auto gt2 = make_gf_from_fourier(gw, 401);
+  auto gt3 = make_gf_from_fourier(gw, 501); // evicts a plan
+  EXPECT_EQ(fftw_plan_cache_size(), 2);
+  EXPECT_GF_NEAR(make_gf_from_fourier(gw, 301), gt1, 1.e-14);
+  EXPECT_GF_NEAR(make_gf_from_fourier(gw, 401), gt2, 1.e-14);
+  EXPECT_EQ(fftw_plan_cache_size(), 2);
+  EXPECT_EQ(get_fftw_plan_cache_max_size(), 2);
+  set_fftw_plan_cache_max_size(1);
+  EXPECT_EQ(fftw_plan_cache_size(), 1);
+  set_fftw_plan_cache_max_size(64);
+}
+
+// The plans are keyed on the strides and alignment : check the FFT of strided and shifted data against the sum,
+// with a small cache where the plans are evicted
+TEST(FourierPlanCache, StridedAndMisaligned) {
+  clear_fftw_plan_cache();
+  set_fftw_plan_cache_max_size(2);
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> dist(-1, 1);
+  int n_others = 3;
+  for (int N : {12, 16, 15, 12, 16})
+    for (int offset : {0, 1})
+      for (int step : {1, 3}) {
+        auto big_in = array<dcomplex, 2>(offset + step * N, n_others);
+        for (auto &x : big_in) x = dcomplex(dist(rng), dist(rng));
+        auto big_out = array<dcomplex, 2>(N + 1, n_others);
+        auto in      = big_in(range(offset, offset + step * N, step), range());
+        auto out     = big_out(range(1 - offset, N + 1 - offset), range());
+        int dims[]   = {N};
+        _fourier_base(in, out, 1, dims, n_others, FFTW_FORWARD);
+
+        for (int k = 0; k < N; ++k)
+          for (int i = 0; i < n_others; ++i) {
+            dcomplex r = 0;
+            for (int j = 0; j < N; ++j) r += in(j, i) * std::exp(dcomplex(0, -2 * M_PI * ((j * k) % N) / N));
+            EXPECT_NEAR(std::abs(out(k, i) - r), 0, 1.e-12);
+          }
+        EXPECT_TRUE(fftw_plan_cache_size() <= 2);
+      }
+  EXPECT_THROW(set_fftw_plan_cache_max_size(0), triqs::runtime_error);
+  set_fftw_plan_cache_max_size(64);
+  clear_fftw_plan_cache();
+}
+
+MAKE_MAIN;
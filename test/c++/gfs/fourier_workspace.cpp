@@ -0,0 +1,106 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Nils Wentzell
+
+#include <triqs/test_tools/gfs.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Count the heap allocations
+std::atomic<long> n_allocations = 0;
+void *operator new(std::size_t n) {
+  ++n_allocations;
+  if (void *p = std::malloc(n == 0 ? 1 : n)) return p;
+  throw std::bad_alloc{};
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+triqs::clef::placeholder<0> iw_;
+
+// The workspace gives the same result as fourier, with the same moments
+void test_workspace(statistic_enum statistic) {
+  double beta = 10, E = -1;
+  auto Gw     = gf<imfreq, matrix_valued>{{beta, statistic, 100}, {2, 2}};
+  Gw(iw_) << 1 / (iw_ - E) + 1 / (iw_ + 2 * E) - 4.5 / (iw_ - 1.25 * E);
+
+  auto known_moments                                   = make_zero_tail(Gw, 4);
+  matrix_view<dcomplex>{known_moments(1, ellipsis())} = -2.5;
+  matrix_view<dcomplex>{known_moments(2, ellipsis())} = -1 + 2 + 4.5 * 1.25;
+  matrix_view<dcomplex>{known_moments(3, ellipsis())} = -1 + 4 - 4.5 * 1.25 * 1.25;
+
+  auto Gt_ref = gf<imtime, matrix_valued>{{beta, statistic, 1001}, {2, 2}};
+  Gt_ref()    = fourier(Gw, known_moments);
+  auto Gw_ref = gf<imfreq, matrix_valued>{Gw.mesh(), {2, 2}};
+  Gw_ref()    = fourier(Gt_ref, known_moments);
+
+  auto ws = fourier_workspace{Gt_ref.mesh(), Gw.mesh()};
+  auto Gt = gf<imtime, matrix_valued>{Gt_ref.mesh(), {2, 2}};
+  auto Gw2 = gf<imfreq, matrix_valued>{Gw.mesh(), {2, 2}};
+
+  for (int iter = 0; iter < 3; ++iter) { // the buffers are reused
+    ws.inverse(Gt, Gw, known_moments);
+    EXPECT_GF_NEAR(Gt, Gt_ref, 1.e-13);
+    ws.direct(Gw2(), Gt, known_moments);
+    EXPECT_GF_NEAR(Gw2, Gw_ref, 1.e-13);
+  }
+  EXPECT_GF_NEAR(Gw2, Gw, 1.e-6);
+
+  // Another target size with the same workspace, from non contiguous data
+  auto gw_s = slice_target_to_scalar(Gw, 0, 0);
+  auto gt_s = gf<imtime, scalar_valued>{Gt_ref.mesh(), {}};
+  ws.inverse(gt_s, gw_s, known_moments(range(), 0, 0));
+  EXPECT_GF_NEAR(gt_s, slice_target_to_scalar(Gt_ref, 0, 0), 1.e-13);
+
+  // Errors
+  auto Gw_other = gf<imfreq, matrix_valued>{{beta, statistic, 50}, {2, 2}};
+  EXPECT_THROW(ws.direct(Gw_other, Gt, known_moments), triqs::runtime_error);
+  EXPECT_THROW(ws.inverse(Gt, Gw, make_zero_tail(Gw, 2)), triqs::runtime_error);
+  EXPECT_THROW(ws.inverse(slice_target_to_scalar(Gt, 0, 0), gw_s, known_moments(range(), 0, 0)), triqs::runtime_error);
+  EXPECT_THROW((fourier_workspace{{beta, statistic, 101}, Gw.mesh()}), triqs::runtime_error);
+}
+
+// After the first call, the transforms make no heap allocation, also with threads
+TEST(FourierWorkspace, NoAllocation) {
+  double beta = 10;
+  auto Gw     = gf<imfreq, matrix_valued>{{beta, Fermion, 100}, {2, 2}};
+  Gw(iw_) << 1 / (iw_ - 1) + 1 / (iw_ + 2);
+  auto known_moments                                   = make_zero_tail(Gw, 4);
+  matrix_view<dcomplex>{known_moments(1, ellipsis())} = 2;
+  matrix_view<dcomplex>{known_moments(2, ellipsis())} = -1;
+  matrix_view<dcomplex>{known_moments(3, ellipsis())} = 5;
+  auto Gt = gf<imtime, matrix_valued>{{beta, Fermion, 1001}, {2, 2}};
+  auto ws = fourier_workspace{Gt.mesh(), Gw.mesh()};
+
+  for (int n_threads : {1, 2}) {
+    set_fourier_n_threads(n_threads);
+    ws.inverse(Gt, Gw, known_moments);
+    ws.direct(Gw, Gt, known_moments);
+    long n0 = n_allocations;
+    for (int iter = 0; iter < 5; ++iter) {
+      ws.inverse(Gt, Gw, known_moments);
+      ws.direct(Gw, Gt, known_moments);
+    }
+    EXPECT_EQ(n_allocations - n0, 0);
+  }
+  set_fourier_n_threads(1);
+}
+
+TEST(FourierWorkspace, Fermion) { test_workspace(Fermion); }
+TEST(FourierWorkspace, Boson) { test_workspace(Boson); }
+
+MAKE_MAIN;
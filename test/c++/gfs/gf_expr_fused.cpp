@@ -0,0 +1,143 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include <triqs/test_tools/gfs.hpp>
+
+using namespace triqs::gfs;
+using namespace triqs::arrays;
+
+// G0^{-1}(iw) = iw + mu - h, Sigma(iw) = v / (iw - e) and w(iw) = 1 / (iw - 1), for n x n matrices
+struct dyson_data {
+  gf<imfreq> g0_inv, sigma, w;
+  dyson_data(int n, double beta, int n_iw) {
+    g0_inv = gf<imfreq>{{beta, Fermion, n_iw}, {n, n}};
+    sigma  = g0_inv;
+    w      = g0_inv;
+    for (auto const &iw : g0_inv.mesh()) {
+      for (int a = 0; a < n; ++a)
+        for (int b = 0; b < n; ++b) {
+          g0_inv[iw](a, b) = (a == b ? dcomplex(iw) + 0.3 - 0.5 * a : -0.2);
+          sigma[iw](a, b)  = (0.4 + 0.1 * (a + b)) / (dcomplex(iw) - 0.7 + 0.1 * a);
+          w[iw](a, b)      = (a == b ? 1.0 : 0.1) / (dcomplex(iw) - 1.0);
+        }
+    }
+  }
+};
+
+TEST(GfExprFused, Dyson) { // NOLINT
+
+  for (int n : {1, 2, 3, 5}) {
+    auto [g0_inv, sigma, w] = dyson_data(n, 10, 200);
+
+    // Point by point reference
+    auto g_ref = g0_inv;
+    auto p_ref = g0_inv;
+    for (auto const &iw : g0_inv.mesh()) {
+      g_ref[iw] = matrix<dcomplex>{inverse(matrix<dcomplex>(g0_inv[iw] - sigma[iw]))};
+      p_ref[iw] = g_ref[iw] * w[iw];
+    }
+
+    gf<imfreq> g = inverse(g0_inv - sigma);
+    EXPECT_GF_NEAR(g, g_ref, 1e-13);
+
+    gf<imfreq> p = inverse(g0_inv - sigma) * w;
+    EXPECT_GF_NEAR(p, p_ref, 1e-13);
+
+    // Threads, in a view
+    p() = 0;
+    fused_assign(p, inverse(g0_inv - sigma) * w, 3);
+    EXPECT_GF_NEAR(p, p_ref, 1e-13);
+
+    // Division, scalars and unary minus
+    g() = 0;
+    fused_assign(g, -(1.0 / (g0_inv - sigma)) + 2.0 * (g0_inv / g0_inv) - g0_inv * inverse(1.0 * g0_inv) * 2.0, 4);
+    EXPECT_GF_NEAR(g, gf<imfreq>{-g_ref}, 1e-12);
+
+    // The result may appear in the expression
+    p = g0_inv;
+    p = inverse(p - sigma);
+    EXPECT_GF_NEAR(p, g_ref, 1e-13);
+  }
+}
+
+// ----------------------------------------------------------------------
+
+TEST(GfExprFused, Scalar) { // NOLINT
+
+  auto g = gf<imfreq, scalar_valued>{{10, Fermion, 100}};
+  for (auto const &iw : g.mesh()) g[iw] = dcomplex(iw) - 0.5;
+  auto g_ref = g;
+  for (auto const &iw : g.mesh()) g_ref[iw] = 2.0 / (dcomplex(iw) - 0.5) + dcomplex(iw) - 0.5;
+
+  gf<imfreq, scalar_valued> r = 2.0 * inverse(1.0 * g) + g;
+  EXPECT_GF_NEAR(r, g_ref, 1e-14);
+  r() = 0;
+  fused_assign(r, 2.0 / g + g, 2);
+  EXPECT_GF_NEAR(r, g_ref, 1e-14);
+}
+
+// ----------------------------------------------------------------------
+
+// The fused evaluation of e against its point by point evaluation
+template <typename G, typename E> void check_fused(G const &g, E const &e) {
+  auto r   = g;
+  auto ref = g;
+  for (auto const &iw : g.mesh()) ref[iw] = e[iw];
+  r = e;
+  EXPECT_GF_NEAR(r, ref, 1e-14);
+}
+
+TEST(GfExprFused, ScalarPlusMinus) { // NOLINT
+
+  // The scalar is added on the diagonal of the matrices
+  auto [g0_inv, sigma, w] = dyson_data(3, 10, 100);
+  gf<imfreq> r            = g0_inv + 1.0;
+  for (auto const &iw : r.mesh()) EXPECT_ARRAY_NEAR(matrix<dcomplex>(r[iw] - g0_inv[iw]), make_unit_matrix<dcomplex>(3), 1e-14);
+
+  check_fused(g0_inv, g0_inv + 1.0);
+  check_fused(g0_inv, 1.0 - g0_inv);
+  check_fused(g0_inv, g0_inv - dcomplex(0, 2));
+  check_fused(g0_inv, 2 + sigma);
+  check_fused(g0_inv, inverse(g0_inv - 0.5) * w - 1.0);
+
+  auto g = gf<imfreq, scalar_valued>{{10, Fermion, 100}};
+  for (auto const &iw : g.mesh()) g[iw] = dcomplex(iw) - 0.5;
+  check_fused(g, g + 1.0);
+  check_fused(g, 1.0 - g);
+  check_fused(g, inverse(g - 0.5) + dcomplex(0, 2));
+}
+
+// ----------------------------------------------------------------------
+
+TEST(GfExprFused, NotFused) { // NOLINT
+
+  // On a product mesh, inverse(expr) is evaluated point by point
+  auto m = gf_mesh<cartesian_product<imfreq, imfreq>>{{10, Fermion, 5}, {10, Fermion, 5}};
+  auto g = gf<cartesian_product<imfreq, imfreq>>{m, {2, 2}};
+  g() = 0.1;
+  for (auto [w1, w2] : m) {
+    g[w1, w2](0, 0) = dcomplex(w1) + 1.0;
+    g[w1, w2](1, 1) = dcomplex(w2) - 1.0;
+  }
+
+  gf<cartesian_product<imfreq, imfreq>> r = inverse(1.0 * g);
+  for (auto [w1, w2] : m) EXPECT_ARRAY_NEAR(matrix<dcomplex>(r[w1, w2]), matrix<dcomplex>(inverse(matrix<dcomplex>(g[w1, w2]))), 1e-14);
+
+  EXPECT_THROW(fused_assign(r, inverse(1.0 * g) * gf<cartesian_product<imfreq, imfreq>>{m, {3, 3}}), triqs::runtime_error);
+}
+
+MAKE_MAIN;
@@ -54,9 +54,13 @@ TEST(CtHyb, gf_inverse2) {
   auto G_iw_inv = G_iw;
   G_iw_inv(om_, k_) << 1. / (om_ - 2 * t * (cos(k_(0)) + cos(k_(1))));
 
+  auto G_iw2 = G_iw;
+  invert_in_place(G_iw2(), 3);
+
   G_iw = inverse(G_iw);
 
   EXPECT_GF_NEAR(G_iw, G_iw_inv);
+  EXPECT_GF_NEAR(G_iw2, G_iw_inv);
 }
 
 TEST(CtHyb, gf_inverse3) {
@@ -84,4 +88,25 @@ TEST(CtHyb, gf_inverse3) {
   EXPECT_GF_NEAR(G_iw, G_iw_inv);
 }
 
+TEST(CtHyb, gf_inverse_matrix) {
+  double beta = 10.0;
+  triqs::clef::placeholder<0> om_;
+
+  for (int n : {2, 3, 5}) {
+    auto h = matrix<dcomplex>(n, n);
+    for (int i = 0; i < n; ++i)
+      for (int j = 0; j < n; ++j) h(i, j) = (i == j ? 0.5 * i : 0.2);
+
+    auto G_iw = gf<imfreq>{{beta, Fermion, 100}, {n, n}};
+    G_iw(om_) << om_ - h;
+
+    auto G_iw_inv = G_iw;
+    for (auto const &w : G_iw.mesh()) G_iw_inv[w] = matrix<dcomplex>{inverse(matrix<dcomplex>(G_iw[w]))};
+
+    EXPECT_GF_NEAR(inverse(G_iw), G_iw_inv);
+    invert_in_place(G_iw(), 4);
+    EXPECT_GF_NEAR(G_iw, G_iw_inv);
+  }
+}
+
 MAKE_MAIN;
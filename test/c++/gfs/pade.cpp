@@ -0,0 +1,127 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Michel Ferrero, Olivier Parcollet, Nils Wentzell
+
+#include <triqs/test_tools/gfs.hpp>
+#include <triqs/gfs/transform/pade.hpp>
+#include <triqs/utility/pade_approximants.hpp>
+
+using namespace triqs::utility;
+
+// A few Lorentzian peaks, with the weights w
+dcomplex g_lorentz(dcomplex z, double w) { return w * 0.7 / (z - 2.6 + 0.3i) + (1 - w) * 0.3 / (z + 3.4 + 0.1i) + 0.2 / (z - 0.1 + 0.2i); }
+
+gf<imfreq> make_gw(double beta, double w1, double w2) {
+  auto gw = gf<imfreq>{{beta, Fermion, 200}, {2, 2}};
+  gw() = 0;
+  for (auto const &w : gw.mesh()) {
+    gw[w](0, 0) = g_lorentz(w, w1);
+    gw[w](1, 1) = g_lorentz(w, w2);
+  }
+  return gw;
+}
+
+TEST(Pade, Coefficients) { // NOLINT
+
+  double beta = 100;
+  for (int n_points : {10, 30, 60}) {
+    auto z_in = arrays::vector<dcomplex>(n_points);
+    auto u_in = arrays::vector<dcomplex>(n_points);
+    for (int i = 0; i < n_points; ++i) {
+      z_in(i) = 1i * M_PI * (2 * i + 1) / beta;
+      u_in(i) = g_lorentz(z_in(i), 0.5);
+    }
+    auto e = arrays::array<dcomplex, 1>(201);
+    for (int k = 0; k < 201; ++k) e(k) = -6 + 0.06 * k + 0.01i;
+    auto a_gmp = pade_coefficients_gmp(z_in, u_in);
+    auto a     = pade_coefficients(z_in, u_in, e);
+
+    // The continued fraction with both sets of coefficients
+    auto r_gmp = arrays::array<dcomplex, 1>(201), r = arrays::array<dcomplex, 1>(201);
+    pade_evaluate(z_in, a_gmp, e, r_gmp);
+    pade_evaluate(z_in, a, e, r);
+    EXPECT_ARRAY_NEAR(r, r_gmp, 1e-8);
+
+    // The vectorized evaluation is the one of pade_approximant
+    auto PA = pade_approximant(z_in, u_in, e);
+    for (int k = 0; k < 201; ++k) EXPECT_COMPLEX_NEAR(r(k), PA(e(k)), 1e-12);
+  }
+}
+
+// ----------------------------------------------------------------------
+
+TEST(Pade, Fallback) { // NOLINT
+
+  // Close to the real axis
+  auto e = arrays::array<dcomplex, 1>(201);
+  for (int k = 0; k < 201; ++k) e(k) = -6 + 0.06 * k + 0.01i;
+
+  for (double beta : {100, 100000}) {
+    int n_points = 100;
+    auto z_in    = arrays::vector<dcomplex>(n_points);
+    auto u_in    = arrays::vector<dcomplex>(n_points);
+    for (int i = 0; i < n_points; ++i) {
+      z_in(i) = 1i * M_PI * (2 * i + 1) / beta;
+      u_in(i) = g_lorentz(z_in(i), 0.5);
+    }
+
+    // At very low temperature, the double-precision coefficients have no correct digit at e,
+    // so the accuracy of the double-double ones can not be asserted : the GMP coefficients are used.
+    auto a_dd = pade_coefficients_dd(z_in, u_in, e);
+    EXPECT_EQ(bool(a_dd), (beta < 1000));
+    if (!a_dd) EXPECT_ARRAY_EQ(pade_coefficients(z_in, u_in, e), pade_coefficients_gmp(z_in, u_in));
+
+    // Without the points of evaluation, pade_approximant uses the GMP coefficients, also at low temperature
+    auto r_gmp = arrays::array<dcomplex, 1>(201);
+    pade_evaluate(z_in, pade_coefficients_gmp(z_in, u_in), e, r_gmp);
+    auto PA = pade_approximant(z_in, u_in);
+    for (int k = 0; k < 201; ++k) EXPECT_COMPLEX_NEAR(PA(e(k)), r_gmp(k), 1e-10);
+  }
+}
+
+// ----------------------------------------------------------------------
+
+TEST(Pade, Gf) { // NOLINT
+
+  double beta = 100, eta = 0.01;
+  int L       = 30;
+  auto gw     = make_gw(beta, 0.5, 0.8);
+
+  auto gr = gf<refreq>{{-6, 6, 1201}, {2, 2}};
+  pade(gr, gw, L, eta);
+
+  // The continuation is close to the exact function away from the real axis
+  for (auto const &om : gr.mesh()) {
+    EXPECT_COMPLEX_NEAR(gr[om](0, 0), g_lorentz(dcomplex(om) + 1i * eta, 0.5), 1e-3);
+    EXPECT_COMPLEX_NEAR(gr[om](1, 1), g_lorentz(dcomplex(om) + 1i * eta, 0.8), 1e-3);
+  }
+
+  // Threads
+  auto gr2 = gr;
+  pade(gr2, gw, L, eta, 3);
+  EXPECT_GF_NEAR(gr2, gr, 1e-14);
+
+  // Block Green functions
+  auto bw = make_block_gf({"up", "dn"}, {gw, make_gw(beta, 0.2, 0.4)});
+  auto br = make_block_gf({"up", "dn"}, {gr, gr});
+  pade(br, bw, L, eta, 4);
+  EXPECT_GF_NEAR(br[0], gr, 1e-14);
+  auto gr_dn = gr;
+  pade(gr_dn, bw[1], L, eta);
+  EXPECT_GF_NEAR(br[1], gr_dn, 1e-14);
+}
+
+MAKE_MAIN;
@@ -0,0 +1,113 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Igor Krivenko, Nils Wentzell
+
+#include <triqs/test_tools/arrays.hpp>
+#include <random>
+#include <sstream>
+
+#include <triqs/operators/many_body_operator.hpp>
+#include <triqs/hilbert_space/hilbert_space.hpp>
+#include <triqs/hilbert_space/imperative_operator.hpp>
+#include <triqs/hilbert_space/state.hpp>
+
+using namespace triqs::hilbert_space;
+using triqs::operators::c;
+using triqs::operators::c_dag;
+
+using uint128_t = unsigned __int128;
+
+fock_bitset<128> to_bitset(uint128_t x) {
+  fock_bitset<128> r;
+  r.words = {uint64_t(x), uint64_t(x >> 64)};
+  return r;
+}
+
+// The 128 bits set has the arithmetic of the 128 bits unsigned integer
+TEST(fock_state, bitset128) { // NOLINT
+  std::mt19937_64 rng(1);
+  for (int k = 0; k < 200; ++k) {
+    uint128_t x = (uint128_t(rng()) << 64) | rng(), y = (uint128_t(rng()) << 64) | rng();
+    if (k % 3 == 0) y = x ^ (uint128_t(1) << (k % 128)); // differ by one bit only
+    auto bx = to_bitset(x), by = to_bitset(y);
+    EXPECT_EQ(bx & by, to_bitset(x & y));
+    EXPECT_EQ(bx | by, to_bitset(x | y));
+    EXPECT_EQ(bx ^ by, to_bitset(x ^ y));
+    EXPECT_EQ(~bx, to_bitset(~x));
+    EXPECT_EQ(bx < by, x < y);
+    EXPECT_EQ(bx == by, x == y);
+    EXPECT_EQ(bool(bx & by), (x & y) != 0);
+    for (int n : {0, 1, 17, 63, 64, 65, 100, 127}) {
+      EXPECT_EQ(bx << n, to_bitset(x << n));
+      EXPECT_EQ(bx >> n, to_bitset(x >> n));
+    }
+    int count = 0;
+    for (int n = 0; n < 128; ++n) count += int((x >> n) & 1);
+    EXPECT_EQ(popcount(bx), count);
+    EXPECT_EQ(parity(bx), count % 2 == 1);
+    EXPECT_EQ(low_word(bx), uint64_t(x));
+  }
+  std::stringstream ss;
+  ss << (fock_bitset<128>(0xab) << 64 | fock_bitset<128>(0x1));
+  EXPECT_EQ(ss.str(), "0xab0000000000000001");
+}
+
+TEST(fock_state, bitset256) { // NOLINT
+  auto f = fock_bitset<256>(1) << 200 | fock_bitset<256>(1) << 3;
+  EXPECT_EQ(popcount(f), 2);
+  EXPECT_FALSE(parity(f));
+  EXPECT_EQ(f.words[3], uint64_t(1) << 8);
+  EXPECT_EQ(f >> 197, fock_bitset<256>(8));
+  EXPECT_TRUE(fock_bitset<256>(-1) < f);
+  EXPECT_EQ(popcount(~f), 254);
+}
+
+// ----------------------------------------------------------------------
+
+int n_modes = std::min(fock_state_bits, 100);
+
+bool bit(fock_state_t const &f, int n) { return bool((f >> n) & fock_state_t(1)); }
+
+// The sign of the fermionic operator n on the Fock state f : (-1)^(number of modes below n in f)
+double sign(fock_state_t const &f, int n) { return parity(f & ~(~fock_state_t(0) << n)) ? -1 : 1; }
+
+// The action of c^+_i c_j on random Fock states of n_modes modes, including the sign beyond the 16 first modes
+TEST(fock_state, imperative_operator) { // NOLINT
+  fundamental_operator_set fops;
+  for (int n = 0; n < n_modes; ++n) fops.insert(n);
+
+  std::mt19937_64 rng(2);
+  for (int k = 0; k < 20; ++k) {
+    fock_state_t f = 0;
+    for (int n = 0; n < n_modes; ++n)
+      if (rng() % 2) f |= fock_state_t(1) << n;
+    int i = rng() % n_modes, j = rng() % n_modes;
+
+    sub_hilbert_space hs(0);
+    hs.add_fock_state(f);
+    fock_state_t f1 = f ^ (fock_state_t(1) << j), f2 = f1 ^ (fock_state_t(1) << i);
+    if (!hs.has_state(f2)) hs.add_fock_state(f2);
+
+    state<sub_hilbert_space, double, false> psi(hs);
+    psi(hs.get_state_index(f)) = 1;
+    auto res = imperative_operator<sub_hilbert_space>(c_dag(i) * c(j), fops)(psi);
+
+    double ref = (bit(f, j) and !bit(f1, i)) ? sign(f, j) * sign(f1, i) : 0;
+    EXPECT_EQ(res(hs.get_state_index(f2)), ref);
+  }
+}
+
+MAKE_MAIN;
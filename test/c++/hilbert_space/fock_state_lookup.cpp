@@ -0,0 +1,96 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Igor Krivenko, Nils Wentzell
+
+#include <triqs/test_tools/arrays.hpp>
+#include <algorithm>
+#include <map>
+#include <random>
+
+#include <triqs/hilbert_space/hilbert_space.hpp>
+
+using namespace triqs::hilbert_space;
+
+std::mt19937_64 rng(1);
+
+fock_state_t random_state(int n_bits) {
+  fock_state_t f = 0;
+  for (int n = 0; n < n_bits; ++n)
+    if (rng() % 2) f |= fock_state_t(1) << n;
+  return f;
+}
+
+// Add the states one by one, and compare the lookup with a map after each of them, on the states and on some others
+void check_lookup(std::vector<fock_state_t> const &states, std::vector<fock_state_t> const &others, lookup_kind kind) {
+  sub_hilbert_space hs(0);
+  std::map<fock_state_t, int> ref;
+  for (auto const &f : states) {
+    hs.add_fock_state(f);
+    ref.emplace(f, ref.size());
+    if (ref.size() % 37 != 1 and ref.size() != states.size()) continue;
+    for (auto const &[g, i] : ref) EXPECT_EQ(hs.get_state_index(g), i);
+    for (auto const &g : others) {
+      if (ref.count(g) == 0) { EXPECT_FALSE(hs.has_state(g)); }
+    }
+  }
+  EXPECT_EQ(hs.size(), states.size());
+  EXPECT_TRUE(hs.get_lookup_kind() == kind);
+}
+
+TEST(fock_state_lookup, direct) { // NOLINT
+  // All the states in the bits [3, 9), with the bits 1 and 12 set
+  std::vector<fock_state_t> states, others;
+  for (int i = 0; i < 64; ++i) states.push_back(fock_state_t(i) << 3 | fock_state_t(2) | fock_state_t(1) << 12);
+  std::shuffle(states.begin(), states.end(), rng);
+  for (int i = 0; i < 100; ++i) others.push_back(states[i % 64] ^ (fock_state_t(1) << (i % 16)));
+  check_lookup(states, others, lookup_kind::direct);
+}
+
+TEST(fock_state_lookup, combinatorial) { // NOLINT
+  // All the states with 4 particles in 14 modes, and a spectator mode
+  int n_modes = 14;
+  std::vector<fock_state_t> states, others;
+  for (int i = 0; i < (1 << n_modes); ++i) {
+    auto f = fock_state_t(i) << 1 | fock_state_t(1) << 20;
+    (popcount(fock_state_t(i)) == 4 ? states : others).push_back(f);
+  }
+  std::shuffle(states.begin(), states.end(), rng);
+  others.resize(2000);
+  for (int i = 0; i < 100; ++i) others.push_back(states[i] ^ (fock_state_t(1) << 20));
+  check_lookup(states, others, lookup_kind::combinatorial);
+}
+
+TEST(fock_state_lookup, hash) { // NOLINT
+  std::vector<fock_state_t> states, others;
+  for (int i = 0; i < 500; ++i) states.push_back(random_state(std::min(fock_state_bits, 100)));
+  states.push_back(states[17]); // a duplicate keeps the first index
+  for (int i = 0; i < 500; ++i) others.push_back(random_state(std::min(fock_state_bits, 100)));
+  check_lookup(states, others, lookup_kind::hash);
+}
+
+// The sparse states of a few particles among many modes
+TEST(fock_state_lookup, few_particles) { // NOLINT
+  int n_modes = std::min(fock_state_bits, 100);
+  std::vector<fock_state_t> states, others;
+  for (int i = 0; i < n_modes; ++i)
+    for (int j = 0; j < i; ++j) states.push_back(fock_state_t(1) << i | fock_state_t(1) << j);
+  std::shuffle(states.begin(), states.end(), rng);
+  for (int i = 0; i < n_modes; ++i) others.push_back(fock_state_t(1) << i);
+  others.push_back(~fock_state_t(0));
+  check_lookup(states, others, lookup_kind::combinatorial);
+}
+
+MAKE_MAIN;
@@ -87,6 +87,16 @@ TEST(hilbert_space, hilbert_space) {
   EXPECT_EQ(hs1, hs_h5);
 }
 
+TEST(hilbert_space, too_many_operators) {
+  using triqs::hilbert_space::hilbert_space;
+  fundamental_operator_set fop;
+  for (int i = 0; i < hilbert_space::max_n_operators; ++i) fop.insert(i);
+  EXPECT_EQ(1 << hilbert_space::max_n_operators, hilbert_space(fop).size());
+
+  fop.insert(hilbert_space::max_n_operators);
+  EXPECT_THROW(hilbert_space{fop}, triqs::runtime_error);
+}
+
 TEST(hilbert_space, fock_state) {
   fundamental_operator_set fop;
   for (int i = 0; i < 4; ++i) fop.insert(i);
@@ -0,0 +1,113 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Nils Wentzell
+
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/test_tools/gfs.hpp>
+
+#include <triqs/lattice/hilbert_transform.hpp>
+
+using namespace triqs::gfs;
+using namespace triqs::lattice;
+using namespace triqs::arrays;
+
+matrix<dcomplex> mat(dcomplex a, dcomplex b, dcomplex c, dcomplex d) { return {{a, b}, {c, d}}; }
+
+// A grid of energies, with a gaussian density of states
+std::pair<array<double, 1>, array<double, 1>> make_dos(int n) {
+  auto eps = array<double, 1>(n);
+  auto rho = array<double, 1>(n);
+  for (int i = 0; i < n; ++i) {
+    eps(i) = -3 + 6.0 * i / (n - 1);
+    rho(i) = std::exp(-eps(i) * eps(i)) * 6.0 / (n - 1) / std::sqrt(M_PI);
+  }
+  return {eps, rho};
+}
+
+// The direct sum
+template <typename G> G reference(array<double, 1> const &eps, array<double, 1> const &rho, G const &sigma, double mu, double eta) {
+  auto g = sigma;
+  g()    = 0;
+  for (auto const &w : sigma.mesh())
+    for (int i = 0; i < first_dim(eps); ++i)
+      g[w] += rho(i) * inverse(matrix<dcomplex>((dcomplex(w) + mu + 1i * eta - eps(i)) * make_unit_matrix<dcomplex>(2) - sigma[w]));
+  return g;
+}
+
+TEST(HilbertTransform, Grid) { // NOLINT
+
+  auto [eps, rho] = make_dos(301);
+  double mu = 0.2, eta = 0.05;
+
+  auto sigma_diag = gf<imfreq>{{10, Fermion, 100}, {2, 2}};
+  auto sigma_full = sigma_diag;
+  for (auto const &w : sigma_diag.mesh()) {
+    sigma_diag[w] = mat(1 / (dcomplex(w) - 0.5), 0, 0, 0.3 / (dcomplex(w) + 1));
+    sigma_full[w] = mat(1 / (dcomplex(w) - 0.5), 0.2, 0.2, 0.3 / (dcomplex(w) + 1));
+  }
+
+  // The diagonal path, without inversion, and the matrix path
+  EXPECT_GF_NEAR(hilbert_transform(eps, rho, sigma_diag, mu, eta), reference(eps, rho, sigma_diag, mu, eta), 1e-12);
+  EXPECT_GF_NEAR(hilbert_transform(eps, rho, sigma_full, mu, eta), reference(eps, rho, sigma_full, mu, eta), 1e-12);
+
+  // With the matrices eps_hat
+  auto eps_hat = std::vector<matrix<dcomplex>>{};
+  for (int i = 0; i < first_dim(eps); ++i) eps_hat.push_back(eps(i) * make_unit_matrix<dcomplex>(2));
+  EXPECT_GF_NEAR(hilbert_transform(rho, eps_hat, sigma_diag, mu, eta), reference(eps, rho, sigma_diag, mu, eta), 1e-12);
+
+  // On the real axis
+  auto sigma_w = gf<refreq>{{-5, 5, 201}, {2, 2}};
+  for (auto const &w : sigma_w.mesh()) sigma_w[w] = mat(-0.1i, 0.1, 0.1, -0.2i);
+  EXPECT_GF_NEAR(hilbert_transform(eps, rho, sigma_w, mu, eta), reference(eps, rho, sigma_w, mu, eta), 1e-12);
+
+  EXPECT_THROW(hilbert_transform(eps, array<double, 1>(3), sigma_diag, mu), triqs::runtime_error);
+  EXPECT_THROW(hilbert_transform(rho, std::vector<matrix<dcomplex>>(first_dim(eps), make_unit_matrix<dcomplex>(3)), sigma_diag, mu), triqs::runtime_error);
+}
+
+// ----------------------------------------------------------------------
+
+TEST(HilbertTransform, Adaptive) { // NOLINT
+
+  // sqrt(z^2 - D^2), on the branch ~ z for large z
+  auto sqrt_branch = [](dcomplex z, double D) {
+    dcomplex q = std::sqrt(z * z - D * D);
+    return (std::real(q / z) < 0 ? -q : q);
+  };
+
+  // Semi-circular density of states : G(z) = 2 (z - sqrt(z^2 - D^2)) / D^2
+  double D = 2;
+  auto rho = [D](double e) { return 2 * std::sqrt(std::max(D * D - e * e, 0.0)) / (M_PI * D * D); };
+
+  auto sigma = gf<imfreq>{{20, Fermion, 50}, {1, 1}};
+  sigma()    = 0;
+  auto g     = hilbert_transform(rho, -D, D, sigma, 0, 0, 1e-8);
+
+  for (auto const &w : sigma.mesh()) EXPECT_COMPLEX_NEAR(g[w](0, 0), 2 * (dcomplex(w) - sqrt_branch(dcomplex(w), D)) / (D * D), 1e-7);
+
+  // Density of states of the linear chain, with inverse square root singularities at the band edges : G(z) = 1 / sqrt(z^2 - D^2)
+  auto rho_1d = [D](double e) { return (D * D - e * e > 0 ? 1 / (M_PI * std::sqrt(D * D - e * e)) : 0.0); };
+  auto g_1d   = hilbert_transform(rho_1d, -D, D, sigma, 0, 0, 1e-8);
+
+  for (auto const &w : sigma.mesh()) EXPECT_COMPLEX_NEAR(g_1d[w](0, 0), 1.0 / sqrt_branch(dcomplex(w), D), 1e-7);
+
+  // Both are normalized
+  EXPECT_NEAR(dos_integral(rho, -D, D, 1e-10), 1, 1e-9);
+  EXPECT_NEAR(dos_integral(rho_1d, -D, D, 1e-8), 1, 1e-6);
+
+  EXPECT_THROW(hilbert_transform(rho, D, -D, sigma, 0), triqs::runtime_error);
+}
+
+MAKE_MAIN;
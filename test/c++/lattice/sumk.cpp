@@ -0,0 +1,114 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Nils Wentzell
+
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/test_tools/gfs.hpp>
+
+#include <triqs/lattice/sumk.hpp>
+
+using namespace triqs::gfs;
+using namespace triqs::lattice;
+using namespace triqs::arrays;
+
+matrix<dcomplex> mat(dcomplex a, dcomplex b, dcomplex c, dcomplex d) { return {{a, b}, {c, d}}; }
+
+// A two band square lattice, with nearest neighbour hopping and an inter-band hybridization
+tight_binding make_tb() {
+  auto bl    = bravais_lattice{matrix<double>{{1, 0}, {0, 1}}, std::vector<r_t>{{0, 0, 0}, {0, 0, 0}}};
+  auto t     = mat(-1, 0.2, 0.2, -0.5);
+  auto displ = std::vector<std::vector<long>>{{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {0, 0}};
+  auto mats  = std::vector<matrix<dcomplex>>{t, t, t, t, mat(0.3, 0, 0, -0.3)};
+  return tight_binding{bl, displ, mats};
+}
+
+// A local self-energy
+block_gf<imfreq> make_sigma(gf_mesh<imfreq> const &mesh) {
+  auto s_up = gf<imfreq>{mesh, {2, 2}};
+  auto s_dn = gf<imfreq>{mesh, {2, 2}};
+  for (auto const &w : mesh) {
+    s_up[w] = mat(1 / (dcomplex(w) - 0.5), 0.1, 0.1, 0.5 / (dcomplex(w) + 1));
+    s_dn[w] = mat(0.2 / (dcomplex(w) + 0.5), 0, 0, 0);
+  }
+  return make_block_gf({"up", "dn"}, {s_up, s_dn});
+}
+
+TEST(SumK, LocalSigma) { // NOLINT
+
+  auto tb    = make_tb();
+  auto mesh  = gf_mesh<imfreq>{10, Fermion, 50};
+  auto sigma = make_sigma(mesh);
+  double mu  = 0.3;
+
+  // A regular grid of k-points, with non uniform weights
+  int n_l      = 8;
+  auto k_stack = array<double, 2>(2, n_l * n_l);
+  auto weights = array<double, 1>(n_l * n_l);
+  for (int i = 0; i < n_l; ++i)
+    for (int j = 0; j < n_l; ++j) {
+      k_stack(0, i * n_l + j) = double(i) / n_l;
+      k_stack(1, i * n_l + j) = double(j) / n_l;
+      weights(i * n_l + j)    = (1 + 0.5 * std::cos(i + j)) / (n_l * n_l);
+    }
+
+  // Reference : the direct sum
+  auto TK    = fourier(tb);
+  auto G_ref = sigma;
+  for (int b = 0; b < 2; ++b) {
+    G_ref[b]() = 0;
+    for (int k = 0; k < n_l * n_l; ++k)
+      for (auto const &w : mesh)
+        G_ref[b][w] += weights(k) * inverse(matrix<dcomplex>((dcomplex(w) + mu) * make_unit_matrix<dcomplex>(2) - TK(k_stack(range(), k)) - sigma[b][w]));
+  }
+
+  EXPECT_BLOCK_GF_NEAR(sumk(tb, k_stack, weights, sigma, mu), G_ref);
+  EXPECT_BLOCK_GF_NEAR(sumk(tb, k_stack, weights, sigma, mu, 3), G_ref);
+  EXPECT_BLOCK_GF_NEAR(sumk(hopping_stack(tb, k_stack), weights, sigma, mu, 4), G_ref);
+
+  EXPECT_THROW(sumk(tb, k_stack, array<double, 1>(3), sigma, mu), triqs::runtime_error);
+  auto sigma_3 = make_block_gf({"a"}, {gf<imfreq>{mesh, {3, 3}}});
+  EXPECT_THROW(sumk(tb, k_stack, weights, sigma_3, mu), triqs::runtime_error);
+}
+
+// ----------------------------------------------------------------------
+
+TEST(SumK, KDependentSigma) { // NOLINT
+
+  auto tb     = make_tb();
+  auto w_mesh = gf_mesh<imfreq>{10, Fermion, 20};
+  auto k_mesh = gf_mesh<brillouin_zone>{brillouin_zone{tb.lattice()}, 6};
+  double mu   = -0.2;
+
+  auto s = gf<cartesian_product<brillouin_zone, imfreq>>{{k_mesh, w_mesh}, {2, 2}};
+  for (auto const &k : k_mesh)
+    for (auto const &w : w_mesh) s[k, w] = mat(0.5 * std::cos(k(0)) / (dcomplex(w) - 1), 0, 0, 0.3 * std::sin(k(1)) / dcomplex(w));
+  auto sigma_k = make_block_gf({"up"}, {s});
+
+  // Reference : the direct sum, with k in the basis of the reciprocal lattice
+  auto TK    = fourier(tb);
+  auto G_ref = gf<imfreq>{w_mesh, {2, 2}};
+  G_ref()    = 0;
+  for (auto const &k : k_mesh) {
+    auto k_l = array<double, 1>{k(0) / (2 * M_PI), k(1) / (2 * M_PI)};
+    for (auto const &w : w_mesh)
+      G_ref[w] += inverse(matrix<dcomplex>((dcomplex(w) + mu) * make_unit_matrix<dcomplex>(2) - TK(k_l) - s[k, w])) / k_mesh.size();
+  }
+
+  auto G = sumk(tb, sigma_k, mu, 2);
+  EXPECT_GF_NEAR(G[0], G_ref);
+}
+
+MAKE_MAIN;
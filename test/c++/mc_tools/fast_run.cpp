@@ -0,0 +1,94 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools.hpp>
+
+using namespace triqs::mc_tools;
+
+// A walker in the potential V(x) = a |x|, with two moves (left, right).
+// <|x|> is known exactly : the weights are exp(-a|x|).
+const double a = 0.3;
+
+struct move_step {
+  int *x;
+  int dx;
+  double attempt() { return std::exp(-a * (std::abs(*x + dx) - std::abs(*x))); }
+  double accept() {
+    *x += dx;
+    return 1;
+  }
+  void reject() {}
+};
+
+struct measure_abs_x {
+  int *x;
+  double *sum;
+  long *n;
+  void accumulate(double) {
+    *sum += std::abs(*x);
+    ++*n;
+  }
+  void collect_results(mpi::communicator const &) {}
+};
+
+template <typename MC> double run(MC &mc, int &x, uint64_t chunk_size, uint64_t n_cycles, uint64_t length_cycle) {
+  double sum = 0;
+  long n     = 0;
+  mc.add_move(move_step{&x, -1}, "left", 1.0);
+  mc.add_move(move_step{&x, 1}, "right", 1.0);
+  mc.add_measure(measure_abs_x{&x, &sum, &n}, "abs x");
+  mc.set_step_chunk_size(chunk_size);
+  mc.warmup_and_accumulate(100, n_cycles, length_cycle, [] { return false; });
+  EXPECT_EQ(mc.get_config_id(), (n_cycles + 100) * length_cycle);
+  return sum / n;
+}
+
+// <|x|> for the weights exp(-a|x|) on Z
+double exact() {
+  double q = std::exp(-a);
+  return 2 * q / ((1 - q) * (1 + q));
+}
+
+TEST(FastRun, Statistics) {
+  for (uint64_t chunk_size : {0, 1, 7, 64}) {
+    {
+      int x = 0;
+      mc_generic<double> mc("", 8237, 0);
+      EXPECT_NEAR(run(mc, x, chunk_size, 100000, 13), exact(), 0.03) << chunk_size;
+    }
+    {
+      int x = 0;
+      mc_generic<double, static_move_set<double, move_step, move_step>> mc("", 8237, 0);
+      EXPECT_NEAR(run(mc, x, chunk_size, 100000, 13), exact(), 0.03) << chunk_size;
+    }
+  }
+}
+
+// The moves do not use the random generator : the random numbers are used in the same order in all modes
+TEST(FastRun, SameChain) {
+  int x1 = 0, x2 = 0, x3 = 0;
+  mc_generic<double> mc1("", 8237, 0), mc2("", 8237, 0), mc3("", 8237, 0);
+  double r1 = run(mc1, x1, 3, 1000, 10);
+  double r2 = run(mc2, x2, 5, 1000, 10);
+  double r3 = run(mc3, x3, 0, 1000, 10);
+  EXPECT_EQ(x1, x3);
+  EXPECT_EQ(r1, r3);
+  EXPECT_EQ(r2, r3);
+}
+
+MAKE_MAIN;
@@ -0,0 +1,166 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools.hpp>
+
+// A random walk on the integers, biased towards 0
+struct configuration {
+  int x = 0;
+};
+
+struct move_step {
+  configuration *config;
+  triqs::mc_tools::random_generator &RNG;
+  int dx = 0;
+  double attempt() {
+    dx = (RNG(2) == 0 ? -1 : 1);
+    return std::exp(-0.1 * (std::abs(config->x + dx) - std::abs(config->x)));
+  }
+  double accept() {
+    config->x += dx;
+    return 1;
+  }
+  void reject() {}
+};
+
+struct measure_x {
+  configuration *config;
+  std::shared_ptr<double> sum_x = std::make_shared<double>(0);
+  std::shared_ptr<long> n       = std::make_shared<long>(0);
+  void accumulate(double) {
+    *sum_x += config->x;
+    ++*n;
+  }
+  void merge(measure_x const &m) {
+    *sum_x += *m.sum_x;
+    *n += *m.n;
+  }
+  void collect_results(mpi::communicator const &c) {
+    *sum_x = mpi::all_reduce(*sum_x, c);
+    *n     = mpi::all_reduce(*n, c);
+  }
+};
+
+// ----------------------------------------------------------------
+
+const int seed = 2389, n_walkers = 5, n_cycles = 2000, length_cycle = 10;
+
+// Run n_walkers walkers on n_threads, returns (sum of x, number of measures)
+std::pair<double, long> run_multi(int n_threads) {
+  triqs::mc_tools::mc_multi_walker<double> mc(n_walkers, "", seed, 0, n_threads);
+  std::vector<configuration> configs(n_walkers);
+  measure_x m0;
+  for (int w = 0; w < n_walkers; ++w) {
+    auto &W = mc.walker(w);
+    W.add_move(move_step{&configs[w], W.get_rng()}, "step");
+    measure_x m{&configs[w]};
+    if (w == 0) m0 = m;
+    W.add_measure(m, "x");
+  }
+  EXPECT_EQ(mc.warmup_and_accumulate(100, n_cycles, length_cycle, [] { return false; }), 0);
+  mc.collect_results(mpi::communicator{});
+  // the merge keeps the counters of the chain of walker 0
+  EXPECT_EQ(mc.walker(0).get_current_cycle_number(), 100 + n_cycles);
+  EXPECT_EQ(mc.walker(0).get_config_id(), (100 + n_cycles) * length_cycle);
+  return {*m0.sum_x, *m0.n};
+}
+
+TEST(MultiWalker, SameAsIndependentChains) {
+
+  // The walker w must be the chain of a mc_generic seeded with seed + w
+  double sum_x = 0;
+  for (int w = 0; w < n_walkers; ++w) {
+    triqs::mc_tools::mc_generic<double> mc("", seed + w, 0);
+    configuration config;
+    measure_x m{&config};
+    mc.add_move(move_step{&config, mc.get_rng()}, "step");
+    mc.add_measure(m, "x");
+    mc.warmup_and_accumulate(100, n_cycles, length_cycle, [] { return false; });
+    sum_x += *m.sum_x;
+  }
+
+  for (int n_threads : {0, 1, 2}) {
+    auto [s, n] = run_multi(n_threads);
+    EXPECT_EQ(n, n_walkers * n_cycles);
+    EXPECT_NEAR(s, sum_x, 1.e-10);
+  }
+}
+
+TEST(MultiWalker, PhiloxStreams) {
+
+  // With a counter based generator, the walker w uses the stream w of the seed
+  triqs::mc_tools::mc_multi_walker<double> mc(3, "philox4x32", seed, 0);
+  for (int w = 0; w < 3; ++w) {
+    triqs::mc_tools::random_generator rng("philox4x32", seed, w);
+    for (int i = 0; i < 10; ++i) EXPECT_EQ(mc.walker(w).get_rng()(), rng());
+  }
+}
+
+TEST(MultiWalker, StopCallback) {
+  triqs::mc_tools::mc_multi_walker<double> mc(3, "", seed, 0);
+  std::vector<configuration> configs(3);
+  for (int w = 0; w < 3; ++w) {
+    mc.walker(w).add_move(move_step{&configs[w], mc.walker(w).get_rng()}, "step");
+    mc.walker(w).add_measure(measure_x{&configs[w]}, "x");
+  }
+  int n_calls = 0;
+  EXPECT_EQ(mc.accumulate(1000000, length_cycle, [&n_calls] { return ++n_calls > 50; }), 1);
+  EXPECT_EQ(n_calls, 51);
+}
+
+TEST(MultiWalker, IdleWalkers) {
+  // One thread for 4 walkers : the warmup is stopped during walker 0, the others are skipped
+  triqs::mc_tools::mc_multi_walker<double> mc(4, "", seed, 0, 1);
+  std::vector<configuration> configs(4);
+  measure_x m0{&configs[0]};
+  for (int w = 0; w < 4; ++w) {
+    mc.walker(w).add_move(move_step{&configs[w], mc.walker(w).get_rng()}, "step");
+    mc.walker(w).add_measure((w == 0 ? m0 : measure_x{&configs[w]}), "x");
+  }
+  int n_calls = 0;
+  EXPECT_EQ(mc.warmup(1000000, length_cycle, [&n_calls] { return ++n_calls >= 20; }), 1);
+  EXPECT_EQ(mc.walker(0).get_current_cycle_number(), 20);
+  for (int w = 1; w < 4; ++w) {
+    EXPECT_TRUE(mc.is_idle(w));
+    EXPECT_EQ(mc.walker(w).get_current_cycle_number(), 0);
+  }
+
+  // The idle walkers are neither run nor merged
+  EXPECT_EQ(mc.accumulate(50, length_cycle, [] { return false; }), 0);
+  for (int w = 1; w < 4; ++w) EXPECT_EQ(mc.walker(w).get_current_cycle_number(), 0);
+  mc.collect_results(mpi::communicator{});
+  EXPECT_FALSE(mc.is_idle(0));
+  EXPECT_EQ(*m0.n, 50);
+}
+
+TEST(MultiWalker, MeasureWithoutMerge) {
+  struct measure_no_merge {
+    void accumulate(double) {}
+    void collect_results(mpi::communicator const &) {}
+  };
+  triqs::mc_tools::mc_multi_walker<double> mc(2, "", seed, 0);
+  std::vector<configuration> configs(2);
+  for (int w = 0; w < 2; ++w) {
+    mc.walker(w).add_move(move_step{&configs[w], mc.walker(w).get_rng()}, "step");
+    mc.walker(w).add_measure(measure_no_merge{}, "m");
+  }
+  mc.accumulate(10, length_cycle, [] { return false; });
+  EXPECT_THROW(mc.collect_results(mpi::communicator{}), triqs::runtime_error);
+}
+
+MAKE_MAIN;
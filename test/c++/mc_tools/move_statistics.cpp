@@ -0,0 +1,123 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools.hpp>
+#include <thread>
+
+using namespace triqs::mc_tools;
+
+// A move with a fixed Metropolis ratio, and a slow attempt
+struct move_slow {
+  double ratio;
+  double attempt() {
+    std::this_thread::sleep_for(std::chrono::microseconds(20));
+    return ratio;
+  }
+  double accept() { return 1; }
+  void reject() {}
+};
+
+template <typename MoveSet> void check(MoveSet const &ms, move_statistics const *st_slow, move_statistics const *st_none) {
+
+  ASSERT_TRUE(st_slow != nullptr);
+  EXPECT_TRUE(st_none == nullptr);
+
+  // all ratios 1.e-3 are in the bin of log10 |R| = -3
+  int b  = int((-3 - move_statistics::log10_min) * move_statistics::n_bins / (move_statistics::log10_max - move_statistics::log10_min));
+  auto h = st_slow->get_histogram();
+  long n = 0;
+  for (int i = 0; i < move_statistics::n_bins; ++i) {
+    n += h[i];
+    if (i != b) EXPECT_EQ(h[i], 0);
+  }
+  EXPECT_EQ(h[b], n);
+  EXPECT_GT(n, 500);
+
+  // attempt sleeps, accept and reject do nothing
+  auto t = st_slow->get_times();
+  EXPECT_GT(t[0], n * 20.e-6);
+  EXPECT_LT(t[1] + t[2], 0.1 * t[0]);
+
+  // the statistics are printed after the line of the move
+  std::istringstream lines(ms.get_statistics());
+  std::string l1, l2, l3;
+  std::getline(lines, l1);
+  std::getline(lines, l2);
+  std::getline(lines, l3);
+  EXPECT_NE(l1.find("slow"), std::string::npos);
+  EXPECT_NE(l2.find("time attempt/accept/reject"), std::string::npos);
+  EXPECT_NE(l3.find("histogram"), std::string::npos);
+}
+
+TEST(MoveStatistics, MoveSet) {
+  random_generator rng("", 23);
+  move_set<double> ms(rng);
+  ms.add(move_slow{1.e-3}, "slow", 1.0, true);
+  ms.add(move_slow{0.5}, "not timed", 1.0);
+  for (int i = 0; i < 2000; ++i) {
+    double r = ms.attempt();
+    if (rng() < r)
+      ms.accept();
+    else
+      ms.reject();
+  }
+  ms.collect_statistics(mpi::communicator{});
+  check(ms, ms.statistics(0), ms.statistics(1));
+}
+
+TEST(MoveStatistics, StaticMoveSet) {
+  random_generator rng("", 23);
+  static_move_set<double, move_slow, move_slow> ms(rng);
+  ms.add(move_slow{1.e-3}, "slow", 1.0, true);
+  ms.add(move_slow{0.5}, "not timed", 1.0);
+  for (int i = 0; i < 2000; ++i) {
+    double r = ms.attempt();
+    if (rng() < r)
+      ms.accept();
+    else
+      ms.reject();
+  }
+  ms.collect_statistics(mpi::communicator{});
+  check(ms, ms.statistics(0), ms.statistics(1));
+}
+
+// A move with an h5 group
+struct move_h5 : move_slow {
+  friend void h5_write(h5::group g, std::string const &name, move_h5 const &m) { h5_write(g.create_group(name), "ratio", m.ratio); }
+  friend void h5_read(h5::group g, std::string const &name, move_h5 &m) { h5_read(g.open_group(name), "ratio", m.ratio); }
+};
+
+// The statistics are written apart from the moves : any name of move is allowed
+TEST(MoveStatistics, H5) {
+  triqs::mc_tools::mc_generic<double> mc("", 23, 0);
+  mc.add_move(move_h5{{0.5}}, "statistics", 1.0, true);
+  mc.add_move(move_h5{{1.e-3}}, "other", 1.0, true);
+  mc.warmup(10, 10, [] { return false; });
+  {
+    h5::file file("move_statistics.h5", 'w');
+    h5_write(file, "mc", mc);
+  }
+  h5::file file("move_statistics.h5", 'r');
+  auto gr = h5::group(file).open_group("mc");
+  double ratio = 0;
+  h5_read(gr.open_group("moves").open_group("statistics"), "ratio", ratio);
+  EXPECT_EQ(ratio, 0.5);
+  for (std::string name : {"statistics", "other"}) EXPECT_TRUE(gr.open_group("move_statistics").has_subgroup(name));
+}
+
+MAKE_MAIN;
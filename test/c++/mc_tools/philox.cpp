@@ -0,0 +1,128 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools/random_generator.hpp>
+#include <vector>
+
+using namespace triqs::mc_tools;
+
+// Known answers of Philox4x32-10, from the Random123 distribution
+TEST(Philox, KnownAnswers) {
+  using b_t = std::array<uint32_t, 4>;
+  EXPECT_EQ(philox4x32::block({0, 0, 0, 0}, {0, 0}), (b_t{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+  EXPECT_EQ(philox4x32::block({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}),
+            (b_t{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+  EXPECT_EQ(philox4x32::block({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}),
+            (b_t{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+// The bulk fill gives the same numbers as the block by block generation
+TEST(Philox, Fill) {
+  for (size_t n : {1, 2, 15, 16, 17, 1000}) {
+    philox4x32 p1(2938, 4), p2(2938, 4);
+    std::vector<double> x(n);
+    p1.fill(x.data(), n);
+    for (size_t i = 0; i < n; i += 2) {
+      auto b = p2();
+      EXPECT_EQ(x[i], ((uint64_t(b[0]) << 32 | b[1]) >> 11) * 0x1.0p-53);
+      if (i + 1 < n) EXPECT_EQ(x[i + 1], ((uint64_t(b[2]) << 32 | b[3]) >> 11) * 0x1.0p-53);
+    }
+    EXPECT_EQ(p1.get_position(), p2.get_position());
+  }
+}
+
+TEST(Philox, Uniform) {
+  random_generator rng("philox4x32", 1234);
+  long N    = 1000000;
+  double s1 = 0, s2 = 0;
+  for (long i = 0; i < N; ++i) {
+    double x = rng();
+    ASSERT_TRUE(x >= 0 and x < 1);
+    s1 += x;
+    s2 += x * x;
+  }
+  EXPECT_NEAR(s1 / N, 0.5, 5 * std::sqrt(1 / 12.0 / N));
+  EXPECT_NEAR(s2 / N, 1 / 3.0, 5 * std::sqrt(4 / 45.0 / N));
+}
+
+// jump(n) is the same as drawing n numbers
+TEST(Philox, Jump) {
+  for (long n0 : {0, 1, 600}) {
+    for (long n : {0, 1, 2, 7, 399, 400, 401, 999, 1000, 1001, 12345}) {
+      random_generator r1("philox4x32", 98), r2("philox4x32", 98);
+      for (long i = 0; i < n0; ++i) {
+        r1();
+        r2();
+      }
+      for (long i = 0; i < n; ++i) r1();
+      r2.jump(n);
+      for (int i = 0; i < 2500; ++i) ASSERT_EQ(r1(), r2()) << "n0 = " << n0 << " n = " << n << " i = " << i;
+    }
+  }
+}
+
+TEST(Philox, StreamsAndSplit) {
+  auto first_numbers = [](random_generator &r) {
+    std::vector<double> v(100);
+    for (auto &x : v) x = r();
+    return v;
+  };
+
+  random_generator r0("philox4x32", 98, 0), r1("philox4x32", 98, 1), r0b("philox4x32", 98, 0);
+  auto v0 = first_numbers(r0);
+  EXPECT_EQ(v0, first_numbers(r0b));
+  EXPECT_NE(v0, first_numbers(r1));
+
+  // split is reproducible, and each call gives a new generator
+  random_generator p1("philox4x32", 98), p2("philox4x32", 98);
+  auto c1 = p1.split(), c2 = p1.split(), c1b = p2.split();
+  auto w1 = first_numbers(c1);
+  EXPECT_EQ(w1, first_numbers(c1b));
+  EXPECT_NE(w1, first_numbers(c2));
+  EXPECT_NE(w1, first_numbers(p1));
+
+  // only philox4x32 has streams
+  random_generator mt("mt19937", 98);
+  EXPECT_FALSE(mt.is_splittable());
+  EXPECT_THROW(mt.split(), triqs::runtime_error);
+  EXPECT_THROW(mt.jump(2), triqs::runtime_error);
+  EXPECT_THROW(random_generator("mt19937", 98, 3), triqs::runtime_error);
+}
+
+// A copy continues the sequence of the original, without advancing it
+TEST(Philox, Copy) {
+  for (std::string name : {"philox4x32", "mt19937"}) {
+    random_generator rng(name, 1234), ref(name, 1234);
+    for (int i = 0; i < 700; ++i) {
+      rng();
+      ref();
+    }
+    random_generator cp = rng, cp2("mt11213b", 1);
+    cp2                 = rng;
+    std::vector<double> x(3000), y(3000);
+    for (auto &a : x) a = cp();
+    for (auto &a : y) a = cp2();
+    EXPECT_EQ(x, y);
+    for (auto &a : y) a = rng();
+    EXPECT_EQ(x, y);
+    for (auto &a : y) a = ref();
+    EXPECT_EQ(x, y);
+  }
+}
+
+MAKE_MAIN;
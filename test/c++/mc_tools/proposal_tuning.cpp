@@ -0,0 +1,196 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools.hpp>
+#include <thread>
+
+using namespace triqs::mc_tools;
+
+// A move of given cost (in microseconds) and Metropolis ratio
+struct move_cost {
+  int cost_us;
+  double ratio;
+  double attempt() {
+    if (cost_us > 0) std::this_thread::sleep_for(std::chrono::microseconds(cost_us));
+    return ratio;
+  }
+  double accept() { return 1; }
+  void reject() {}
+};
+
+struct measure_nothing {
+  void accumulate(double) {}
+  void collect_results(mpi::communicator const &) {}
+};
+
+template <typename MC> std::vector<double> run(double max_factor) {
+  MC mc("", 2938, 0);
+  mc.add_move(move_cost{0, 1.0}, "cheap and good", 1.0);
+  mc.add_move(move_cost{50, 0.1}, "expensive and bad", 1.0);
+  mc.add_measure(measure_nothing{}, "nothing");
+  mc.set_proposal_tuning(max_factor);
+  mc.warmup(100, 10, [] { return false; });
+  auto p = mc.get_proposition_probabilities();
+  // the probabilities are frozen after the warmup
+  mc.accumulate(10, 10, [] { return false; });
+  EXPECT_EQ(p, mc.get_proposition_probabilities());
+  return p;
+}
+
+void check_near(std::vector<double> const &a, std::vector<double> const &b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) EXPECT_NEAR(a[i], b[i], 1.e-14);
+}
+
+TEST(ProposalTuning, MoveSet) {
+  // the efficiency of the expensive move is much lower : its factor is clipped to 1/3, the other one to 3.
+  check_near(run<mc_generic<double>>(3), {0.9, 0.1});
+  check_near(run<mc_generic<double>>(0), {0.5, 0.5});
+}
+
+TEST(ProposalTuning, StaticMoveSet) {
+  using mc_t = mc_generic<double, static_move_set<double, move_cost, move_cost>>;
+  check_near(run<mc_t>(3), {0.9, 0.1});
+  check_near(run<mc_t>(0), {0.5, 0.5});
+}
+
+TEST(ProposalTuning, Tuner) {
+  // The move 1 is never accepted : its factor is clipped. The move 0 is more efficient than the whole set.
+  proposal_tuner t({1, 2}, 10);
+  EXPECT_EQ(t.probabilities(), (std::vector<double>{1, 2})); // nothing measured yet
+  for (int i = 0; i < 100; ++i) {
+    t.start(0);
+    t.end(true);
+    t.start(1);
+    t.end(false);
+  }
+  auto p = t.probabilities();
+  EXPECT_GT(p[0], 1);
+  EXPECT_LE(p[0], 10);
+  EXPECT_NEAR(p[1], 0.2, 1.e-15);
+}
+
+// ----------------------------------------------------------------
+// Detailed balance of an insertion and a removal, whose Metropolis ratios assume they have the same proposition probability.
+// The number of particles n has the Poisson weight lambda^n / n!
+
+struct config {
+  int n         = 0;
+  int cost_us   = 0; // cost of the insertion (only during the warmup)
+  double lambda = 2;
+};
+
+struct move_insert {
+  config *c;
+  double attempt() {
+    if (c->cost_us > 0) std::this_thread::sleep_for(std::chrono::microseconds(c->cost_us));
+    return c->lambda / (c->n + 1);
+  }
+  double accept() {
+    ++c->n;
+    return 1;
+  }
+  void reject() {}
+};
+
+struct move_remove {
+  config *c;
+  double attempt() { return c->n / c->lambda; }
+  double accept() {
+    --c->n;
+    return 1;
+  }
+  void reject() {}
+};
+
+struct move_idle {
+  double attempt() { return 1; }
+  double accept() { return 1; }
+  void reject() {}
+};
+
+struct measure_histogram {
+  config *c;
+  std::vector<double> *h;
+  void accumulate(double) {
+    if (c->n < h->size()) (*h)[c->n] += 1;
+  }
+  void collect_results(mpi::communicator const &) {}
+};
+
+// The distribution of n, and the normalized probabilities of insert, remove, idle after the tuning
+std::pair<std::vector<double>, std::vector<double>> run_insert_remove(std::vector<std::vector<std::string>> groups) {
+  config c;
+  std::vector<double> h(10, 0);
+  mc_generic<double> mc("", 2938, 0);
+  mc.add_move(move_insert{&c}, "insert", 1.0);
+  mc.add_move(move_remove{&c}, "remove", 1.0);
+  mc.add_move(move_idle{}, "idle", 1.0);
+  mc.add_measure(measure_histogram{&c, &h}, "histogram");
+  mc.set_proposal_tuning(3, groups);
+  c.cost_us = 50;
+  mc.warmup(100, 10, [] { return false; });
+  c.cost_us = 0;
+  mc.accumulate(200000, 5, [] { return false; });
+  double s = 0;
+  for (auto x : h) s += x;
+  for (auto &x : h) x /= s;
+  return {h, mc.get_proposition_probabilities()};
+}
+
+TEST(ProposalTuning, InsertRemove) {
+  std::vector<double> exact(10);
+  double f = std::exp(-2.0);
+  for (int n = 0; n < 10; ++n) {
+    exact[n] = f;
+    f *= 2.0 / (n + 1);
+  }
+
+  // The pair is tuned as a group : same probabilities, and the exact distribution
+  auto [h, p] = run_insert_remove({{"insert", "remove"}});
+  EXPECT_NEAR(p[0], p[1], 1.e-14);
+  EXPECT_TRUE(p[2] > p[0]); // the idle move is cheaper
+  for (int n = 0; n < 10; ++n) EXPECT_NEAR(h[n], exact[n], 0.01);
+
+  // Tuned alone, the expensive insertion is proposed less often than the removal : the distribution is wrong
+  auto [h2, p2] = run_insert_remove({});
+  EXPECT_TRUE(p2[0] < p2[1]);
+  double err = 0;
+  for (int n = 0; n < 10; ++n) err = std::max(err, std::abs(h2[n] - exact[n]));
+  EXPECT_TRUE(err > 0.05);
+}
+
+TEST(ProposalTuning, TunerGroups) {
+  // The moves 0 and 2 are a group : its efficiency is the one of all its moves, and it keeps their ratio
+  proposal_tuner t({1, 2, 3}, 10, {"a", "b", "c"}, {{"a", "c"}});
+  for (int i = 0; i < 100; ++i) {
+    t.start(0);
+    t.end(true);
+    t.start(1);
+    t.end(false);
+    t.start(2);
+    t.end(false);
+  }
+  auto p = t.probabilities();
+  EXPECT_NEAR(p[2] / p[0], 3, 1.e-14);
+  EXPECT_NEAR(p[1], 0.2, 1.e-15);
+  EXPECT_THROW(proposal_tuner({1, 2}, 10, {"a", "b"}, {{"a", "z"}}), triqs::runtime_error);
+  EXPECT_THROW(proposal_tuner({1, 2}, 10, {"a", "b"}, {{"a"}, {"a", "b"}}), triqs::runtime_error);
+}
+
+MAKE_MAIN;
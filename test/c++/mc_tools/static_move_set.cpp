@@ -0,0 +1,129 @@
+// Copyright (c) 2020 Simons Foundation
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You may obtain a copy of the License at
+//     https://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Authors: Olivier Parcollet, Nils Wentzell
+
+#include <triqs/test_tools/arrays.hpp>
+#include <triqs/mc_tools.hpp>
+
+using namespace triqs::mc_tools;
+
+// A move which counts its attempts, with a fixed Metropolis ratio
+struct move_count {
+  long *n_attempts;
+  double ratio = 1;
+  double attempt() {
+    ++*n_attempts;
+    return ratio;
+  }
+  double accept() { return 1; }
+  void reject() {}
+};
+
+// Another type of move, a step of a random walk
+struct move_step {
+  int *x;
+  int dx;
+  double ratio;
+  double attempt() { return ratio; }
+  double accept() {
+    *x += dx;
+    return 1;
+  }
+  void reject() {}
+};
+
+// ----------------------------------------------------------------
+
+TEST(StaticMoveSet, AliasSelection) {
+
+  random_generator rng("", 2938);
+  std::vector<double> probas = {1, 2.5, 0.5, 0, 3};
+  std::vector<long> n(probas.size(), 0);
+
+  static_move_set<double, move_count, move_count, move_count, move_count, move_count> ms(rng);
+  for (int u = 0; u < 5; ++u) ms.add(move_count{&n[u]}, "m" + std::to_string(u), probas[u]);
+
+  long n_tot = 1000000;
+  for (long k = 0; k < n_tot; ++k) {
+    ms.attempt();
+    ms.reject();
+  }
+
+  double sum_p = 7;
+  for (int u = 0; u < 5; ++u) {
+    double p = probas[u] / sum_p;
+    EXPECT_NEAR(double(n[u]) / n_tot, p, 5 * std::sqrt(p * (1 - p) / n_tot) + 1.e-15);
+  }
+  EXPECT_EQ(n[3], 0);
+}
+
+// A zero probability for the first move added, as in move_set : the alias table is built when all the moves are added
+TEST(StaticMoveSet, ZeroProbabilityFirst) {
+
+  random_generator rng("", 2938);
+  std::vector<long> n(2, 0);
+  static_move_set<double, move_count, move_count> ms(rng);
+  ms.add(move_count{&n[0]}, "never", 0);
+  ms.add(move_count{&n[1]}, "always", 1);
+  for (int k = 0; k < 1000; ++k) {
+    ms.attempt();
+    ms.reject();
+  }
+  EXPECT_EQ(n[0], 0);
+  EXPECT_EQ(n[1], 1000);
+}
+
+TEST(StaticMoveSet, McGeneric) {
+
+  // The random walk of different_moves_mc, with a static move set
+  double pl = 2.5, pr = 1;
+  int x     = 0;
+  mc_generic<double, static_move_set<double, move_step, move_step>> mc("", 23894, 0);
+  mc.add_move(move_step{&x, -1, pr / pl}, "left move", pl);
+  mc.add_move(move_step{&x, 1, pl / pr}, "right move", pr);
+  mc.warmup_and_accumulate(0, 10000, 100, [] { return false; });
+  mc.collect_results(mpi::communicator{});
+
+  auto rates = mc.get_acceptance_rates();
+  EXPECT_NEAR(rates["left move"], pr / pl, 0.01);
+  EXPECT_NEAR(rates["right move"], 1, 1.e-14);
+}
+
+TEST(StaticMoveSet, MissingMove) {
+  int x = 0;
+  long n = 0;
+  mc_generic<double, static_move_set<double, move_step, move_count>> mc("", 23894, 0);
+  mc.add_move(move_step{&x, 1, 0.5}, "step");
+  EXPECT_THROW(mc.add_move(move_step{&x, -1, 0.5}, "step2"), triqs::runtime_error); // only one slot for move_step
+  EXPECT_THROW(mc.warmup(10, 10, [] { return false; }), triqs::runtime_error);
+  mc.add_move(move_count{&n}, "count");
+  mc.warmup(10, 10, [] { return false; });
+  EXPECT_GT(n, 0);
+}
+
+// The statistics of a partially filled set are not defined
+TEST(StaticMoveSet, MissingMoveStatistics) {
+  int x = 0;
+  random_generator rng("", 23894);
+  static_move_set<double, move_step, move_count> ms(rng);
+  ms.add(move_step{&x, 1, 0.5}, "step", 1.0);
+  EXPECT_THROW(ms.collect_statistics(mpi::communicator{}), triqs::runtime_error);
+  try {
+    ms.collect_statistics(mpi::communicator{});
+  } catch (triqs::runtime_error const &e) { EXPECT_TRUE(std::string(e.what()).find("move number 1") != std::string::npos); }
+}
+
+MAKE_MAIN;
@@ -0,0 +1,98 @@
+# Copyright (c) 2020 Simons Foundation
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You may obtain a copy of the License at
+#     https:#www.gnu.org/licenses/gpl-3.0.txt
+#
+# Authors: Michel Ferrero, Olivier Parcollet, Nils Wentzell
+
+# HilbertTransform : the C++ kernel (dos_tools) and the Python loop on the energies give the same G
+
+import sys
+import numpy as np
+from triqs.gf import *
+from triqs.dos import DOS, DOSFromFunction, HilbertTransform
+from triqs.utility.comparison_tests import *
+
+# Count the calls of the C++ kernel
+ht_module = sys.modules['triqs.dos.hilbert_transform']
+n_kernel_calls = [0]
+kernel = ht_module.hilbert_transform
+def counting_kernel(*args):
+    n_kernel_calls[0] += 1
+    return kernel(*args)
+ht_module.hilbert_transform = counting_kernel
+
+mesh = MeshImFreq(beta = 20, S = 'Fermion', n_max = 40)
+Sigma = Gf(mesh = mesh, target_shape = [2, 2])
+Sigma[0, 0] << 0.4 * inverse(iOmega_n - 0.5)
+Sigma[1, 1] << 0.2 * inverse(iOmega_n + 1.0) + 0.1
+mu, eta = 0.2, 0.05
+
+# The 2x2 eps_hat with an interband hopping
+def epsilon_hat(eps):
+    return np.array([[[e, 0.3], [0.3, 0.5 * e]] for e in eps])
+
+def check(d):
+    H = HilbertTransform(d)
+    n_calls = n_kernel_calls[0]
+
+    # The kernel is used for a Gf on a Matsubara mesh, without field. A zero field forces the Python loop.
+    G_kernel = H(Sigma, mu = mu, eta = eta)
+    G_loop = H(Sigma, mu = mu, eta = eta, field = 0.0)
+    assert n_kernel_calls[0] == n_calls + 1
+    assert_gfs_are_close(G_kernel, G_loop, 1.e-12)
+
+    # With a matrix eps_hat
+    G_kernel = H(Sigma, mu = mu, eta = eta, epsilon_hat = epsilon_hat)
+    G_loop = H(Sigma, mu = mu, eta = eta, epsilon_hat = epsilon_hat, field = 0.0)
+    assert n_kernel_calls[0] == n_calls + 2
+    assert_gfs_are_close(G_kernel, G_loop, 1.e-12)
+
+    # The direct sum at a few frequencies
+    R = H.rho_for_sum
+    for n in [0, 5, -2]:
+        ref = sum(R[i] * np.linalg.inv((mesh(n) + mu + 1j * eta) * np.eye(2) - epsilon_hat([e])[0] - Sigma(n)) for i, e in enumerate(d.eps))
+        assert_arrays_are_close(G_kernel(n), ref, 1.e-12)
+
+# A gaussian density of states on a grid
+eps = np.linspace(-3, 3, 201)
+check(DOS(eps, np.exp(-eps**2) / np.sqrt(np.pi), name = 'gaussian'))
+
+# A semi-circular density of states given as a function
+check(DOSFromFunction(lambda e: 2 * np.sqrt(max(4 - e**2, 0)) / (4 * np.pi), -2, 2, n_pts = 301, name = 'semicircle'))
+
+
+# A density of states given as a function, with test_convergence : the adaptive integration of the kernel
+D = 2.0
+H = HilbertTransform(DOSFromFunction(lambda e: 2 * np.sqrt(max(D**2 - e**2, 0)) / (np.pi * D**2), -D, D, name = 'semicircle'))
+Sigma0 = Gf(mesh = mesh, target_shape = [1, 1])
+n_calls = n_kernel_calls[0]
+G = H(Sigma0, test_convergence = 1.e-8)
+assert n_kernel_calls[0] == n_calls + 1
+for n in [0, 5, -2]:
+    z = mesh(n)
+    q = np.sqrt(z * z - D**2)
+    if (q / z).real < 0: q = -q
+    assert abs(G(n)[0, 0] - 2 * (z - q) / D**2) < 1.e-7
+
+# An unnormalized density of states given as a function : both paths normalize it.
+# A zero field forces the sum on the grid of the function.
+rho = lambda e: 2.5 * np.exp(-e**2)
+H = HilbertTransform(DOSFromFunction(rho, -6, 6, n_pts = 1201, name = 'gaussian'))
+Sigma0 = Gf(mesh = mesh, target_shape = [1, 1])
+Sigma0 << 0.3 * inverse(iOmega_n - 0.2)
+G_adaptive = H(Sigma0, mu = mu, test_convergence = 1.e-10)
+G_grid = H(Sigma0, mu = mu, field = 0.0)
+assert_gfs_are_close(G_adaptive, G_grid, 1.e-8)
+
+ht_module.hilbert_transform = kernel
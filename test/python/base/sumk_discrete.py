@@ -0,0 +1,67 @@
+# Copyright (c) 2020 Simons Foundation
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You may obtain a copy of the License at
+#     https:#www.gnu.org/licenses/gpl-3.0.txt
+#
+# Authors: Michel Ferrero, Olivier Parcollet, Nils Wentzell
+
+# SumkDiscrete : the C++ engine (sumk) and the Python loop on the k-points give the same G
+
+import numpy as np
+from triqs.gf import *
+from triqs.sumk import SumkDiscrete
+import triqs.sumk.sumk_discrete as sumk_discrete
+from triqs.utility.comparison_tests import *
+
+# Count the calls of the C++ engine
+n_engine_calls = [0]
+engine = sumk_discrete.sumk
+def counting_engine(*args):
+    n_engine_calls[0] += 1
+    return engine(*args)
+sumk_discrete.sumk = counting_engine
+
+# A 2-band chain on 16 k-points
+nk = 16
+SK = SumkDiscrete(dim = 1, gf_struct = ['a', 'b'])
+SK.resize_arrays(nk)
+for i in range(nk):
+    k = 2 * np.pi * i / nk
+    SK.bz_points[i, 0] = i / nk - 0.5
+    SK.hopping[i] = [[-2 * np.cos(k), 0.3], [0.3, 0.5 - 2 * np.cos(k)]]
+
+mesh = MeshImFreq(beta = 10, S = 'Fermion', n_max = 50)
+Sigma = BlockGf(name_list = ['up', 'dn'], block_list = [Gf(mesh = mesh, target_shape = [2, 2]) for n in range(2)])
+Sigma['up'] << 0.3 * inverse(iOmega_n + 0.5)
+Sigma['dn'] << 0.1 * inverse(iOmega_n - 1.0) + 0.2
+mu = 0.3
+
+# The engine is used for a local Sigma on a Matsubara mesh
+G_fast = SK(Sigma, mu = mu, n_threads = 2)
+assert n_engine_calls[0] == 1
+
+# The Python loop with a field or an epsilon_hat
+G_field = SK(Sigma, mu = mu, field = 0.0)
+G_eps = SK(Sigma, mu = mu, epsilon_hat = lambda eps: eps)
+assert n_engine_calls[0] == 1
+assert_block_gfs_are_close(G_fast, G_field, 1.e-12)
+assert_block_gfs_are_close(G_fast, G_eps, 1.e-12)
+
+# The explicit sum at a few frequencies
+for bl in ['up', 'dn']:
+    for n in [0, 7, -3]:
+        iw = mesh(n)
+        ref = sum(SK.bz_weights[i] * np.linalg.inv((iw + mu) * np.eye(2) - SK.hopping[i] - Sigma[bl](n)) for i in range(nk))
+        assert_arrays_are_close(G_fast[bl](n), ref, 1.e-12)
+
+sumk_discrete.sumk = engine